@@ -155,4 +155,19 @@ echo -e "\e[32m Dataset size: 10 million: 10 million \e[0m"
 echo -e "\e[32m Dataset size: 100 million: 100 million \e[0m"
 ./libpsi_test -kkrt -ss 100000000 -rs 100000000 -t 36
 ./libpsi_test -mkkrt -ss 100000000 -rs 100000000 -t 36
-./libpsi_test -cm20 -ss 100000000 -rs 100000000 -t 36
\ No newline at end of file
+./libpsi_test -cm20 -ss 100000000 -rs 100000000 -t 36
+
+
+echo -e "\e[31m task level kkrt psi with N shards \e[0m"
+## requires running nodes with datasets psi_client_data and psi_server_data
+## registered, e.g. 10 million elements on each side.
+## submit only queues the task, cli waits for the final status reported by
+## the notify servers of both party nodes, set them in PSI_NOTIFY_SERVERS.
+PSI_NOTIFY_SERVERS=${PSI_NOTIFY_SERVERS:-"172.28.1.11:6667,172.28.1.12:6668"}
+bazel build --config=linux :cli
+for shard_num in 1 2 4 8 16; do
+  echo -e "\e[32m kkrt psi shardNum: ${shard_num} \e[0m"
+  time ./cli --task_type=3 --params="clientData:STRING:0:psi_client_data,serverData:STRING:0:psi_server_data,clientIndex:INT32:0:0,serverIndex:INT32:0:1,psiType:INT32:0:0,psiTag:INT32:0:1,shardNum:INT32:0:${shard_num},outputFullFilename:STRING:0:data/result/kkrt_psi_result.csv" --input_datasets="clientData,serverData" \
+    --task_id="kkrt_psi_${shard_num}" --client_id="psi_benchmark" \
+    --notify_servers="${PSI_NOTIFY_SERVERS}" || echo -e "\e[31m kkrt psi shardNum: ${shard_num} failed \e[0m"
+done
@@ -5,10 +5,19 @@ namespace primihub {
 
 void aby3ML::init(u64 partyIdx, Session& prev, Session& next,
   block seed) {
-  mPreproPrev = prev.addChannel(); 
-  mPreproNext = next.addChannel();
-  mPrev = prev.addChannel();
-  mNext = next.addChannel();
+  {
+    std::lock_guard<std::mutex> lck(mChlMtx);
+    mPreproPrev = prev.addChannel();
+    mPreproNext = next.addChannel();
+    mPrev = prev.addChannel();
+    mNext = next.addChannel();
+    if (mCancelled) {
+      mPreproPrev.cancel();
+      mPreproNext.cancel();
+      mPrev.cancel();
+      mNext.cancel();
+    }
+  }
 
   auto commPtr = std::make_shared<CommPkg>(mPrev, mNext);
   
@@ -20,10 +29,20 @@ void aby3ML::init(u64 partyIdx, Session& prev, Session& next,
 }
 
 void aby3ML::fini(void) {
+  mEval.mTruncationStore.clear();
   mPreproPrev.close();
   mPreproNext.close();
   mPrev.close();
   mNext.close();
 }
 
+void aby3ML::cancel(void) {
+  std::lock_guard<std::mutex> lck(mChlMtx);
+  mCancelled = true;
+  mPreproPrev.cancel();
+  mPreproNext.cancel();
+  mPrev.cancel();
+  mNext.cancel();
+}
+
 }  // namespace primihub
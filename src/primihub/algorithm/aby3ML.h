@@ -3,6 +3,7 @@
 #define SRC_primihub_ALGORITHM_ABY3ML_H_
 
 #include <algorithm>
+#include <mutex>
 #include <random>
 #include <vector>
 
@@ -24,6 +25,8 @@ class aby3ML {
   Sh3Evaluator mEval;
   Sh3Runtime mRt;
   bool mPrint = true;
+  std::mutex mChlMtx;
+  bool mCancelled = false;
 
   u64 partyIdx() {
     return mRt.mPartyIdx;
@@ -33,6 +36,8 @@ class aby3ML {
     block seed);
 
   void fini(void);
+  // thread safe, cancels the channels now or once init creates them.
+  void cancel(void);
 
   template<Decimal D>
   sf64Matrix<D> localInput(const f64Matrix<D>& val) {
@@ -112,8 +117,11 @@ class aby3ML {
     return size;
   }
 
-  void preprocess(u64 n, Decimal d) {
-    TODO("implement this");
+  // Offline phase: stores n truncation pairs for multiplications which
+  // truncate shift bits, so the online rounds only carry the reveal.
+  // Every party has to declare the same workload.
+  u64 preprocess(u64 n, u64 shift) {
+    return mEval.preprocess(n, shift);
   }
 
   template<Decimal D>
@@ -6,6 +6,8 @@
 
 #include "src/primihub/data_store/csv/csv_driver.h"
 #include "src/primihub/data_store/factory.h"
+#include "src/primihub/util/metrics.h"
+#include "src/primihub/util/util.h"
 using arrow::Array;
 using arrow::DoubleArray;
 using arrow::Int64Array;
@@ -204,6 +206,7 @@ template <Decimal Dbit> int ArithmeticExecutor<Dbit>::initPartyComm(void) {
 }
 
 template <Decimal Dbit> int ArithmeticExecutor<Dbit>::execute() {
+  SCopedTimer timer;
   if (is_cmp) {
     try {
       sbMatrix sh_res;
@@ -232,6 +235,10 @@ template <Decimal Dbit> int ArithmeticExecutor<Dbit>::execute() {
           mpc_op_exec_->reveal(sh_res, party);
         }
       }
+      record_task_phase("arithmetic", "compare", timer.timeElapse());
+      u64 sent = 0, received = 0;
+      mpc_op_exec_->channelBytes(&sent, &received);
+      record_channel_bytes("arithmetic", sent, received);
     } catch (std::exception &e) {
       LOG(ERROR) << "In party " << party_id_ << ":\n" << e.what() << ".";
     }
@@ -239,6 +246,8 @@ template <Decimal Dbit> int ArithmeticExecutor<Dbit>::execute() {
   }
   try {
     mpc_exec_->runMPCEvaluate();
+    auto evaluate_ts = timer.timeElapse();
+    record_task_phase("mpc_express", "evaluate", evaluate_ts);
     if (mpc_exec_->isFP64RunMode()) {
       mpc_exec_->revealMPCResult(parties_, final_val_double_);
       // for (auto itr = final_val_double_.begin(); itr !=
@@ -252,6 +261,10 @@ template <Decimal Dbit> int ArithmeticExecutor<Dbit>::execute() {
       //      itr++)
       //   LOG(INFO) << *itr;
     }
+    record_task_phase("mpc_express", "reveal", timer.timeElapse() - evaluate_ts);
+    u64 sent = 0, received = 0;
+    mpc_exec_->channelBytes(&sent, &received);
+    record_channel_bytes("mpc_express", sent, received);
   } catch (const std::exception &e) {
     std::string msg = "In party 0, ";
     msg = msg + e.what();
@@ -270,6 +283,14 @@ template <Decimal Dbit> int ArithmeticExecutor<Dbit>::finishPartyComm(void) {
   return 0;
 }
 
+template <Decimal Dbit> void ArithmeticExecutor<Dbit>::cancelPartyComm(void) {
+  if (is_cmp) {
+    mpc_op_exec_->cancel();
+    return;
+  }
+  mpc_exec_->cancelMPCRuntime();
+}
+
 template <Decimal Dbit> int ArithmeticExecutor<Dbit>::saveModel(void) {
   bool is_reveal = false;
   for (auto party : parties_) {
@@ -312,12 +333,16 @@ template <Decimal Dbit> int ArithmeticExecutor<Dbit>::saveModel(void) {
   else
     table = arrow::Table::Make(
         std::make_shared<arrow::Schema>(schema_vector_bool), {array});
-  std::shared_ptr<DataDriver> driver =
-      DataDirverFactory::getDriver("CSV", dataset_service_->getNodeletAddr());
+  std::string filepath = "data/" + res_name_ + ".csv";
+  std::shared_ptr<DataDriver> driver = DataDirverFactory::getDriver(
+      DataDirverFactory::getDriverNameByPath(filepath),
+      dataset_service_->getNodeletAddr());
   std::shared_ptr<CSVDriver> csv_driver =
       std::dynamic_pointer_cast<CSVDriver>(driver);
-
-  std::string filepath = "data/" + res_name_ + ".csv";
+  if (csv_driver == nullptr) {
+    LOG(ERROR) << "No csv driver for " << filepath << ".";
+    return -1;
+  }
   int ret = 0;
   if (col_and_val_double.size() != 0)
     ret = csv_driver->write(table, filepath);
@@ -335,10 +360,20 @@ template <Decimal Dbit> int ArithmeticExecutor<Dbit>::saveModel(void) {
 template <Decimal Dbit>
 int ArithmeticExecutor<Dbit>::_LoadDatasetFromCSV(std::string &filename) {
   std::string nodeaddr("test address"); // TODO
-  std::shared_ptr<DataDriver> driver =
-      DataDirverFactory::getDriver("CSV", nodeaddr);
+  std::shared_ptr<DataDriver> driver = DataDirverFactory::getDriver(
+      DataDirverFactory::getDriverNameByPath(filename), nodeaddr);
+  if (driver == nullptr) {
+    LOG(ERROR) << "No data driver for " << filename << ".";
+    return -1;
+  }
   std::shared_ptr<Cursor> &cursor = driver->read(filename);
-  std::shared_ptr<Dataset> ds = cursor->read();
+  std::shared_ptr<Dataset> ds = cursor ? cursor->read() : nullptr;
+  if (ds == nullptr ||
+      !std::holds_alternative<std::shared_ptr<Table>>(ds->data) ||
+      std::get<std::shared_ptr<Table>>(ds->data) == nullptr) {
+    LOG(ERROR) << "Read dataset from " << filename << " failed.";
+    return -1;
+  }
   std::shared_ptr<Table> table = std::get<std::shared_ptr<Table>>(ds->data);
 
   // Label column.
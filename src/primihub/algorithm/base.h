@@ -37,6 +37,9 @@ class AlgorithmBase {
     virtual int execute() = 0;
     virtual int finishPartyComm() = 0;
     virtual int saveModel() = 0;
+    // called from another thread to unblock the party channels of a task
+    // being cancelled, the blocked calls then throw.
+    virtual void cancelPartyComm() {}
 
   protected:
     std::shared_ptr<DatasetService> dataset_service_;
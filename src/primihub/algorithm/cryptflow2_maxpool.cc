@@ -153,10 +153,20 @@ int MaxPoolExecutor::loadDataset() {
 
   // read data from csv
   std::string nodeaddr("test address"); // TODO
-  std::shared_ptr<DataDriver> driver =
-      DataDirverFactory::getDriver("CSV", nodeaddr);
+  std::shared_ptr<DataDriver> driver = DataDirverFactory::getDriver(
+      DataDirverFactory::getDriverNameByPath(input_filepath_), nodeaddr);
+  if (driver == nullptr) {
+    LOG(ERROR) << "No data driver for " << input_filepath_ << ".";
+    return -1;
+  }
   std::shared_ptr<Cursor> &cursor = driver->read(input_filepath_);
-  std::shared_ptr<Dataset> ds = cursor->read();
+  std::shared_ptr<Dataset> ds = cursor ? cursor->read() : nullptr;
+  if (ds == nullptr ||
+      !std::holds_alternative<std::shared_ptr<Table>>(ds->data) ||
+      std::get<std::shared_ptr<Table>>(ds->data) == nullptr) {
+    LOG(ERROR) << "Read dataset from " << input_filepath_ << " failed.";
+    return -1;
+  }
   std::shared_ptr<Table> table = std::get<std::shared_ptr<Table>>(ds->data);
 
   // Label column.
@@ -23,6 +23,7 @@
 #include "src/primihub/data_store/dataset.h"
 #include "src/primihub/data_store/factory.h"
 #include "src/primihub/service/dataset/model.h"
+#include "src/primihub/util/metrics.h"
 
 using namespace std;
 using namespace Eigen;
@@ -49,7 +50,12 @@ logistic_main(sf64Matrix<D> &train_data_0_1, sf64Matrix<D> &train_label_0_1,
 
   auto preStart = std::chrono::system_clock::now();
 
-  // p.preprocess((B + dim) * IT, D);
+  // Each mini-batch truncates B values of X * w by D bits and dim values
+  // of the update by D + aB bits, see SGD_Logistic.
+  u64 num_batch = (train_data_0_1.rows() / B) * IT;
+  u64 aB = std::log2(1 / (params.mLearningRate / params.mBatchSize));
+  p.preprocess(B * num_batch, D);
+  p.preprocess(train_data_0_1.cols() * num_batch, D + aB);
 
   double preBytes =
       p.mPreproNext.getTotalDataSent() + p.mPreproPrev.getTotalDataSent();
@@ -84,6 +90,12 @@ logistic_main(sf64Matrix<D> &train_data_0_1, sf64Matrix<D> &train_label_0_1,
       1000.0;
 
   double bytes = p.mNext.getTotalDataSent() + p.mPrev.getTotalDataSent();
+  record_task_phase("logistic_regression", "offline", preSeconds * 1000);
+  record_task_phase("logistic_regression", "train", seconds * 1000);
+  record_channel_bytes("logistic_regression",
+      p.mPreproNext.getTotalDataSent() + p.mPreproPrev.getTotalDataSent() + bytes,
+      p.mPreproNext.getTotalDataRecv() + p.mPreproPrev.getTotalDataRecv() +
+      p.mNext.getTotalDataRecv() + p.mPrev.getTotalDataRecv());
 
   if (print) {
     ostreamLock ooo(std::cout);
@@ -182,10 +194,20 @@ int LogisticRegressionExecutor::loadParams(primihub::rpc::Task &task) {
 
 int LogisticRegressionExecutor::_LoadDatasetFromCSV(std::string &filename) {
   std::string nodeaddr("test address"); // TODO
-  std::shared_ptr<DataDriver> driver =
-      DataDirverFactory::getDriver("CSV", nodeaddr);
+  std::shared_ptr<DataDriver> driver = DataDirverFactory::getDriver(
+      DataDirverFactory::getDriverNameByPath(filename), nodeaddr);
+  if (driver == nullptr) {
+    LOG(ERROR) << "No data driver for " << filename << ".";
+    return -1;
+  }
   std::shared_ptr<Cursor> &cursor = driver->read(filename);
-  std::shared_ptr<Dataset> ds = cursor->read();
+  std::shared_ptr<Dataset> ds = cursor ? cursor->read() : nullptr;
+  if (ds == nullptr ||
+      !std::holds_alternative<std::shared_ptr<Table>>(ds->data) ||
+      std::get<std::shared_ptr<Table>>(ds->data) == nullptr) {
+    LOG(ERROR) << "Read dataset from " << filename << " failed.";
+    return -1;
+  }
   std::shared_ptr<Table> table = std::get<std::shared_ptr<Table>>(ds->data);
 
   // Label column.
@@ -391,6 +413,8 @@ int LogisticRegressionExecutor::finishPartyComm(void) {
   return 0;
 }
 
+void LogisticRegressionExecutor::cancelPartyComm(void) { engine_.cancel(); }
+
 int LogisticRegressionExecutor::_ConstructShares(sf64Matrix<D> &w,
                                                  sf64Matrix<D> &train_data,
                                                  sf64Matrix<D> &train_label,
@@ -564,8 +588,13 @@ int LogisticRegressionExecutor::saveModel(void) {
   auto schema = std::make_shared<arrow::Schema>(schema_vector);
   std::shared_ptr<arrow::Table> table = arrow::Table::Make(schema, {array});
 
-  std::shared_ptr<DataDriver> driver =
-      DataDirverFactory::getDriver("CSV", dataset_service_->getNodeletAddr());
+  std::shared_ptr<DataDriver> driver = DataDirverFactory::getDriver(
+      DataDirverFactory::getDriverNameByPath(model_file_name_),
+      dataset_service_->getNodeletAddr());
+  if (driver == nullptr) {
+    LOG(ERROR) << "No data driver for " << model_file_name_ << ".";
+    return -1;
+  }
 
   auto cursor = driver->initCursor(model_file_name_);
   auto dataset = std::make_shared<primihub::Dataset>(table, driver);
@@ -59,6 +59,7 @@ public:
   int initPartyComm(void) override;
   int execute() override;
   int finishPartyComm(void) override;
+  void cancelPartyComm(void) override;
 
   int constructShares(void);
   int saveModel(void);
@@ -2,6 +2,7 @@
 
 #include <arrow/api.h>
 #include <arrow/array.h>
+#include <arrow/compute/api.h>
 #include <arrow/csv/api.h>
 #include <arrow/csv/writer.h>
 #include <arrow/filesystem/localfs.h>
@@ -22,6 +23,8 @@
 #include "src/primihub/data_store/dataset.h"
 #include "src/primihub/data_store/driver.h"
 #include "src/primihub/data_store/factory.h"
+#include "src/primihub/util/metrics.h"
+#include "src/primihub/util/util.h"
 #include <arrow/pretty_print.h>
 using arrow::Array;
 using arrow::DoubleArray;
@@ -31,6 +34,60 @@ using arrow::Table;
 using namespace rapidjson;
 
 namespace primihub {
+namespace {
+// Sums a numeric column with the arrow kernel, nulls are skipped and a
+// column without any valid value sums to 0.
+template <typename T>
+int _ColumnSum(const std::shared_ptr<arrow::ChunkedArray> &column, T &sum) {
+  sum = 0;
+  auto result = arrow::compute::Sum(column);
+  if (!result.ok()) {
+    LOG(ERROR) << "Sum column failed, " << result.status();
+    return -1;
+  }
+  auto scalar = result.ValueOrDie().scalar();
+  if (!scalar->is_valid)
+    return 0;
+  if (scalar->type->id() == arrow::Type::INT64) {
+    sum = static_cast<T>(
+        std::static_pointer_cast<arrow::Int64Scalar>(scalar)->value);
+  } else if (scalar->type->id() == arrow::Type::DOUBLE) {
+    sum = static_cast<T>(
+        std::static_pointer_cast<arrow::DoubleScalar>(scalar)->value);
+  } else {
+    LOG(ERROR) << "Unsupported sum type " << scalar->type->ToString() << ".";
+    return -1;
+  }
+  return 0;
+}
+
+// Replaces nulls with value, chunks without null are reused as they are.
+template <typename ArrayType, typename BuilderType, typename T>
+std::shared_ptr<arrow::ChunkedArray>
+_FillNull(const std::shared_ptr<arrow::ChunkedArray> &column, T value) {
+  if (column->null_count() == 0)
+    return column;
+  arrow::ArrayVector chunks;
+  for (const auto &chunk : column->chunks()) {
+    if (chunk->null_count() == 0) {
+      chunks.push_back(chunk);
+      continue;
+    }
+    auto array = std::static_pointer_cast<ArrayType>(chunk);
+    BuilderType builder;
+    if (!builder.Reserve(array->length()).ok())
+      return nullptr;
+    for (int64_t i = 0; i < array->length(); i++)
+      builder.UnsafeAppend(array->IsNull(i) ? value : array->Value(i));
+    std::shared_ptr<arrow::Array> filled;
+    if (!builder.Finish(&filled).ok())
+      return nullptr;
+    chunks.push_back(filled);
+  }
+  return std::make_shared<arrow::ChunkedArray>(chunks, column->type());
+}
+} // namespace
+
 void MissingProcess::_spiltStr(string str, const string &split,
                                std::vector<string> &strlist) {
   strlist.clear();
@@ -202,165 +259,115 @@ int MissingProcess::initPartyComm(void) {
   return 0;
 }
 
+void MissingProcess::cancelPartyComm(void) { mpc_op_exec_->cancel(); }
+
 int MissingProcess::execute() {
+  SCopedTimer timer;
   try {
-    arrow::Result<std::shared_ptr<Table>> res_table;
-    std::shared_ptr<arrow::Table> new_table;
-    std::shared_ptr<arrow::Array> data_array;
+    // Local statistics of every column: int sum, non-null count and null
+    // count. Sums of double columns go in once the counts are known, as
+    // their share of the mean. A party without the column contributes
+    // zeros.
+    size_t num_col = col_and_dtype_.size();
+    i64Matrix local_stats(num_col, 3);
+    local_stats.setZero();
+    std::vector<double> local_double_sum(num_col, 0);
+    std::vector<int> local_index(num_col, -1);
+    size_t col_idx = 0;
     for (auto itr = col_and_dtype_.begin(); itr != col_and_dtype_.end();
-         itr++) {
-      std::vector<std::string>::iterator t =
+         itr++, col_idx++) {
+      auto t =
           std::find(local_col_names.begin(), local_col_names.end(), itr->first);
-      double double_sum = 0;
-      i64 int_sum = 0;
-      int null_num = 0;
-      if (t != local_col_names.end()) {
-        int tmp_index = std::distance(local_col_names.begin(), t);
-        if (itr->second == 1) {
-          int chunk_num = table->column(tmp_index)->chunks().size();
-          for (int k = 0; k < chunk_num; k++) {
-            auto array = std::static_pointer_cast<Int64Array>(
-                table->column(tmp_index)->chunk(k));
-            null_num +=
-                table->column(tmp_index)->chunk(k)->data()->GetNullCount();
-            for (int64_t j = 0; j < array->length(); j++) {
-              int_sum += array->Value(j);
-            }
-          }
-          int_sum = int_sum / (table->num_rows() - null_num);
-        } else if (itr->second == 2) {
-          // check schema
-          int chunk_num = table->column(tmp_index)->chunks().size();
-          for (int k = 0; k < chunk_num; k++) {
-            if (table->schema()->GetFieldByName(itr->first)->type()->id() ==
-                9) {
-              auto array = std::static_pointer_cast<Int64Array>(
-                  table->column(tmp_index)->chunk(k));
-              for (int64_t j = 0; j < array->length(); j++) {
-                double_sum += array->Value(j);
-              }
-            } else {
-              auto array = std::static_pointer_cast<DoubleArray>(
-                  table->column(tmp_index)->chunk(k));
-              for (int64_t j = 0; j < array->length(); j++) {
-                double_sum += array->Value(j);
-              }
-            }
-            null_num +=
-                table->column(tmp_index)->chunk(k)->data()->GetNullCount();
-          }
-          double_sum = double_sum / (table->num_rows() - null_num);
-        }
+      if (t == local_col_names.end())
+        continue;
+      int tmp_index = std::distance(local_col_names.begin(), t);
+      local_index[col_idx] = tmp_index;
+      auto column = table->column(tmp_index);
+      local_stats(col_idx, 1) = column->length() - column->null_count();
+      local_stats(col_idx, 2) = column->null_count();
+      int ret = 0;
+      if (itr->second == 1)
+        ret = _ColumnSum(column, local_stats(col_idx, 0));
+      else if (itr->second == 2)
+        ret = _ColumnSum(column, local_double_sum[col_idx]);
+      if (ret) {
+        LOG(ERROR) << "Sum column " << itr->first << " failed.";
+        return -1;
       }
-      if (itr->second == 1) {
-        si64 sharedInt;
-        LOG(INFO) << "Begin to handle column " << itr->first << ".";
-        LOG(INFO) << "Begin to run MPC sum.";
-        mpc_op_exec_->createShares(int_sum, sharedInt);
-        i64 new_sum = mpc_op_exec_->revealAll(sharedInt);
-        LOG(INFO) << "Finish to run MPC sum.";
-        new_sum = new_sum / 3;
-        if (t != local_col_names.end()) {
-          int tmp_index = std::distance(local_col_names.begin(), t);
-          int chunk_num = table->column(tmp_index)->chunks().size();
-          std::vector<i64> new_col;
-          for (int k = 0; k < chunk_num; k++) {
-
-            auto csv_array = std::static_pointer_cast<Int64Array>(
-                table->column(tmp_index)->chunk(k));
-            std::vector<int> null_index;
-            auto tmp_array = table->column(tmp_index)->chunk(k);
-            for (int i = 0; i < tmp_array->length(); i++) {
-              if (tmp_array->IsNull(i))
-                null_index.push_back(i);
-            }
-            std::vector<i64> tmp_new_col;
-            for (int64_t i = 0; i < csv_array->length(); i++) {
-              tmp_new_col.push_back(csv_array->Value(i));
-            }
-            for (auto itr = null_index.begin(); itr != null_index.end();
-                 itr++) {
-              tmp_new_col[*itr] = new_sum;
-            }
-            new_col.insert(new_col.end(), tmp_new_col.begin(),
-                           tmp_new_col.end());
-          }
-          arrow::Int64Builder int64_builder;
-          int64_builder.AppendValues(new_col);
-          int64_builder.Finish(&data_array);
-
-          arrow::ChunkedArray *new_array = new arrow::ChunkedArray(data_array);
+    }
 
-          auto ptr_Array = std::shared_ptr<arrow::ChunkedArray>(new_array);
-          res_table = table->SetColumn(
-              tmp_index, arrow::field(itr->first, arrow::int64()), ptr_Array);
-          table = res_table.ValueUnsafe();
-        }
+    auto local_stats_ts = timer.timeElapse();
+    record_task_phase("missing_val_processing", "local_stats", local_stats_ts);
+    LOG(INFO) << "Begin to run MPC sum of " << num_col << " columns.";
+    i64Matrix stats = mpc_op_exec_->revealSumAll(local_stats);
+    std::vector<i64> counts(num_col);
+    for (size_t i = 0; i < num_col; i++)
+      counts[i] = stats(i, 1);
+    std::vector<double> double_mean =
+        mpc_op_exec_->revealMeanAll<D16>(local_double_sum, counts);
+    LOG(INFO) << "Finish to run MPC sum.";
+    auto mpc_mean_ts = timer.timeElapse();
+    record_task_phase("missing_val_processing", "mpc_mean",
+                      mpc_mean_ts - local_stats_ts);
+    u64 sent = 0, received = 0;
+    mpc_op_exec_->channelBytes(&sent, &received);
+    record_channel_bytes("missing_val_processing", sent, received);
+
+    col_idx = 0;
+    for (auto itr = col_and_dtype_.begin(); itr != col_and_dtype_.end();
+         itr++, col_idx++) {
+      i64 count = stats(col_idx, 1);
+      VLOG(3) << "Column " << itr->first << " has " << count
+              << " values and " << stats(col_idx, 2) << " nulls.";
+      int tmp_index = local_index[col_idx];
+      if (tmp_index < 0)
+        continue;
+
+      auto column = table->column(tmp_index);
+      std::shared_ptr<arrow::ChunkedArray> new_column;
+      std::shared_ptr<arrow::Field> new_field;
+      if (itr->second == 1) {
+        i64 mean = count > 0 ? stats(col_idx, 0) / count : 0;
+        new_column = _FillNull<Int64Array, arrow::Int64Builder>(column, mean);
+        new_field = arrow::field(itr->first, arrow::int64());
       } else if (itr->second == 2) {
-        sf64<D16> sharedFixedInt;
-        LOG(INFO) << "Begin to handle column " << itr->first << ".";
-        LOG(INFO) << "Begin to run MPC sum.";
-        mpc_op_exec_->createShares(double_sum, sharedFixedInt);
-        double new_sum = mpc_op_exec_->revealAll(sharedFixedInt);
-        LOG(INFO) << "Finish to run MPC sum.";
-
-        new_sum = new_sum / 3;
-
-        if (t != local_col_names.end()) {
-          int tmp_index = std::distance(local_col_names.begin(), t);
-          std::vector<double> new_col;
-          int chunk_num = table->column(tmp_index)->chunks().size();
-          for (int k = 0; k < chunk_num; k++) {
-            std::vector<double> tmp_new_col;
-
-            if (table->schema()->GetFieldByName(itr->first)->type()->id() ==
-                9) {
-
-              auto csv_array = std::static_pointer_cast<Int64Array>(
-                  table->column(tmp_index)->chunk(k));
-
-              for (int64_t j = 0; j < csv_array->length(); j++) {
-                tmp_new_col.push_back(csv_array->Value(j));
-              }
-            } else {
-              auto csv_array = std::static_pointer_cast<DoubleArray>(
-                  table->column(tmp_index)->chunk(k));
-
-              for (int64_t i = 0; i < csv_array->length(); i++) {
-                tmp_new_col.push_back(csv_array->Value(i));
-              }
-            }
-            std::vector<int> null_index;
-            auto tmp_array = table->column(tmp_index)->chunk(k);
-            for (int i = 0; i < tmp_array->length(); i++) {
-              if (tmp_array->IsNull(i))
-                null_index.push_back(i);
-            }
-            for (auto itr = null_index.begin(); itr != null_index.end();
-                 itr++) {
-              tmp_new_col[*itr] = new_sum;
-            }
-            new_col.insert(new_col.end(), tmp_new_col.begin(),
-                           tmp_new_col.end());
+        double mean = double_mean[col_idx];
+        if (column->type()->id() != arrow::Type::DOUBLE) {
+          auto cast_result = arrow::compute::Cast(column, arrow::float64());
+          if (!cast_result.ok()) {
+            LOG(ERROR) << "Cast column " << itr->first
+                       << " to double failed, " << cast_result.status();
+            return -1;
           }
-          arrow::DoubleBuilder double_builder;
-          double_builder.AppendValues(new_col);
-          double_builder.Finish(&data_array);
-
-          arrow::ChunkedArray *new_array = new arrow::ChunkedArray(data_array);
-
-          auto ptr_Array = std::shared_ptr<arrow::ChunkedArray>(new_array);
-          res_table = table->SetColumn(
-              tmp_index, arrow::field(itr->first, arrow::float64()), ptr_Array);
-          table = res_table.ValueUnsafe();
+          column = cast_result.ValueOrDie().chunked_array();
         }
+        new_column =
+            _FillNull<DoubleArray, arrow::DoubleBuilder>(column, mean);
+        new_field = arrow::field(itr->first, arrow::float64());
+      } else {
+        continue;
+      }
+      if (new_column == nullptr) {
+        LOG(ERROR) << "Fill missing value of column " << itr->first
+                   << " failed.";
+        return -1;
+      }
+      auto res_table = table->SetColumn(tmp_index, new_field, new_column);
+      if (!res_table.ok()) {
+        LOG(ERROR) << "Replace column " << itr->first << " failed, "
+                   << res_table.status();
+        return -1;
       }
+      table = res_table.ValueOrDie();
     }
+    record_task_phase("missing_val_processing", "fill_null",
+                      timer.timeElapse() - mpc_mean_ts);
   } catch (std::exception &e) {
     LOG(ERROR) << "In party " << party_id_ << ":\n" << e.what() << ".";
+    return -1;
   }
   return 0;
-} // namespace primihub
+}
 
 int MissingProcess::finishPartyComm(void) {
   si64 tmp_share0, tmp_share1, tmp_share2;
@@ -380,8 +387,13 @@ int MissingProcess::saveModel(void) {
 
   std::string new_path = data_file_path_.substr(0, pos) + "_missing.csv";
 
-  std::shared_ptr<DataDriver> driver =
-      DataDirverFactory::getDriver("CSV", dataset_service_->getNodeletAddr());
+  std::shared_ptr<DataDriver> driver = DataDirverFactory::getDriver(
+      DataDirverFactory::getDriverNameByPath(new_path),
+      dataset_service_->getNodeletAddr());
+  if (driver == nullptr) {
+    LOG(ERROR) << "No data driver for " << new_path << ".";
+    return -1;
+  }
 
   auto cursor = driver->initCursor(new_path);
   auto dataset = std::make_shared<primihub::Dataset>(table, driver);
@@ -400,11 +412,20 @@ int MissingProcess::saveModel(void) {
 
 int MissingProcess::_LoadDatasetFromCSV(std::string &filename) {
   std::string nodeaddr("test address"); // TODO
-  std::shared_ptr<DataDriver> driver =
-      DataDirverFactory::getDriver("CSV", nodeaddr);
+  std::shared_ptr<DataDriver> driver = DataDirverFactory::getDriver(
+      DataDirverFactory::getDriverNameByPath(filename), nodeaddr);
+  if (driver == nullptr) {
+    LOG(ERROR) << "No data driver for " << filename << ".";
+    return -1;
+  }
   std::shared_ptr<Cursor> &cursor = driver->read(filename);
-  std::shared_ptr<Dataset> ds = cursor->read();
-
+  std::shared_ptr<Dataset> ds = cursor ? cursor->read() : nullptr;
+  if (ds == nullptr ||
+      !std::holds_alternative<std::shared_ptr<Table>>(ds->data) ||
+      std::get<std::shared_ptr<Table>>(ds->data) == nullptr) {
+    LOG(ERROR) << "Read dataset from " << filename << " failed.";
+    return -1;
+  }
   table = std::get<std::shared_ptr<Table>>(ds->data);
   bool errors = false;
   std::vector<std::string> col_names = table->ColumnNames();
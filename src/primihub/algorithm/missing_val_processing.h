@@ -28,6 +28,7 @@ class MissingProcess : public AlgorithmBase {
   int initPartyComm(void) override;
   int execute() override;
   int finishPartyComm(void) override;
+  void cancelPartyComm(void) override;
   int saveModel(void);
 
  private:
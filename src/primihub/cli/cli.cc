@@ -49,6 +49,14 @@ ABSL_FLAG(std::vector<std::string>,
 
 ABSL_FLAG(std::string, job_id, "100", "job id");    // TODO: auto generate
 ABSL_FLAG(std::string, task_id, "200", "task id");  // TODO: auto generate
+ABSL_FLAG(int64_t, task_timeout_ms, 0, "cancel the task after it, 0 means no deadline");
+ABSL_FLAG(std::string, client_id, "cli", "submit client id, notify servers "
+          "send the task status to this id");
+ABSL_FLAG(std::vector<std::string>, notify_servers, std::vector<std::string>(),
+          "notify servers of the party nodes, wait for the final task status "
+          "on each of them after submit, empty to return after submit");
+ABSL_FLAG(int64_t, wait_timeout_ms, 0,
+          "give up waiting for the final status after it, 0 means no limit");
 
 ABSL_FLAG(std::string, task_lang, "proto", "task language, proto or python");
 ABSL_FLAG(std::string, task_code, "logistic_regression", "task code");
@@ -147,6 +155,8 @@ int SDKClient::SubmitTask() {
     // TODO Generate job id and task id
     pushTaskRequest.mutable_task()->set_job_id(absl::GetFlag(FLAGS_job_id));
     pushTaskRequest.mutable_task()->set_task_id(absl::GetFlag(FLAGS_task_id));
+    pushTaskRequest.mutable_task()->set_timeout_ms(absl::GetFlag(FLAGS_task_timeout_ms));
+    pushTaskRequest.set_submit_client_id(absl::GetFlag(FLAGS_client_id));
     pushTaskRequest.set_sequence_number(11);
     pushTaskRequest.set_client_processed_up_to(22);
 
@@ -162,6 +172,7 @@ int SDKClient::SubmitTask() {
             LOG(INFO) << "job_id: " << pushTaskReply.job_id() << " doing";
         } else {
             LOG(INFO) << "job_id: " << pushTaskReply.job_id() << " error";
+            return -1;
         }
     } else {
         LOG(INFO) << "ERROR: " << status.error_message();
@@ -171,6 +182,101 @@ int SDKClient::SubmitTask() {
     return 0;
 }
 
+TaskStatusWatcher::~TaskStatusWatcher() {
+    for (auto& sub : subs_) {
+        sub->context.TryCancel();
+    }
+    for (auto& sub : subs_) {
+        if (sub->thread.joinable()) {
+            sub->thread.join();
+        }
+    }
+}
+
+int TaskStatusWatcher::subscribe(const std::string& notify_server) {
+    auto sub = std::make_unique<Subscription>();
+    sub->server = notify_server;
+    sub->stub = NodeService::NewStub(
+        grpc::CreateChannel(notify_server, grpc::InsecureChannelCredentials()));
+    primihub::rpc::ClientContext request;
+    request.set_client_id(client_id_);
+    sub->reader = sub->stub->SubscribeNodeEvent(&sub->context, request);
+    // the server sends its node context once the client is registered
+    NodeEventReply reply;
+    if (!sub->reader->Read(&reply)) {
+        LOG(ERROR) << "subscribe to notify server " << notify_server << " failed";
+        sub->context.TryCancel();
+        return -1;
+    }
+    auto* ptr = sub.get();
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        subs_.push_back(std::move(sub));
+    }
+    ptr->thread = std::thread(&TaskStatusWatcher::_Read, this, ptr);
+    return 0;
+}
+
+void TaskStatusWatcher::_Read(Subscription* sub) {
+    NodeEventReply reply;
+    while (sub->reader->Read(&reply)) {
+        if (reply.event_type() != primihub::rpc::NODE_EVENT_TYPE_TASK_STATUS) {
+            continue;
+        }
+        const auto& task_status = reply.task_status();
+        if (task_status.task_context().task_id() != task_id_) {
+            continue;
+        }
+        const auto& status = task_status.status();
+        LOG(INFO) << sub->server << " task " << task_id_ << ": " << status
+                  << ", " << task_status.message();
+        // a scheduler job only hands the task to the parties
+        if (status == "RUNNING" || task_status.message() == "task dispatched") {
+            continue;
+        }
+        std::lock_guard<std::mutex> lck(mtx_);
+        sub->status = status;
+        cv_.notify_all();
+    }
+    std::lock_guard<std::mutex> lck(mtx_);
+    if (sub->status.empty()) {
+        sub->status = "DISCONNECTED";
+        cv_.notify_all();
+    }
+}
+
+// called with mtx_ held
+bool TaskStatusWatcher::_AllDone() {
+    for (const auto& sub : subs_) {
+        if (sub->status.empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int TaskStatusWatcher::wait(int64_t timeout_ms) {
+    std::unique_lock<std::mutex> lck(mtx_);
+    if (timeout_ms > 0) {
+        if (!cv_.wait_for(lck, std::chrono::milliseconds(timeout_ms),
+                          [this] { return _AllDone(); })) {
+            LOG(ERROR) << "wait for task " << task_id_ << " timeout";
+            return -1;
+        }
+    } else {
+        cv_.wait(lck, [this] { return _AllDone(); });
+    }
+    int ret = 0;
+    for (const auto& sub : subs_) {
+        if (sub->status != "SUCCESS") {
+            LOG(ERROR) << "task " << task_id_ << " on " << sub->server
+                       << ": " << sub->status;
+            ret = -1;
+        }
+    }
+    return ret;
+}
+
 }  // namespace primihub
 
 int main(int argc, char** argv) {
@@ -191,12 +297,24 @@ int main(int argc, char** argv) {
     std::vector<std::string> peers;
     peers.push_back(absl::GetFlag(FLAGS_server));
 
+    int ret = -1;
     for (auto peer : peers) {
         LOG(INFO) << "SDK SubmitTask to: " << peer;
         primihub::SDKClient client(
             grpc::CreateChannel(peer, grpc::InsecureChannelCredentials()));
+        primihub::TaskStatusWatcher watcher(absl::GetFlag(FLAGS_client_id),
+                                            absl::GetFlag(FLAGS_task_id));
+        auto notify_servers = absl::GetFlag(FLAGS_notify_servers);
+        for (const auto& notify_server : notify_servers) {
+            if (watcher.subscribe(notify_server)) {
+                return 1;
+            }
+        }
         auto _start = std::chrono::high_resolution_clock::now();
-        auto ret = client.SubmitTask();
+        ret = client.SubmitTask();
+        if (!ret && !notify_servers.empty()) {
+            ret = watcher.wait(absl::GetFlag(FLAGS_wait_timeout_ms));
+        }
         auto _end = std::chrono::high_resolution_clock::now();
         auto time_cost = std::chrono::duration_cast<std::chrono::milliseconds>(_end - _start).count();
         LOG(INFO) << "SubmitTask time cost(ms): " << time_cost;
@@ -206,5 +324,5 @@ int main(int argc, char** argv) {
 
     }
 
-    return 0;
+    return ret ? 1 : 0;
 }
@@ -28,9 +28,12 @@
 
 #include <algorithm>
 #include <cmath>
+#include <condition_variable>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 #include <map>
 
@@ -39,10 +42,13 @@
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 
+#include "src/primihub/protos/service.grpc.pb.h"
 #include "src/primihub/protos/worker.grpc.pb.h"
 #include "src/primihub/common/config/config.h"
 #include "src/primihub/util/util.h"
 
+using primihub::rpc::NodeEventReply;
+using primihub::rpc::NodeService;
 using primihub::rpc::VMNode;
 using primihub::rpc::PushTaskRequest;
 using primihub::rpc::PushTaskReply;
@@ -66,6 +72,43 @@ class SDKClient {
   std::unique_ptr<VMNode::Stub> stub_;
 };
 
+/**
+ * Waits for the final status of a task on the notify servers of its
+ * party nodes. A node only notifies subscribed clients, so subscribe
+ * before the task is submitted.
+ */
+class TaskStatusWatcher {
+ public:
+  TaskStatusWatcher(const std::string& client_id, const std::string& task_id)
+    : client_id_(client_id), task_id_(task_id) {}
+  ~TaskStatusWatcher();
+
+  // returns 0 once the notify server has registered the subscription
+  int subscribe(const std::string& notify_server);
+  // 0 if every subscribed node reports success, -1 on failure or timeout.
+  // timeout_ms <= 0 waits without limit.
+  int wait(int64_t timeout_ms);
+
+ private:
+  struct Subscription {
+    std::string server;
+    std::unique_ptr<NodeService::Stub> stub;
+    grpc::ClientContext context;
+    std::unique_ptr<grpc::ClientReader<NodeEventReply>> reader;
+    std::thread thread;
+    std::string status;  // final status, empty while running
+  };
+
+  void _Read(Subscription* sub);
+  bool _AllDone();
+
+  std::string client_id_;
+  std::string task_id_;
+  std::vector<std::unique_ptr<Subscription>> subs_;
+  std::mutex mtx_;
+  std::condition_variable cv_;
+};
+
 }  // namespace primihub
 
 #endif  // SRC_PRIMIHUB_CLI_CLI_H_
@@ -15,7 +15,6 @@
  */
 
 #include <variant>
-#include <sys/stat.h>
 
 #include "src/primihub/data_store/csv/csv_driver.h"
 #include "src/primihub/data_store/driver.h"
@@ -30,6 +29,53 @@
 #include <iostream>
 
 namespace primihub {
+namespace {
+// Common type of a column whose samples were inferred differently.
+std::shared_ptr<arrow::DataType>
+widenType(const std::shared_ptr<arrow::DataType> &a,
+          const std::shared_ptr<arrow::DataType> &b) {
+  if (a->Equals(*b) || b->id() == arrow::Type::NA) {
+    return a;
+  }
+  if (a->id() == arrow::Type::NA) {
+    return b;
+  }
+  auto is_number = [](const std::shared_ptr<arrow::DataType> &t) {
+    return t->id() == arrow::Type::INT64 || t->id() == arrow::Type::DOUBLE;
+  };
+  if (is_number(a) && is_number(b)) {
+    return arrow::float64();
+  }
+  if (a->id() == arrow::Type::BINARY || b->id() == arrow::Type::BINARY) {
+    return arrow::binary();
+  }
+  return arrow::utf8();
+}
+
+// Parse a chunk of csv text with type inference, column_names is empty
+// if the chunk starts with the header.
+std::shared_ptr<arrow::Table>
+parseSample(std::shared_ptr<arrow::Buffer> buffer,
+            const std::vector<std::string> &column_names) {
+  auto read_options = arrow::csv::ReadOptions::Defaults();
+  read_options.use_threads = false;
+  read_options.column_names = column_names;
+  auto input = std::make_shared<arrow::io::BufferReader>(buffer);
+  auto maybe_reader = arrow::csv::TableReader::Make(
+      arrow::io::default_io_context(), input, read_options,
+      arrow::csv::ParseOptions::Defaults(),
+      arrow::csv::ConvertOptions::Defaults());
+  if (!maybe_reader.ok()) {
+    return nullptr;
+  }
+  auto maybe_table = maybe_reader.ValueOrDie()->Read();
+  if (!maybe_table.ok()) {
+    VLOG(3) << "Parse csv sample failed, " << maybe_table.status();
+    return nullptr;
+  }
+  return maybe_table.ValueOrDie();
+}
+}  // namespace
 
 // csv cursor implementation
 CSVCursor::CSVCursor(std::string filePath, std::shared_ptr<CSVDriver> driver) {
@@ -43,53 +89,197 @@ void CSVCursor::close() {
   // TODO
 }
 
-// read all data from csv file
-std::shared_ptr<primihub::Dataset> CSVCursor::read() {
-  struct stat file_info;
-  ::stat(filePath.c_str(), &file_info);
-  size_t file_size = file_info.st_size;
+// StreamingReader fixes the column types on the first block and fails on
+// a later block which contradicts them, so the types are inferred from
+// blocks spread over the whole file first. A small file is covered
+// completely. A sample which can't be parsed, e.g. it starts inside a
+// quoted newline, is skipped.
+int CSVCursor::inferColumnTypes() {
+  column_types_.clear();
+  auto maybe_file = arrow::io::ReadableFile::Open(filePath);
+  if (!maybe_file.ok()) {
+    LOG(ERROR) << "Failed to open file: " << filePath << ", "
+               << maybe_file.status();
+    return -1;
+  }
+  auto file = maybe_file.ValueOrDie();
+  auto maybe_size = file->GetSize();
+  if (!maybe_size.ok()) {
+    return -1;
+  }
+  int64_t file_size = maybe_size.ValueOrDie();
+  int64_t block_size = block_size_;
+  int64_t num_sample = (file_size + block_size - 1) / block_size;
+  if (num_sample > kTypeSampleBlocks) {
+    num_sample = kTypeSampleBlocks;
+  }
+  int64_t stride =
+      num_sample > 1 ? (file_size - block_size) / (num_sample - 1) : 0;
+
+  std::vector<std::string> column_names;
+  std::vector<std::shared_ptr<arrow::DataType>> types;
+  for (int64_t i = 0; i < num_sample; i++) {
+    int64_t position = i * stride;
+    // extend the last sample to the end of file
+    int64_t length = i + 1 == num_sample ? file_size - position : block_size;
+    auto maybe_buffer = file->ReadAt(position, length);
+    if (!maybe_buffer.ok()) {
+      LOG(ERROR) << "Read csv file " << filePath << " failed, "
+                 << maybe_buffer.status();
+      return -1;
+    }
+    auto buffer = maybe_buffer.ValueOrDie();
+    // keep whole lines only
+    auto text = reinterpret_cast<const char *>(buffer->data());
+    int64_t begin = 0;
+    int64_t end = buffer->size();
+    if (position != 0) {
+      while (begin < end && text[begin] != '\n') {
+        begin++;
+      }
+      begin++;
+    }
+    if (position + end < file_size) {
+      while (end > begin && text[end - 1] != '\n') {
+        end--;
+      }
+    }
+    if (begin >= end) {
+      continue;
+    }
+    if (position != 0 && column_names.empty()) {
+      // the header sample failed, sample rows can't be named
+      break;
+    }
+    auto table = parseSample(arrow::SliceBuffer(buffer, begin, end - begin),
+                             position == 0 ? std::vector<std::string>()
+                                           : column_names);
+    if (table == nullptr) {
+      continue;
+    }
+    if (position == 0) {
+      for (const auto &field : table->schema()->fields()) {
+        column_names.push_back(field->name());
+        types.push_back(field->type());
+      }
+      continue;
+    }
+    if (table->num_columns() != static_cast<int>(types.size())) {
+      continue;
+    }
+    for (int col = 0; col < table->num_columns(); col++) {
+      types[col] = widenType(types[col], table->schema()->field(col)->type());
+    }
+  }
+  for (size_t col = 0; col < types.size(); col++) {
+    if (types[col]->id() != arrow::Type::NA) {
+      column_types_[column_names[col]] = types[col];
+    }
+  }
+  return 0;
+}
+
+std::shared_ptr<arrow::RecordBatchReader> CSVCursor::makeStreamingReader() {
+  if (!types_inferred_) {
+    // on failure the StreamingReader infers from the first block
+    inferColumnTypes();
+    types_inferred_ = true;
+  }
   arrow::io::IOContext io_context = arrow::io::default_io_context();
   arrow::fs::LocalFileSystem local_fs(
       arrow::fs::LocalFileSystemOptions::Defaults());
   auto result_ifstream = local_fs.OpenInputStream(filePath);
   if (!result_ifstream.ok()) {
-    std::cout << "Failed to open file: " << filePath << std::endl;
-    return nullptr; // TODO throw exception
+    LOG(ERROR) << "Failed to open file: " << filePath << ", "
+               << result_ifstream.status();
+    return nullptr;
   }
   std::shared_ptr<arrow::io::InputStream> input = result_ifstream.ValueOrDie();
 
   auto read_options = arrow::csv::ReadOptions::Defaults();
-  read_options.block_size = file_size;
+  read_options.block_size = block_size_;
+  read_options.use_threads = use_threads_;
   auto parse_options = arrow::csv::ParseOptions::Defaults();
   auto convert_options = arrow::csv::ConvertOptions::Defaults();
+  convert_options.column_types = column_types_;
 
-  // Instantiate TableReader from input stream and options
-  auto maybe_reader = arrow::csv::TableReader::Make(
+  auto maybe_reader = arrow::csv::StreamingReader::Make(
       io_context, input, read_options, parse_options, convert_options);
   if (!maybe_reader.ok()) {
-    // TODO Handle TableReader instantiation error...
+    LOG(ERROR) << "Create csv reader for " << filePath << " failed, "
+               << maybe_reader.status();
+    return nullptr;
   }
-  std::shared_ptr<arrow::csv::TableReader> reader = *maybe_reader;
+  return maybe_reader.ValueOrDie();
+}
 
-  // Read table from CSV file
-  auto maybe_table = reader->Read();
-  if (!maybe_table.ok()) {
-    // TODO Handle CSV read error
-    // (for example a CSV syntax error or failed type conversion)
-  }
-  std::shared_ptr<arrow::Table> table = *maybe_table;
-  auto dataset = std::make_shared<primihub::Dataset>(table, this->driver_);
-  return dataset;
+std::shared_ptr<arrow::RecordBatchReader> CSVCursor::readBatches() {
+  return makeStreamingReader();
+}
+
+// read all data from csv file
+std::shared_ptr<primihub::Dataset> CSVCursor::read() {
+  return this->read(0, -1);
 }
 
 std::shared_ptr<primihub::Dataset> CSVCursor::read(int64_t offset,
                                                    int64_t limit) {
-  // TODO
-  return nullptr;
+  auto reader = makeStreamingReader();
+  if (reader == nullptr) {
+    return nullptr;  // TODO throw exception
+  }
+
+  // Skip the first 'offset' rows and keep at most 'limit' rows, slices
+  // share buffers with the parsed batch so no data is copied here.
+  std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+  int64_t skip = offset > 0 ? offset : 0;
+  int64_t remain = limit;
+  while (remain != 0) {
+    std::shared_ptr<arrow::RecordBatch> batch;
+    auto status = reader->ReadNext(&batch);
+    if (!status.ok()) {
+      // a CSV syntax error or failed type conversion
+      LOG(ERROR) << "Read csv file " << filePath << " failed, " << status;
+      return nullptr;
+    }
+    if (batch == nullptr) {
+      break;
+    }
+    int64_t num_rows = batch->num_rows();
+    if (skip >= num_rows) {
+      skip -= num_rows;
+      continue;
+    }
+    int64_t length = num_rows - skip;
+    if (remain > 0 && length > remain) {
+      length = remain;
+    }
+    if (skip == 0 && length == num_rows) {
+      batches.emplace_back(std::move(batch));
+    } else {
+      batches.emplace_back(batch->Slice(skip, length));
+    }
+    skip = 0;
+    if (remain > 0) {
+      remain -= length;
+    }
+  }
+
+  auto maybe_table = arrow::Table::FromRecordBatches(reader->schema(), batches);
+  if (!maybe_table.ok()) {
+    LOG(ERROR) << "Convert record batches to table failed, "
+               << maybe_table.status();
+    return nullptr;
+  }
+  std::shared_ptr<arrow::Table> table = maybe_table.ValueOrDie();
+  this->offset = offset + table->num_rows();
+  auto dataset = std::make_shared<primihub::Dataset>(table, this->driver_);
+  return dataset;
 }
 
 int CSVCursor::write(std::shared_ptr<primihub::Dataset> dataset) {
   // write Dataset to csv file
+  types_inferred_ = false;
   auto result = arrow::io::FileOutputStream::Open(this->filePath);
   if (!result.ok()) {
     LOG(ERROR) << "Open file " << filePath << " failed.";
@@ -17,24 +17,57 @@
 #ifndef SRC_PRIMIHUB_DATA_STORE_CSV_CSV_DRIVER_H_
 #define SRC_PRIMIHUB_DATA_STORE_CSV_CSV_DRIVER_H_
 
+#include <arrow/record_batch.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
 #include "src/primihub/data_store/dataset.h"
 #include "src/primihub/data_store/driver.h"
 
 namespace primihub {
 class CSVDriver;
 
+// CSV file is parsed block by block with arrow's StreamingReader, so peak
+// memory depends on block size instead of file size.
 class CSVCursor : public Cursor {
 public:
+  static constexpr int32_t kDefaultBlockSize = 1 << 22;  // 4MB
+
   CSVCursor(std::string filePath, std::shared_ptr<CSVDriver> driver);
   ~CSVCursor();
   std::shared_ptr<primihub::Dataset> read() override;
-  std::shared_ptr<primihub::Dataset> read(int64_t offset, int64_t limit);
+  // read at most limit rows starting from row offset, limit < 0 means
+  // read until the end of file.
+  std::shared_ptr<primihub::Dataset> read(int64_t offset, int64_t limit) override;
+  // return a reader which yields one RecordBatch per parsed block.
+  std::shared_ptr<arrow::RecordBatchReader> readBatches() override;
   int write(std::shared_ptr<primihub::Dataset> dataset) override;
   void close() override;
 
+  // Type of each column is inferred from blocks sampled across the whole
+  // file, a column whose samples disagree is widened, e.g. int64 and
+  // double to double, numbers and text to string.
+  void setBlockSize(int32_t block_size) {
+    block_size_ = block_size;
+    types_inferred_ = false;
+  }
+  void setUseThreads(bool use_threads) { use_threads_ = use_threads; }
+
 private:
+  std::shared_ptr<arrow::RecordBatchReader> makeStreamingReader();
+  int inferColumnTypes();
+
+  static constexpr int kTypeSampleBlocks = 16;
+
   std::string filePath;
   unsigned long long offset = 0;
+  int32_t block_size_{kDefaultBlockSize};
+  bool use_threads_{true};
+  bool types_inferred_{false};
+  std::unordered_map<std::string, std::shared_ptr<arrow::DataType>>
+      column_types_;
   std::shared_ptr<CSVDriver> driver_;
 };
 
@@ -17,7 +17,62 @@
 
 #include "src/primihub/data_store/driver.h"
 
+#include <glog/logging.h>
+
 namespace primihub {
+namespace {
+// TableBatchReader only keeps a reference to the table, so hold the
+// table here for the whole lifetime of the reader.
+class OwningTableBatchReader : public arrow::RecordBatchReader {
+ public:
+  explicit OwningTableBatchReader(std::shared_ptr<arrow::Table> table)
+      : table_(std::move(table)), reader_(*table_) {}
+
+  std::shared_ptr<arrow::Schema> schema() const override {
+    return reader_.schema();
+  }
+
+  arrow::Status ReadNext(std::shared_ptr<arrow::RecordBatch>* batch) override {
+    return reader_.ReadNext(batch);
+  }
+
+ private:
+  std::shared_ptr<arrow::Table> table_;
+  arrow::TableBatchReader reader_;
+};
+}  // namespace
+
+///////////////////////////////// Cursor //////////////////////////////////////////////////
+std::shared_ptr<arrow::RecordBatchReader> Cursor::readBatches() {
+  auto dataset = this->read();
+  if (dataset == nullptr) {
+    return nullptr;
+  }
+  if (!std::holds_alternative<std::shared_ptr<arrow::Table>>(dataset->data)) {
+    LOG(ERROR) << "Only table dataset can be read batch by batch.";
+    return nullptr;
+  }
+  auto table = std::get<std::shared_ptr<arrow::Table>>(dataset->data);
+  return std::make_shared<OwningTableBatchReader>(std::move(table));
+}
+
+int Cursor::writeBatches(std::shared_ptr<arrow::RecordBatchReader> reader) {
+  std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+  auto status = reader->ReadAll(&batches);
+  if (!status.ok()) {
+    LOG(ERROR) << "Read record batches failed, " << status;
+    return -1;
+  }
+  auto maybe_table = arrow::Table::FromRecordBatches(reader->schema(), batches);
+  if (!maybe_table.ok()) {
+    LOG(ERROR) << "Convert record batches to table failed, "
+               << maybe_table.status();
+    return -1;
+  }
+  auto dataset = std::make_shared<primihub::Dataset>(maybe_table.ValueOrDie(), nullptr);
+  return this->write(dataset);
+}
+
 ///////////////////////////////// DataDriver //////////////////////////////////////////////
 std::shared_ptr<Cursor>& DataDriver::getCursor() { return cursor; }
 std::string DataDriver::getDriverType() const { return driver_type; }
@@ -31,7 +31,7 @@
 #include <exception>
 #include <memory>
 
-
+#include <arrow/record_batch.h>
 
 // #include "src/primihub/common/clp.h"
 // #include "src/primihub/common/type/type.h"
@@ -44,9 +44,18 @@ namespace primihub {
 class Dataset;
 class Cursor {
   public:
+    virtual ~Cursor() = default;
     virtual std::shared_ptr<primihub::Dataset> read() = 0;
     virtual std::shared_ptr<primihub::Dataset> read(int64_t offset, int64_t limit) = 0;
+    // Iterate over the data source batch by batch. Drivers able to produce
+    // data incrementally should override it, the default implementation
+    // materializes the whole dataset through read() first.
+    virtual std::shared_ptr<arrow::RecordBatchReader> readBatches();
     virtual int write(std::shared_ptr<primihub::Dataset> dataset) = 0;
+    // Write everything produced by reader. Drivers able to write
+    // incrementally should override it, the default implementation
+    // collects all batches into one table and calls write().
+    virtual int writeBatches(std::shared_ptr<arrow::RecordBatchReader> reader);
     virtual void close() = 0;
 };
 
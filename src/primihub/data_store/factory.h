@@ -21,6 +21,8 @@
 #include <boost/algorithm/string.hpp>
 #include "src/primihub/data_store/driver.h"
 #include "src/primihub/data_store/csv/csv_driver.h"
+#include "src/primihub/data_store/ipc/ipc_driver.h"
+#include "src/primihub/data_store/parquet/parquet_driver.h"
 #include "src/primihub/data_store/sqlite/sqlite_driver.h"
 
 namespace primihub {
@@ -37,11 +39,29 @@ class DataDirverFactory {
             // TODO not implemented yet
         } else if (boost::to_upper_copy(dirverName) == "SQLITE" ) {
             return std::make_shared<SQLiteDriver>(nodeletAddr);
+        } else if (boost::to_upper_copy(dirverName) == "ARROW" ||
+                   boost::to_upper_copy(dirverName) == "IPC" ||
+                   boost::to_upper_copy(dirverName) == "FEATHER") {
+            return std::make_shared<IPCDriver>(nodeletAddr);
+        } else if (boost::to_upper_copy(dirverName) == "PARQUET") {
+            return std::make_shared<ParquetDriver>(nodeletAddr);
         } else {
             throw std::invalid_argument(
                 "[DataDirverFactory]Invalid dirver name");
         }
     }
+
+    // driver name of a local data file, decided by its extension
+    static std::string getDriverNameByPath(const std::string &filePath) {
+        auto path = boost::to_lower_copy(filePath);
+        if (boost::ends_with(path, ".arrow") || boost::ends_with(path, ".feather")) {
+            return "ARROW";
+        }
+        if (boost::ends_with(path, ".parquet")) {
+            return "PARQUET";
+        }
+        return "CSV";
+    }
 };
 
 } // namespace primihub
@@ -0,0 +1,239 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "src/primihub/data_store/ipc/ipc_driver.h"
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/writer.h>
+#include <glog/logging.h>
+
+#include <cstdio>
+
+namespace primihub {
+namespace {
+class IPCBatchReader : public arrow::RecordBatchReader {
+ public:
+  explicit IPCBatchReader(std::shared_ptr<arrow::ipc::RecordBatchFileReader> reader)
+      : reader_(std::move(reader)) {}
+
+  std::shared_ptr<arrow::Schema> schema() const override {
+    return reader_->schema();
+  }
+
+  arrow::Status ReadNext(std::shared_ptr<arrow::RecordBatch>* batch) override {
+    if (index_ >= reader_->num_record_batches()) {
+      batch->reset();
+      return arrow::Status::OK();
+    }
+    auto maybe_batch = reader_->ReadRecordBatch(index_++);
+    if (!maybe_batch.ok()) {
+      return maybe_batch.status();
+    }
+    *batch = maybe_batch.ValueOrDie();
+    return arrow::Status::OK();
+  }
+
+ private:
+  std::shared_ptr<arrow::ipc::RecordBatchFileReader> reader_;
+  int index_{0};
+};
+}  // namespace
+
+// ipc cursor implementation
+IPCCursor::IPCCursor(std::string filePath, std::shared_ptr<IPCDriver> driver) {
+  this->filePath = filePath;
+  this->driver_ = driver;
+}
+
+IPCCursor::~IPCCursor() { this->close(); }
+
+void IPCCursor::close() {
+  reader_.reset();
+  file_.reset();
+}
+
+int IPCCursor::open() {
+  if (reader_ != nullptr) {
+    return 0;
+  }
+  auto maybe_file = arrow::io::MemoryMappedFile::Open(filePath, arrow::io::FileMode::READ);
+  if (!maybe_file.ok()) {
+    LOG(ERROR) << "Failed to map file: " << filePath << ", " << maybe_file.status();
+    return -1;
+  }
+  file_ = maybe_file.ValueOrDie();
+  auto maybe_reader = arrow::ipc::RecordBatchFileReader::Open(file_);
+  if (!maybe_reader.ok()) {
+    LOG(ERROR) << "Open arrow file " << filePath << " failed, " << maybe_reader.status();
+    return -1;
+  }
+  reader_ = maybe_reader.ValueOrDie();
+  if (columns_.empty()) {
+    return 0;
+  }
+  // the footer is parsed again with the projection, only the buffers of
+  // the included fields are touched afterwards.
+  auto options = arrow::ipc::IpcReadOptions::Defaults();
+  for (const auto& name : columns_) {
+    int index = reader_->schema()->GetFieldIndex(name);
+    if (index < 0) {
+      LOG(ERROR) << "Column " << name << " not found in " << filePath;
+      reader_.reset();
+      return -1;
+    }
+    options.included_fields.push_back(index);
+  }
+  maybe_reader = arrow::ipc::RecordBatchFileReader::Open(file_, options);
+  if (!maybe_reader.ok()) {
+    LOG(ERROR) << "Open arrow file " << filePath << " failed, " << maybe_reader.status();
+    return -1;
+  }
+  reader_ = maybe_reader.ValueOrDie();
+  return 0;
+}
+
+std::shared_ptr<arrow::RecordBatchReader> IPCCursor::readBatches() {
+  if (open()) {
+    return nullptr;
+  }
+  return std::make_shared<IPCBatchReader>(reader_);
+}
+
+// read all data from arrow file
+std::shared_ptr<primihub::Dataset> IPCCursor::read() {
+  return this->read(0, -1);
+}
+
+std::shared_ptr<primihub::Dataset> IPCCursor::read(int64_t offset,
+                                                   int64_t limit) {
+  if (open()) {
+    return nullptr;  // TODO throw exception
+  }
+  // Batches are views on the mapped file, loading one to learn its row
+  // count costs only its metadata.
+  std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+  int64_t skip = offset > 0 ? offset : 0;
+  int64_t remain = limit;
+  for (int i = 0; i < reader_->num_record_batches() && remain != 0; i++) {
+    auto maybe_batch = reader_->ReadRecordBatch(i);
+    if (!maybe_batch.ok()) {
+      LOG(ERROR) << "Read arrow file " << filePath << " failed, "
+                 << maybe_batch.status();
+      return nullptr;
+    }
+    auto batch = maybe_batch.ValueOrDie();
+    int64_t num_rows = batch->num_rows();
+    if (skip >= num_rows) {
+      skip -= num_rows;
+      continue;
+    }
+    int64_t length = num_rows - skip;
+    if (remain > 0 && length > remain) {
+      length = remain;
+    }
+    if (skip == 0 && length == num_rows) {
+      batches.emplace_back(std::move(batch));
+    } else {
+      batches.emplace_back(batch->Slice(skip, length));
+    }
+    skip = 0;
+    if (remain > 0) {
+      remain -= length;
+    }
+  }
+
+  auto maybe_table = arrow::Table::FromRecordBatches(reader_->schema(), batches);
+  if (!maybe_table.ok()) {
+    LOG(ERROR) << "Convert record batches to table failed, "
+               << maybe_table.status();
+    return nullptr;
+  }
+  std::shared_ptr<arrow::Table> table = maybe_table.ValueOrDie();
+  this->offset = offset + table->num_rows();
+  return std::make_shared<primihub::Dataset>(table, this->driver_);
+}
+
+int IPCCursor::writeBatches(std::shared_ptr<arrow::RecordBatchReader> reader) {
+  // other cursors may still map the file, write a new one and rename it
+  // into place instead of truncating the mapped pages
+  close();
+  std::string tmp_path = this->filePath + ".tmp";
+  auto result = arrow::io::FileOutputStream::Open(tmp_path);
+  if (!result.ok()) {
+    LOG(ERROR) << "Open file " << tmp_path << " failed.";
+    return -1;
+  }
+  auto stream = result.ValueOrDie();
+  auto maybe_writer = arrow::ipc::MakeFileWriter(stream, reader->schema());
+  if (!maybe_writer.ok()) {
+    LOG(ERROR) << "Create arrow file writer failed, " << maybe_writer.status();
+    return -1;
+  }
+  auto writer = maybe_writer.ValueOrDie();
+  arrow::Status status;
+  while (status.ok()) {
+    std::shared_ptr<arrow::RecordBatch> batch;
+    status = reader->ReadNext(&batch);
+    if (!status.ok() || batch == nullptr) {
+      break;
+    }
+    status = writer->WriteRecordBatch(*batch);
+  }
+  if (status.ok()) {
+    status = writer->Close();
+  }
+  if (status.ok()) {
+    status = stream->Close();
+  }
+  if (!status.ok()) {
+    LOG(ERROR) << "Write content to arrow file failed, " << status;
+    remove(tmp_path.c_str());
+    return -2;
+  }
+  if (rename(tmp_path.c_str(), this->filePath.c_str()) != 0) {
+    LOG(ERROR) << "Rename " << tmp_path << " to " << filePath << " failed.";
+    remove(tmp_path.c_str());
+    return -2;
+  }
+  return 0;
+}
+
+int IPCCursor::write(std::shared_ptr<primihub::Dataset> dataset) {
+  auto table = std::get<std::shared_ptr<arrow::Table>>(dataset->data);
+  return writeBatches(std::make_shared<arrow::TableBatchReader>(*table));
+}
+
+// ======== IPC Driver implementation ========
+
+IPCDriver::IPCDriver(const std::string &nodelet_addr)
+    : DataDriver(nodelet_addr) {
+  driver_type = "ARROW";
+}
+
+std::shared_ptr<Cursor> &IPCDriver::read(const std::string &filePath) {
+  return this->initCursor(filePath);
+}
+
+std::shared_ptr<Cursor> &IPCDriver::initCursor(const std::string &filePath) {
+  filePath_ = filePath;
+  this->cursor = std::make_shared<IPCCursor>(filePath, shared_from_this());
+  return getCursor();
+}
+
+std::string IPCDriver::getDataURL() const { return filePath_; };
+
+} // namespace primihub
@@ -0,0 +1,79 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#ifndef SRC_PRIMIHUB_DATA_STORE_IPC_IPC_DRIVER_H_
+#define SRC_PRIMIHUB_DATA_STORE_IPC_IPC_DRIVER_H_
+
+#include <arrow/record_batch.h>
+#include <arrow/table.h>
+#include <arrow/ipc/reader.h>
+
+#include "src/primihub/data_store/dataset.h"
+#include "src/primihub/data_store/driver.h"
+
+namespace primihub {
+class IPCDriver;
+
+// Arrow IPC file (feather v2). The file is memory mapped and the arrays
+// point straight into the mapping, so reading copies no data. Only the
+// projected columns are loaded, and read(offset, limit) skips the record
+// batches outside of the requested rows.
+class IPCCursor : public Cursor {
+public:
+  IPCCursor(std::string filePath, std::shared_ptr<IPCDriver> driver);
+  ~IPCCursor();
+  std::shared_ptr<primihub::Dataset> read() override;
+  // read at most limit rows starting from row offset, limit < 0 means
+  // read until the end of file.
+  std::shared_ptr<primihub::Dataset> read(int64_t offset, int64_t limit) override;
+  // return a reader which yields the record batches one by one.
+  std::shared_ptr<arrow::RecordBatchReader> readBatches() override;
+  int write(std::shared_ptr<primihub::Dataset> dataset) override;
+  // every batch of reader is written as soon as it is read.
+  int writeBatches(std::shared_ptr<arrow::RecordBatchReader> reader) override;
+  void close() override;
+
+  // empty means all columns
+  void setColumns(const std::vector<std::string>& columns) { columns_ = columns; }
+
+private:
+  int open();
+
+  std::string filePath;
+  std::vector<std::string> columns_;
+  unsigned long long offset = 0;
+  std::shared_ptr<arrow::io::RandomAccessFile> file_{nullptr};
+  std::shared_ptr<arrow::ipc::RecordBatchFileReader> reader_{nullptr};
+  std::shared_ptr<IPCDriver> driver_;
+};
+
+class IPCDriver : public DataDriver,
+                  public std::enable_shared_from_this<IPCDriver> {
+public:
+  explicit IPCDriver(const std::string &nodelet_addr);
+  ~IPCDriver() {}
+
+  std::shared_ptr<Cursor> &read(const std::string &filePath) override;
+  std::shared_ptr<Cursor> &initCursor(const std::string &filePath) override;
+  std::string getDataURL() const override;
+
+private:
+  std::string filePath_;
+};
+
+} // namespace primihub
+
+#endif // SRC_PRIMIHUB_DATA_STORE_IPC_IPC_DRIVER_H_
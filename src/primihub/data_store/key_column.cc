@@ -0,0 +1,156 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "src/primihub/data_store/key_column.h"
+
+#include <arrow/api.h>
+#include <arrow/compute/api.h>
+#include <arrow/util/bit_util.h>
+#include <glog/logging.h>
+
+#include "src/primihub/data_store/factory.h"
+
+namespace primihub {
+namespace {
+template <typename IndexType>
+std::shared_ptr<arrow::ChunkedArray> selectByIndex(
+    const std::shared_ptr<arrow::ChunkedArray>& column,
+    const std::vector<IndexType>& indices, bool complement) {
+  if (column == nullptr) {
+    return nullptr;
+  }
+  int64_t length = column->length();
+  auto maybe_bitmap = arrow::AllocateEmptyBitmap(length);
+  if (!maybe_bitmap.ok()) {
+    LOG(ERROR) << "allocate selection bitmap failed, " << maybe_bitmap.status();
+    return nullptr;
+  }
+  std::shared_ptr<arrow::Buffer> bitmap = maybe_bitmap.MoveValueUnsafe();
+  uint8_t* bits = bitmap->mutable_data();
+  for (auto index : indices) {
+    auto pos = static_cast<int64_t>(index);
+    if (pos < 0 || pos >= length) {
+      LOG(WARNING) << "index " << pos << " out of range " << length;
+      continue;
+    }
+    arrow::BitUtil::SetBit(bits, pos);
+  }
+  if (complement) {
+    int64_t num_bytes = arrow::BitUtil::BytesForBits(length);
+    for (int64_t i = 0; i < num_bytes; i++) {
+      bits[i] = ~bits[i];
+    }
+  }
+  auto mask = std::make_shared<arrow::BooleanArray>(length, bitmap);
+  auto result = arrow::compute::Filter(column, mask);
+  if (!result.ok()) {
+    LOG(ERROR) << "filter key column failed, " << result.status();
+    return nullptr;
+  }
+  return result.ValueOrDie().chunked_array();
+}
+}  // namespace
+
+int64_t KeyColumn::load(const std::string& driver_name,
+                        const std::string& data_url,
+                        int col_index, int64_t max_num) {
+  std::string nodeaddr("localhost");  // TODO
+  auto driver = DataDirverFactory::getDriver(driver_name, nodeaddr);
+  if (driver == nullptr) {
+    LOG(ERROR) << "create " << driver_name << " driver failed";
+    return -1;
+  }
+  auto& cursor = driver->read(data_url);
+  std::shared_ptr<Dataset> ds{nullptr};
+  if (max_num > 0) {
+    ds = cursor->read(0, max_num);
+  }
+  // not every driver supports paging, fall back to read all
+  if (ds == nullptr) {
+    ds = cursor->read();
+  }
+  if (ds == nullptr) {
+    LOG(ERROR) << "read dataset " << data_url << " failed";
+    return -1;
+  }
+  auto table = std::get<std::shared_ptr<arrow::Table>>(ds->data);
+  return load(table, col_index, max_num);
+}
+
+int64_t KeyColumn::load(const std::shared_ptr<arrow::Table>& table,
+                        int col_index, int64_t max_num) {
+  clear();
+  int num_col = table->num_columns();
+  if (col_index < 0 || col_index >= num_col) {
+    LOG(ERROR) << "dataset column number is smaller than key column index, "
+               << "dataset total column: " << num_col << " "
+               << "expected column index: " << col_index;
+    return -1;
+  }
+  auto column = table->column(col_index);
+  if (max_num > 0 && column->length() > max_num) {
+    column = column->Slice(0, max_num);
+  }
+  // numeric keys are inferred as number type by csv reader,
+  // convert them to their string representation.
+  if (column->type()->id() != arrow::Type::STRING) {
+    auto result = arrow::compute::Cast(column, arrow::utf8());
+    if (!result.ok()) {
+      LOG(ERROR) << "convert key column from " << column->type()->ToString()
+                 << " to string failed, " << result.status();
+      return -1;
+    }
+    column = result.ValueOrDie().chunked_array();
+  }
+
+  values_.reserve(column->length());
+  for (const auto& chunk : column->chunks()) {
+    auto array = std::static_pointer_cast<arrow::StringArray>(chunk);
+    for (int64_t i = 0; i < array->length(); i++) {
+      auto value = array->GetView(i);
+      values_.emplace_back(value.data(), value.size());
+    }
+  }
+  column_ = std::move(column);
+  VLOG(5) << "loaded key column records: " << values_.size();
+  return size();
+}
+
+std::vector<std::string> KeyColumn::toStrings() const {
+  std::vector<std::string> strs;
+  strs.reserve(values_.size());
+  for (const auto& value : values_) {
+    strs.emplace_back(value);
+  }
+  return strs;
+}
+
+std::shared_ptr<arrow::ChunkedArray> KeyColumn::select(
+    const std::vector<int64_t>& indices, bool complement) const {
+  return selectByIndex(column_, indices, complement);
+}
+
+std::shared_ptr<arrow::ChunkedArray> KeyColumn::select(
+    const std::vector<uint64_t>& indices, bool complement) const {
+  return selectByIndex(column_, indices, complement);
+}
+
+void KeyColumn::clear() {
+  values_.clear();
+  column_.reset();
+}
+
+}  // namespace primihub
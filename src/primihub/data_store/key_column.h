@@ -0,0 +1,71 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#ifndef SRC_PRIMIHUB_DATA_STORE_KEY_COLUMN_H_
+#define SRC_PRIMIHUB_DATA_STORE_KEY_COLUMN_H_
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <arrow/chunked_array.h>
+#include <arrow/table.h>
+
+namespace primihub {
+
+// Key column of a dataset used by PSI/PIR tasks as set elements.
+// All chunks of the column are walked and each value is exposed as a
+// std::string_view into the arrow buffers, the column is kept alive here
+// so no per-row std::string is allocated while loading.
+class KeyColumn {
+ public:
+  KeyColumn() = default;
+
+  // load column 'col_index' of the dataset located by 'data_url' with the
+  // driver named 'driver_name' (CSV, SQLITE), keep at most max_num values
+  // if max_num > 0. return number of loaded values or -1 on error.
+  int64_t load(const std::string& driver_name, const std::string& data_url,
+               int col_index, int64_t max_num = 0);
+  int64_t load(const std::shared_ptr<arrow::Table>& table, int col_index,
+               int64_t max_num = 0);
+
+  int64_t size() const { return static_cast<int64_t>(values_.size()); }
+  bool empty() const { return values_.empty(); }
+  std::string_view operator[](int64_t index) const { return values_[index]; }
+  const std::vector<std::string_view>& values() const { return values_; }
+  // string typed column which all the views point into.
+  const std::shared_ptr<arrow::ChunkedArray>& column() const { return column_; }
+
+  // copy values out for consumers which only accept std::string
+  std::vector<std::string> toStrings() const;
+  // select values at 'indices' in their original row order, or the values
+  // not at 'indices' if complement is true. a bitmap over all rows is
+  // built and applied by arrow filter, so it is linear in column length.
+  std::shared_ptr<arrow::ChunkedArray> select(const std::vector<int64_t>& indices,
+                                              bool complement = false) const;
+  std::shared_ptr<arrow::ChunkedArray> select(const std::vector<uint64_t>& indices,
+                                              bool complement = false) const;
+  void clear();
+
+ private:
+  std::shared_ptr<arrow::ChunkedArray> column_{nullptr};
+  std::vector<std::string_view> values_;
+};
+
+}  // namespace primihub
+
+#endif  // SRC_PRIMIHUB_DATA_STORE_KEY_COLUMN_H_
@@ -0,0 +1,279 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "src/primihub/data_store/parquet/parquet_driver.h"
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <glog/logging.h>
+#include <parquet/arrow/writer.h>
+
+#include <cstdio>
+
+namespace primihub {
+namespace {
+// parquet's batch reader refers to the file reader, keep it alive as well.
+class ParquetBatchReader : public arrow::RecordBatchReader {
+ public:
+  ParquetBatchReader(std::shared_ptr<parquet::arrow::FileReader> file_reader,
+                     std::unique_ptr<arrow::RecordBatchReader> reader)
+      : file_reader_(std::move(file_reader)), reader_(std::move(reader)) {}
+
+  std::shared_ptr<arrow::Schema> schema() const override {
+    return reader_->schema();
+  }
+
+  arrow::Status ReadNext(std::shared_ptr<arrow::RecordBatch>* batch) override {
+    return reader_->ReadNext(batch);
+  }
+
+ private:
+  std::shared_ptr<parquet::arrow::FileReader> file_reader_;
+  std::unique_ptr<arrow::RecordBatchReader> reader_;
+};
+}  // namespace
+
+// parquet cursor implementation
+ParquetCursor::ParquetCursor(std::string filePath,
+                             std::shared_ptr<ParquetDriver> driver) {
+  this->filePath = filePath;
+  this->driver_ = driver;
+}
+
+ParquetCursor::~ParquetCursor() { this->close(); }
+
+void ParquetCursor::close() { reader_.reset(); }
+
+int ParquetCursor::open() {
+  if (reader_ != nullptr) {
+    return 0;
+  }
+  auto maybe_file = arrow::io::MemoryMappedFile::Open(filePath, arrow::io::FileMode::READ);
+  if (!maybe_file.ok()) {
+    LOG(ERROR) << "Failed to map file: " << filePath << ", " << maybe_file.status();
+    return -1;
+  }
+  std::unique_ptr<parquet::arrow::FileReader> reader;
+  auto status = parquet::arrow::OpenFile(maybe_file.ValueOrDie(),
+                                         arrow::default_memory_pool(), &reader);
+  if (!status.ok()) {
+    LOG(ERROR) << "Open parquet file " << filePath << " failed, " << status;
+    return -1;
+  }
+  reader_ = std::move(reader);
+  return 0;
+}
+
+int ParquetCursor::columnIndices(std::vector<int>* indices) {
+  std::shared_ptr<arrow::Schema> schema;
+  auto status = reader_->GetSchema(&schema);
+  if (!status.ok()) {
+    LOG(ERROR) << "Read schema of " << filePath << " failed, " << status;
+    return -1;
+  }
+  indices->clear();
+  if (columns_.empty()) {
+    for (int i = 0; i < schema->num_fields(); i++) {
+      indices->push_back(i);
+    }
+    return 0;
+  }
+  // columns are flat, field index is the same as leaf column index
+  for (const auto& name : columns_) {
+    int index = schema->GetFieldIndex(name);
+    if (index < 0) {
+      LOG(ERROR) << "Column " << name << " not found in " << filePath;
+      return -1;
+    }
+    indices->push_back(index);
+  }
+  return 0;
+}
+
+std::shared_ptr<arrow::RecordBatchReader> ParquetCursor::readBatches() {
+  std::vector<int> column_indices;
+  if (open() || columnIndices(&column_indices)) {
+    return nullptr;
+  }
+  std::vector<int> row_groups(reader_->num_row_groups());
+  for (size_t i = 0; i < row_groups.size(); i++) {
+    row_groups[i] = i;
+  }
+  std::unique_ptr<arrow::RecordBatchReader> reader;
+  auto status = reader_->GetRecordBatchReader(row_groups, column_indices, &reader);
+  if (!status.ok()) {
+    LOG(ERROR) << "Create batch reader for " << filePath << " failed, " << status;
+    return nullptr;
+  }
+  return std::make_shared<ParquetBatchReader>(reader_, std::move(reader));
+}
+
+// read all data from parquet file
+std::shared_ptr<primihub::Dataset> ParquetCursor::read() {
+  return this->read(0, -1);
+}
+
+std::shared_ptr<primihub::Dataset> ParquetCursor::read(int64_t offset,
+                                                       int64_t limit) {
+  std::vector<int> column_indices;
+  if (open() || columnIndices(&column_indices)) {
+    return nullptr;  // TODO throw exception
+  }
+  // select the row groups overlapping [offset, offset + limit) from the
+  // file footer, the others are never decoded.
+  offset = offset > 0 ? offset : 0;
+  auto metadata = reader_->parquet_reader()->metadata();
+  std::vector<int> row_groups;
+  int64_t first_row = -1;
+  int64_t row_start = 0;
+  for (int i = 0; i < metadata->num_row_groups(); i++) {
+    int64_t num_rows = metadata->RowGroup(i)->num_rows();
+    int64_t row_end = row_start + num_rows;
+    if (limit >= 0 && row_start >= offset + limit) {
+      break;
+    }
+    if (row_end > offset) {
+      if (first_row < 0) {
+        first_row = row_start;
+      }
+      row_groups.push_back(i);
+    }
+    row_start = row_end;
+  }
+  bool empty = row_groups.empty();
+  if (empty && metadata->num_row_groups() > 0) {
+    // decode the first row group only for its schema
+    row_groups.push_back(0);
+  }
+
+  std::shared_ptr<arrow::Table> table;
+  auto status = reader_->ReadRowGroups(row_groups, column_indices, &table);
+  if (!status.ok()) {
+    LOG(ERROR) << "Read parquet file " << filePath << " failed, " << status;
+    return nullptr;
+  }
+  if (empty) {
+    table = table->Slice(0, 0);
+  } else if (first_row >= 0) {
+    int64_t skip = offset - first_row;
+    int64_t length = table->num_rows() - skip;
+    if (limit >= 0 && length > limit) {
+      length = limit;
+    }
+    if (skip > 0 || length < table->num_rows()) {
+      table = table->Slice(skip, length);
+    }
+  }
+  this->offset = offset + table->num_rows();
+  return std::make_shared<primihub::Dataset>(table, this->driver_);
+}
+
+int ParquetCursor::writeBatches(std::shared_ptr<arrow::RecordBatchReader> reader) {
+  // other cursors may still map the file, write a new one and rename it
+  // into place instead of truncating the mapped pages
+  close();
+  std::string tmp_path = this->filePath + ".tmp";
+  auto result = arrow::io::FileOutputStream::Open(tmp_path);
+  if (!result.ok()) {
+    LOG(ERROR) << "Open file " << tmp_path << " failed.";
+    return -1;
+  }
+  auto stream = result.ValueOrDie();
+  std::unique_ptr<parquet::arrow::FileWriter> writer;
+  auto status = parquet::arrow::FileWriter::Open(*reader->schema(),
+      arrow::default_memory_pool(), stream,
+      parquet::default_writer_properties(),
+      parquet::default_arrow_writer_properties(), &writer);
+  while (status.ok()) {
+    std::shared_ptr<arrow::RecordBatch> batch;
+    status = reader->ReadNext(&batch);
+    if (!status.ok() || batch == nullptr) {
+      break;
+    }
+    auto maybe_table = arrow::Table::FromRecordBatches({batch});
+    if (!maybe_table.ok()) {
+      status = maybe_table.status();
+      break;
+    }
+    status = writer->WriteTable(*maybe_table.ValueOrDie(), row_group_size_);
+  }
+  if (status.ok()) {
+    status = writer->Close();
+  }
+  if (status.ok()) {
+    status = stream->Close();
+  }
+  if (!status.ok()) {
+    LOG(ERROR) << "Write content to parquet file failed, " << status;
+    remove(tmp_path.c_str());
+    return -2;
+  }
+  if (rename(tmp_path.c_str(), this->filePath.c_str()) != 0) {
+    LOG(ERROR) << "Rename " << tmp_path << " to " << filePath << " failed.";
+    remove(tmp_path.c_str());
+    return -2;
+  }
+  return 0;
+}
+
+int ParquetCursor::write(std::shared_ptr<primihub::Dataset> dataset) {
+  close();
+  std::string tmp_path = this->filePath + ".tmp";
+  auto result = arrow::io::FileOutputStream::Open(tmp_path);
+  if (!result.ok()) {
+    LOG(ERROR) << "Open file " << tmp_path << " failed.";
+    return -1;
+  }
+  auto stream = result.ValueOrDie();
+  auto table = std::get<std::shared_ptr<arrow::Table>>(dataset->data);
+  auto status = parquet::arrow::WriteTable(*table, arrow::default_memory_pool(),
+                                           stream, row_group_size_);
+  if (status.ok()) {
+    status = stream->Close();
+  }
+  if (!status.ok()) {
+    LOG(ERROR) << "Write content to parquet file failed, " << status;
+    remove(tmp_path.c_str());
+    return -2;
+  }
+  if (rename(tmp_path.c_str(), this->filePath.c_str()) != 0) {
+    LOG(ERROR) << "Rename " << tmp_path << " to " << filePath << " failed.";
+    remove(tmp_path.c_str());
+    return -2;
+  }
+  return 0;
+}
+
+// ======== Parquet Driver implementation ========
+
+ParquetDriver::ParquetDriver(const std::string &nodelet_addr)
+    : DataDriver(nodelet_addr) {
+  driver_type = "PARQUET";
+}
+
+std::shared_ptr<Cursor> &ParquetDriver::read(const std::string &filePath) {
+  return this->initCursor(filePath);
+}
+
+std::shared_ptr<Cursor> &ParquetDriver::initCursor(const std::string &filePath) {
+  filePath_ = filePath;
+  this->cursor = std::make_shared<ParquetCursor>(filePath, shared_from_this());
+  return getCursor();
+}
+
+std::string ParquetDriver::getDataURL() const { return filePath_; };
+
+} // namespace primihub
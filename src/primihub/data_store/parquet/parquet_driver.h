@@ -0,0 +1,82 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#ifndef SRC_PRIMIHUB_DATA_STORE_PARQUET_PARQUET_DRIVER_H_
+#define SRC_PRIMIHUB_DATA_STORE_PARQUET_PARQUET_DRIVER_H_
+
+#include <arrow/record_batch.h>
+#include <arrow/table.h>
+#include <parquet/arrow/reader.h>
+
+#include "src/primihub/data_store/dataset.h"
+#include "src/primihub/data_store/driver.h"
+
+namespace primihub {
+class ParquetDriver;
+
+// The file is memory mapped and decoded by parquet's arrow reader. Only
+// the projected columns are decoded, and read(offset, limit) decodes only
+// the row groups overlapping the requested rows.
+class ParquetCursor : public Cursor {
+public:
+  static constexpr int64_t kDefaultRowGroupSize = 1 << 16;
+
+  ParquetCursor(std::string filePath, std::shared_ptr<ParquetDriver> driver);
+  ~ParquetCursor();
+  std::shared_ptr<primihub::Dataset> read() override;
+  // read at most limit rows starting from row offset, limit < 0 means
+  // read until the end of file.
+  std::shared_ptr<primihub::Dataset> read(int64_t offset, int64_t limit) override;
+  // return a reader which yields the row groups one by one.
+  std::shared_ptr<arrow::RecordBatchReader> readBatches() override;
+  int write(std::shared_ptr<primihub::Dataset> dataset) override;
+  // every batch of reader is written as soon as it is read.
+  int writeBatches(std::shared_ptr<arrow::RecordBatchReader> reader) override;
+  void close() override;
+
+  // empty means all columns
+  void setColumns(const std::vector<std::string>& columns) { columns_ = columns; }
+  void setRowGroupSize(int64_t row_group_size) { row_group_size_ = row_group_size; }
+
+private:
+  int open();
+  int columnIndices(std::vector<int>* indices);
+
+  std::string filePath;
+  std::vector<std::string> columns_;
+  int64_t row_group_size_{kDefaultRowGroupSize};
+  unsigned long long offset = 0;
+  std::shared_ptr<parquet::arrow::FileReader> reader_{nullptr};
+  std::shared_ptr<ParquetDriver> driver_;
+};
+
+class ParquetDriver : public DataDriver,
+                      public std::enable_shared_from_this<ParquetDriver> {
+public:
+  explicit ParquetDriver(const std::string &nodelet_addr);
+  ~ParquetDriver() {}
+
+  std::shared_ptr<Cursor> &read(const std::string &filePath) override;
+  std::shared_ptr<Cursor> &initCursor(const std::string &filePath) override;
+  std::string getDataURL() const override;
+
+private:
+  std::string filePath_;
+};
+
+} // namespace primihub
+
+#endif // SRC_PRIMIHUB_DATA_STORE_PARQUET_PARQUET_DRIVER_H_
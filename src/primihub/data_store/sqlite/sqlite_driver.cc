@@ -21,142 +21,447 @@
 #include "src/primihub/util/util.h"
 
 #include <arrow/api.h>
-// #include <arrow/csv/api.h>
-// #include <arrow/csv/writer.h>
-// #include <arrow/filesystem/localfs.h>
 #include <arrow/io/api.h>
+#include <algorithm>
+#include <cctype>
 #include <fstream>
-#include <glog/logging.h>
 #include <iostream>
 
 namespace primihub {
+namespace {
+enum class ColumnKind : int8_t {
+  INT64 = 0,
+  DOUBLE,
+  STRING,
+  BINARY,
+};
 
-// sqlite cursor implementation
-SQLiteCursor::SQLiteCursor(const std::string& sql, std::shared_ptr<SQLiteDriver> driver) {
-  this->sql_ = sql;
-  this->driver_ = driver;
+// map the declared column type to arrow following sqlite's affinity rules
+ColumnKind ColumnKindOf(const std::string& declared_type) {
+  std::string type_name = declared_type;
+  std::transform(type_name.begin(), type_name.end(), type_name.begin(),
+                 [](unsigned char c) { return std::toupper(c); });
+  if (type_name.find("INT") != std::string::npos) {
+    return ColumnKind::INT64;
+  }
+  if (type_name.find("REAL") != std::string::npos ||
+      type_name.find("FLOA") != std::string::npos ||
+      type_name.find("DOUB") != std::string::npos) {
+    return ColumnKind::DOUBLE;
+  }
+  if (type_name.find("BLOB") != std::string::npos) {
+    return ColumnKind::BINARY;
+  }
+  return ColumnKind::STRING;
 }
 
-SQLiteCursor::~SQLiteCursor() { this->close(); }
+std::shared_ptr<arrow::DataType> ArrowTypeOf(ColumnKind kind) {
+  switch (kind) {
+  case ColumnKind::INT64:
+    return arrow::int64();
+  case ColumnKind::DOUBLE:
+    return arrow::float64();
+  case ColumnKind::BINARY:
+    return arrow::binary();
+  default:
+    return arrow::utf8();
+  }
+}
 
-void SQLiteCursor::close() {}
+std::string SqlTypeOf(const arrow::DataType& type) {
+  if (arrow::is_integer(type.id()) || type.id() == arrow::Type::BOOL) {
+    return "INTEGER";
+  }
+  if (arrow::is_floating(type.id())) {
+    return "REAL";
+  }
+  if (type.id() == arrow::Type::BINARY) {
+    return "BLOB";
+  }
+  return "TEXT";
+}
 
-// read all data from csv file
-std::shared_ptr<primihub::Dataset>
-SQLiteCursor::read() {
-  VLOG(5) << "sql_sql_sql_sql_: " << sql_;
-  std::shared_ptr<arrow::Table> table{nullptr};
-  auto& db_connector = this->driver_->getDBConnector();
-  SQLite::Statement sql_query(*db_connector, sql_);
-  std::map<std::string, std::unique_ptr<TypeContainer>> query_result;
-  std::vector<std::tuple<std::string, sql_type_t>> col_metas;
-  bool col_meta_collected{false};
-  std::vector<std::shared_ptr<arrow::Field>> result_schema_filed;
-  while (sql_query.executeStep()) {
-    for (size_t i = 0; i < sql_query.getColumnCount(); i++) {
-      std::string col_type = sql_query.getColumnDeclaredType(i);
-      auto col_name = sql_query.getColumnOriginName(i);
-      if (!col_meta_collected) {
-        sql_type_t sql_col_type = this->get_sql_type_by_type_name(col_type);
-        switch (sql_col_type) {
-        case sql_type_t::STRING:
-          col_metas.emplace_back(std::make_tuple(col_name, sql_col_type));
-          result_schema_filed.push_back(arrow::field(col_name, arrow::binary()));
-          break;
-        case sql_type_t::INT:
-          col_metas.emplace_back(std::make_tuple(col_name, sql_col_type));
-          result_schema_filed.push_back(arrow::field(col_name, arrow::int64()));
-          break;
-        case sql_type_t::DOUBLE:
-          col_metas.emplace_back(std::make_tuple(col_name, sql_col_type));
-          result_schema_filed.push_back(arrow::field(col_name, arrow::float64()));
-          break;
-        default:
-          break;
-        }
+std::string QuoteIdentifier(const std::string& name) {
+  std::string quoted = "\"";
+  for (char c : name) {
+    if (c == '"') {
+      quoted.push_back('"');
+    }
+    quoted.push_back(c);
+  }
+  quoted.push_back('"');
+  return quoted;
+}
+
+// Pulls rows from a prepared statement, batch_size rows per RecordBatch.
+class SQLiteBatchReader : public arrow::RecordBatchReader {
+ public:
+  SQLiteBatchReader(std::shared_ptr<SQLiteDriver> driver,
+                    std::unique_ptr<SQLite::Statement> stmt, int64_t batch_size)
+      : driver_(std::move(driver)), stmt_(std::move(stmt)),
+        batch_size_(batch_size) {}
+
+  // resolve the result schema once, before the first row is stepped
+  arrow::Status Init() {
+    std::vector<std::shared_ptr<arrow::Field>> fields;
+    int col_count = stmt_->getColumnCount();
+    for (int i = 0; i < col_count; i++) {
+      std::string col_name = stmt_->getColumnName(i);
+      std::string declared_type;
+      try {
+        declared_type = stmt_->getColumnDeclaredType(i);
+      } catch (std::exception& e) {
+        // expression column, sqlite has no declared type for it
+        VLOG(5) << "no declared type for column " << col_name << ", use TEXT";
       }
-      // process data
-      switch (std::get<1>(col_metas[i])) {
-      case sql_type_t::STRING: {
-        std::string col_value = sql_query.getColumn(i);
-        if (query_result.find(col_name) == query_result.end()) {
-          query_result[col_name] = std::make_unique<TypeContainer>(sql_type_t::STRING);
+      auto kind = ColumnKindOf(declared_type);
+      kinds_.push_back(kind);
+      fields.push_back(arrow::field(col_name, ArrowTypeOf(kind)));
+      std::unique_ptr<arrow::ArrayBuilder> builder;
+      RETURN_NOT_OK(arrow::MakeBuilder(arrow::default_memory_pool(),
+                                       fields.back()->type(), &builder));
+      builders_.push_back(std::move(builder));
+    }
+    schema_ = arrow::schema(fields);
+    return arrow::Status::OK();
+  }
+
+  std::shared_ptr<arrow::Schema> schema() const override { return schema_; }
+
+  arrow::Status ReadNext(std::shared_ptr<arrow::RecordBatch>* batch) override {
+    *batch = nullptr;
+    if (done_) {
+      return arrow::Status::OK();
+    }
+    int64_t num_rows = 0;
+    try {
+      while (num_rows < batch_size_) {
+        if (!stmt_->executeStep()) {
+          done_ = true;
+          break;
         }
-        query_result[col_name]->string_values.emplace_back(std::move(col_value));
-      }
-      break;
-      case sql_type_t::INT: {
-        int64_t col_value = sql_query.getColumn(i);
-        if (query_result.find(col_name) == query_result.end()) {
-          query_result[col_name] = std::make_unique<TypeContainer>(sql_type_t::INT);
+        for (size_t i = 0; i < kinds_.size(); i++) {
+          RETURN_NOT_OK(appendCell(i));
         }
-        query_result[col_name]->int_values.emplace_back(col_value);
+        num_rows++;
       }
-      break;
-      case sql_type_t::DOUBLE: {
-        double col_value = sql_query.getColumn(i);
-        if (query_result.find(col_name) == query_result.end()) {
-          query_result[col_name] = std::make_unique<TypeContainer>(sql_type_t::DOUBLE);
+    } catch (std::exception& e) {
+      return arrow::Status::IOError("sqlite read failed: ", e.what());
+    }
+    if (num_rows == 0) {
+      return arrow::Status::OK();
+    }
+    std::vector<std::shared_ptr<arrow::Array>> columns(builders_.size());
+    for (size_t i = 0; i < builders_.size(); i++) {
+      RETURN_NOT_OK(builders_[i]->Finish(&columns[i]));
+    }
+    *batch = arrow::RecordBatch::Make(schema_, num_rows, std::move(columns));
+    return arrow::Status::OK();
+  }
 
-        }
-        query_result[col_name]->double_values.emplace_back(col_value);
-      }
-      break;
-      default:
-      LOG(ERROR) << "unknown sql type: ";
-      break;
-      }
+ private:
+  arrow::Status appendCell(size_t i) {
+    SQLite::Column column = stmt_->getColumn(static_cast<int>(i));
+    auto* builder = builders_[i].get();
+    if (column.isNull()) {
+      return builder->AppendNull();
     }
-    col_meta_collected = true;
-  }
-  // convert data to arrow array
-  std::vector<std::shared_ptr<arrow::Array>> array_data;
-  for (size_t i = 0; i < col_metas.size(); i++) {
-    auto& col_name = std::get<0>(col_metas[i]);
-    auto& col_type = std::get<1>(col_metas[i]);
-    switch (col_type) {
-    case sql_type_t::STRING:{
-      arrow::StringBuilder builder;
-      auto& string_values = query_result[col_name]->string_values;
-      std::shared_ptr<arrow::Array> array;
-      builder.AppendValues(string_values);
-      builder.Finish(&array);
-      array_data.push_back(std::move(array));
+    switch (kinds_[i]) {
+    case ColumnKind::INT64:
+      return static_cast<arrow::Int64Builder*>(builder)->Append(column.getInt64());
+    case ColumnKind::DOUBLE:
+      return static_cast<arrow::DoubleBuilder*>(builder)->Append(column.getDouble());
+    case ColumnKind::BINARY:
+      return static_cast<arrow::BinaryBuilder*>(builder)->Append(
+          static_cast<const uint8_t*>(column.getBlob()), column.getBytes());
+    default: {
+      // getText must be called before getBytes for the size of the text
+      const char* text = column.getText();
+      return static_cast<arrow::StringBuilder*>(builder)->Append(
+          text, column.getBytes());
     }
-    break;
-    case sql_type_t::INT:{
-      arrow::NumericBuilder<arrow::Int64Type> builder;
-      auto& int_values = query_result[col_name]->int_values;
-      std::shared_ptr<arrow::Array> array;
-      builder.AppendValues(int_values);
-      builder.Finish(&array);
-      array_data.push_back(std::move(array));
     }
+  }
+
+  std::shared_ptr<SQLiteDriver> driver_;  // keeps the db connection alive
+  std::unique_ptr<SQLite::Statement> stmt_;
+  int64_t batch_size_;
+  bool done_{false};
+  std::shared_ptr<arrow::Schema> schema_;
+  std::vector<ColumnKind> kinds_;
+  std::vector<std::unique_ptr<arrow::ArrayBuilder>> builders_;
+};
+
+void BindCell(SQLite::Statement* stmt, int index, const arrow::Array& array,
+              int64_t row) {
+  if (array.IsNull(row)) {
+    stmt->bind(index);
+    return;
+  }
+  switch (array.type_id()) {
+  case arrow::Type::BOOL:
+    stmt->bind(index, static_cast<int32_t>(
+        static_cast<const arrow::BooleanArray&>(array).Value(row)));
     break;
-    case sql_type_t::DOUBLE: {
-      arrow::NumericBuilder<arrow::DoubleType> builder;
-      auto& double_values = query_result[col_name]->double_values;
-      std::shared_ptr<arrow::Array> array;
-      builder.AppendValues(double_values);
-      builder.Finish(&array);
-      array_data.push_back(std::move(array));
-    }
+  case arrow::Type::INT8:
+    stmt->bind(index, static_cast<int32_t>(
+        static_cast<const arrow::Int8Array&>(array).Value(row)));
+    break;
+  case arrow::Type::INT16:
+    stmt->bind(index, static_cast<int32_t>(
+        static_cast<const arrow::Int16Array&>(array).Value(row)));
     break;
+  case arrow::Type::INT32:
+    stmt->bind(index, static_cast<const arrow::Int32Array&>(array).Value(row));
+    break;
+  case arrow::Type::INT64:
+    stmt->bind(index, static_cast<int64_t>(
+        static_cast<const arrow::Int64Array&>(array).Value(row)));
+    break;
+  case arrow::Type::UINT8:
+    stmt->bind(index, static_cast<int32_t>(
+        static_cast<const arrow::UInt8Array&>(array).Value(row)));
+    break;
+  case arrow::Type::UINT16:
+    stmt->bind(index, static_cast<int32_t>(
+        static_cast<const arrow::UInt16Array&>(array).Value(row)));
+    break;
+  case arrow::Type::UINT32:
+    stmt->bind(index, static_cast<const arrow::UInt32Array&>(array).Value(row));
+    break;
+  case arrow::Type::UINT64:
+    stmt->bind(index, static_cast<int64_t>(
+        static_cast<const arrow::UInt64Array&>(array).Value(row)));
+    break;
+  case arrow::Type::FLOAT:
+    stmt->bind(index, static_cast<double>(
+        static_cast<const arrow::FloatArray&>(array).Value(row)));
+    break;
+  case arrow::Type::DOUBLE:
+    stmt->bind(index, static_cast<const arrow::DoubleArray&>(array).Value(row));
+    break;
+  case arrow::Type::STRING:
+    stmt->bind(index,
+        static_cast<const arrow::StringArray&>(array).GetString(row));
+    break;
+  case arrow::Type::BINARY: {
+    auto view = static_cast<const arrow::BinaryArray&>(array).GetView(row);
+    stmt->bind(index, view.data(), static_cast<int>(view.size()));
+    break;
+  }
+  default: {
+    auto scalar = array.GetScalar(row);
+    stmt->bind(index, scalar.ok() ? scalar.ValueOrDie()->ToString() : "");
+    break;
+  }
+  }
+}
+
+// sqlite limits the number of host parameters of one statement
+constexpr int64_t kMaxBindParams = 999;
+constexpr int64_t kMaxRowsPerInsert = 256;
+
+int WriteTable(SQLite::Database* db, const std::string& table_name,
+               const std::shared_ptr<arrow::Table>& table) {
+  auto schema = table->schema();
+  int64_t num_cols = schema->num_fields();
+  if (num_cols == 0) {
+    LOG(ERROR) << "no column to write into table " << table_name;
+    return -1;
+  }
+  std::string create_sql = "CREATE TABLE IF NOT EXISTS " +
+                           QuoteIdentifier(table_name) + " (";
+  std::string col_list;
+  for (int64_t i = 0; i < num_cols; i++) {
+    const auto& field = schema->field(i);
+    if (i != 0) {
+      create_sql.append(", ");
+      col_list.append(", ");
     }
+    create_sql.append(QuoteIdentifier(field->name())).append(" ")
+              .append(SqlTypeOf(*field->type()));
+    col_list.append(QuoteIdentifier(field->name()));
   }
-  auto schema = std::make_shared<arrow::Schema>(result_schema_filed);
-  table = arrow::Table::Make(schema, array_data);
-  auto dataset = std::make_shared<primihub::Dataset>(table, this->driver_);
-  return dataset;
+  create_sql.append(")");
+
+  // several rows per INSERT and one transaction for the whole table
+  int64_t rows_per_insert =
+      std::max<int64_t>(1, std::min(kMaxRowsPerInsert, kMaxBindParams / num_cols));
+  auto make_insert_sql = [&](int64_t num_rows) {
+    std::string row_values = "(";
+    for (int64_t i = 0; i < num_cols; i++) {
+      row_values.append(i == 0 ? "?" : ", ?");
+    }
+    row_values.append(")");
+    std::string sql = "INSERT INTO " + QuoteIdentifier(table_name) +
+                      " (" + col_list + ") VALUES ";
+    for (int64_t i = 0; i < num_rows; i++) {
+      if (i != 0) {
+        sql.append(", ");
+      }
+      sql.append(row_values);
+    }
+    return sql;
+  };
+
+  try {
+    db->exec(create_sql);
+    SQLite::Transaction transaction(*db);
+    auto total_rows = table->num_rows();
+    int64_t written_rows = 0;
+    std::unique_ptr<SQLite::Statement> insert_stmt;
+    int64_t stmt_rows = 0;
+    int64_t rows_in_stmt = 0;
+    arrow::TableBatchReader batch_reader(*table);
+    std::shared_ptr<arrow::RecordBatch> batch;
+    while (true) {
+      auto status = batch_reader.ReadNext(&batch);
+      if (!status.ok()) {
+        LOG(ERROR) << "read table failed: " << status;
+        return -1;
+      }
+      if (batch == nullptr) {
+        break;
+      }
+      for (int64_t row = 0; row < batch->num_rows(); row++) {
+        if (rows_in_stmt == 0) {
+          int64_t rows = std::min(rows_per_insert, total_rows - written_rows);
+          if (rows != stmt_rows) {
+            insert_stmt = std::make_unique<SQLite::Statement>(
+                *db, make_insert_sql(rows));
+            stmt_rows = rows;
+          }
+        }
+        for (int64_t col = 0; col < num_cols; col++) {
+          int index = static_cast<int>(rows_in_stmt * num_cols + col + 1);
+          BindCell(insert_stmt.get(), index, *batch->column(col), row);
+        }
+        rows_in_stmt++;
+        written_rows++;
+        if (rows_in_stmt == stmt_rows) {
+          insert_stmt->exec();
+          insert_stmt->reset();
+          rows_in_stmt = 0;
+        }
+      }
+    }
+    transaction.commit();
+    VLOG(5) << "write " << written_rows << " rows into table " << table_name;
+  } catch (std::exception& e) {
+    LOG(ERROR) << "write table " << table_name << " failed: " << e.what();
+    return -1;
+  }
+  return 0;
+}
+}  // namespace
+
+// sqlite cursor implementation
+SQLiteCursor::SQLiteCursor(const std::string& table_name,
+                           const std::string& query_condition,
+                           std::shared_ptr<SQLiteDriver> driver)
+    : table_name_(table_name), query_condition_(query_condition),
+      driver_(driver) {}
+
+SQLiteCursor::~SQLiteCursor() { this->close(); }
+
+void SQLiteCursor::close() {}
+
+std::string SQLiteCursor::buildQuery() const {
+  std::string sql_str = "select ";
+  if (!columns_.empty()) {
+    for (size_t i = 0; i < columns_.size(); i++) {
+      if (i != 0) {
+        sql_str.append(", ");
+      }
+      sql_str.append(QuoteIdentifier(columns_[i]));
+    }
+  } else if (query_condition_.find_first_not_of(" \t") != std::string::npos) {
+    sql_str.append(query_condition_);
+  } else {
+    sql_str.append("*");
+  }
+  sql_str.append(" from ").append(QuoteIdentifier(table_name_))
+         .append(" limit ? offset ?");
+  return sql_str;
+}
+
+std::shared_ptr<arrow::RecordBatchReader>
+SQLiteCursor::makeBatchReader(int64_t offset, int64_t limit) {
+  auto& db_connector = this->driver_->getDBConnector();
+  if (db_connector == nullptr) {
+    LOG(ERROR) << "sqlite db is not opened";
+    return nullptr;
+  }
+  auto sql_str = buildQuery();
+  VLOG(5) << "query sql: " << sql_str << " limit: " << limit
+          << " offset: " << offset;
+  std::shared_ptr<SQLiteBatchReader> reader;
+  try {
+    auto stmt = std::make_unique<SQLite::Statement>(*db_connector, sql_str);
+    // a negative limit means no limit in sqlite
+    stmt->bind(1, static_cast<int64_t>(limit < 0 ? -1 : limit));
+    stmt->bind(2, static_cast<int64_t>(offset > 0 ? offset : 0));
+    reader = std::make_shared<SQLiteBatchReader>(this->driver_,
+                                                 std::move(stmt), batch_size_);
+  } catch (std::exception& e) {
+    LOG(ERROR) << "prepare sql: " << sql_str << " failed: " << e.what();
+    return nullptr;
+  }
+  auto status = reader->Init();
+  if (!status.ok()) {
+    LOG(ERROR) << "resolve schema of " << table_name_ << " failed, " << status;
+    return nullptr;
+  }
+  return reader;
+}
+
+std::shared_ptr<arrow::RecordBatchReader> SQLiteCursor::readBatches() {
+  return makeBatchReader(0, -1);
+}
+
+// read all data from table
+std::shared_ptr<primihub::Dataset> SQLiteCursor::read() {
+  return this->read(0, -1);
 }
 
 std::shared_ptr<primihub::Dataset>
 SQLiteCursor::read(int64_t offset, int64_t limit) {
-  return nullptr;
+  auto reader = makeBatchReader(offset, limit);
+  if (reader == nullptr) {
+    return nullptr;
+  }
+  std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
+  while (true) {
+    std::shared_ptr<arrow::RecordBatch> batch;
+    auto status = reader->ReadNext(&batch);
+    if (!status.ok()) {
+      LOG(ERROR) << "read table " << table_name_ << " failed, " << status;
+      return nullptr;
+    }
+    if (batch == nullptr) {
+      break;
+    }
+    batches.push_back(std::move(batch));
+  }
+  auto maybe_table = arrow::Table::FromRecordBatches(reader->schema(), batches);
+  if (!maybe_table.ok()) {
+    LOG(ERROR) << "Convert record batches to table failed, "
+               << maybe_table.status();
+    return nullptr;
+  }
+  std::shared_ptr<arrow::Table> table = maybe_table.ValueOrDie();
+  this->offset = offset + table->num_rows();
+  auto dataset = std::make_shared<primihub::Dataset>(table, this->driver_);
+  return dataset;
 }
 
 int SQLiteCursor::write(std::shared_ptr<primihub::Dataset> dataset) {
-
+  if (!std::holds_alternative<std::shared_ptr<arrow::Table>>(dataset->data)) {
+    LOG(ERROR) << "Only table dataset can be written to sqlite.";
+    return -1;
+  }
+  auto table = std::get<std::shared_ptr<arrow::Table>>(dataset->data);
+  return this->driver_->write(table, table_name_);
 }
 
 // ======== SQLite Driver implementation ========
@@ -166,44 +471,52 @@ SQLiteDriver::SQLiteDriver(const std::string &nodelet_addr) : DataDriver(nodelet
 }
 
 std::shared_ptr<Cursor>& SQLiteDriver::read(const std::string& conn_str) {
-   return this->initCursor(conn_str);
+  return this->openCursor(conn_str, SQLite::OPEN_READONLY);
 }
 
 std::shared_ptr<Cursor>& SQLiteDriver::initCursor(const std::string& conn_str) {
-  // parse conn_str
-  VLOG(5) << "conn_strconn_strconn_strconn_str: " << conn_str;
+  return this->openCursor(conn_str, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+}
+
+std::shared_ptr<Cursor>& SQLiteDriver::openCursor(const std::string& conn_str,
+                                                  int open_flags) {
+  // parse conn_str, format: sqlite#db_path#table_name#[query_condition]
+  VLOG(5) << "conn_str: " << conn_str;
   conn_info_ = conn_str;
   std::vector<std::string> conn_info;
   char sep_operator = '#';
   str_split(conn_str, &conn_info, sep_operator);
-  auto driver_type = conn_info[CONN_FIELDS::DRIVER_TYPE];
+  if (conn_info.size() <= CONN_FIELDS::TABLE_NAME) {
+    LOG(ERROR) << "invalid sqlite connection string: " << conn_str;
+    return getCursor();  // nullptr
+  }
   auto& db_path = conn_info[CONN_FIELDS::DB_PATH];
   db_path_ = db_path;
   std::string& table_name = conn_info[CONN_FIELDS::TABLE_NAME];
   VLOG(5) << "db_path: " << db_path << " table_name: " << table_name << " conn_info size: " << conn_info.size();
   try {
-    this->db_connector = std::make_unique<SQLite::Database>(db_path);
+    this->db_connector = std::make_unique<SQLite::Database>(db_path, open_flags);
   } catch (std::exception& e) {
     LOG(ERROR) << "create cursor failed: " << e.what();
     return getCursor();  // nullptr
   }
 
-  std::string& query_condition = conn_info[CONN_FIELDS::QUERY_CONDITION];
-  std::string sql_str = "select ";
-  if (query_condition.empty()) {
-    sql_str.append("*");
-  } else {
-    sql_str.append(query_condition);
+  std::string query_condition;
+  if (conn_info.size() > CONN_FIELDS::QUERY_CONDITION) {
+    query_condition = conn_info[CONN_FIELDS::QUERY_CONDITION];
   }
-  sql_str.append(" from ").append(table_name);
-  VLOG(5) << "query sql: " << sql_str;
-  this->cursor = std::make_shared<SQLiteCursor>(sql_str, shared_from_this());
+  this->cursor = std::make_shared<SQLiteCursor>(table_name, query_condition,
+                                                shared_from_this());
   return getCursor();
 }
 
 // write data to specifiy table
 int SQLiteDriver::write(std::shared_ptr<arrow::Table> table, const std::string& table_name) {
-  return 0;
+  if (this->db_connector == nullptr) {
+    LOG(ERROR) << "sqlite db is not opened";
+    return -1;
+  }
+  return WriteTable(this->db_connector.get(), table_name, table);
 }
 
 std::string SQLiteDriver::getDataURL() const { return conn_info_; };
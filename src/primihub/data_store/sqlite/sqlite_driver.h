@@ -17,6 +17,9 @@
 #ifndef SRC_PRIMIHUB_DATA_STORE_SQLITE_SQLITE_DRIVER_H_
 #define SRC_PRIMIHUB_DATA_STORE_SQLITE_SQLITE_DRIVER_H_
 
+#include <arrow/record_batch.h>
+#include <arrow/table.h>
+
 #include "src/primihub/data_store/dataset.h"
 #include "src/primihub/data_store/driver.h"
 #include "SQLiteCpp/SQLiteCpp.h"
@@ -24,50 +27,44 @@
 namespace primihub {
 class SQLiteDriver;
 
+// Rows are appended straight into typed arrow builders and emitted as
+// RecordBatches of at most batch_size rows. Column projection, offset and
+// limit are part of the generated SQL, so sqlite skips the rows itself.
 class SQLiteCursor : public Cursor {
 public:
-  SQLiteCursor(const std::string& sql, std::shared_ptr<SQLiteDriver> driver);
+  static constexpr int64_t kDefaultBatchSize = 1 << 16;
+
+  // query_condition is the select list of the connection string, it's
+  // passed to sqlite as is, empty selects all columns
+  SQLiteCursor(const std::string& table_name,
+               const std::string& query_condition,
+               std::shared_ptr<SQLiteDriver> driver);
   ~SQLiteCursor();
   std::shared_ptr<primihub::Dataset> read() override;
-  std::shared_ptr<primihub::Dataset> read(int64_t offset, int64_t limit);
+  // read at most limit rows starting from row offset, limit < 0 means
+  // read until the last row.
+  std::shared_ptr<primihub::Dataset> read(int64_t offset, int64_t limit) override;
+  std::shared_ptr<arrow::RecordBatchReader> readBatches() override;
+  // append the dataset to the table, the table is created if not exists.
   int write(std::shared_ptr<primihub::Dataset> dataset) override;
   void close() override;
 
- protected:
-  enum class sql_type_t : int8_t{
-    STRING = 0,
-    INT,
-    INT64,
-    FLOAT,
-    DOUBLE,
-    UNKONW,
-  };
-  struct TypeContainer {
-    explicit TypeContainer(sql_type_t col_type) : col_type_(col_type) {}
-    std::vector<std::string> string_values;
-    std::vector<float> float_values;
-    std::vector<double> double_values;
-    std::vector<int64_t> int_values;
-    sql_type_t col_type_;
-  };
-  sql_type_t get_sql_type_by_type_name(const std::string& type_name) {
-    auto it = sql_type_name_to_enum.find(type_name);
-    if (it != sql_type_name_to_enum.end()) {
-      return it->second;
-    }
-    return sql_type_t::UNKONW;
-  }
+  void setBatchSize(int64_t batch_size) { batch_size_ = batch_size; }
+  // project plain column names, replaces the query condition, empty means
+  // all columns
+  void setColumns(const std::vector<std::string>& columns) { columns_ = columns; }
 
  private:
-  std::string sql_;
+  std::shared_ptr<arrow::RecordBatchReader> makeBatchReader(int64_t offset,
+                                                            int64_t limit);
+  std::string buildQuery() const;
+
+  std::string table_name_;
+  std::string query_condition_;
+  std::vector<std::string> columns_;
+  int64_t batch_size_{kDefaultBatchSize};
   unsigned long long offset = 0;
   std::shared_ptr<SQLiteDriver> driver_{nullptr};
-  std::map<std::string, sql_type_t> sql_type_name_to_enum {
-    {"TEXT", sql_type_t::STRING},
-    {"INTEGER", sql_type_t::INT64},
-    {"INT", sql_type_t::INT},
-    {"DOUBLE", sql_type_t::DOUBLE},
-  };
 };
 
 class SQLiteDriver : public DataDriver, public std::enable_shared_from_this<SQLiteDriver> {
@@ -76,11 +73,14 @@ public:
   SQLiteDriver(const std::string &nodelet_addr);
   ~SQLiteDriver() = default;
 
+  // the db is opened read only
   std::shared_ptr<Cursor>& read(const std::string& conn_str) override;
+  // the db is opened read write and created if not exists, for write
   std::shared_ptr<Cursor>& initCursor(const std::string& conn_str) override;
   std::string getDataURL() const override;
   std::unique_ptr<SQLite::Database>& getDBConnector() { return db_connector; }
-  // write data to specifiy db table
+  // write data to specifiy db table, rows are inserted in batches with one
+  // prepared statement inside a single transaction.
   int write(std::shared_ptr<arrow::Table> table, const std::string& table_name);
  protected:
   enum CONN_FIELDS {
@@ -90,11 +90,11 @@ public:
     QUERY_CONDITION,
   };
  private:
+  std::shared_ptr<Cursor>& openCursor(const std::string& conn_str, int open_flags);
+
   std::string conn_info_;
   std::string db_path_;
   std::unique_ptr<SQLite::Database> db_connector{nullptr};
-
-
 };
 
 } // namespace primihub
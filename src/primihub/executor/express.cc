@@ -1,4 +1,5 @@
 #include <glog/logging.h>
+#include <algorithm>
 #include <sstream>
 
 #include "src/primihub/executor/express.h"
@@ -350,6 +351,7 @@ template <Decimal Dbit> MPCExpressExecutor<Dbit>::FeedDict::~FeedDict() {
 template <Decimal Dbit> MPCExpressExecutor<Dbit>::MPCExpressExecutor() {
   col_config_ = nullptr;
   mpc_op_ = nullptr;
+  cancelled_ = false;
   feed_dict_ = nullptr;
 }
 
@@ -677,13 +679,25 @@ void MPCExpressExecutor<Dbit>::initMPCRuntime(uint32_t party_id,
     prev_name = "12";
   }
 
-  mpc_op_ = new MPCOperator(party_id, next_name, prev_name);
+  {
+    std::lock_guard<std::mutex> lck(mpc_op_mtx_);
+    mpc_op_ = new MPCOperator(party_id, next_name, prev_name);
+    if (cancelled_)
+      mpc_op_->cancel();
+  }
   mpc_op_->setup(next_ip, prev_ip, next_port, prev_port);
 
   party_id_ = party_id;
   return;
 }
 
+template <Decimal Dbit> void MPCExpressExecutor<Dbit>::cancelMPCRuntime(void) {
+  std::lock_guard<std::mutex> lck(mpc_op_mtx_);
+  cancelled_ = true;
+  if (mpc_op_ != nullptr)
+    mpc_op_->cancel();
+}
+
 template <Decimal Dbit>
 void MPCExpressExecutor<Dbit>::constructI64Matrix(TokenValue &val,
                                                   i64Matrix &m) {
@@ -702,19 +716,6 @@ void MPCExpressExecutor<Dbit>::constructI64Matrix(TokenValue &val,
   return;
 }
 
-template <Decimal Dbit>
-void MPCExpressExecutor<Dbit>::createI64Shares(TokenValue &val,
-                                               si64Matrix &sh_val) {
-  if (val.type == 4) {
-    mpc_op_->createShares(sh_val);
-  } else {
-    i64Matrix m;
-    constructI64Matrix(val, m);
-    mpc_op_->createShares(m, sh_val);
-  }
-  return;
-}
-
 template <Decimal Dbit>
 void MPCExpressExecutor<Dbit>::constructFP64Matrix(TokenValue &val,
                                                    eMatrix<double> &m) {
@@ -732,19 +733,6 @@ void MPCExpressExecutor<Dbit>::constructFP64Matrix(TokenValue &val,
   return;
 }
 
-template <Decimal Dbit>
-void MPCExpressExecutor<Dbit>::createFP64Shares(TokenValue &val,
-                                                sf64Matrix<Dbit> &sh_val) {
-  if (val.type == 4) {
-    mpc_op_->createShares<Dbit>(sh_val);
-  } else {
-    eMatrix<double> m;
-    constructFP64Matrix(val, m);
-    mpc_op_->createShares<Dbit>(m, sh_val);
-  }
-  return;
-}
-
 template <Decimal Dbit>
 void MPCExpressExecutor<Dbit>::createTokenValue(sf64Matrix<Dbit> *m,
                                                 TokenValue &v) {
@@ -825,49 +813,24 @@ int MPCExpressExecutor<Dbit>::createTokenValue(const std::string &token,
   return 0;
 }
 
+// Columns are shared before any operator runs, so an operand of the
+// following methods is either a share or a constant. The result of add and
+// sub is written into the result share directly, without temporary matrix.
 template <Decimal Dbit>
 void MPCExpressExecutor<Dbit>::runMPCAddFP64(TokenValue &val1, TokenValue &val2,
                                              TokenValue &res) {
-  sf64Matrix<Dbit> sh_val1, sh_val2;
-  sf64Matrix<Dbit> *p_sh_val1 = nullptr;
-  sf64Matrix<Dbit> *p_sh_val2 = nullptr;
-  f64<Dbit> constfixed;
-
-  uint32_t val_count = feed_dict_->getColumnValuesCount();
-
-  if (val1.type == 0 || val1.type == 4) {
-    sh_val1.resize(val_count, 1);
-    createFP64Shares(val1, sh_val1);
-    p_sh_val1 = &sh_val1;
-  } else if (val1.type == 2) {
-    constfixed = val1.val_union.fp64_val;
-  } else {
-    p_sh_val1 = val1.val_union.sh_fp64_m;
-  }
-
-  if (val2.type == 0 || val2.type == 4) {
-    sh_val2.resize(val_count, 1);
-    createFP64Shares(val2, sh_val2);
-    p_sh_val2 = &sh_val2;
-  } else if (val2.type == 2) {
-    constfixed = val2.val_union.fp64_val;
-  } else {
-    p_sh_val2 = val2.val_union.sh_fp64_m;
-  }
-
-  sf64Matrix<Dbit> *sh_res = new sf64Matrix<Dbit>(val_count, 1);
+  sf64Matrix<Dbit> *sh_res = newFP64Share();
   if (val1.type != 2 && val2.type != 2) {
-    std::vector<sf64Matrix<Dbit>> sh_val_vec;
-    sh_val_vec.emplace_back(*p_sh_val1);
-    sh_val_vec.emplace_back(*p_sh_val2);
-
-    *sh_res = mpc_op_->MPC_Add(sh_val_vec);
+    sf64Matrix<Dbit> &sh_val1 = *val1.val_union.sh_fp64_m;
+    sf64Matrix<Dbit> &sh_val2 = *val2.val_union.sh_fp64_m;
+    (*sh_res)[0] = sh_val1[0] + sh_val2[0];
+    (*sh_res)[1] = sh_val1[1] + sh_val2[1];
+  } else if (val1.type == 2) {
+    f64<Dbit> constfixed = val1.val_union.fp64_val;
+    *sh_res = mpc_op_->MPC_Add_Const(constfixed, *val2.val_union.sh_fp64_m);
   } else {
-    if (val1.type == 2) {
-      *sh_res = mpc_op_->MPC_Add_Const(constfixed, *p_sh_val2);
-    } else {
-      *sh_res = mpc_op_->MPC_Add_Const(constfixed, *p_sh_val1);
-    }
+    f64<Dbit> constfixed = val2.val_union.fp64_val;
+    *sh_res = mpc_op_->MPC_Add_Const(constfixed, *val1.val_union.sh_fp64_m);
   }
   createTokenValue(sh_res, res);
 }
@@ -875,43 +838,18 @@ void MPCExpressExecutor<Dbit>::runMPCAddFP64(TokenValue &val1, TokenValue &val2,
 template <Decimal Dbit>
 void MPCExpressExecutor<Dbit>::runMPCAddI64(TokenValue &val1, TokenValue &val2,
                                             TokenValue &res) {
-  si64Matrix sh_val1, sh_val2;
-  si64Matrix *p_sh_val1 = nullptr;
-  si64Matrix *p_sh_val2 = nullptr;
-  i64 constInt;
-  uint32_t val_count = feed_dict_->getColumnValuesCount();
-
-  if (val1.type == 1 || val1.type == 4) {
-    sh_val1.resize(val_count, 1);
-    createI64Shares(val1, sh_val1);
-    p_sh_val1 = &sh_val1;
-  } else if (val1.type == 3) {
-    constInt = val1.val_union.i64_val;
-  } else {
-    p_sh_val1 = val1.val_union.sh_i64_m;
-  }
-
-  if (val2.type == 1 || val2.type == 4) {
-    sh_val2.resize(val_count, 1);
-    createI64Shares(val2, sh_val2);
-    p_sh_val2 = &sh_val2;
-  } else if (val2.type == 3) {
-    constInt = val2.val_union.i64_val;
-  } else {
-    p_sh_val2 = val2.val_union.sh_i64_m;
-  }
-
-  si64Matrix *sh_res = new si64Matrix(val_count, 1);
+  si64Matrix *sh_res = newI64Share();
   if (val1.type != 3 && val2.type != 3) {
-    std::vector<si64Matrix> sh_val_vec;
-    sh_val_vec.emplace_back(*p_sh_val1);
-    sh_val_vec.emplace_back(*p_sh_val2);
-    *sh_res = mpc_op_->MPC_Add(sh_val_vec);
+    si64Matrix &sh_val1 = *val1.val_union.sh_i64_m;
+    si64Matrix &sh_val2 = *val2.val_union.sh_i64_m;
+    (*sh_res)[0] = sh_val1[0] + sh_val2[0];
+    (*sh_res)[1] = sh_val1[1] + sh_val2[1];
+  } else if (val1.type == 3) {
+    *sh_res = mpc_op_->MPC_Add_Const(val1.val_union.i64_val,
+                                     *val2.val_union.sh_i64_m);
   } else {
-    if (val1.type == 3)
-      *sh_res = mpc_op_->MPC_Add_Const(constInt, *p_sh_val2);
-    else
-      *sh_res = mpc_op_->MPC_Add_Const(constInt, *p_sh_val1);
+    *sh_res = mpc_op_->MPC_Add_Const(val2.val_union.i64_val,
+                                     *val1.val_union.sh_i64_m);
   }
   createTokenValue(sh_res, res);
 }
@@ -919,43 +857,20 @@ void MPCExpressExecutor<Dbit>::runMPCAddI64(TokenValue &val1, TokenValue &val2,
 template <Decimal Dbit>
 void MPCExpressExecutor<Dbit>::runMPCSubFP64(TokenValue &val1, TokenValue &val2,
                                              TokenValue &res) {
-  sf64Matrix<Dbit> sh_val1, sh_val2;
-  sf64Matrix<Dbit> *p_sh_val1 = nullptr;
-  sf64Matrix<Dbit> *p_sh_val2 = nullptr;
-  f64<Dbit> constfixed;
-
-  uint32_t val_count = feed_dict_->getColumnValuesCount();
-
-  if (val1.type == 0 || val1.type == 4) {
-    sh_val1.resize(val_count, 1);
-    createFP64Shares(val1, sh_val1);
-    p_sh_val1 = &sh_val1;
-  } else if (val1.type == 2) {
-    constfixed = val1.val_union.fp64_val;
-  } else {
-    p_sh_val1 = val1.val_union.sh_fp64_m;
-  }
-
-  if (val2.type == 0 || val2.type == 4) {
-    sh_val2.resize(val_count, 1);
-    createFP64Shares(val2, sh_val2);
-    p_sh_val2 = &sh_val2;
-  } else if (val2.type == 2) {
-    constfixed = val2.val_union.fp64_val;
-  } else {
-    p_sh_val2 = val2.val_union.sh_fp64_m;
-  }
-
-  sf64Matrix<Dbit> *sh_res = new sf64Matrix<Dbit>(val_count, 1);
+  sf64Matrix<Dbit> *sh_res = newFP64Share();
   if (val1.type != 2 && val2.type != 2) {
-    std::vector<sf64Matrix<Dbit>> sh_val_vec;
-    sh_val_vec.emplace_back(*p_sh_val2);
-    *sh_res = mpc_op_->MPC_Sub(*p_sh_val1, sh_val_vec);
+    sf64Matrix<Dbit> &sh_val1 = *val1.val_union.sh_fp64_m;
+    sf64Matrix<Dbit> &sh_val2 = *val2.val_union.sh_fp64_m;
+    (*sh_res)[0] = sh_val1[0] - sh_val2[0];
+    (*sh_res)[1] = sh_val1[1] - sh_val2[1];
+  } else if (val1.type == 2) {
+    f64<Dbit> constfixed = val1.val_union.fp64_val;
+    *sh_res = mpc_op_->MPC_Sub_Const(constfixed, *val2.val_union.sh_fp64_m,
+                                     false);
   } else {
-    if (val1.type == 2) {
-      *sh_res = mpc_op_->MPC_Sub_Const(constfixed, *p_sh_val2, false);
-    } else
-      *sh_res = mpc_op_->MPC_Sub_Const(constfixed, *p_sh_val1, true);
+    f64<Dbit> constfixed = val2.val_union.fp64_val;
+    *sh_res = mpc_op_->MPC_Sub_Const(constfixed, *val1.val_union.sh_fp64_m,
+                                     true);
   }
   createTokenValue(sh_res, res);
 }
@@ -963,87 +878,18 @@ void MPCExpressExecutor<Dbit>::runMPCSubFP64(TokenValue &val1, TokenValue &val2,
 template <Decimal Dbit>
 void MPCExpressExecutor<Dbit>::runMPCSubI64(TokenValue &val1, TokenValue &val2,
                                             TokenValue &res) {
-  si64Matrix sh_val1, sh_val2;
-  si64Matrix *p_sh_val1 = nullptr;
-  si64Matrix *p_sh_val2 = nullptr;
-  i64 constInt;
-
-  uint32_t val_count = feed_dict_->getColumnValuesCount();
-
-  if (val1.type == 1 || val1.type == 4) {
-    sh_val1.resize(val_count, 1);
-    createI64Shares(val1, sh_val1);
-    p_sh_val1 = &sh_val1;
-  } else if (val1.type == 3) {
-    constInt = val1.val_union.i64_val;
-  } else {
-    p_sh_val1 = val1.val_union.sh_i64_m;
-  }
-
-  if (val2.type == 1 || val2.type == 4) {
-    sh_val2.resize(val_count, 1);
-    createI64Shares(val2, sh_val2);
-    p_sh_val2 = &sh_val2;
-  } else if (val2.type == 3) {
-    constInt = val2.val_union.i64_val;
-  } else {
-    p_sh_val2 = val2.val_union.sh_i64_m;
-  }
-
-  si64Matrix *sh_res = new si64Matrix(val_count, 1);
+  si64Matrix *sh_res = newI64Share();
   if (val1.type != 3 && val2.type != 3) {
-    std::vector<si64Matrix> sh_val_vec;
-    sh_val_vec.emplace_back(*p_sh_val2);
-    *sh_res = mpc_op_->MPC_Sub(*p_sh_val1, sh_val_vec);
-  } else {
-    if (val1.type == 3)
-      *sh_res = mpc_op_->MPC_Sub_Const(constInt, *p_sh_val2, false);
-    else {
-      // LOG(INFO) << constInt;
-      // LOG(INFO) << (*p_sh_val1)[0](0, 0);
-      // LOG(INFO) << (*p_sh_val1)[1](0, 0);
-      *sh_res = mpc_op_->MPC_Sub_Const(constInt, *p_sh_val1, true);
-    }
-  }
-  createTokenValue(sh_res, res);
-}
-
-template <Decimal Dbit>
-void MPCExpressExecutor<Dbit>::runMPCMulFP64(TokenValue &val1, TokenValue &val2,
-                                             TokenValue &res) {
-  sf64Matrix<Dbit> sh_val1, sh_val2;
-  sf64Matrix<Dbit> *p_sh_val1 = nullptr;
-  sf64Matrix<Dbit> *p_sh_val2 = nullptr;
-  f64<Dbit> constfixed;
-  uint32_t val_count = feed_dict_->getColumnValuesCount();
-
-  if (val1.type == 0 || val1.type == 4) {
-    sh_val1.resize(val_count, 1);
-    createFP64Shares(val1, sh_val1);
-    p_sh_val1 = &sh_val1;
-  } else if (val1.type == 2) {
-    constfixed = val1.val_union.fp64_val;
-  } else {
-    p_sh_val1 = val1.val_union.sh_fp64_m;
-  }
-
-  if (val2.type == 0 || val2.type == 4) {
-    sh_val2.resize(val_count, 1);
-    createFP64Shares(val2, sh_val2);
-    p_sh_val2 = &sh_val2;
-  } else if (val2.type == 2) {
-    constfixed = val2.val_union.fp64_val;
-  } else {
-    p_sh_val2 = val2.val_union.sh_fp64_m;
-  }
-  sf64Matrix<Dbit> *sh_res = new sf64Matrix<Dbit>(val_count, 1);
-  if (val1.type != 2 && val2.type != 2) {
-    *sh_res = mpc_op_->MPC_Dot_Mul(*p_sh_val1, *p_sh_val2);
+    si64Matrix &sh_val1 = *val1.val_union.sh_i64_m;
+    si64Matrix &sh_val2 = *val2.val_union.sh_i64_m;
+    (*sh_res)[0] = sh_val1[0] - sh_val2[0];
+    (*sh_res)[1] = sh_val1[1] - sh_val2[1];
+  } else if (val1.type == 3) {
+    *sh_res = mpc_op_->MPC_Sub_Const(val1.val_union.i64_val,
+                                     *val2.val_union.sh_i64_m, false);
   } else {
-    if (val1.type == 2)
-      *sh_res = mpc_op_->MPC_Mul_Const(constfixed, *p_sh_val2);
-    else
-      *sh_res = mpc_op_->MPC_Mul_Const(constfixed, *p_sh_val1);
+    *sh_res = mpc_op_->MPC_Sub_Const(val2.val_union.i64_val,
+                                     *val1.val_union.sh_i64_m, true);
   }
   createTokenValue(sh_res, res);
 }
@@ -1051,63 +897,29 @@ void MPCExpressExecutor<Dbit>::runMPCMulFP64(TokenValue &val1, TokenValue &val2,
 template <Decimal Dbit>
 void MPCExpressExecutor<Dbit>::runMPCMulI64(TokenValue &val1, TokenValue &val2,
                                             TokenValue &res) {
-  si64Matrix sh_val1, sh_val2;
-  si64Matrix *p_sh_val1 = nullptr;
-  si64Matrix *p_sh_val2 = nullptr;
-  i64 constInt;
-
-  uint32_t val_count = feed_dict_->getColumnValuesCount();
-
-  if (val1.type == 1 || val1.type == 4) {
-    sh_val1.resize(val_count, 1);
-    createI64Shares(val1, sh_val1);
-    p_sh_val1 = &sh_val1;
-  } else if (val1.type == 3) {
-    constInt = val1.val_union.i64_val;
-  } else {
-    p_sh_val1 = val1.val_union.sh_i64_m;
-  }
-
-  if (val2.type == 1 || val2.type == 4) {
-    sh_val2.resize(val_count, 1);
-    createI64Shares(val2, sh_val2);
-    p_sh_val2 = &sh_val2;
-  } else if (val2.type == 3) {
-    constInt = val2.val_union.i64_val;
-  } else {
-    p_sh_val2 = val2.val_union.sh_i64_m;
-  }
-
-  si64Matrix *sh_res = new si64Matrix(val_count, 1);
+  si64Matrix *sh_res = newI64Share();
   if (val1.type != 3 && val2.type != 3) {
-    *sh_res = mpc_op_->MPC_Dot_Mul(*p_sh_val1, *p_sh_val2);
+    *sh_res = mpc_op_->MPC_Dot_Mul(*val1.val_union.sh_i64_m,
+                                   *val2.val_union.sh_i64_m);
+  } else if (val1.type == 3) {
+    *sh_res = mpc_op_->MPC_Mul_Const(val1.val_union.i64_val,
+                                     *val2.val_union.sh_i64_m);
   } else {
-    if (val1.type == 3)
-      *sh_res = mpc_op_->MPC_Mul_Const(constInt, *p_sh_val2);
-    else
-      *sh_res = mpc_op_->MPC_Mul_Const(constInt, *p_sh_val1);
+    *sh_res = mpc_op_->MPC_Mul_Const(val2.val_union.i64_val,
+                                     *val1.val_union.sh_i64_m);
   }
-
   createTokenValue(sh_res, res);
 }
 
 template <Decimal Dbit>
 void MPCExpressExecutor<Dbit>::runMPCDivFP64(TokenValue &val1, TokenValue &val2,
                                              TokenValue &res) {
-
-  sf64Matrix<Dbit> sh_val1, sh_val2;
+  sf64Matrix<Dbit> sh_val1;
   sf64Matrix<Dbit> *p_sh_val1 = nullptr;
-  sf64Matrix<Dbit> *p_sh_val2 = nullptr;
-  f64<Dbit> constfixed;
-  eMatrix<double> temp_f64Matrix;
-
   uint32_t val_count = feed_dict_->getColumnValuesCount();
-  if (val1.type == 0 || val1.type == 4) {
-    sh_val1.resize(val_count, 1);
-    createFP64Shares(val1, sh_val1);
-    p_sh_val1 = &sh_val1;
-  } else if (val1.type == 2) {
-    temp_f64Matrix.resize(val_count, 1);
+
+  if (val1.type == 2) {
+    eMatrix<double> temp_f64Matrix(val_count, 1);
     sh_val1.resize(val_count, 1);
     for (u64 i = 0; i < val_count; i++)
       temp_f64Matrix(i, 0) = val1.val_union.fp64_val;
@@ -1120,27 +932,52 @@ void MPCExpressExecutor<Dbit>::runMPCDivFP64(TokenValue &val1, TokenValue &val2,
   } else {
     p_sh_val1 = val1.val_union.sh_fp64_m;
   }
-  if (val2.type == 0 || val2.type == 4) {
-    sh_val2.resize(val_count, 1);
-    createFP64Shares(val2, sh_val2);
-    p_sh_val2 = &sh_val2;
-  } else if (val2.type == 2) {
-    constfixed = val2.val_union.fp64_val;
-  } else {
-    p_sh_val2 = val2.val_union.sh_fp64_m;
+
+  // Divide by a constant is run as multiply by it's reciprocal, see
+  // runMPCLevel.
+  sf64Matrix<Dbit> *sh_res = newFP64Share();
+  *sh_res = mpc_op_->MPC_Div(*p_sh_val1, *val2.val_union.sh_fp64_m);
+  createTokenValue(sh_res, res);
+}
+
+template <Decimal Dbit>
+sf64Matrix<Dbit> *MPCExpressExecutor<Dbit>::newFP64Share(void) {
+  if (!fp64_share_pool_.empty()) {
+    sf64Matrix<Dbit> *m = fp64_share_pool_.back();
+    fp64_share_pool_.pop_back();
+    return m;
   }
-  sf64Matrix<Dbit> *sh_res = new sf64Matrix<Dbit>(val_count, 1);
-  if (val1.type != 2 && val2.type != 2) {
-    *sh_res = mpc_op_->MPC_Div(*p_sh_val1, *p_sh_val2);
-  } else {
-    if (val1.type == 2) {
-      *sh_res = mpc_op_->MPC_Div(*p_sh_val1, *p_sh_val2);
-    } else {
-      constfixed = 1.0 / static_cast<double>(constfixed);
-      *sh_res = mpc_op_->MPC_Mul_Const(constfixed, *p_sh_val1);
-    }
+
+  uint32_t val_count = feed_dict_->getColumnValuesCount();
+  return new sf64Matrix<Dbit>(val_count, 1);
+}
+
+template <Decimal Dbit> si64Matrix *MPCExpressExecutor<Dbit>::newI64Share(void) {
+  if (!i64_share_pool_.empty()) {
+    si64Matrix *m = i64_share_pool_.back();
+    i64_share_pool_.pop_back();
+    return m;
   }
-  createTokenValue(sh_res, res);
+
+  uint32_t val_count = feed_dict_->getColumnValuesCount();
+  return new si64Matrix(val_count, 1);
+}
+
+template <Decimal Dbit>
+void MPCExpressExecutor<Dbit>::releaseShare(const std::string &token) {
+  auto iter = token_val_map_.find(token);
+  if (iter == token_val_map_.end())
+    return;
+
+  // All shares have the same shape, keep the memory for later operators.
+  if (iter->second.type == 5)
+    fp64_share_pool_.emplace_back(iter->second.val_union.sh_fp64_m);
+  else if (iter->second.type == 6)
+    i64_share_pool_.emplace_back(iter->second.val_union.sh_i64_m);
+  else
+    return;
+
+  token_val_map_.erase(iter);
 }
 
 template <Decimal Dbit>
@@ -1171,96 +1008,365 @@ void MPCExpressExecutor<Dbit>::AfterMPCRun(std::stack<std::string> &token_stk,
   val_stk.push(res);
 }
 
-template <Decimal Dbit> int MPCExpressExecutor<Dbit>::runMPCEvaluate(void) {
-  std::stack<std::string> stk1;
-  std::stack<TokenValue> val_stk;
+template <Decimal Dbit>
+bool MPCExpressExecutor<Dbit>::foldConstant(ExprNode &node,
+                                            std::vector<ExprNode> &nodes) {
+  TokenValue &val1 = nodes[node.left].val;
+  TokenValue &val2 = nodes[node.right].val;
+  std::ostringstream ss;
+
+  if (fp64_run_) {
+    if (val1.type != 2 || val2.type != 2)
+      return false;
 
-  while (!suffix_stk_.empty()) {
-    std::string token = suffix_stk_.top();
-    if (token == "+") {
-      std::string a, b;
-      TokenValue val1, val2, res;
-      BeforeMPCRun(stk1, val_stk, val1, val2, a, b);
+    double a = val1.val_union.fp64_val;
+    double b = val2.val_union.fp64_val;
+    double res;
+    if (node.token == "+")
+      res = a + b;
+    else if (node.token == "-")
+      res = a - b;
+    else if (node.token == "*")
+      res = a * b;
+    else if (b != 0)
+      res = a / b;
+    else
+      return false;
 
-      if (fp64_run_) {
-        LOG(INFO) << "Run FP64 Add between '" << a << "' and '" << b << "'.";
-        runMPCAddFP64(val1, val2, res);
-        LOG(INFO) << "Run FP64 Add finish.";
-      } else {
-        LOG(INFO) << "Run I64 Add between '" << a << " and '" << b << "'.";
-        si64Matrix sh_sum;
-        runMPCAddI64(val1, val2, res);
-        LOG(INFO) << "Run I64 Add finish.";
+    node.val.val_union.fp64_val = res;
+    node.val.type = 2;
+    ss.precision(17);
+    ss << res;
+  } else {
+    if (val1.type != 3 || val2.type != 3 || node.token == "/")
+      return false;
+
+    int64_t a = val1.val_union.i64_val;
+    int64_t b = val2.val_union.i64_val;
+    int64_t res;
+    if (node.token == "+")
+      res = a + b;
+    else if (node.token == "-")
+      res = a - b;
+    else
+      res = a * b;
+
+    node.val.val_union.i64_val = res;
+    node.val.type = 3;
+    ss << res;
+  }
+
+  LOG(INFO) << "Fold '" << node.name << "' into constant " << ss.str() << ".";
+  node.token = ss.str();
+  node.name = node.token;
+  node.left = -1;
+  node.right = -1;
+  node.level = 0;
+  return true;
+}
+
+template <Decimal Dbit>
+int MPCExpressExecutor<Dbit>::buildExprGraph(std::vector<ExprNode> &nodes,
+                                             int &root) {
+  std::stack<std::string> suffix_stk = suffix_stk_;
+  std::stack<int> node_stk;
+  // Key of a sub-express to it's node, a sub-express appears more than once
+  // is evaluated only once.
+  std::map<std::string, int> node_index;
+
+  while (!suffix_stk.empty()) {
+    ExprNode node;
+    node.token = suffix_stk.top();
+    suffix_stk.pop();
+    std::string key;
+
+    if (isOperator(node.token)) {
+      if (node_stk.size() < 2) {
+        LOG(ERROR) << "Operator '" << node.token << "' lacks operand.";
+        return -1;
       }
 
-      std::string new_token = "(" + a + "+" + b + ")";
-      AfterMPCRun(stk1, val_stk, new_token, res);
-    } else if (token == "-") {
-      std::string a, b;
-      TokenValue val1, val2, res;
-      BeforeMPCRun(stk1, val_stk, val1, val2, a, b);
+      node.right = node_stk.top();
+      node_stk.pop();
+      node.left = node_stk.top();
+      node_stk.pop();
 
-      if (fp64_run_) {
-        LOG(INFO) << "Run FP64 Sub between '" << a << "' and '" << b << "'.";
-        runMPCSubFP64(val1, val2, res);
-        LOG(INFO) << "Run FP64 Sub finish.";
+      node.name = "(" + nodes[node.left].name + node.token +
+                  nodes[node.right].name + ")";
+      node.level =
+          std::max(nodes[node.left].level, nodes[node.right].level) + 1;
+
+      if (foldConstant(node, nodes)) {
+        key = node.name;
       } else {
-        LOG(INFO) << "Run I64 Sub between '" << a << " and '" << b << "'.";
-        si64Matrix sh_sum;
-        runMPCSubI64(val1, val2, res);
-        LOG(INFO) << "Run I64 Sub finish.";
+        int left = node.left;
+        int right = node.right;
+        if ((node.token == "+" || node.token == "*") && left > right)
+          std::swap(left, right);
+        key = std::to_string(left) + node.token + std::to_string(right);
+      }
+    } else {
+      if (createTokenValue(node.token, node.val)) {
+        LOG(ERROR) << "Construct token value for token '" << node.token
+                   << "' failed.";
+        return -2;
       }
 
-      std::string new_token = "(" + a + "-" + b + ")";
-      AfterMPCRun(stk1, val_stk, new_token, res);
-    } else if (token == "*") {
-      std::string a, b;
-      TokenValue val1, val2, res;
-      BeforeMPCRun(stk1, val_stk, val1, val2, a, b);
+      node.name = node.token;
+      node.left = -1;
+      node.right = -1;
+      node.level = 0;
+      key = node.name;
+    }
 
-      if (fp64_run_) {
-        LOG(INFO) << "Run FP64 Mul between '" << a << "' and '" << b << "'.";
-        runMPCMulFP64(val1, val2, res);
-        LOG(INFO) << "Run FP64 Mul finish.";
+    auto iter = node_index.find(key);
+    if (iter != node_index.end()) {
+      if (node.left != -1)
+        LOG(INFO) << "Reuse result of '" << nodes[iter->second].name
+                  << "' for '" << node.name << "'.";
+      node_stk.push(iter->second);
+      continue;
+    }
+
+    // A node reused by CSE may be read by a lower level after a higher one.
+    // Nothing reads the root, so it's kept for revealMPCResult.
+    node.last_use = -1;
+    if (node.left != -1) {
+      nodes[node.left].last_use =
+          std::max(nodes[node.left].last_use, node.level);
+      nodes[node.right].last_use =
+          std::max(nodes[node.right].last_use, node.level);
+    }
+
+    node_index[key] = nodes.size();
+    node_stk.push(nodes.size());
+    // An operator's value is saved by runMPCLevel once it's evaluated.
+    if (node.left == -1)
+      token_val_map_[node.name] = node.val;
+    nodes.emplace_back(node);
+  }
+
+  if (node_stk.size() != 1) {
+    LOG(ERROR) << "Express " << expr_ << " should have only one result.";
+    return -3;
+  }
+
+  root = node_stk.top();
+  if (nodes[root].left == -1 && nodes[root].val.type != 0 &&
+      nodes[root].val.type != 1 && nodes[root].val.type != 4) {
+    LOG(ERROR) << "Express " << expr_ << " is a constant, nothing to run.";
+    return -4;
+  }
+
+  LOG(INFO) << "Express graph has " << nodes.size() << " nodes.";
+  return 0;
+}
+
+template <Decimal Dbit>
+int MPCExpressExecutor<Dbit>::shareColumnValues(std::vector<ExprNode> &nodes) {
+  // Values of local column must live until the sharing finish.
+  std::list<f64Matrix<Dbit>> fp64_vals;
+  std::list<i64Matrix> i64_vals;
+  uint32_t count = 0;
+
+  // Issue sharing of all columns together, so they take a single round
+  // instead of one round for each column.
+  for (auto &node : nodes) {
+    TokenValue &val = node.val;
+    if (node.left != -1 || val.type == 2 || val.type == 3)
+      continue;
+
+    if (fp64_run_) {
+      sf64Matrix<Dbit> *sh_val = newFP64Share();
+      if (val.type == 4) {
+        mpc_op_->enc.remoteFixedMatrix(mpc_op_->runtime, *sh_val);
       } else {
-        LOG(INFO) << "Run I64 Mul between '" << a << " and '" << b << "'.";
-        si64Matrix sh_sum;
-        runMPCMulI64(val1, val2, res);
-        LOG(INFO) << "Run I64 Mul finish.";
+        eMatrix<double> m;
+        constructFP64Matrix(val, m);
+        fp64_vals.emplace_back(m.rows(), m.cols());
+        for (u64 i = 0; i < m.size(); i++)
+          fp64_vals.back()(i) = m(i);
+        mpc_op_->enc.localFixedMatrix(mpc_op_->runtime, fp64_vals.back(),
+                                      *sh_val);
       }
+      createTokenValue(sh_val, val);
+    } else {
+      si64Matrix *sh_val = newI64Share();
+      if (val.type == 4) {
+        mpc_op_->enc.remoteIntMatrix(mpc_op_->runtime, *sh_val);
+      } else {
+        i64_vals.emplace_back();
+        constructI64Matrix(val, i64_vals.back());
+        mpc_op_->enc.localIntMatrix(mpc_op_->runtime, i64_vals.back(),
+                                    *sh_val);
+      }
+      createTokenValue(sh_val, val);
+    }
 
-      std::string new_token = "(" + a + "*" + b + ")";
-      AfterMPCRun(stk1, val_stk, new_token, res);
-    } else if (token == "/") {
-      std::string a, b;
-      TokenValue val1, val2, res;
-      BeforeMPCRun(stk1, val_stk, val1, val2, a, b);
-      LOG(INFO) << "Run FP64 Div between '" << a << "' and '" << b << "'.";
-      runMPCDivFP64(val1, val2, res);
-      LOG(INFO) << "Run FP64 Div finish.";
-      std::string new_token = "(" + a + "/" + b + ")";
-      AfterMPCRun(stk1, val_stk, new_token, res);
+    token_val_map_[node.name] = val;
+    count++;
+  }
+
+  if (count)
+    mpc_op_->runtime.runAll();
+
+  LOG(INFO) << "Create shares for " << count << " columns finish.";
+  return 0;
+}
+
+template <Decimal Dbit>
+bool MPCExpressExecutor<Dbit>::isLocalOperator(ExprNode &node,
+                                               std::vector<ExprNode> &nodes) {
+  if (node.token == "+" || node.token == "-")
+    return true;
+
+  // Multiply a share with an int64 constant needs no truncation.
+  if (node.token == "*" && !fp64_run_)
+    return nodes[node.left].val.type == 3 || nodes[node.right].val.type == 3;
+
+  return false;
+}
+
+template <Decimal Dbit>
+void MPCExpressExecutor<Dbit>::asyncMPCMul(TokenValue &val1, TokenValue &val2,
+                                           TokenValue &res,
+                                           std::list<f64<Dbit>> &consts) {
+  if (!fp64_run_) {
+    si64Matrix *sh_res = newI64Share();
+    mpc_op_->eval.asyncDotMul(mpc_op_->runtime, *val1.val_union.sh_i64_m,
+                              *val2.val_union.sh_i64_m, *sh_res);
+    createTokenValue(sh_res, res);
+    return;
+  }
+
+  sf64Matrix<Dbit> *sh_res = newFP64Share();
+  if (val1.type != 2 && val2.type != 2) {
+    mpc_op_->eval.asyncDotMul(mpc_op_->runtime, *val1.val_union.sh_fp64_m,
+                              *val2.val_union.sh_fp64_m, *sh_res);
+  } else {
+    // The task refers to the constant until it finish.
+    TokenValue &sh_val = (val1.type == 2 ? val2 : val1);
+    consts.emplace_back((val1.type == 2 ? val1 : val2).val_union.fp64_val);
+    mpc_op_->eval.asyncConstFixedMul(mpc_op_->runtime, consts.back(),
+                                     *sh_val.val_union.sh_fp64_m, *sh_res);
+  }
+  createTokenValue(sh_res, res);
+}
+
+template <Decimal Dbit>
+int MPCExpressExecutor<Dbit>::runMPCLevel(
+    std::vector<ExprNode> &nodes, const std::vector<size_t> &level_nodes) {
+  std::list<f64<Dbit>> consts;
+  std::vector<size_t> div_nodes;
+  uint32_t async_count = 0;
+
+  // Local operators first, the runtime must be idle when they run.
+  for (auto idx : level_nodes) {
+    ExprNode &node = nodes[idx];
+    if (!isLocalOperator(node, nodes))
+      continue;
+
+    TokenValue &val1 = nodes[node.left].val;
+    TokenValue &val2 = nodes[node.right].val;
+    if (node.token == "+") {
+      if (fp64_run_)
+        runMPCAddFP64(val1, val2, node.val);
+      else
+        runMPCAddI64(val1, val2, node.val);
+    } else if (node.token == "-") {
+      if (fp64_run_)
+        runMPCSubFP64(val1, val2, node.val);
+      else
+        runMPCSubI64(val1, val2, node.val);
     } else {
-      stk1.push(token);
-      suffix_stk_.pop();
+      runMPCMulI64(val1, val2, node.val);
+    }
+  }
 
-      TokenValue token_val;
-      if (createTokenValue(token, token_val)) {
-        LOG(ERROR) << "Construct token value for token '" << token
-                   << "' failed.";
-        return -1;
-      }
+  // Then all multiplications of the level, they send their messages in
+  // the same round.
+  for (auto idx : level_nodes) {
+    ExprNode &node = nodes[idx];
+    if (isLocalOperator(node, nodes))
+      continue;
 
-      val_stk.push(token_val);
-      token_val_map_[token] = token_val;
+    TokenValue &val1 = nodes[node.left].val;
+    TokenValue &val2 = nodes[node.right].val;
+    if (node.token == "*") {
+      asyncMPCMul(val1, val2, node.val, consts);
+      async_count++;
+    } else if (val2.type == 2) {
+      // Divide by a constant is multiply by it's reciprocal.
+      TokenValue reciprocal;
+      reciprocal.type = 2;
+      reciprocal.val_union.fp64_val = 1.0 / val2.val_union.fp64_val;
+      asyncMPCMul(val1, reciprocal, node.val, consts);
+      async_count++;
+    } else {
+      div_nodes.emplace_back(idx);
     }
   }
 
-  while (!stk1.empty()) {
-    suffix_stk_.push(stk1.top());
-    stk1.pop();
+  if (async_count)
+    mpc_op_->runtime.runAll();
+
+  // Division takes many rounds, run it one by one.
+  for (auto idx : div_nodes) {
+    ExprNode &node = nodes[idx];
+    runMPCDivFP64(nodes[node.left].val, nodes[node.right].val, node.val);
+  }
+
+  for (auto idx : level_nodes) {
+    token_val_map_[nodes[idx].name] = nodes[idx].val;
+    LOG(INFO) << "Run " << (fp64_run_ ? "FP64" : "I64") << " '"
+              << nodes[idx].name << "' finish.";
+  }
+
+  return 0;
+}
+
+template <Decimal Dbit> int MPCExpressExecutor<Dbit>::runMPCEvaluate(void) {
+  std::vector<ExprNode> nodes;
+  int root = -1;
+  if (buildExprGraph(nodes, root)) {
+    LOG(ERROR) << "Build graph for express " << expr_ << " failed.";
+    return -1;
+  }
+
+  if (shareColumnValues(nodes)) {
+    LOG(ERROR) << "Create shares for columns failed.";
+    return -2;
+  }
+
+  // Run the graph level by level, so the count of communication rounds is
+  // the depth of express rather than the count of operators.
+  std::vector<std::vector<size_t>> levels;
+  for (size_t i = 0; i < nodes.size(); i++) {
+    if (nodes[i].left == -1)
+      continue;
+    if (levels.size() <= static_cast<size_t>(nodes[i].level))
+      levels.resize(nodes[i].level + 1);
+    levels[nodes[i].level].emplace_back(i);
+  }
+
+  for (size_t level = 1; level < levels.size(); level++) {
+    LOG(INFO) << "Run level " << level << " of express, "
+              << levels[level].size() << " operators.";
+    if (runMPCLevel(nodes, levels[level])) {
+      LOG(ERROR) << "Run level " << level << " of express failed.";
+      return -3;
+    }
+
+    for (auto &node : nodes)
+      if (node.last_use == static_cast<int>(level))
+        releaseShare(node.name);
   }
 
+  // The final token is used by revealMPCResult.
+  while (!suffix_stk_.empty())
+    suffix_stk_.pop();
+  suffix_stk_.push(nodes[root].name);
+
   return 0;
 }
 
@@ -1337,6 +1443,14 @@ template <Decimal Dbit> void MPCExpressExecutor<Dbit>::Clean(void) {
     }
   }
 
+  for (auto m : fp64_share_pool_)
+    delete m;
+  fp64_share_pool_.clear();
+
+  for (auto m : i64_share_pool_)
+    delete m;
+  i64_share_pool_.clear();
+
   if (col_config_) {
     delete col_config_;
     col_config_ = nullptr;
@@ -1360,6 +1474,14 @@ template <Decimal Dbit> void MPCExpressExecutor<Dbit>::Clean(void) {
   token_type_map_.clear();
 }
 
+template <Decimal Dbit>
+void MPCExpressExecutor<Dbit>::channelBytes(u64 *sent, u64 *received) {
+  *sent = 0;
+  *received = 0;
+  if (mpc_op_ != nullptr)
+    mpc_op_->channelBytes(sent, received);
+}
+
 template <Decimal Dbit> MPCExpressExecutor<Dbit>::~MPCExpressExecutor() {
   Clean();
 }
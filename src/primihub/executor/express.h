@@ -3,15 +3,20 @@
 
 #include <cstdlib>
 #include <iostream>
+#include <list>
 #include <map>
+#include <mutex>
 #include <stack>
 #include <string>
+#include <vector>
 
 #include "src/primihub/operator/aby3_operator.h"
 
 namespace primihub {
 
 template <Decimal Dbit> class LocalExpressExecutor;
+// Tests the express graph and share pool without a MPC runtime.
+class MPCExpressExecutorTest;
 
 template <Decimal Dbit> class MPCExpressExecutor {
 public:
@@ -50,6 +55,10 @@ public:
                       const std::string &prev_ip, uint16_t next_port,
                       uint16_t prev_port);
 
+  // Thread safe, cancels the channels of the MPC runtime, also when it is
+  // not created yet.
+  void cancelMPCRuntime(void);
+
   // Method group 6: Execute express with MPC protocol.
   int runMPCEvaluate(void);
 
@@ -58,6 +67,9 @@ public:
 
   void revealMPCResult(std::vector<uint32_t> &party, std::vector<int64_t> &vec);
 
+  // Bytes moved by the MPC runtime, zeros before initMPCRuntime.
+  void channelBytes(u64 *sent, u64 *received);
+
   // Method group end;
 
   bool isFP64RunMode(void) { return this->fp64_run_; }
@@ -95,7 +107,8 @@ public:
     // type == 4: a remote column, set nothing.
     // type == 5: a share matrix for FP64 matrix.
     // type == 6: a share matrix for I64 matrix.
-    uint8_t type;
+    // type == 7: an operator not evaluated yet, set nothing.
+    uint8_t type = 7;
 
     TokenValue(){};
     ~TokenValue(){};
@@ -116,6 +129,8 @@ public:
         return "local FP64 column";
       case 4:
         return "remote column";
+      case 7:
+        return "not evaluated";
       default:
         return "unknown type";
       }
@@ -123,6 +138,7 @@ public:
   };
 
   template <Decimal Dbits> friend class LocalExpressExecutor;
+  friend class MPCExpressExecutorTest;
 
 private:
   // ColumnConfig saves column's owner and it's data type.
@@ -190,6 +206,48 @@ private:
     ColumnConfig *col_config_;
   };
 
+  // A node of the express graph built from the suffix express, either an
+  // operand or an operator on the value of two other nodes. Operands are on
+  // level 0 and an operator is one level above its deepest operand, so the
+  // operators of one level don't depend on each other.
+  struct ExprNode {
+    std::string token;
+    // Sub-express evaluated by the node, it's the key in token_val_map_.
+    std::string name;
+    int left;
+    int right;
+    int level;
+    // Last level reads the node's value, it's share is released after it.
+    int last_use;
+    TokenValue val;
+  };
+
+  // Replace an operator on two constants with it's value.
+  bool foldConstant(ExprNode &node, std::vector<ExprNode> &nodes);
+
+  // Build graph from suffix_stk_, a sub-express appears more than once has
+  // only one node.
+  int buildExprGraph(std::vector<ExprNode> &nodes, int &root);
+
+  int shareColumnValues(std::vector<ExprNode> &nodes);
+
+  bool isLocalOperator(ExprNode &node, std::vector<ExprNode> &nodes);
+
+  void asyncMPCMul(TokenValue &val1, TokenValue &val2, TokenValue &res,
+                   std::list<f64<Dbit>> &consts);
+
+  int runMPCLevel(std::vector<ExprNode> &nodes,
+                  const std::vector<size_t> &level_nodes);
+
+  // Shares of intermediate value are taken from and released into a pool,
+  // so memory is bounded by the count of alive values rather than the
+  // count of operators.
+  sf64Matrix<Dbit> *newFP64Share(void);
+
+  si64Matrix *newI64Share(void);
+
+  void releaseShare(const std::string &token);
+
   inline int createTokenValue(const std::string &token, TokenValue &token_val);
 
   inline void createTokenValue(sf64Matrix<Dbit> *m, TokenValue &token_val);
@@ -200,10 +258,6 @@ private:
 
   inline void constructFP64Matrix(TokenValue &token_val, eMatrix<double> &m);
 
-  inline void createI64Shares(TokenValue &val, si64Matrix &sh_val);
-
-  inline void createFP64Shares(TokenValue &val, sf64Matrix<Dbit> &sh_val);
-
   inline void BeforeMPCRun(std::stack<std::string> &token_stk,
                            std::stack<TokenValue> &val_stk, TokenValue &val1,
                            TokenValue &val2, std::string &a, std::string &b);
@@ -220,8 +274,6 @@ private:
 
   void runMPCSubI64(TokenValue &val1, TokenValue &val2, TokenValue &res);
 
-  void runMPCMulFP64(TokenValue &val1, TokenValue &val2, TokenValue &res);
-
   void runMPCMulI64(TokenValue &val1, TokenValue &val2, TokenValue &res);
 
   void runMPCDivFP64(TokenValue &val1, TokenValue &val2, TokenValue &res);
@@ -237,9 +289,13 @@ private:
   std::stack<std::string> suffix_stk_;
   ColumnConfig *col_config_;
   MPCOperator *mpc_op_;
+  std::mutex mpc_op_mtx_;
+  bool cancelled_;
   FeedDict *feed_dict_;
   std::map<std::string, TokenValue> token_val_map_;
   std::map<std::string, TokenType> token_type_map_;
+  std::vector<sf64Matrix<Dbit> *> fp64_share_pool_;
+  std::vector<si64Matrix *> i64_share_pool_;
   uint32_t party_id_;
 };
 
@@ -14,11 +14,14 @@
  limitations under the License.
  */
 
+#include <atomic>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <signal.h>
 #include <sstream>
+#include <thread>
 #include <unistd.h>
 
 #include <arrow/flight/server.h>
@@ -27,11 +30,18 @@
 #include "src/primihub/data_store/factory.h"
 #include "src/primihub/node/ds.h"
 #include "src/primihub/node/node.h"
+#include "src/primihub/node/result_sink.h"
 #include "src/primihub/service/dataset/service.h"
 #include "src/primihub/service/dataset/util.hpp"
 #include "src/primihub/task/language/factory.h"
 #include "src/primihub/task/semantic/parser.h"
+#include "src/primihub/task/semantic/pir_server_cache.h"
+#include "src/primihub/task/semantic/psi_server_cache.h"
+#include "src/primihub/task/semantic/psi_server_task.h"
 #include "src/primihub/util/file_util.h"
+#include "src/primihub/util/metrics.h"
+#include "src/primihub/util/network/grpc_channel_pool.h"
+#include "src/primihub/util/util.h"
 
 using grpc::Server;
 using primihub::rpc::Params;
@@ -45,6 +55,12 @@ ABSL_FLAG(std::string, node_id, "node0", "unique node_id");
 ABSL_FLAG(std::string, config, "./config/node.yaml", "config file");
 ABSL_FLAG(bool, singleton, false, "singleton mode"); // TODO: remove this flag
 ABSL_FLAG(int, service_port, 50050, "node service port");
+ABSL_FLAG(int, task_worker_num, 4, "number of threads executing submitted tasks");
+ABSL_FLAG(int, task_queue_size, 64, "max queued tasks per task type");
+ABSL_FLAG(int64_t, task_timeout_ms, 24 * 3600 * 1000,
+          "deadline of submitted tasks without their own timeout, 0 to disable");
+ABSL_FLAG(int, metrics_port, 0, "port of the prometheus metrics endpoint, 0 to disable");
+ABSL_FLAG(std::string, metrics_address, "127.0.0.1", "address the metrics endpoint listens on");
 
 namespace primihub {
 Status VMNodeImpl::Send(ServerContext* context,
@@ -56,8 +72,13 @@ Status VMNodeImpl::Send(ServerContext* context,
     std::string task_id;
     int storage_type{-1};
     std::string storage_info;
-    std::vector<std::string> recv_data;
-    VLOG(5) << "VMNodeImpl::Send: received xxx: ";
+    // every chunk goes to the sink as soon as it arrives,
+    // on failure keep draining the stream so the client is not blocked
+    std::unique_ptr<ResultSink> sink;
+    int ret{0};
+    ResultSink::Checksum received;
+    std::string checksum;
+    size_t recv_rows{0};
     TaskRequest request;
     while (reader->Read(&request)) {
         if (!recv_meta_info) {
@@ -70,37 +91,43 @@ Status VMNodeImpl::Send(ServerContext* context,
                     << "task_id: " << task_id << " "
                     << "storage_type: " << storage_type << " "
                     << "storage_info: " << storage_info;
+            if (storage_type == primihub::rpc::TaskRequest::FILE) {
+                if (ValidateDir(storage_info)) {
+                    LOG(ERROR) << "file path is not exist, please check";
+                    ret = -1;
+                } else {
+                    sink = ResultSink::Create(storage_info);
+                    if (sink == nullptr) {
+                        ret = -1;
+                    }
+                }
+            }
         }
-        auto item_size = request.data().size();
-        for (size_t i = 0; i < item_size; i++) {
-            recv_data.push_back(request.data(i));
+        received.add(request.data());
+        recv_rows += request.data_size();
+        if (!request.checksum().empty()) {
+            checksum = request.checksum();
+        }
+        if (ret == 0 && sink != nullptr) {
+            ret = sink->append(request.data());
         }
     }
 
-    if (storage_type == primihub::rpc::TaskRequest::FILE) {
-        std::string data_path = storage_info;
-        save_data_to_file(data_path, std::move(recv_data));
-    }
-    VLOG(5) << "end of read data from client";
-    response->set_ret_code(primihub::rpc::retcode::SUCCESS);
-    return Status::OK;
-}
-
-int VMNodeImpl::save_data_to_file(const std::string& data_path, std::vector<std::string>&& save_data) {
-    if (ValidateDir(data_path)) {
-        LOG(ERROR) << "file path is not exist, please check";
-        return -1;
+    if (ret == 0 && !checksum.empty() && checksum != received.value()) {
+        LOG(ERROR) << "checksum mismatch for " << storage_info << ", expected: "
+                   << checksum << " received: " << received.value();
+        ret = -1;
     }
-    auto data = std::move(save_data);
-    if (data.empty()) {
-        return 0;
+    if (sink != nullptr && sink->finish(ret == 0)) {
+        ret = -1;
     }
-    std::ofstream in_fs(data_path, std::ios::out);
-    for (const auto& data_item : data) {
-        in_fs << data_item << "\n";
+    VLOG(5) << "end of read data from client, rows: " << recv_rows;
+    if (ret) {
+        response->set_ret_code(primihub::rpc::retcode::FAIL);
+    } else {
+        response->set_ret_code(primihub::rpc::retcode::SUCCESS);
     }
-    in_fs.close();
-    return 0;
+    return Status::OK;
 }
 
 Status VMNodeImpl::SubmitTask(ServerContext *context,
@@ -111,19 +138,23 @@ Status VMNodeImpl::SubmitTask(ServerContext *context,
     google::protobuf::TextFormat::PrintToString(*pushTaskRequest, &str);
     LOG(INFO) << str << std::endl;
 
-    std::string job_task = pushTaskRequest->task().job_id() + pushTaskRequest->task().task_id();
     pushTaskReply->set_job_id(pushTaskRequest->task().job_id());
 
-    // if (running_set.find(job_task) != running_set.end()) {
-    //     pushTaskReply->set_ret_code(1);
-    //     return Status::OK;
-    // }
-
+    // the task is queued on the node executor and the reply only carries
+    // the admission result, progress is published via the notify service
+    auto task_type = pushTaskRequest->task().type();
+    std::string job_task = TaskExecutor::jobKey(pushTaskRequest->task().job_id(),
+                                                pushTaskRequest->task().task_id(),
+                                                task_type);
+    const auto& job_id = pushTaskRequest->task().job_id();
+    const auto& task_id = pushTaskRequest->task().task_id();
+    std::string party_key = TaskExecutor::jobKey(job_id, task_id,
+        primihub::rpc::TaskType::NODE_TASK);
+    TaskExecutor::Job job;
     // actor
-    if (pushTaskRequest->task().type() == primihub::rpc::TaskType::ACTOR_TASK ||
-            pushTaskRequest->task().type() == primihub::rpc::TaskType::TEE_TASK) {
+    if (task_type == primihub::rpc::TaskType::ACTOR_TASK ||
+            task_type == primihub::rpc::TaskType::TEE_TASK) {
         LOG(INFO) << "start to schedule task";
-        // absl::MutexLock lock(&parser_mutex_);
         // Construct language parser
         std::shared_ptr<LanguageParser> lan_parser_ =
             LanguageParserFactory::Create(*pushTaskRequest);
@@ -131,50 +162,200 @@ Status VMNodeImpl::SubmitTask(ServerContext *context,
             pushTaskReply->set_ret_code(1);
             return Status::OK;
         }
-        lan_parser_->parseTask();
-        lan_parser_->parseDatasets();
-
-        // Construct protocol semantic parser
-        auto _psp = ProtocolSemanticParser(this->node_id, this->singleton,
-                                           this->nodelet->getDataService());
-        // Parse and dispatch task.
-        _psp.parseTaskSyntaxTree(lan_parser_);
-
-    } else if (pushTaskRequest->task().type() == primihub::rpc::TaskType::PIR_TASK ||
-            pushTaskRequest->task().type() == primihub::rpc::TaskType::PSI_TASK) {
+        job = [this, lan_parser_, job_id, task_id, party_key](
+                const TaskExecutor::Token& token) -> int {
+            lan_parser_->parseTask();
+            lan_parser_->parseDatasets();
+
+            // Construct protocol semantic parser
+            auto _psp = ProtocolSemanticParser(this->node_id, this->singleton,
+                                               this->nodelet->getDataService());
+            _psp.setCancelToken(token);
+            // Parse and dispatch task.
+            _psp.parseTaskSyntaxTree(lan_parser_);
+            this->recordParties(party_key, _psp.getPartyAddresses());
+            if (token->isCancelled()) {
+                // parties which took the task before the cancel
+                this->forwardKill(job_id, task_id, token->reason());
+                return -1;
+            }
+            return 0;
+        };
+    } else if (task_type == primihub::rpc::TaskType::PIR_TASK ||
+            task_type == primihub::rpc::TaskType::PSI_TASK) {
         LOG(INFO) << "start to schedule schedule task";
-        // absl::MutexLock lock(&parser_mutex_);
         std::shared_ptr<LanguageParser> lan_parser_ =
             LanguageParserFactory::Create(*pushTaskRequest);
         if (lan_parser_ == nullptr) {
             pushTaskReply->set_ret_code(1);
             return Status::OK;
         }
-        lan_parser_->parseDatasets();
-
-        // Construct protocol semantic parser
-        auto _psp = ProtocolSemanticParser(this->node_id, this->singleton,
-                                           this->nodelet->getDataService());
-        VLOG(5) << "Construct protocol semantic parser finished";
-        // Parse and dispathc pir task.
-        if (pushTaskRequest->task().type() ==
-            primihub::rpc::TaskType::PIR_TASK) {
-            _psp.schedulePirTask(lan_parser_, this->nodelet->getNodeletAddr());
-        } else {
-            _psp.schedulePsiTask(lan_parser_);
-        }
-        auto _type = static_cast<int>(pushTaskRequest->task().type());
-        VLOG(5) << "end schedule schedule task for type: " << _type;
+        job = [this, lan_parser_, task_type, job_id, task_id, party_key](
+                const TaskExecutor::Token& token) -> int {
+            lan_parser_->parseDatasets();
+
+            // Construct protocol semantic parser
+            auto _psp = ProtocolSemanticParser(this->node_id, this->singleton,
+                                               this->nodelet->getDataService());
+            _psp.setCancelToken(token);
+            VLOG(5) << "Construct protocol semantic parser finished";
+            // Parse and dispathc pir task.
+            if (task_type == primihub::rpc::TaskType::PIR_TASK) {
+                _psp.schedulePirTask(lan_parser_, this->nodelet->getNodeletAddr());
+            } else {
+                _psp.schedulePsiTask(lan_parser_);
+            }
+            VLOG(5) << "end schedule schedule task for type: "
+                    << static_cast<int>(task_type);
+            this->recordParties(party_key, _psp.getPartyAddresses());
+            if (token->isCancelled()) {
+                this->forwardKill(job_id, task_id, token->reason());
+                return -1;
+            }
+            return 0;
+        };
     } else {
         LOG(INFO) << "start to create worker for task";
-        running_set.insert(job_task);
-        std::shared_ptr<Worker> worker = CreateWorker();
-        worker->execute(pushTaskRequest);
-        running_set.erase(job_task);
+        std::vector<std::string> parties;
+        for (const auto& pair : pushTaskRequest->task().node_map()) {
+            if (pair.first != this->node_id) {
+                parties.emplace_back(
+                    absl::StrCat(pair.second.ip(), ":", pair.second.port()));
+            }
+        }
+        recordParties(party_key, parties);
+        auto request = std::make_shared<PushTaskRequest>(*pushTaskRequest);
+        job = [this, request](const TaskExecutor::Token& token) -> int {
+            std::shared_ptr<Worker> worker = CreateWorker();
+            return worker->execute(request.get(), token);
+        };
     }
+    int ret = task_executor_->submit(job_task, task_type,
+                                     pushTaskRequest->task().task_id(),
+                                     pushTaskRequest->submit_client_id(),
+                                     std::move(job),
+                                     pushTaskRequest->task().timeout_ms());
+    pushTaskReply->set_ret_code(ret);
     return Status::OK;
 }
 
+Status VMNodeImpl::KillTask(ServerContext *context,
+                            const KillTaskRequest *request,
+                            KillTaskResponse *response) {
+    std::string reason = request->reason().empty() ?
+                         "killed by request" : request->reason();
+    // the node may run both the scheduler job and its own party task
+    std::string job_task = TaskExecutor::jobKey(request->job_id(),
+        request->task_id(), primihub::rpc::TaskType::NODE_TASK);
+    std::string schedule_job = TaskExecutor::jobKey(request->job_id(),
+        request->task_id(), primihub::rpc::TaskType::ACTOR_TASK);
+    int ret = task_executor_->cancel(job_task, reason);
+    if (task_executor_->cancel(schedule_job, reason) == 0) {
+        ret = 0;
+    }
+    // every party runs its own copy of the task
+    if (!request->forwarded() &&
+            forwardKill(request->job_id(), request->task_id(), reason) > 0) {
+        ret = 0;
+    }
+    if (ret) {
+        LOG(WARNING) << "kill task: " << job_task << " is not running";
+        response->set_ret_code(1);
+        return Status::OK;
+    }
+    response->set_ret_code(0);
+    return Status::OK;
+}
+
+void VMNodeImpl::recordParties(const std::string& party_key,
+                               const std::vector<std::string>& addresses) {
+    constexpr size_t kMaxTrackedTasks = 1024;
+    if (addresses.empty()) {
+        return;
+    }
+    absl::MutexLock lock(&party_mutex_);
+    auto& parties = task_parties_[party_key];
+    if (parties.empty()) {
+        task_party_order_.push_back(party_key);
+    }
+    for (const auto& address : addresses) {
+        if (std::find(parties.begin(), parties.end(), address) == parties.end()) {
+            parties.push_back(address);
+        }
+    }
+    while (task_party_order_.size() > kMaxTrackedTasks) {
+        task_parties_.erase(task_party_order_.front());
+        task_party_order_.pop_front();
+    }
+}
+
+std::vector<std::string> VMNodeImpl::getParties(const std::string& party_key) {
+    absl::MutexLock lock(&party_mutex_);
+    auto it = task_parties_.find(party_key);
+    if (it == task_parties_.end()) {
+        return {};
+    }
+    return it->second;
+}
+
+int VMNodeImpl::forwardKill(const std::string& job_id,
+                            const std::string& task_id,
+                            const std::string& reason) {
+    constexpr int kForwardTimeoutMs = 5000;
+    auto parties = getParties(TaskExecutor::jobKey(job_id, task_id,
+        primihub::rpc::TaskType::NODE_TASK));
+    std::string self_address = absl::StrCat(node_ip, ":", service_port);
+    KillTaskRequest request;
+    request.set_job_id(job_id);
+    request.set_task_id(task_id);
+    request.set_reason(reason);
+    request.set_forwarded(true);
+
+    std::atomic<int> killed{0};
+    std::vector<std::thread> thrds;
+    for (const auto& address : parties) {
+        if (address == self_address) {
+            continue;
+        }
+        thrds.emplace_back([&request, &killed, address]() {
+            grpc::ClientContext context;
+            context.set_deadline(std::chrono::system_clock::now() +
+                                 std::chrono::milliseconds(kForwardTimeoutMs));
+            KillTaskResponse response;
+            auto stub = GrpcChannelPool::getInstance().getVMNodeStub(address);
+            Status status = stub->KillTask(&context, request, &response);
+            if (!status.ok()) {
+                LOG(ERROR) << "forward kill task to " << address << " failed: "
+                           << status.error_message();
+                return;
+            }
+            if (response.ret_code() == 0) {
+                killed++;
+            }
+        });
+    }
+    for (auto& t : thrds) {
+        t.join();
+    }
+    VLOG(3) << "forward kill task " << job_id << task_id << ": " << killed
+            << " of " << parties.size() << " parties cancelled it";
+    return killed;
+}
+
+// the peer waits on the server task, so the task never outlives the
+// deadline of its rpc
+static void SetTokenDeadline(ServerContext* context,
+                             const TaskExecutor::Token& token) {
+    auto deadline = context->deadline();
+    if (deadline == std::chrono::system_clock::time_point::max()) {
+        return;
+    }
+    auto timeout_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::system_clock::now()).count();
+    // an expired deadline still cancels the task right away
+    token->setTimeout(timeout_ms > 0 ? timeout_ms : 1);
+}
+
 /***********************************************
  *
  * method runs on the node as psi or pir server
@@ -230,7 +411,8 @@ int VMNodeImpl::process_pir_response(const ExecuteTaskResponse& response,
     do {
         ExecuteTaskResponse sub_resp;
         auto sub_pir_res = sub_resp.mutable_pir_response();
-        sub_pir_res->set_ret_code(0);
+        sub_pir_res->set_ret_code(pir_res.ret_code());
+        sub_pir_res->set_database_size(pir_res.database_size());
         size_t pack_size = 0;
         for (size_t i = sended_index; i < reply_num; i++) {
             // get query len
@@ -289,11 +471,16 @@ Status VMNodeImpl::ExecuteTask(ServerContext* context,
                 (*ptr_params)[key] = pv;
             }
             auto req_type = recv_request.algorithm_request_case();
+            if (req_type == ExecuteTaskRequest::AlgorithmRequestCase::kPsiRequest &&
+                    recv_request.psi_request().stream_mode()) {
+                return ExecutePsiStream(context, recv_request, stream);
+            }
             if (req_type == ExecuteTaskRequest::AlgorithmRequestCase::kPsiRequest) {
                 is_psi_request = true;
                 taskType = primihub::rpc::TaskType::NODE_PSI_TASK;
                 const auto& psi_req = recv_request.psi_request();
-                job_task = psi_req.job_id() + psi_req.task_id();
+                job_task = TaskExecutor::jobKey(psi_req.job_id(), psi_req.task_id(),
+                                                primihub::rpc::TaskType::NODE_PSI_TASK);
                 auto psi_request = task_request.mutable_psi_request();
                 psi_request->set_job_id(psi_req.job_id());
                 psi_request->set_task_id(psi_req.task_id());
@@ -302,12 +489,14 @@ Status VMNodeImpl::ExecuteTask(ServerContext* context,
                 is_pir_request = true;
                 taskType = primihub::rpc::TaskType::NODE_PIR_TASK;
                 const auto& pir_req = recv_request.pir_request();
-                job_task = pir_req.job_id() + pir_req.task_id();
+                job_task = TaskExecutor::jobKey(pir_req.job_id(), pir_req.task_id(),
+                                                primihub::rpc::TaskType::NODE_PIR_TASK);
                 auto pir_request = task_request.mutable_pir_request();
                 pir_request->set_galois_keys(pir_req.galois_keys());
                 pir_request->set_relin_keys(pir_req.relin_keys());
                 pir_request->set_job_id(pir_req.job_id());
                 pir_request->set_task_id(pir_req.task_id());
+                pir_request->mutable_plan()->CopyFrom(pir_req.plan());
             }
             first_visit_flag = true;
         }
@@ -328,7 +517,8 @@ Status VMNodeImpl::ExecuteTask(ServerContext* context,
             }
         }
     }
-    if (running_set.find(job_task) != running_set.end()) {
+    TaskExecutor::Token token;
+    if (task_executor_->acquire(job_task, &token) != TaskExecutor::ACCEPTED) {
         if (is_psi_request) {
             task_response.mutable_psi_response()->set_ret_code(1);
         } else if (is_pir_request) {
@@ -342,13 +532,12 @@ Status VMNodeImpl::ExecuteTask(ServerContext* context,
     if (taskType == primihub::rpc::TaskType::NODE_PSI_TASK ||
         taskType == primihub::rpc::TaskType::NODE_PIR_TASK) {
         LOG(INFO) << "Start to create PSI/PIR server task";
-        running_set.insert(job_task);
+        // the client waits on this stream, so run inline instead of queueing
+        SetTokenDeadline(context, token);
         std::shared_ptr<Worker> worker = CreateWorker();
-        running_map.insert({job_task, worker});
-        worker->execute(&task_request, &task_response);
-        running_map.erase(job_task);
-        running_set.erase(job_task);
+        worker->execute(&task_request, &task_response, token);
     }
+    task_executor_->release(job_task);
 
     std::vector<ExecuteTaskResponse> splited_resp;
     process_task_reseponse(is_psi_request, task_response, &splited_resp);
@@ -359,6 +548,74 @@ Status VMNodeImpl::ExecuteTask(ServerContext* context,
     return Status::OK;
 }
 
+Status VMNodeImpl::ExecutePsiStream(ServerContext* context,
+        const ExecuteTaskRequest& first_request,
+        grpc::ServerReaderWriter<ExecuteTaskResponse, ExecuteTaskRequest>* stream) {
+    const auto& psi_req = first_request.psi_request();
+    std::string job_task = TaskExecutor::jobKey(psi_req.job_id(), psi_req.task_id(),
+        primihub::rpc::TaskType::NODE_PSI_TASK);
+    TaskExecutor::Token token;
+    if (task_executor_->acquire(job_task, &token) != TaskExecutor::ACCEPTED) {
+        ExecuteTaskResponse task_response;
+        task_response.mutable_psi_response()->set_ret_code(1);
+        stream->Write(task_response);
+        return Status::OK;
+    }
+    LOG(INFO) << "Start to create PSI server stream task";
+    ExecuteTaskResponse unused_response;
+    auto psi_task = std::make_shared<task::PSIServerTask>(this->node_id,
+        first_request, &unused_response, this->nodelet->getDataService());
+    SetTokenDeadline(context, token);
+    psi_task->setCancellationToken(token);
+    int ret = psi_task->executeStream(
+        [stream](ExecuteTaskRequest* request) { return stream->Read(request); },
+        [stream](const ExecuteTaskResponse& response) {
+            return stream->Write(response);
+        });
+    task_executor_->release(job_task);
+    if (ret) {
+        LOG(ERROR) << "Error occurs during server node execute psi stream task.";
+        ExecuteTaskResponse task_response;
+        task_response.mutable_psi_response()->set_ret_code(2);
+        stream->Write(task_response);
+    }
+    return Status::OK;
+}
+
+void VMNodeImpl::loadTaskConfig(const std::string& config_file_path) {
+    YAML::Node config = YAML::LoadFile(config_file_path);
+    const auto& psi_config = config["psi_server_cache"];
+    if (psi_config) {
+        task::PsiServerCache::Options options;
+        if (psi_config["enabled"]) {
+            options.enabled = psi_config["enabled"].as<bool>();
+        }
+        if (psi_config["key_rotation_sec"]) {
+            options.key_rotation_sec = psi_config["key_rotation_sec"].as<int64_t>();
+        }
+        if (psi_config["max_bytes"]) {
+            options.max_bytes = psi_config["max_bytes"].as<uint64_t>();
+        }
+        if (task::PsiServerCache::getInstance().setOptions(options)) {
+            LOG(WARNING) << "psi_server_cache config is ignored";
+        }
+    }
+    const auto& pir_config = config["pir_server_cache"];
+    if (pir_config) {
+        task::PirDatabaseCache::Options options;
+        if (pir_config["enabled"]) {
+            options.enabled = pir_config["enabled"].as<bool>();
+        }
+        if (pir_config["row_file_dir"]) {
+            options.row_file_dir = pir_config["row_file_dir"].as<std::string>();
+        }
+        if (pir_config["max_bytes"]) {
+            options.max_bytes = pir_config["max_bytes"].as<uint64_t>();
+        }
+        task::PirDatabaseCache::getInstance().setOptions(options);
+    }
+}
+
 std::shared_ptr<Worker> VMNodeImpl::CreateWorker() {
     auto worker = std::make_shared<Worker>(this->node_id, this->nodelet);
     LOG(INFO) << " 🤖️ Start create worker " << this->node_id;
@@ -395,6 +652,15 @@ void RunServer(primihub::VMNodeImpl *node_service,
 
         // set the max message size to 128M
         builder->SetMaxReceiveMessageSize(128 * 1024 * 1024);
+        // accept the keepalive pings of pooled channels from peer nodes
+        auto channel_options = GrpcChannelPool::getInstance().options();
+        if (channel_options.keepalive_time_ms > 0) {
+            builder->AddChannelArgument(
+                GRPC_ARG_HTTP2_MIN_RECV_PING_INTERVAL_WITHOUT_DATA_MS,
+                channel_options.keepalive_time_ms);
+            builder->AddChannelArgument(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS,
+                channel_options.keepalive_permit_without_calls ? 1 : 0);
+        }
     };
 
     // Start the server
@@ -441,12 +707,26 @@ int main(int argc, char **argv) {
     int service_port = absl::GetFlag(FLAGS_service_port);
     std::string config_file = absl::GetFlag(FLAGS_config);
 
+    primihub::TaskExecutor::Options executor_options;
+    executor_options.worker_num = std::max(absl::GetFlag(FLAGS_task_worker_num), 1);
+    executor_options.max_queue_size = std::max(absl::GetFlag(FLAGS_task_queue_size), 1);
+    executor_options.default_timeout_ms = absl::GetFlag(FLAGS_task_timeout_ms);
+
     std::string node_ip = "0.0.0.0";
     node_service = new primihub::VMNodeImpl(node_id, node_ip, service_port,
-                                            singleton, config_file);
+                                            singleton, config_file,
+                                            executor_options);
     data_service = new primihub::DataServiceImpl(
         node_service->getNodelet()->getDataService(),
         node_service->getNodelet()->getNodeletAddr());
+
+    static primihub::MetricsHttpServer metrics_server;
+    int metrics_port = absl::GetFlag(FLAGS_metrics_port);
+    if (metrics_port > 0) {
+        if (metrics_server.start(absl::GetFlag(FLAGS_metrics_address), metrics_port)) {
+            LOG(WARNING) << "metrics endpoint is not available";
+        }
+    }
     primihub::RunServer(node_service, data_service, service_port);
 
     return EXIT_SUCCESS;
@@ -27,7 +27,9 @@
 
 #include <algorithm>
 #include <cmath>
+#include <deque>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
@@ -41,6 +43,7 @@
 
 #include "src/primihub/common/config/config.h"
 #include "src/primihub/node/nodelet.h"
+#include "src/primihub/node/task_executor.h"
 
 #include "src/primihub/node/worker/worker.h"
 #include "src/primihub/protos/psi.grpc.pb.h"
@@ -63,6 +66,8 @@ using primihub::rpc::TaskRequest;
 using primihub::rpc::TaskResponse;
 using primihub::rpc::ExecuteTaskRequest;
 using primihub::rpc::ExecuteTaskResponse;
+using primihub::rpc::KillTaskRequest;
+using primihub::rpc::KillTaskResponse;
 using primihub::rpc::Node;
 using primihub::rpc::PirRequest;
 using primihub::rpc::PirResponse;
@@ -83,13 +88,18 @@ class VMNodeImpl final: public VMNode::Service {
   public:
     explicit VMNodeImpl(const std::string &node_id_,
                         const std::string &node_ip_, int service_port_,
-                        bool singleton_, const std::string &config_file_path_)
+                        bool singleton_, const std::string &config_file_path_,
+                        const TaskExecutor::Options& executor_options =
+                            TaskExecutor::Options())
         : node_id(node_id_), node_ip(node_ip_), service_port(service_port_),
           singleton(singleton_), config_file_path(config_file_path_) {
-        running_set.clear();
         nodelet = std::make_shared<Nodelet>(config_file_path);
+        loadTaskConfig(config_file_path);
+        task_executor_ = std::make_unique<TaskExecutor>(executor_options);
     }
     ~VMNodeImpl() override {
+      // stop running tasks before the nodelet they use goes away
+      this->task_executor_.reset();
       this->nodelet.reset();
     }
 
@@ -101,6 +111,10 @@ class VMNodeImpl final: public VMNode::Service {
     Status Send(ServerContext* context,
                 ServerReader<TaskRequest>* reader,
                 TaskResponse* response) override;
+    // cancel a queued or running task of this node
+    Status KillTask(ServerContext* context,
+                    const KillTaskRequest* request,
+                    KillTaskResponse* response) override;
 
     std::shared_ptr<Worker> CreateWorker();
 
@@ -119,13 +133,33 @@ class VMNodeImpl final: public VMNode::Service {
           std::vector<ExecuteTaskResponse>* splited_responses);
     int process_pir_response(const ExecuteTaskResponse& response,
           std::vector<ExecuteTaskResponse>* splited_responses);
-    int save_data_to_file(const std::string& data_path, std::vector<std::string>&& save_data);
+    // ECDH psi in stream mode, answers each request chunk as it arrives
+    Status ExecutePsiStream(ServerContext* context,
+          const ExecuteTaskRequest& first_request,
+          grpc::ServerReaderWriter<ExecuteTaskResponse, ExecuteTaskRequest>* stream);
     int validate_file_path(const std::string& data_path) { return 0;}
   private:
+    // settings of server side tasks, shared by all requests to this node
+    void loadTaskConfig(const std::string& config_file_path);
+    // the other parties of a task, every party runs its own copy of the
+    // task, so a kill is sent on to them
+    void recordParties(const std::string& party_key,
+                       const std::vector<std::string>& addresses);
+    std::vector<std::string> getParties(const std::string& party_key);
+    // returns the number of parties which cancelled the task
+    int forwardKill(const std::string& job_id, const std::string& task_id,
+                    const std::string& reason);
+
     std::unordered_map<std::string, std::shared_ptr<Worker>>
         workers_ GUARDED_BY(worker_map_mutex_);
 
     mutable absl::Mutex worker_map_mutex_;
+    // key: party key of the task, value: ip:port of its other parties,
+    // only the latest kMaxTrackedTasks tasks are kept
+    std::map<std::string, std::vector<std::string>>
+        task_parties_ GUARDED_BY(party_mutex_);
+    std::deque<std::string> task_party_order_ GUARDED_BY(party_mutex_);
+    mutable absl::Mutex party_mutex_;
     mutable absl::Mutex parser_mutex_;
     const std::string node_id;
     const std::string node_ip;
@@ -135,8 +169,8 @@ class VMNodeImpl final: public VMNode::Service {
     // PeerDatasetMap peer_dataset_map;
     // std::shared_ptr<LanguageParser> lan_parser_;
     bool singleton;
-    std::set<std::string> running_set;
-    std::map<std::string, std::shared_ptr<Worker>> running_map;
+    // queues submitted tasks and tracks every running job of this node
+    std::unique_ptr<TaskExecutor> task_executor_;
 
     std::shared_ptr<Nodelet> nodelet;
     std::string config_file_path;
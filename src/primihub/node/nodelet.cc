@@ -17,6 +17,7 @@
 #include "src/primihub/node/nodelet.h"
 #include "src/primihub/service/dataset/localkv/storage_default.h"
 #include "src/primihub/service/dataset/localkv/storage_leveldb.h"
+#include "src/primihub/util/network/grpc_channel_pool.h"
 
 namespace primihub {
 Nodelet::Nodelet(const std::string& config_file_path) {
@@ -31,6 +32,9 @@ Nodelet::Nodelet(const std::string& config_file_path) {
     std::string addr = config["p2p"]["multi_addr"].as<std::string>();
     p2p_node_stub_->start(addr);
 
+    // Channels to peer nodes are shared by all tasks of this node
+    loadGrpcChannelConfig(config);
+
     // Create and start notify service
     auto notify_server_addr = config["notify_server"].as<std::string>();
     notify_service_ = std::make_shared<primihub::service::NotifyService>(notify_server_addr);
@@ -48,8 +52,22 @@ Nodelet::Nodelet(const std::string& config_file_path) {
     if (localkv_c == "default") {
         local_kv_ = std::make_shared<primihub::service::StorageBackendDefault>();
     } else if (localkv_c == "leveldb") {
+        primihub::service::StorageBackendLevelDB::Options kv_options;
+        auto kv_config = config["localkv"];
+        if (kv_config["block_cache_mb"]) {
+            kv_options.block_cache_size = kv_config["block_cache_mb"].as<size_t>() << 20;
+        }
+        if (kv_config["bloom_bits_per_key"]) {
+            kv_options.bloom_bits_per_key = kv_config["bloom_bits_per_key"].as<int>();
+        }
+        if (kv_config["write_buffer_mb"]) {
+            kv_options.write_buffer_size = kv_config["write_buffer_mb"].as<size_t>() << 20;
+        }
+        if (kv_config["sync"]) {
+            kv_options.sync = kv_config["sync"].as<bool>();
+        }
         local_kv_ = std::make_shared<primihub::service::StorageBackendLevelDB>(
-             config["localkv"]["path"].as<std::string>()
+             kv_config["path"].as<std::string>(), kv_options
         );
     } else {
        local_kv_ = std::make_shared<primihub::service::StorageBackendDefault>();
@@ -62,6 +80,9 @@ Nodelet::Nodelet(const std::string& config_file_path) {
 
     auto timeout = config["p2p"]["dht_get_value_timeout"].as<unsigned int>();
     loadConifg(config_file_path, timeout);
+    dataset_service_->setMetaCacheTTL(
+        config["p2p"]["meta_cache_ttl"].as<unsigned int>(300),
+        config["p2p"]["meta_negative_ttl"].as<unsigned int>(2));
 
 }
 
@@ -78,6 +99,39 @@ std::string Nodelet::getNodeletAddr() {
     return nodelet_addr_;
 }
 
+void Nodelet::loadGrpcChannelConfig(const YAML::Node& config) {
+    GrpcChannelOptions options;
+    const auto& channel_config = config["grpc_channel"];
+    if (channel_config) {
+        if (channel_config["max_message_size"]) {
+            options.max_message_size = channel_config["max_message_size"].as<int>();
+        }
+        if (channel_config["keepalive_time_ms"]) {
+            options.keepalive_time_ms = channel_config["keepalive_time_ms"].as<int>();
+        }
+        if (channel_config["keepalive_timeout_ms"]) {
+            options.keepalive_timeout_ms = channel_config["keepalive_timeout_ms"].as<int>();
+        }
+        if (channel_config["keepalive_permit_without_calls"]) {
+            options.keepalive_permit_without_calls =
+                channel_config["keepalive_permit_without_calls"].as<bool>();
+        }
+        if (channel_config["compression"]) {
+            options.compression = channel_config["compression"].as<std::string>();
+        }
+        if (channel_config["max_attempts"]) {
+            options.max_attempts = channel_config["max_attempts"].as<int>();
+        }
+        if (channel_config["initial_backoff_ms"]) {
+            options.initial_backoff_ms = channel_config["initial_backoff_ms"].as<int>();
+        }
+        if (channel_config["max_backoff_ms"]) {
+            options.max_backoff_ms = channel_config["max_backoff_ms"].as<int>();
+        }
+    }
+    GrpcChannelPool::getInstance().setOptions(options);
+}
+
 // Load config file and load default datasets
 void Nodelet::loadConifg(const std::string &config_file_path, unsigned int dht_get_value_timeout) {
     dataset_service_->loadDefaultDatasets(config_file_path);
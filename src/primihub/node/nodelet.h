@@ -21,6 +21,8 @@
 
 #include <string>
 
+#include <yaml-cpp/yaml.h>
+
 #include "src/primihub/p2p/node_stub.h"
 #include "src/primihub/service/dataset/service.h"
 #include "src/primihub/service/dataset/storage_backend.h"
@@ -42,6 +44,7 @@ class Nodelet {
 
   private:
     void loadConifg(const std::string &config_file_path, unsigned int timeout);
+    void loadGrpcChannelConfig(const YAML::Node& config);
 
     std::shared_ptr<primihub::p2p::NodeStub> p2p_node_stub_;
     std::shared_ptr<primihub::service::StorageBackend> local_kv_;
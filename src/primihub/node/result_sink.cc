@@ -0,0 +1,303 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "src/primihub/node/result_sink.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <arrow/ipc/writer.h>
+#include <glog/logging.h>
+#include <parquet/arrow/writer.h>
+
+#include "src/primihub/util/util.h"
+
+namespace primihub {
+
+namespace {
+
+bool EndsWith(const std::string& str, const std::string& suffix) {
+    return str.size() >= suffix.size() &&
+           str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// rows are collected in a user space buffer and written with one syscall
+// once it is full, so a 4M grpc message costs about one write
+class CsvResultSink : public ResultSink {
+ public:
+    static constexpr size_t kBufferSize = 1 << 22;
+
+    explicit CsvResultSink(const std::string& path) : ResultSink(path) {
+        buffer_.reserve(kBufferSize);
+    }
+    ~CsvResultSink() override {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    int open() {
+        fd_ = ::open(tmp_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) {
+            LOG(ERROR) << "open " << tmp_path_ << " failed: " << strerror(errno);
+            return -1;
+        }
+        return 0;
+    }
+
+    int append(const Rows& rows) override {
+        for (const auto& row : rows) {
+            if (buffer_.size() + row.size() + 1 > kBufferSize && flush()) {
+                return -1;
+            }
+            buffer_.append(row);
+            buffer_.push_back('\n');
+        }
+        return 0;
+    }
+
+ protected:
+    int close() override {
+        int ret = flush();
+        if (ret == 0 && ::fsync(fd_) != 0) {
+            LOG(ERROR) << "fsync " << tmp_path_ << " failed: " << strerror(errno);
+            ret = -1;
+        }
+        if (::close(fd_) != 0) {
+            ret = -1;
+        }
+        fd_ = -1;
+        return ret;
+    }
+
+ private:
+    int flush() {
+        const char* data = buffer_.data();
+        size_t left = buffer_.size();
+        while (left > 0) {
+            ssize_t n = ::write(fd_, data, left);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                LOG(ERROR) << "write " << tmp_path_ << " failed: " << strerror(errno);
+                return -1;
+            }
+            data += n;
+            left -= n;
+        }
+        buffer_.clear();
+        return 0;
+    }
+
+    int fd_{-1};
+    std::string buffer_;
+};
+
+// single string column, the column name is taken from the header row
+class ColumnarResultSink : public ResultSink {
+ public:
+    using ResultSink::ResultSink;
+
+    int append(const Rows& rows) override {
+        int begin = 0;
+        if (!opened_) {
+            if (rows.empty()) {
+                return 0;
+            }
+            if (openWriter(columnName(rows.Get(0)))) {
+                return -1;
+            }
+            begin = 1;
+        }
+        if (begin >= rows.size()) {
+            return 0;
+        }
+        arrow::StringBuilder builder;
+        auto status = builder.Reserve(rows.size() - begin);
+        for (int i = begin; status.ok() && i < rows.size(); i++) {
+            status = builder.Append(rows.Get(i));
+        }
+        std::shared_ptr<arrow::Array> array;
+        if (status.ok()) {
+            status = builder.Finish(&array);
+        }
+        if (status.ok()) {
+            auto batch = arrow::RecordBatch::Make(schema_, array->length(), {array});
+            status = writeBatch(batch);
+        }
+        if (!status.ok()) {
+            LOG(ERROR) << "write " << tmp_path_ << " failed: " << status;
+            return -1;
+        }
+        return 0;
+    }
+
+ protected:
+    virtual arrow::Status openFile(std::shared_ptr<arrow::io::OutputStream> sink) = 0;
+    virtual arrow::Status writeBatch(const std::shared_ptr<arrow::RecordBatch>& batch) = 0;
+    virtual arrow::Status closeFile() = 0;
+
+    int close() override {
+        if (!opened_) {
+            // the writer failed to open earlier
+            if (schema_ != nullptr) {
+                return -1;
+            }
+            // nothing received, still leave a valid empty file behind
+            if (openWriter("data")) {
+                return -1;
+            }
+        }
+        auto status = closeFile();
+        if (status.ok()) {
+            status = stream_->Close();
+        }
+        if (!status.ok()) {
+            LOG(ERROR) << "close " << tmp_path_ << " failed: " << status;
+            return -1;
+        }
+        return 0;
+    }
+
+    std::shared_ptr<arrow::Schema> schema_;
+
+ private:
+    static std::string columnName(const std::string& header) {
+        std::string name = header;
+        if (name.size() >= 2 && name.front() == '"' && name.back() == '"') {
+            name = name.substr(1, name.size() - 2);
+        }
+        return name.empty() ? "data" : name;
+    }
+
+    int openWriter(const std::string& column_name) {
+        auto stream_result = arrow::io::FileOutputStream::Open(tmp_path_);
+        if (!stream_result.ok()) {
+            LOG(ERROR) << "open " << tmp_path_ << " failed: " << stream_result.status();
+            return -1;
+        }
+        stream_ = stream_result.ValueOrDie();
+        schema_ = arrow::schema({arrow::field(column_name, arrow::utf8())});
+        auto status = openFile(stream_);
+        if (!status.ok()) {
+            LOG(ERROR) << "create writer for " << tmp_path_ << " failed: " << status;
+            return -1;
+        }
+        opened_ = true;
+        return 0;
+    }
+
+    bool opened_{false};
+    std::shared_ptr<arrow::io::FileOutputStream> stream_;
+};
+
+class IpcResultSink : public ColumnarResultSink {
+ public:
+    using ColumnarResultSink::ColumnarResultSink;
+
+ protected:
+    arrow::Status openFile(std::shared_ptr<arrow::io::OutputStream> sink) override {
+        auto result = arrow::ipc::MakeFileWriter(sink, schema_);
+        if (!result.ok()) {
+            return result.status();
+        }
+        writer_ = result.ValueOrDie();
+        return arrow::Status::OK();
+    }
+    arrow::Status writeBatch(const std::shared_ptr<arrow::RecordBatch>& batch) override {
+        return writer_->WriteRecordBatch(*batch);
+    }
+    arrow::Status closeFile() override {
+        return writer_->Close();
+    }
+
+ private:
+    std::shared_ptr<arrow::ipc::RecordBatchWriter> writer_;
+};
+
+class ParquetResultSink : public ColumnarResultSink {
+ public:
+    using ColumnarResultSink::ColumnarResultSink;
+
+ protected:
+    arrow::Status openFile(std::shared_ptr<arrow::io::OutputStream> sink) override {
+        return parquet::arrow::FileWriter::Open(*schema_, arrow::default_memory_pool(),
+            sink, parquet::default_writer_properties(), &writer_);
+    }
+    arrow::Status writeBatch(const std::shared_ptr<arrow::RecordBatch>& batch) override {
+        auto table_result = arrow::Table::FromRecordBatches({batch});
+        if (!table_result.ok()) {
+            return table_result.status();
+        }
+        return writer_->WriteTable(*table_result.ValueOrDie(), batch->num_rows());
+    }
+    arrow::Status closeFile() override {
+        return writer_->Close();
+    }
+
+ private:
+    std::unique_ptr<parquet::arrow::FileWriter> writer_;
+};
+
+}  // namespace
+
+std::unique_ptr<ResultSink> ResultSink::Create(const std::string& path) {
+    if (EndsWith(path, ".arrow") || EndsWith(path, ".feather")) {
+        return std::make_unique<IpcResultSink>(path);
+    }
+    if (EndsWith(path, ".parquet")) {
+        return std::make_unique<ParquetResultSink>(path);
+    }
+    auto sink = std::make_unique<CsvResultSink>(path);
+    if (sink->open()) {
+        return nullptr;
+    }
+    return sink;
+}
+
+void ResultSink::Checksum::addRow(Rows* chunk, const char* data, size_t len) {
+    chunk->Add()->assign(data, len);
+    crc_ = crc32_update(crc_, data, len);
+    crc_ = crc32_update(crc_, "\n", 1);
+}
+
+void ResultSink::Checksum::add(const Rows& rows) {
+    for (const auto& row : rows) {
+        crc_ = crc32_update(crc_, row.data(), row.size());
+        crc_ = crc32_update(crc_, "\n", 1);
+    }
+}
+
+int ResultSink::finish(bool keep) {
+    int ret = close();
+    if (keep && ret == 0) {
+        if (::rename(tmp_path_.c_str(), path_.c_str()) == 0) {
+            return 0;
+        }
+        LOG(ERROR) << "rename " << tmp_path_ << " to " << path_
+                   << " failed: " << strerror(errno);
+    }
+    ::unlink(tmp_path_.c_str());
+    return keep ? -1 : 0;
+}
+
+}  // namespace primihub
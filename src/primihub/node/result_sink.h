@@ -0,0 +1,85 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#ifndef SRC_PRIMIHUB_NODE_RESULT_SINK_H_
+#define SRC_PRIMIHUB_NODE_RESULT_SINK_H_
+
+#include <google/protobuf/repeated_field.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace primihub {
+
+/**
+ * Destination of a result stream received by VMNodeImpl::Send.
+ *
+ * Rows are written as each chunk arrives instead of being collected in
+ * memory first. The first row is the column header. Output goes to
+ * "<path>.tmp" and is renamed to path by a successful finish(), so a
+ * reader never sees a partially written result.
+ *
+ * The format follows the extension of path:
+ *   .arrow / .feather  Arrow IPC file, one record batch per chunk
+ *   .parquet           Parquet file, one row group per chunk
+ *   anything else      csv, one row per line
+ */
+class ResultSink {
+ public:
+    using Rows = google::protobuf::RepeatedPtrField<std::string>;
+
+    /**
+     * crc32 of the rows as a sink stores them, one row per line.
+     * The sender adds each row it puts into a chunk and sends value()
+     * with the last chunk, the receiver adds the rows it got and compares.
+     */
+    class Checksum {
+     public:
+        void addRow(Rows* chunk, const char* data, size_t len);
+        void add(const Rows& rows);
+        std::string value() const { return std::to_string(crc_); }
+
+     private:
+        uint32_t crc_{0};
+    };
+
+    static std::unique_ptr<ResultSink> Create(const std::string& path);
+
+    explicit ResultSink(const std::string& path)
+        : path_(path), tmp_path_(path + ".tmp") {}
+    virtual ~ResultSink() = default;
+
+    virtual int append(const Rows& rows) = 0;
+    /**
+     * keep = true flushes the output and publishes it at path,
+     * keep = false discards everything written so far.
+     */
+    int finish(bool keep);
+
+    const std::string& path() const { return path_; }
+
+ protected:
+    virtual int close() = 0;
+
+    std::string path_;
+    std::string tmp_path_;
+};
+
+}  // namespace primihub
+
+#endif  // SRC_PRIMIHUB_NODE_RESULT_SINK_H_
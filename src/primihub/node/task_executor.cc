@@ -0,0 +1,334 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "src/primihub/node/task_executor.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <utility>
+
+#include "src/primihub/service/notify/model.h"
+#include "src/primihub/util/metrics.h"
+
+using primihub::service::EventBusNotifyDelegate;
+
+namespace primihub {
+
+TaskExecutor::TaskExecutor(const Options& options) : options_(options) {
+    if (options_.worker_num == 0) {
+        options_.worker_num = 1;
+    }
+    if (options_.max_queue_size == 0) {
+        options_.max_queue_size = 1;
+    }
+    // keep a worker for the party tasks the schedulers wait on
+    max_running_schedulers_ = std::max<size_t>(options_.worker_num - 1, 1);
+    for (size_t i = 0; i < options_.worker_num; i++) {
+        workers_.emplace_back(&TaskExecutor::_Run, this);
+    }
+    LOG(INFO) << "task executor started, worker num: " << options_.worker_num
+              << " max queue size: " << options_.max_queue_size
+              << " default timeout ms: " << options_.default_timeout_ms;
+}
+
+TaskExecutor::~TaskExecutor() {
+    std::map<int, std::deque<Item>> dropped;
+    std::vector<Token> running;
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        stop_ = true;
+        dropped.swap(queues_);
+        pending_ = 0;
+        _UpdatePendingGauge();
+        for (const auto& job : active_jobs_) {
+            running.push_back(job.second);
+        }
+    }
+    cv_.notify_all();
+    // unblock the running jobs, otherwise join waits for them forever
+    for (auto& token : running) {
+        token->cancel("node is shutting down");
+    }
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    for (const auto& queue : dropped) {
+        for (const auto& item : queue.second) {
+            LOG(WARNING) << "drop queued task: " << item.job_key;
+            _Notify(item, "FAILED", "node is shutting down");
+        }
+    }
+}
+
+bool TaskExecutor::isScheduler(rpc::TaskType type) {
+    switch (type) {
+    case rpc::TaskType::ACTOR_TASK:
+    case rpc::TaskType::PIR_TASK:
+    case rpc::TaskType::PSI_TASK:
+    case rpc::TaskType::TEE_TASK:
+        return true;
+    default:
+        return false;
+    }
+}
+
+int TaskExecutor::priority(rpc::TaskType type) {
+    // scheduling only pushes sub tasks to the nodes, never hold it back
+    if (isScheduler(type)) {
+        return 2;
+    }
+    switch (type) {
+    // interactive two party tasks, the peer is waiting on us
+    case rpc::TaskType::NODE_PIR_TASK:
+    case rpc::TaskType::NODE_PSI_TASK:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+std::string TaskExecutor::jobKey(const std::string& job_id,
+                                 const std::string& task_id,
+                                 rpc::TaskType type) {
+    if (isScheduler(type)) {
+        return "schedule:" + job_id + task_id;
+    }
+    return job_id + task_id;
+}
+
+int TaskExecutor::submit(const std::string& job_key, rpc::TaskType type,
+                         const std::string& task_id,
+                         const std::string& submit_client_id, Job job,
+                         int64_t timeout_ms) {
+    auto token = std::make_shared<CancellationToken>();
+    Item item{job_key, type, task_id, submit_client_id, std::move(job), token};
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        if (stop_) {
+            LOG(ERROR) << "task executor is stopped, reject task: " << job_key;
+            _CountRejected(type);
+            return REJECTED;
+        }
+        if (active_jobs_.find(job_key) != active_jobs_.end()) {
+            LOG(WARNING) << "task is already running: " << job_key;
+            return RUNNING;
+        }
+        auto& queue = queues_[static_cast<int>(type)];
+        if (queue.size() >= options_.max_queue_size) {
+            LOG(ERROR) << "task queue for type " << type << " is full, "
+                       << "reject task: " << job_key;
+            _CountRejected(type);
+            return REJECTED;
+        }
+        active_jobs_.emplace(job_key, token);
+        queue.push_back(std::move(item));
+        pending_++;
+        _UpdatePendingGauge();
+        VLOG(5) << "queue task: " << job_key << " type: " << type
+                << " pending: " << pending_;
+    }
+    // the deadline covers the time in queue as well
+    token->setTimeout(timeout_ms > 0 ? timeout_ms : options_.default_timeout_ms);
+    cv_.notify_one();
+    return ACCEPTED;
+}
+
+int TaskExecutor::acquire(const std::string& job_key, Token* token) {
+    auto job_token = std::make_shared<CancellationToken>();
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        if (!active_jobs_.emplace(job_key, job_token).second) {
+            return RUNNING;
+        }
+    }
+    if (token != nullptr) {
+        *token = std::move(job_token);
+    }
+    return ACCEPTED;
+}
+
+void TaskExecutor::release(const std::string& job_key) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    active_jobs_.erase(job_key);
+}
+
+int TaskExecutor::cancel(const std::string& job_key,
+                         const std::string& reason) {
+    Token token;
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        auto it = active_jobs_.find(job_key);
+        if (it == active_jobs_.end()) {
+            return -1;
+        }
+        token = it->second;
+    }
+    // callbacks close sockets, run them without holding mtx_
+    if (!token->cancel(reason)) {
+        VLOG(5) << "task is already cancelled: " << job_key;
+    }
+    LOG(INFO) << "cancel task: " << job_key << ", reason: " << reason;
+    return 0;
+}
+
+bool TaskExecutor::isActive(const std::string& job_key) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    return active_jobs_.find(job_key) != active_jobs_.end();
+}
+
+size_t TaskExecutor::pendingCount() {
+    std::lock_guard<std::mutex> lck(mtx_);
+    return pending_;
+}
+
+// called with mtx_ held
+bool TaskExecutor::_HasRunnable() {
+    for (const auto& queue : queues_) {
+        if (queue.second.empty()) {
+            continue;
+        }
+        if (!isScheduler(static_cast<rpc::TaskType>(queue.first)) ||
+                running_schedulers_ < max_running_schedulers_) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TaskExecutor::_PopNext(Item* item) {
+    std::deque<Item>* selected = nullptr;
+    int selected_priority = -1;
+    bool schedulers_full = running_schedulers_ >= max_running_schedulers_;
+    for (auto& queue : queues_) {
+        if (queue.second.empty()) {
+            continue;
+        }
+        auto type = static_cast<rpc::TaskType>(queue.first);
+        if (schedulers_full && isScheduler(type)) {
+            continue;
+        }
+        int prio = priority(type);
+        if (prio > selected_priority) {
+            selected_priority = prio;
+            selected = &queue.second;
+        }
+    }
+    if (selected == nullptr) {
+        return false;
+    }
+    *item = std::move(selected->front());
+    selected->pop_front();
+    if (isScheduler(item->type)) {
+        running_schedulers_++;
+    }
+    pending_--;
+    _UpdatePendingGauge();
+    return true;
+}
+
+void TaskExecutor::_Notify(const Item& item, const std::string& status,
+                           const std::string& message) {
+    EventBusNotifyDelegate::getInstance().notifyStatus(
+        item.task_id, item.submit_client_id, status, message);
+}
+
+// called with mtx_ held
+void TaskExecutor::_UpdatePendingGauge() {
+    static auto& pending_gauge = MetricsRegistry::getInstance().gauge(
+        "primihub_task_queue_pending", {}, "Tasks waiting for a worker.");
+    pending_gauge.set(pending_);
+}
+
+void TaskExecutor::_CountRejected(rpc::TaskType type) {
+    MetricsRegistry::getInstance().counter(
+        "primihub_task_rejected_total",
+        {{"task_type", rpc::TaskType_Name(type)}},
+        "Tasks rejected by the node executor.").inc();
+}
+
+void TaskExecutor::_Run() {
+    while (true) {
+        Item item;
+        {
+            std::unique_lock<std::mutex> lck(mtx_);
+            cv_.wait(lck, [this] { return stop_ || _HasRunnable(); });
+            if (stop_) {
+                return;
+            }
+            if (!_PopNext(&item)) {
+                continue;
+            }
+        }
+        if (item.token->isCancelled()) {
+            LOG(WARNING) << "skip cancelled task: " << item.job_key;
+            _Notify(item, "CANCELLED", item.token->reason());
+            _Finish(item);
+            continue;
+        }
+        VLOG(5) << "start task: " << item.job_key;
+        _Notify(item, "RUNNING", "task started");
+        auto start = std::chrono::steady_clock::now();
+        int ret = -1;
+        try {
+            ret = item.job(item.token);
+        } catch (std::exception& e) {
+            LOG(ERROR) << "task " << item.job_key << " throw: " << e.what();
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        // a cancelled job usually fails on its closed channels, report why
+        bool cancelled = item.token->isCancelled();
+        std::string status = cancelled ? "CANCELLED" :
+                             (ret == 0 ? "SUCCESS" : "FAILED");
+        MetricsRegistry::getInstance().histogram(
+            "primihub_task_duration_seconds",
+            {{"task_type", rpc::TaskType_Name(item.type)}, {"status", status}},
+            "Run time of tasks executed by the node.", 1e-6).observe(elapsed);
+        if (cancelled) {
+            LOG(WARNING) << "task " << item.job_key << " is cancelled: "
+                         << item.token->reason();
+            _Notify(item, status, item.token->reason());
+        } else if (ret == 0) {
+            // the parties report the end of the task itself
+            _Notify(item, status, isScheduler(item.type) ?
+                    "task dispatched" : "task finished");
+        } else {
+            LOG(ERROR) << "task " << item.job_key << " failed, ret: " << ret;
+            _Notify(item, status, "task failed");
+        }
+        _Finish(item);
+    }
+}
+
+void TaskExecutor::_Finish(const Item& item) {
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        active_jobs_.erase(item.job_key);
+        if (!isScheduler(item.type)) {
+            return;
+        }
+        running_schedulers_--;
+    }
+    // a queued scheduler job may be waiting for this slot
+    cv_.notify_all();
+}
+
+}  // namespace primihub
@@ -0,0 +1,150 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#ifndef SRC_PRIMIHUB_NODE_TASK_EXECUTOR_H_
+#define SRC_PRIMIHUB_NODE_TASK_EXECUTOR_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/primihub/protos/common.pb.h"
+#include "src/primihub/util/cancellation.h"
+
+namespace primihub {
+
+/**
+ * Node level executor for submitted tasks.
+ *
+ * Tasks are queued per task type and picked by a fixed number of worker
+ * threads, higher priority types first and FIFO within one type.
+ * Scheduler jobs wait for the party tasks they dispatch, which may be
+ * queued on this node as well, so they never hold more than
+ * worker_num - 1 workers.
+ * Every job is tracked by its job key (see jobKey()) from the moment it
+ * is admitted until it finishes, so a duplicated submit is answered with
+ * "doing" instead of running the same task twice.
+ * Every job owns a cancellation token, which is cancelled by cancel(), by
+ * the deadline given on submit (or the default one) or when the executor
+ * stops. A job cancelled while queued never runs.
+ * Status changes are published through the notify service.
+ */
+class TaskExecutor {
+ public:
+    using Token = std::shared_ptr<CancellationToken>;
+    using Job = std::function<int(const Token& token)>;
+
+    struct Options {
+        size_t worker_num{4};
+        size_t max_queue_size{64};  // per task type
+        // deadline of jobs submitted without one, <= 0 disables it
+        int64_t default_timeout_ms{24 * 3600 * 1000};
+    };
+
+    // same values as PushTaskReply.ret_code
+    enum Admission {
+        ACCEPTED = 0,
+        RUNNING = 1,
+        REJECTED = 2,
+    };
+
+    explicit TaskExecutor(const Options& options);
+    ~TaskExecutor();
+
+    TaskExecutor(const TaskExecutor&) = delete;
+    TaskExecutor& operator=(const TaskExecutor&) = delete;
+
+    /**
+     * Queue job for asynchronous execution, returns an Admission value.
+     * task_id and submit_client_id are only used for status notification.
+     * timeout_ms > 0 sets the deadline of the job, counted from now,
+     * otherwise the default deadline of the executor applies.
+     */
+    int submit(const std::string& job_key, rpc::TaskType type,
+               const std::string& task_id,
+               const std::string& submit_client_id, Job job,
+               int64_t timeout_ms = 0);
+
+    /**
+     * Register a job which runs on the caller's thread, e.g. the server side
+     * of ExecuteTask where the peer is waiting on the stream.
+     * Returns RUNNING if the job key is already active, otherwise the token
+     * of the job is returned in token when it is not null.
+     */
+    int acquire(const std::string& job_key, Token* token = nullptr);
+    void release(const std::string& job_key);
+
+    // returns 0 if the job is active and is cancelled now, -1 otherwise.
+    int cancel(const std::string& job_key, const std::string& reason);
+
+    bool isActive(const std::string& job_key);
+    size_t pendingCount();
+
+    static int priority(rpc::TaskType type);
+    // ACTOR/PSI/PIR/TEE jobs only dispatch party tasks and wait for them
+    static bool isScheduler(rpc::TaskType type);
+    /**
+     * Key of a job. A scheduler job sends its own job_id and task_id to
+     * every party, and this node may be one of them, so scheduler jobs
+     * are keyed apart from party tasks.
+     */
+    static std::string jobKey(const std::string& job_id,
+                              const std::string& task_id,
+                              rpc::TaskType type);
+
+ private:
+    struct Item {
+        std::string job_key;
+        rpc::TaskType type;
+        std::string task_id;
+        std::string submit_client_id;
+        Job job;
+        Token token;
+    };
+
+    void _Run();
+    bool _HasRunnable();
+    bool _PopNext(Item* item);
+    // release the job key and its scheduler slot
+    void _Finish(const Item& item);
+    void _Notify(const Item& item, const std::string& status,
+                 const std::string& message);
+    void _UpdatePendingGauge();
+    void _CountRejected(rpc::TaskType type);
+
+    Options options_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    bool stop_{false};
+    size_t pending_{0};
+    size_t running_schedulers_{0};
+    size_t max_running_schedulers_{1};
+    // key: task type
+    std::map<int, std::deque<Item>> queues_;
+    // key: job key
+    std::map<std::string, Token> active_jobs_;
+    std::vector<std::thread> workers_;
+};
+
+}  // namespace primihub
+
+#endif  // SRC_PRIMIHUB_NODE_TASK_EXECUTOR_H_
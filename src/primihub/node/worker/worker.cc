@@ -34,7 +34,8 @@ using primihub::rpc::PsiTag;
 
 namespace primihub {
 
-void Worker::execute(const PushTaskRequest *pushTaskRequest) {
+int Worker::execute(const PushTaskRequest *pushTaskRequest,
+                    std::shared_ptr<CancellationToken> token) {
     auto type = pushTaskRequest->task().type();
     VLOG(2) << "Worker::execute task type: " << type;
     if (type == rpc::TaskType::NODE_TASK ||
@@ -43,17 +44,21 @@ void Worker::execute(const PushTaskRequest *pushTaskRequest) {
         auto pTask = TaskFactory::Create(this->node_id, *pushTaskRequest, dataset_service);
         if (pTask == nullptr) {
             LOG(ERROR) << "Woker create task failed.";
-            return;
+            return -1;
+        }
+        if (token != nullptr) {
+            pTask->setCancellationToken(token);
         }
         LOG(INFO) << " 🚀 Worker start execute task ";
         int ret = pTask->execute();
         if (ret != 0) {
             LOG(ERROR) << "Error occurs during execute task.";
+            return ret;
         }
     } else if (type == rpc::TaskType::NODE_PSI_TASK) {
         if (pushTaskRequest->task().node_map().size() < 2) {
             LOG(ERROR) << "At least 2 nodes srunning with 2PC task now.";
-            return;
+            return -1;
         }
 
         const auto& param_map = pushTaskRequest->task().params().param_map();
@@ -66,7 +71,7 @@ void Worker::execute(const PushTaskRequest *pushTaskRequest) {
         if (psiTag == PsiTag::ECDH) {
             auto param_map_it = param_map.find("serverAddress");
             if (param_map_it == param_map.end()) {
-                return;
+                return -1;
             }
         }
 
@@ -74,15 +79,20 @@ void Worker::execute(const PushTaskRequest *pushTaskRequest) {
         auto pTask = TaskFactory::Create(this->node_id, *pushTaskRequest, dataset_service);
         if (pTask == nullptr) {
             LOG(ERROR) << "Woker create psi task failed.";
-            return;
+            return -1;
+        }
+        if (token != nullptr) {
+            pTask->setCancellationToken(token);
         }
         int ret = pTask->execute();
-        if (ret != 0)
+        if (ret != 0) {
             LOG(ERROR) << "Error occurs during execute psi task.";
+            return ret;
+        }
     } else if (type == rpc::TaskType::NODE_PIR_TASK) {
         if (pushTaskRequest->task().node_map().size() < 2) {
             LOG(ERROR) << "At least 2 nodes srunning with 2PC task now.";
-            return;
+            return -1;
         }
 
         const auto& param_map = pushTaskRequest->task().params().param_map();
@@ -96,7 +106,7 @@ void Worker::execute(const PushTaskRequest *pushTaskRequest) {
         if (pirType == PirType::ID_PIR) {
             auto param_map_it = param_map.find("serverAddress");
             if (param_map_it == param_map.end()) {
-                return ;
+                return -1;
             }
         }
 
@@ -104,21 +114,28 @@ void Worker::execute(const PushTaskRequest *pushTaskRequest) {
         auto pTask = TaskFactory::Create(this->node_id, *pushTaskRequest, dataset_service);
         if (pTask == nullptr) {
             LOG(ERROR) << "Woker create pir task failed.";
-            return ;
+            return -1;
+        }
+        if (token != nullptr) {
+            pTask->setCancellationToken(token);
         }
         int ret = pTask->execute();
         if (ret != 0) {
             LOG(ERROR) << "Error occurs during execute pir task.";
+            return ret;
         }
     } else {
         LOG(WARNING) << "unsupported Requested task type: " << type;
+        return -1;
     }
+    return 0;
 }
 
 
 // PIR /PSI Server worker execution
-void Worker::execute(const ExecuteTaskRequest *taskRequest,
-                     ExecuteTaskResponse *taskResponse) {
+int Worker::execute(const ExecuteTaskRequest *taskRequest,
+                    ExecuteTaskResponse *taskResponse,
+                    std::shared_ptr<CancellationToken> token) {
     auto request_type = taskRequest->algorithm_request_case();
     if (request_type == ExecuteTaskRequest::AlgorithmRequestCase::kPsiRequest) {
         auto dataset_service = nodelet->getDataService();
@@ -129,11 +146,15 @@ void Worker::execute(const ExecuteTaskRequest *taskRequest,
 					                     dataset_service);
         if (pTask == nullptr) {
             LOG(ERROR) << "Woker create server node task failed.";
-            return;
+            return -1;
+        }
+        if (token != nullptr) {
+            pTask->setCancellationToken(token);
         }
         int ret = pTask->execute();
         if (ret != 0) {
             LOG(ERROR) << "Error occurs during server node execute task.";
+            return ret;
         }
     } else if (request_type == ExecuteTaskRequest::AlgorithmRequestCase::kPirRequest) {
         VLOG(0) << "algorithm_request_case kPirRequest Worker::execute";
@@ -145,15 +166,21 @@ void Worker::execute(const ExecuteTaskRequest *taskRequest,
                                          dataset_service);
         if (pTask == nullptr) {
             LOG(ERROR) << "Woker create server node task failed.";
-            return;
+            return -1;
+        }
+        if (token != nullptr) {
+            pTask->setCancellationToken(token);
         }
         int ret = pTask->execute();
         if (ret != 0) {
             LOG(ERROR) << "Error occurs during server node execute task.";
+            return ret;
         }
     } else {
         LOG(WARNING) << "Requested task type is not supported.";
+        return -1;
     }
+    return 0;
 }
 
 } // namespace primihub
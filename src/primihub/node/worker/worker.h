@@ -47,6 +47,7 @@
 #include "src/primihub/algorithm/aby3ML.h"
 #include "src/primihub/algorithm/plainML.h"
 #include "src/primihub/protocol/aby3/sh3_gen.h"
+#include "src/primihub/util/cancellation.h"
 #include "src/primihub/util/network/socket/ioservice.h"
 #include "src/primihub/protos/worker.grpc.pb.h"
 
@@ -65,10 +66,13 @@ class Worker {
                      std::shared_ptr<Nodelet> nodelet_)
         : node_id(node_id_), nodelet(nodelet_) {}
 
-    void execute(const PushTaskRequest* pushTaskRequest);
+    // token, when given, is the one the task checks and is cancelled by
+    int execute(const PushTaskRequest* pushTaskRequest,
+                std::shared_ptr<CancellationToken> token = nullptr);
 
-    void execute(const ExecuteTaskRequest *taskRequest,
-                 ExecuteTaskResponse *taskResponse);
+    int execute(const ExecuteTaskRequest *taskRequest,
+                ExecuteTaskResponse *taskResponse,
+                std::shared_ptr<CancellationToken> token = nullptr);
 
  private:
   std::unordered_map<std::string, std::shared_ptr<Worker>> workers_
@@ -40,6 +40,16 @@ int MPCOperator::setup(std::string next_ip, std::string prev_ip, u32 next_port,
 
   comm.setNext(ep_next_.addChannel());
   comm.setPrev(ep_prev_.addChannel());
+  {
+    // Channels share their state, cancel() reaches comm through these.
+    std::lock_guard<std::mutex> lck(chl_mtx_);
+    mNext = comm.mNext();
+    mPrev = comm.mPrev();
+    if (cancelled_) {
+      mNext.cancel();
+      mPrev.cancel();
+    }
+  }
   comm.mNext().waitForConnection();
   comm.mPrev().waitForConnection();
   comm.mNext().send(partyIdx);
@@ -70,9 +80,6 @@ int MPCOperator::setup(std::string next_ip, std::string prev_ip, u32 next_port,
   binEval.mPrng.SetSeed(toBlock(partyIdx));
   gen.init(toBlock(partyIdx), toBlock((partyIdx + 1) % 3));
 
-  // Copies the Channels and will use them for later protcols.
-  mNext = comm.mNext();
-  mPrev = comm.mPrev();
   auto commPtr = std::make_shared<CommPkg>(comm.mPrev(), comm.mNext());
   runtime.init(partyIdx, commPtr);
   return 1;
@@ -82,6 +89,18 @@ void MPCOperator::fini() {
   mPrev.close();
   mNext.close();
 }
+
+void MPCOperator::cancel() {
+  std::lock_guard<std::mutex> lck(chl_mtx_);
+  cancelled_ = true;
+  mNext.cancel();
+  mPrev.cancel();
+}
+void MPCOperator::channelBytes(u64 *sent, u64 *received) {
+  *sent = mNext.getTotalDataSent() + mPrev.getTotalDataSent();
+  *received = mNext.getTotalDataRecv() + mPrev.getTotalDataRecv();
+}
+
 void MPCOperator::createShares(const i64Matrix &vals,
                                si64Matrix &sharedMatrix) {
   enc.localIntMatrix(runtime, vals, sharedMatrix).get();
@@ -158,6 +177,22 @@ i64 MPCOperator::revealAll(const si64 &val){
   return ret;
 }
 
+i64Matrix MPCOperator::revealSumAll(const i64Matrix &local_vals) {
+  si64Matrix sh_vals(local_vals.rows(), local_vals.cols());
+  i64Matrix ret(local_vals.rows(), local_vals.cols());
+  auto task = enc.localIntMatrix(runtime, local_vals, sh_vals);
+  enc.revealAll(task, sh_vals, ret).get();
+  return ret;
+}
+
+std::vector<i64> MPCOperator::revealSumAll(const std::vector<i64> &local_vals) {
+  i64Matrix vals(local_vals.size(), 1);
+  for (u64 i = 0; i < local_vals.size(); ++i)
+    vals(i) = local_vals[i];
+  i64Matrix sum = revealSumAll(vals);
+  return std::vector<i64>(sum.data(), sum.data() + sum.size());
+}
+
 i64Matrix MPCOperator::reveal(const si64Matrix &vals) {
   i64Matrix ret(vals.rows(), vals.cols());
   enc.reveal(runtime, vals, ret).get();
@@ -317,30 +352,19 @@ void MPCOperator::MPC_Compare(sbMatrix &sh_res) {
   LOG(INFO) << "Party " << (partyIdx + 1) % 3 << " and party "
             << (partyIdx + 2) % 3 << " provide value for MPC compare.";
 
-  // Create binary share.
+  // Create binary share, the MSB circuit runs once both shares are ready,
+  // so share creation and evaluation are waited for only once.
   uint32_t num_elem = all_party_shape[0][0] * all_party_shape[0][1];
-  std::vector<sbMatrix> sh_m_vec;
-  for (uint8_t i = 0; i < 2; i++) {
-    sbMatrix sh_m(num_elem, VAL_BITCOUNT);
-    enc.remoteBinMatrix(runtime.noDependencies(), sh_m).get();
-    sh_m_vec.emplace_back(sh_m);
-  }
-
-  LOG(INFO) << "Create binary share for value from two party finish.";
+  std::vector<sbMatrix> sh_m_vec(2, sbMatrix(num_elem, VAL_BITCOUNT));
+  auto task = enc.remoteBinMatrix(runtime.noDependencies(), sh_m_vec[0]) &&
+              enc.remoteBinMatrix(runtime.noDependencies(), sh_m_vec[1]);
 
-  // Build then run MSB circuit.
-  KoggeStoneLibrary lib;
-  uint64_t size = 64;
-  BetaCircuit *cir = lib.int_int_add_msb(size);
-  cir->levelByAndDepth();
-  auto task = runtime.noDependencies();
-  task.get();
+  BetaCircuit *cir = CircuitCache::getInstance().int_int_add_msb(64);
 
-  sh_res.resize(sh_m_vec[0].i64Size(), 1);
+  sh_res.resize(num_elem, 1);
   std::vector<const sbMatrix *> input = {&sh_m_vec[0], &sh_m_vec[1]};
   std::vector<sbMatrix *> output = {&sh_res};
-  task = binEval.asyncEvaluate(task, cir, gen, input, output);
-  task.get();
+  binEval.asyncEvaluate(task, cir, gen, input, output).get();
 
   LOG(INFO) << "Finish evaluate MSB circuit.";
 }
@@ -3,14 +3,18 @@
 
 #include <Eigen/Dense>
 #include <algorithm>
+#include <cmath>
+#include <mutex>
 #include <random>
+#include <stdexcept>
+#include <string>
 #include <unistd.h>
 #include <vector>
 
 #include "src/primihub/common/defines.h"
 #include "src/primihub/common/type/fixed_point.h"
 #include "src/primihub/common/type/type.h"
-#include "src/primihub/primitive/ppa/kogge_stone.h"
+#include "src/primihub/primitive/circuit/circuit_library.h"
 #include "src/primihub/protocol/aby3/encryptor.h"
 #include "src/primihub/protocol/aby3/evaluator/binary_evaluator.h"
 #include "src/primihub/protocol/aby3/evaluator/evaluator.h"
@@ -43,6 +47,8 @@ public:
   u64 partyIdx;
   string next_name;
   string prev_name;
+  std::mutex chl_mtx_;
+  bool cancelled_ = false;
 
   MPCOperator(u64 partyIdx_, string NextName, string PrevName)
       : partyIdx(partyIdx_), next_name(NextName), prev_name(PrevName) {}
@@ -50,6 +56,10 @@ public:
   int setup(std::string next_ip, std::string prev_ip, u32 next_port,
             u32 prev_port);
   void fini();
+  // thread safe, cancels the channels now or once setup creates them.
+  void cancel();
+  // bytes moved over both channels, valid between setup and fini.
+  void channelBytes(u64 *sent, u64 *received);
   template <Decimal D>
   void createShares(const eMatrix<double> &vals, sf64Matrix<D> &sharedMatrix) {
     f64Matrix<D> fixedMatrix(vals.rows(), vals.cols());
@@ -137,6 +147,77 @@ public:
     return static_cast<double>(ret);
   }
 
+  // Every party inputs a matrix of the same shape and all of them learn
+  // the element-wise sum, e.g. per-column statistics of a horizontally
+  // partitioned dataset. The reveal is chained onto the share task, so
+  // the whole matrix costs one share round and one reveal round.
+  i64Matrix revealSumAll(const i64Matrix &local_vals);
+
+  std::vector<i64> revealSumAll(const std::vector<i64> &local_vals);
+
+  template <Decimal D>
+  eMatrix<double> revealSumAll(const eMatrix<double> &local_vals) {
+    f64Matrix<D> fixed_vals(local_vals.rows(), local_vals.cols());
+    for (u64 i = 0; i < fixed_vals.size(); ++i)
+      fixed_vals(i) = local_vals(i);
+
+    sf64Matrix<D> sh_vals(local_vals.rows(), local_vals.cols());
+    f64Matrix<D> temp(local_vals.rows(), local_vals.cols());
+    auto task = enc.localFixedMatrix(runtime, fixed_vals, sh_vals);
+    enc.revealAll(task, sh_vals, temp).get();
+
+    eMatrix<double> ret(local_vals.rows(), local_vals.cols());
+    for (u64 i = 0; i < ret.size(); ++i)
+      ret(i) = static_cast<double>(temp(i));
+    return ret;
+  }
+
+  template <Decimal D>
+  std::vector<double> revealSumAll(const std::vector<double> &local_vals) {
+    eMatrix<double> vals(local_vals.size(), 1);
+    for (u64 i = 0; i < local_vals.size(); ++i)
+      vals(i) = local_vals[i];
+    eMatrix<double> sum = revealSumAll<D>(vals);
+    return std::vector<double>(sum.data(), sum.data() + sum.size());
+  }
+
+  // Every party inputs its local sum of each column and all of them learn
+  // the mean, counts being the total counts known to every party. A party
+  // shares sum / count instead of sum, split into an integer part shared
+  // as i64 and a fraction shared as fixed point, so sums beyond the fixed
+  // point range (2^47 for D16) do not wrap around.
+  template <Decimal D>
+  std::vector<double> revealMeanAll(const std::vector<double> &local_sums,
+                                    const std::vector<i64> &counts) {
+    i64Matrix int_parts(local_sums.size(), 1);
+    eMatrix<double> fractions(local_sums.size(), 1);
+    for (u64 i = 0; i < local_sums.size(); ++i) {
+      double part = counts[i] > 0 ? local_sums[i] / counts[i] : 0;
+      if (splitMeanPart(part, &int_parts(i), &fractions(i)))
+        throw std::runtime_error("Mean of column " + std::to_string(i) +
+                                 " is out of the i64 range.");
+    }
+    i64Matrix int_sum = revealSumAll(int_parts);
+    eMatrix<double> frac_sum = revealSumAll<D>(fractions);
+
+    std::vector<double> means(local_sums.size());
+    for (u64 i = 0; i < means.size(); ++i)
+      means[i] = static_cast<double>(int_sum(i)) + frac_sum(i);
+    return means;
+  }
+
+  // value = int_part + frac_part with frac_part in [0, 1). Returns -1 if
+  // the integer parts of three parties could overflow i64.
+  static int splitMeanPart(double value, i64 *int_part, double *frac_part) {
+    constexpr double kLimit = static_cast<double>(1ULL << 61);
+    if (!std::isfinite(value) || std::abs(value) >= kLimit)
+      return -1;
+    double floor_value = std::floor(value);
+    *int_part = static_cast<i64>(floor_value);
+    *frac_part = value - floor_value;
+    return 0;
+  }
+
   template <Decimal D> eMatrix<double> reveal(const sf64Matrix<D> &vals) {
     f64Matrix<D> temp(vals.rows(), vals.cols());
     enc.reveal(runtime, vals, temp).get();
@@ -812,39 +893,31 @@ public:
     uint64_t num_elem = all_party_shape[0][0] * all_party_shape[0][1];
     m.resize(num_elem, 1);
 
-    std::vector<sbMatrix> sh_m_vec;
+    // The MSB circuit runs once both shares are ready, so share creation
+    // and evaluation are waited for only once.
+    std::vector<sbMatrix> sh_m_vec(2, sbMatrix(num_elem, VAL_BITCOUNT));
+    std::vector<Sh3Task> share_tasks;
     for (uint64_t i = 0; i < 3; i++) {
       if (static_cast<int>(i) == skip_index)
         continue;
-      if (i == partyIdx) {
-        sbMatrix sh_m(num_elem, VAL_BITCOUNT);
-        auto task = runtime.noDependencies();
-        task.get();
-        enc.localBinMatrix(task, m.i64Cast(), sh_m).get();
-        sh_m_vec.emplace_back(sh_m);
-      } else {
-        sbMatrix sh_m(num_elem, VAL_BITCOUNT);
-        auto task = runtime.noDependencies();
-        task.get();
-        enc.remoteBinMatrix(task, sh_m).get();
-        sh_m_vec.emplace_back(sh_m);
-      }
+      sbMatrix &sh_m = sh_m_vec[share_tasks.size()];
+      if (i == partyIdx)
+        share_tasks.emplace_back(
+            enc.localBinMatrix(runtime.noDependencies(), m.i64Cast(), sh_m));
+      else
+        share_tasks.emplace_back(
+            enc.remoteBinMatrix(runtime.noDependencies(), sh_m));
     }
 
-    LOG(INFO) << "Create binary share for value from two party finish.";
-
-    // Build then run MSB circuit.
-    KoggeStoneLibrary lib;
-    uint64_t size = 64;
-    BetaCircuit *cir = lib.int_int_add_msb(size);
-    cir->levelByAndDepth();
+    BetaCircuit *cir = CircuitCache::getInstance().int_int_add_msb(64);
 
     sh_res.resize(m.size(), 1);
     std::vector<const sbMatrix *> input = {&sh_m_vec[0], &sh_m_vec[1]};
     std::vector<sbMatrix *> output = {&sh_res};
-    auto task = runtime.noDependencies();
-    task = binEval.asyncEvaluate(task, cir, gen, input, output);
-    task.get();
+    binEval
+        .asyncEvaluate(share_tasks[0] && share_tasks[1], cir, gen, input,
+                       output)
+        .get();
     // Recover original value.
     if (skip_index == 0 || skip_index == 1) {
       if (partyIdx == 2)
@@ -222,4 +222,26 @@ BetaCircuit *CircuitLibrary::convert_arith_to_bin(u64 n, u64 bits) {
   return iter->second;
 }
 
+BetaCircuit *CircuitCache::levelled(BetaCircuit *cir) {
+  if (cir->mLevelCounts.size() == 0)
+    cir->levelByAndDepth();
+  return cir;
+}
+
+BetaCircuit *CircuitCache::int_int_add_msb(u64 size) {
+  std::lock_guard<std::mutex> lck(mtx_);
+  return levelled(kogge_stone_lib_.int_int_add_msb(size));
+}
+
+BetaCircuit *CircuitCache::int_Sh3Piecewise_helper(u64 size,
+                                                   u64 numThesholds) {
+  std::lock_guard<std::mutex> lck(mtx_);
+  return levelled(lib_.int_Sh3Piecewise_helper(size, numThesholds));
+}
+
+BetaCircuit *CircuitCache::convert_arith_to_bin(u64 n, u64 bits) {
+  std::lock_guard<std::mutex> lck(mtx_);
+  return levelled(lib_.convert_arith_to_bin(n, bits));
+}
+
 } // namespace primihub
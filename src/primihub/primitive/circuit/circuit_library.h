@@ -3,6 +3,7 @@
 #define SRC_primihub_PRIMITIVE_CIRCUIT_CIRCUIT_LIBRARY_H_
 
 
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 #include <utility>
@@ -10,6 +11,7 @@
 #include "src/primihub/common/defines.h"
 #include "src/primihub/primitive/circuit/beta_circuit.h"
 #include "src/primihub/primitive/circuit/beta_library.h"
+#include "src/primihub/primitive/ppa/kogge_stone.h"
 
 namespace primihub {
 
@@ -30,6 +32,33 @@ class CircuitLibrary : public BetaLibrary {
 
 };
 
+// Process wide cache of circuits keyed by circuit type and bit width.
+// A circuit is built and levelled by and depth once, under the lock, and is
+// only read afterwards, so evaluators in different threads can share it.
+// Circuits live until the process exits.
+class CircuitCache {
+ public:
+  static CircuitCache& getInstance() {
+    static CircuitCache kSingleInstance;
+    return kSingleInstance;
+  }
+
+  // Kogge-Stone msb of a + b, used by compare.
+  BetaCircuit* int_int_add_msb(u64 size);
+
+  BetaCircuit* int_Sh3Piecewise_helper(u64 size, u64 numThesholds);
+
+  BetaCircuit* convert_arith_to_bin(u64 n, u64 bits);
+
+ private:
+  CircuitCache() = default;
+  BetaCircuit* levelled(BetaCircuit* cir);
+
+  std::mutex mtx_;
+  CircuitLibrary lib_;
+  KoggeStoneLibrary kogge_stone_lib_;
+};
+
 }  // namespace primihub
 
 #endif  // SRC_primihub_PRIMITIVE_CIRCUIT_CIRCUIT_LIBRARY_H_
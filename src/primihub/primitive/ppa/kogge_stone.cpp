@@ -404,6 +404,8 @@ BetaCircuit *KoggeStoneLibrary::int_int_add_msb(u64 size) {
   circuit->addTempWireBundle(t);
   int_int_add_msb_build_optimized(circuit, a, b, msb, t);
 
+  // Owned by the library, which deletes it in destructor.
+  mCirMap.insert(std::make_pair(key, circuit));
   return circuit;
 }
 
@@ -1,6 +1,8 @@
 
 #include "src/primihub/protocol/aby3/evaluator/evaluator.h"
 
+#include <glog/logging.h>
+
 namespace primihub {
 
   void Sh3Evaluator::init(u64 partyIdx, block prevSeed, block nextSeed, u64
@@ -287,8 +289,89 @@ namespace primihub {
       }).getClosure();
   }
 
+  u64 TruncationPairStore::size(u64 d) const {
+    auto it = mPools.find(d);
+    if (it == mPools.end())
+      return 0;
+    return it->second.mR.size() - it->second.mOffset;
+  }
+
+  void TruncationPairStore::push(u64 d, const TruncationPair& pair) {
+    u64 n = pair.mR.size();
+    if (n > remaining())
+      throw std::runtime_error(LOCATION);
+
+    auto& pool = mPools[d];
+    // drop the consumed prefix before the pool grows
+    if (pool.mOffset) {
+      pool.mR.erase(pool.mR.begin(), pool.mR.begin() + pool.mOffset);
+      pool.mRTrunc0.erase(pool.mRTrunc0.begin(),
+                          pool.mRTrunc0.begin() + pool.mOffset);
+      pool.mRTrunc1.erase(pool.mRTrunc1.begin(),
+                          pool.mRTrunc1.begin() + pool.mOffset);
+      pool.mOffset = 0;
+    }
+    pool.mR.insert(pool.mR.end(), pair.mR.data(), pair.mR.data() + n);
+    pool.mRTrunc0.insert(pool.mRTrunc0.end(), pair.mRTrunc[0].data(),
+                         pair.mRTrunc[0].data() + n);
+    pool.mRTrunc1.insert(pool.mRTrunc1.end(), pair.mRTrunc[1].data(),
+                         pair.mRTrunc[1].data() + n);
+    mSize += n;
+  }
+
+  bool TruncationPairStore::pop(u64 d, u64 xSize, u64 ySize,
+                                TruncationPair& pair) {
+    u64 n = xSize * ySize;
+    auto it = mPools.find(d);
+    if (it == mPools.end() || it->second.mR.size() - it->second.mOffset < n)
+      return false;
+
+    auto& pool = it->second;
+    pair.mR.resize(xSize, ySize);
+    pair.mRTrunc.resize(xSize, ySize);
+    std::copy_n(pool.mR.data() + pool.mOffset, n, pair.mR.data());
+    std::copy_n(pool.mRTrunc0.data() + pool.mOffset, n,
+                pair.mRTrunc[0].data());
+    std::copy_n(pool.mRTrunc1.data() + pool.mOffset, n,
+                pair.mRTrunc[1].data());
+    pool.mOffset += n;
+    mSize -= n;
+    if (pool.mOffset == pool.mR.size())
+      mPools.erase(it);
+    return true;
+  }
+
+  void TruncationPairStore::clear() {
+    mPools.clear();
+    mSize = 0;
+  }
+
+  u64 Sh3Evaluator::preprocess(u64 n, u64 d) {
+    if (DEBUG_disable_randomization)
+      return 0;
+    if (n > mTruncationStore.remaining()) {
+      LOG(WARNING) << "Truncation store is full, preprocess "
+                   << mTruncationStore.remaining() << " of " << n
+                   << " pairs for shift " << d << ".";
+      n = mTruncationStore.remaining();
+    }
+    if (n == 0)
+      return 0;
+    mTruncationStore.push(d, generateTruncationTuple(n, 1, d));
+    return n;
+  }
+
   TruncationPair Sh3Evaluator::getTruncationTuple(u64 xSize, u64 ySize, u64 d) {
     TruncationPair pair;
+    if (!DEBUG_disable_randomization &&
+        mTruncationStore.pop(d, xSize, ySize, pair))
+      return pair;
+    return generateTruncationTuple(xSize, ySize, d);
+  }
+
+  TruncationPair Sh3Evaluator::generateTruncationTuple(u64 xSize, u64 ySize,
+                                                       u64 d) {
+    TruncationPair pair;
     if (DEBUG_disable_randomization) {
         pair.mR.resize(xSize, ySize);
         pair.mR.setZero();
@@ -3,6 +3,7 @@
 #define SRC_primihub_PROTOCOL_ABY3_EVALUATOR_EVALUATOR_H_
 
 #include <iomanip>
+#include <map>
 #include <vector>
 #include <memory>
 #include <utility>
@@ -27,6 +28,39 @@ struct TruncationPair {
     si64Matrix mRTrunc;
 };
 
+// Truncation pairs generated ahead of the online phase, one pool per
+// truncation shift. The pairs are drawn from the PRNGs shared with the
+// neighbours, so every party has to fill and consume the store in the same
+// order. Pools are flat, a pair of any shape takes the next elements.
+class TruncationPairStore {
+ public:
+  explicit TruncationPairStore(u64 maxSize = 1ull << 22)
+      : mMaxSize(maxSize) {}
+
+  // number of elements which can still be stored.
+  u64 remaining() const { return mMaxSize - mSize; }
+  u64 size() const { return mSize; }
+  u64 size(u64 d) const;
+
+  // appends the elements of pair to the pool of shift d, pair must fit.
+  void push(u64 d, const TruncationPair& pair);
+
+  // takes xSize * ySize elements of the pool of shift d, returns false
+  // and takes nothing if the pool holds fewer.
+  bool pop(u64 d, u64 xSize, u64 ySize, TruncationPair& pair);
+
+  void clear();
+
+ private:
+  struct Pool {
+    std::vector<i64> mR, mRTrunc0, mRTrunc1;
+    u64 mOffset = 0;
+  };
+
+  std::map<u64, Pool> mPools;
+  u64 mMaxSize, mSize = 0;
+};
+
 class Sh3Evaluator {
  public:
   void init(u64 partyIdx, block prevSeed, block nextSeed, u64 buffSize = 256);
@@ -115,8 +149,18 @@ class Sh3Evaluator {
                               C.i64Cast(), D);
   }
 
+  // Offline phase: generates n truncation pairs for shift d into
+  // mTruncationStore, bounded by its capacity. Returns the number of pairs
+  // generated. getTruncationTuple serves from the store before it falls
+  // back to generating pairs online.
+  u64 preprocess(u64 n, u64 d);
+
   TruncationPair getTruncationTuple(u64 xSize, u64 ySize, u64 d);
 
+  TruncationPair generateTruncationTuple(u64 xSize, u64 ySize, u64 d);
+
+  TruncationPairStore mTruncationStore;
+
   u64 mPartyIdx = -1, mTruncationIdx = 0;
   Sh3ShareGen mShareGen;
   SharedOT mOtPrev, mOtNext;
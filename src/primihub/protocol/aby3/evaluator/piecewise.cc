@@ -379,8 +379,8 @@ namespace primihub {
       }
 
       // std::cout << "before lib.int_Sh3Piecewise_helper, mThresholds.size():" << mThresholds.size() << ", sizeof(i64) * 8:" << sizeof(i64) * 8 << std::endl;
-      auto cir = lib.int_Sh3Piecewise_helper(sizeof(i64) * 8,
-        mThresholds.size());
+      auto cir = CircuitCache::getInstance().int_Sh3Piecewise_helper(
+        sizeof(i64) * 8, mThresholds.size());
       // std::cout << "after lib.int_Sh3Piecewise_helper" << std::endl;
 
       binEng.setCir(cir, inputs.size(), gen);
@@ -118,7 +118,6 @@ class Sh3Piecewise {
   std::vector<sbMatrix> circuitInput0;
   sbMatrix circuitInput1;
   Sh3BinaryEvaluator binEng;
-  CircuitLibrary lib;
   std::vector<si64Matrix> functionOutputs;
 
   Sh3Encryptor DebugEnc;
@@ -16,15 +16,28 @@
 
 
 #include "src/primihub/service/dataset/localkv/storage_leveldb.h"
+
+#include <leveldb/write_batch.h>
+
 #include "src/primihub/service/dataset/util.hpp"
 #include "src/primihub/service/error.hpp"
 
 namespace primihub::service {
 
-StorageBackendLevelDB::StorageBackendLevelDB(std::string path) : path_(path) {
-    leveldb::Options options;
-    options.create_if_missing = true;
-    leveldb::Status status = leveldb::DB::Open(options, path_, &db_);
+StorageBackendLevelDB::StorageBackendLevelDB(std::string path, const Options &options)
+    : path_(path), options_(options) {
+    leveldb::Options db_options;
+    db_options.create_if_missing = true;
+    db_options.write_buffer_size = options_.write_buffer_size;
+    if (options_.block_cache_size > 0) {
+        block_cache_.reset(leveldb::NewLRUCache(options_.block_cache_size));
+        db_options.block_cache = block_cache_.get();
+    }
+    if (options_.bloom_bits_per_key > 0) {
+        filter_policy_.reset(leveldb::NewBloomFilterPolicy(options_.bloom_bits_per_key));
+        db_options.filter_policy = filter_policy_.get();
+    }
+    leveldb::Status status = leveldb::DB::Open(db_options, path_, &db_);
     if (!status.ok()) {
         throw Error::INTERNAL_ERROR;
     }
@@ -35,6 +48,11 @@ StorageBackendLevelDB::~StorageBackendLevelDB()  {
     delete db_;
 }
 
+leveldb::WriteOptions StorageBackendLevelDB::writeOptions() const {
+    leveldb::WriteOptions write_options;
+    write_options.sync = options_.sync;
+    return write_options;
+}
 
 outcome::result<void> StorageBackendLevelDB::putValue(Key key, Value value) {
     // Kade::ContentId to leveldb::Slice
@@ -42,7 +60,7 @@ outcome::result<void> StorageBackendLevelDB::putValue(Key key, Value value) {
     leveldb::Slice key_slice = key_str;
     try {
         // leveldb::Status to outcome::result<void>
-        auto status = db_->Put(leveldb::WriteOptions(), key_slice, value);
+        auto status = db_->Put(writeOptions(), key_slice, value);
         if (!status.ok()) {
             return Error::INTERNAL_ERROR;
         }
@@ -50,16 +68,38 @@ outcome::result<void> StorageBackendLevelDB::putValue(Key key, Value value) {
         std::cout << "StorageBackendLevelDB::putValue() exception: " << e.what() << std::endl;
         return Error::INTERNAL_ERROR;
     }
-    
+
     return outcome::success();
 }
 
-outcome::result<Value> StorageBackendLevelDB::getValue(const Key &key) const {
+outcome::result<void> StorageBackendLevelDB::putValues(
+        const std::vector<std::pair<Key, Value>> &kvs) {
+    if (kvs.empty()) {
+        return outcome::success();
+    }
+    try {
+        leveldb::WriteBatch batch;
+        for (const auto &kv : kvs) {
+            batch.Put(Key2Str(kv.first), kv.second);
+        }
+        auto status = db_->Write(writeOptions(), &batch);
+        if (!status.ok()) {
+            return Error::INTERNAL_ERROR;
+        }
+    } catch (const std::exception &e) {
+        std::cout << "StorageBackendLevelDB::putValues() exception: " << e.what() << std::endl;
+        return Error::INTERNAL_ERROR;
+    }
+    return outcome::success();
+}
+
+outcome::result<Value> StorageBackendLevelDB::get(
+        const leveldb::ReadOptions &read_options, const Key &key) const {
     std::string value;
     auto key_str = Key2Str(key);
     leveldb::Slice key_slice = key_str;
     try {
-        auto status = db_->Get(leveldb::ReadOptions(), key_slice, &value);
+        auto status = db_->Get(read_options, key_slice, &value);
         if (!status.ok()) {
             return Error::VALUE_NOT_FOUND;
         }
@@ -70,27 +110,78 @@ outcome::result<Value> StorageBackendLevelDB::getValue(const Key &key) const {
     return outcome::success(value);
 }
 
+outcome::result<Value> StorageBackendLevelDB::getValue(const Key &key) const {
+    return get(leveldb::ReadOptions(), key);
+}
+
 outcome::result<void> StorageBackendLevelDB::erase(const Key &key) {
     auto key_str = Key2Str(key);
     leveldb::Slice key_slice = key_str;
-    leveldb::Status status = db_->Delete(leveldb::WriteOptions(), key_slice);
+    leveldb::Status status = db_->Delete(writeOptions(), key_slice);
     if (!status.ok()) {
         return Error::INTERNAL_ERROR;
     }
     return outcome::success();
 }
 
+outcome::result<void> StorageBackendLevelDB::iterate(leveldb::ReadOptions read_options,
+        const KVVisitor &visitor) const {
+    // a full scan would only evict the hot metas from the block cache
+    read_options.fill_cache = false;
+    std::unique_ptr<leveldb::Iterator> it(db_->NewIterator(read_options));
+    try {
+        for (it->SeekToFirst(); it->Valid(); it->Next()) {
+            auto key = Str2Key(it->key().ToString());
+            if (!visitor(key, it->value().ToString())) {
+                break;
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cout << "StorageBackendLevelDB::iterate() exception: " << e.what() << std::endl;
+        return Error::INTERNAL_ERROR;
+    }
+    if (!it->status().ok()) {
+        return Error::INTERNAL_ERROR;
+    }
+    return outcome::success();
+}
+
+outcome::result<void> StorageBackendLevelDB::forEach(const KVVisitor &visitor) const {
+    return iterate(leveldb::ReadOptions(), visitor);
+}
+
 outcome::result<std::vector<std::pair<Key, Value>>>
 StorageBackendLevelDB::getAll() const {
     std::vector<std::pair<Key, Value>> result;
-    leveldb::Iterator *it = db_->NewIterator(leveldb::ReadOptions());
-    for (it->SeekToFirst(); it->Valid(); it->Next()) {
-        auto key = Str2Key(it->key().ToString());
-        auto value = it->value().ToString();
+    auto r = forEach([&result](const Key &key, const Value &value) {
         result.emplace_back(key, value);
+        return true;
+    });
+    if (!r) {
+        return r.error();
     }
-    delete it;
     return outcome::success(result);
 }
 
+std::unique_ptr<StorageBackendLevelDB::Snapshot> StorageBackendLevelDB::snapshot() const {
+    return std::unique_ptr<Snapshot>(new Snapshot(this, db_->GetSnapshot()));
+}
+
+StorageBackendLevelDB::Snapshot::~Snapshot() {
+    storage_->db_->ReleaseSnapshot(snapshot_);
+}
+
+outcome::result<Value> StorageBackendLevelDB::Snapshot::getValue(const Key &key) const {
+    leveldb::ReadOptions read_options;
+    read_options.snapshot = snapshot_;
+    return storage_->get(read_options, key);
+}
+
+outcome::result<void> StorageBackendLevelDB::Snapshot::forEach(
+        const KVVisitor &visitor) const {
+    leveldb::ReadOptions read_options;
+    read_options.snapshot = snapshot_;
+    return storage_->iterate(read_options, visitor);
+}
+
 } // namespace primihub::service
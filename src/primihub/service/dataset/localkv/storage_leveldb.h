@@ -17,14 +17,53 @@
 #ifndef SRC_PRIMIHUB_SERVICE_DATASET_LOCALKV_STORAGE_LEVELDB_H_
 #define SRC_PRIMIHUB_SERVICE_DATASET_LOCALKV_STORAGE_LEVELDB_H_
 
+#include <memory>
 #include <string>
+#include <leveldb/cache.h>
 #include <leveldb/db.h>
+#include <leveldb/filter_policy.h>
 #include "src/primihub/service/dataset/storage_backend.h"
 
 namespace primihub::service {
+    /**
+     * Local meta storage on LevelDB.
+     *
+     * Metas are small json documents read by id, so reads are served from
+     * an LRU block cache and a bloom filter skips the sst files which do
+     * not hold the key. Keys are stored in their CID string form, a hash,
+     * so the iteration order carries no meaning.
+     */
     class StorageBackendLevelDB : public StorageBackend {
       public:
-        StorageBackendLevelDB(std::string path);
+        struct Options {
+            size_t block_cache_size{8 << 20};
+            int bloom_bits_per_key{10};     // 0 disables the bloom filter
+            size_t write_buffer_size{4 << 20};
+            bool sync{false};               // fsync every write
+        };
+
+        /**
+         * Consistent read view of the db, writes after its creation are
+         * not visible through it.
+         */
+        class Snapshot {
+          public:
+            ~Snapshot();
+            outcome::result<Value> getValue(const Key &key) const;
+            outcome::result<void> forEach(const KVVisitor &visitor) const;
+
+          private:
+            friend class StorageBackendLevelDB;
+            Snapshot(const StorageBackendLevelDB *storage,
+                     const leveldb::Snapshot *snapshot)
+                : storage_(storage), snapshot_(snapshot) {}
+
+            const StorageBackendLevelDB *storage_;
+            const leveldb::Snapshot *snapshot_;
+        };
+
+        explicit StorageBackendLevelDB(std::string path,
+                                       const Options &options = Options());
         ~StorageBackendLevelDB();
 
         outcome::result<void> putValue(Key key, Value value) override;
@@ -35,8 +74,25 @@ namespace primihub::service {
 
         outcome::result<std::vector<std::pair<Key, Value>>> getAll() const override;
 
+        // one WriteBatch for all pairs
+        outcome::result<void> putValues(
+            const std::vector<std::pair<Key, Value>> &kvs) override;
+
+        outcome::result<void> forEach(const KVVisitor &visitor) const override;
+
+        std::unique_ptr<Snapshot> snapshot() const;
+
       private:
+        outcome::result<Value> get(const leveldb::ReadOptions &read_options,
+                                   const Key &key) const;
+        outcome::result<void> iterate(leveldb::ReadOptions read_options,
+                                      const KVVisitor &visitor) const;
+        leveldb::WriteOptions writeOptions() const;
+
         std::string path_;
+        Options options_;
+        std::unique_ptr<leveldb::Cache> block_cache_;
+        std::unique_ptr<const leveldb::FilterPolicy> filter_policy_;
         leveldb::DB *db_;
 
     }; // class StorageBackendLevelDB
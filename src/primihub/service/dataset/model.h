@@ -140,6 +140,9 @@ class DatasetMeta {
     void setDataURL(const std::string &data_url) { this->data_url = data_url; }
     std::shared_ptr<DatasetSchema> getSchema() { return schema; }
     uint64_t getTotalRecords() { return total_records; }
+    void setTotalRecords(uint64_t total_records) {
+        this->total_records = total_records;
+    }
     DatasetId id;
 
   private:
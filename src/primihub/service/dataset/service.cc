@@ -15,15 +15,24 @@
  */
 
 #include <glog/logging.h>
+#include <stdio.h>
+#include <sys/stat.h>
 
+#include <algorithm>
+#include <condition_variable>
 #include <future>
+#include <set>
 #include <thread>
 #include <chrono>
 
+#include <arrow/csv/writer.h>
+#include <arrow/io/file.h>
+
 #include "src/primihub/service/dataset/service.h"
 #include "src/primihub/data_store/factory.h"
 #include "src/primihub/common/config/config.h"
 #include "src/primihub/service/dataset/util.hpp"
+#include "src/primihub/util/metrics.h"
 
 using namespace std::chrono_literals;
 
@@ -56,6 +65,9 @@ namespace primihub::service {
                                 std::shared_ptr<primihub::DataDriver> driver,
                                 const std::string& description, // TODO put description in meta
                                 DatasetMeta& meta) {
+        if (!columnar_format_.empty() && driver->getDriverType() == "CSV") {
+            driver = convertToColumnar(driver);
+        }
         // Read data using driver for get dataset & datameta
         // TODO just get meta info from dataset
         auto dataset = driver->getCursor()->read();
@@ -66,6 +78,45 @@ namespace primihub::service {
         return dataset;
     }
 
+    /**
+     * @brief Convert csv file to columnar format next to it, so the text is
+     *        parsed and the column types are inferred only once.
+     *        The converted file is reused as long as it is newer than the csv.
+     * @return driver of the columnar file, or csv_driver if conversion failed
+     */
+    std::shared_ptr<primihub::DataDriver> DatasetService::convertToColumnar(
+                                std::shared_ptr<primihub::DataDriver> csv_driver) {
+        std::string csv_path = csv_driver->getDataURL();
+        auto dot = csv_path.find_last_of('.');
+        auto slash = csv_path.find_last_of('/');
+        std::string target = csv_path;
+        if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+            target = csv_path.substr(0, dot);
+        }
+        target += columnar_format_ == "parquet" ? ".parquet" : ".arrow";
+
+        auto driver = DataDirverFactory::getDriver(
+            DataDirverFactory::getDriverNameByPath(target), nodelet_addr_);
+        struct stat csv_stat, target_stat;
+        bool converted = stat(csv_path.c_str(), &csv_stat) == 0 &&
+                         stat(target.c_str(), &target_stat) == 0 &&
+                         target_stat.st_mtime >= csv_stat.st_mtime;
+        if (!converted) {
+            auto reader = csv_driver->getCursor()->readBatches();
+            if (reader == nullptr) {
+                return csv_driver;
+            }
+            // the cursor writes a temp file and renames it into place
+            if (driver->initCursor(target)->writeBatches(reader) != 0) {
+                LOG(ERROR) << "Convert " << csv_path << " to " << target << " failed";
+                return csv_driver;
+            }
+            LOG(INFO) << "Converted " << csv_path << " to " << target;
+        }
+        driver->read(target);
+        return driver;
+    }
+
     /**
      * @brief write dataset to local storage
      * @param dataset [input]: Dataset to be written with own driver
@@ -153,6 +204,9 @@ namespace primihub::service {
         std::string nodelet_addr = config["node"].as<std::string>() + ":"
             + config["location"].as<std::string>() + ":"
             + std::to_string(config["grpc_port"].as<uint64_t>());
+        if (config["columnar_format"]) {
+            setColumnarFormat(config["columnar_format"].as<std::string>());
+        }
         if (config["datasets"]) {
             for (const auto& dataset : config["datasets"]) {
                 auto dataset_type = dataset["model"].as<std::string>();
@@ -178,7 +232,9 @@ namespace primihub::service {
         LOG(INFO) << "💾 Restore dataset from local storage...";
         std::vector<DatasetMeta> metas;
         metaService_->getAllLocalMetas(metas);
-        for (auto meta : metas) {
+        std::vector<DatasetMeta> restored;
+        restored.reserve(metas.size());
+        for (auto& meta : metas) {
             // Update node let address.
             std::string node_id, node_ip, dataset_path;
             int node_port;
@@ -189,9 +245,10 @@ namespace primihub::service {
             }
 
             meta.setDataURL(nodelet_addr_ + ":" + dataset_path);
-            // Publish dataset meta on libp2p network.
-            metaService_->putMeta(meta);
+            restored.push_back(std::move(meta));
         }
+        // Publish dataset meta on libp2p network.
+        metaService_->putMetas(restored);
     }
 
     void DatasetService::setMetaSearchTimeout(unsigned int timeout) {
@@ -200,11 +257,45 @@ namespace primihub::service {
        }
     }
 
+    void DatasetService::setMetaCacheTTL(unsigned int ttl, unsigned int negative_ttl) {
+       if (metaService_) {
+          metaService_->setMetaCacheTTL(ttl, negative_ttl);
+       }
+    }
+
     std::string DatasetService::getNodeletAddr(void) {
         return nodelet_addr_;
     }
 
     // ======================== DatasetMetaService ====================================
+    namespace {
+    // process wide series of the counters in MetaLookupStats
+    struct MetaLookupMetrics {
+        Counter& lookups;
+        Counter& cache_hits;
+        Counter& dht_queries;
+        Counter& timeouts;
+        Histogram& latency;
+    };
+
+    MetaLookupMetrics& metaLookupMetrics() {
+        auto& registry = MetricsRegistry::getInstance();
+        static MetaLookupMetrics metrics{
+            registry.counter("primihub_meta_lookups_total", {},
+                             "Dataset meta lookups of task schedulers."),
+            registry.counter("primihub_meta_cache_hits_total", {},
+                             "Dataset metas answered from the meta cache."),
+            registry.counter("primihub_meta_dht_queries_total", {},
+                             "DHT queries sent for dataset metas."),
+            registry.counter("primihub_meta_lookup_timeouts_total", {},
+                             "Dataset meta lookups which timed out."),
+            registry.histogram("primihub_meta_lookup_duration_seconds", {},
+                               "Elapsed time of dataset meta lookups.", 1e-3),
+        };
+        return metrics;
+    }
+    }  // namespace
+
     DatasetMetaService::DatasetMetaService(std::shared_ptr<primihub::p2p::NodeStub> p2pStub,
                                    std::shared_ptr<StorageBackend> localKv) {
         p2pStub_ = p2pStub;
@@ -213,15 +304,11 @@ namespace primihub::service {
 
     // Get all local metas
     outcome::result<void> DatasetMetaService::getAllLocalMetas(std::vector<DatasetMeta> & metas) {
-        // Get all k, v from local storage
-        auto r = localKv_->getAll();
-        auto rl = r.value();
-        for (auto kv_pair : rl) {
-            // Construct meta from k, v
-            auto meta = DatasetMeta(kv_pair.second);
-            metas.push_back(meta);
-        }
-        return outcome::success();
+        // Construct meta from each k, v of local storage
+        return localKv_->forEach([&metas](const Key& key, const Value& value) {
+            metas.emplace_back(value);
+            return true;
+        });
     }
 
     std::shared_ptr<DatasetMeta> DatasetMetaService::getLocalMeta(const DatasetId& id) {
@@ -237,11 +324,28 @@ namespace primihub::service {
         LOG(INFO) << "<< Put meta: "<< meta_str;
          // Save datameta in local storage.
         localKv_->putValue(meta.id,  meta_str);
+        cacheMeta(meta.getDescription(), std::make_shared<DatasetMeta>(meta));
 
         // Publish dataset meta on libp2p network.
         p2pStub_->putDHTValue(meta.id, meta_str);
     }
 
+    void DatasetMetaService::putMetas(std::vector<DatasetMeta>& metas) {
+        std::vector<std::pair<Key, Value>> kvs;
+        kvs.reserve(metas.size());
+        for (auto& meta : metas) {
+            kvs.emplace_back(meta.id, meta.toJSON());
+        }
+        auto r = localKv_->putValues(kvs);
+        if (!r) {
+            LOG(ERROR) << "Save " << kvs.size() << " metas in local storage failed";
+        }
+        for (size_t i = 0; i < metas.size(); i++) {
+            cacheMeta(metas[i].getDescription(), std::make_shared<DatasetMeta>(metas[i]));
+            p2pStub_->putDHTValue(metas[i].id, kvs[i].second);
+        }
+    }
+
 
     outcome::result<void> DatasetMetaService::getMeta(const DatasetId& id,
                                     FoundMetaHandler handler) {
@@ -264,6 +368,7 @@ namespace primihub::service {
                     std::copy(r.begin(), r.end(), std::ostream_iterator<uint8_t>(rs, ""));
                     std::cout<<rs.str()<<std::endl;
                     auto _meta = std::make_shared<DatasetMeta>(std::move(rs.str()));
+                    cacheMeta(_meta->getDescription(), _meta);
                     handler(_meta);
                 } catch (std::exception& e) {
                     LOG(ERROR) << "<< Get meta failed: " << e.what();
@@ -273,96 +378,293 @@ namespace primihub::service {
         return outcome::success();
     }
 
+    DatasetMetaService::CacheState DatasetMetaService::lookupCache(
+            const std::string& key, std::shared_ptr<DatasetMeta>* meta) {
+        std::lock_guard<std::mutex> lck(meta_cache_mtx_);
+        auto it = meta_cache_.find(key);
+        if (it == meta_cache_.end()) {
+            return CacheState::MISS;
+        }
+        if (std::chrono::steady_clock::now() >= it->second.expire_at) {
+            meta_cache_.erase(it);
+            return CacheState::MISS;
+        }
+        if (it->second.meta == nullptr) {
+            return CacheState::NOT_FOUND;
+        }
+        *meta = it->second.meta;
+        return CacheState::HIT;
+    }
 
-      outcome::result<void> DatasetMetaService::findPeerListFromDatasets(
-                                                        const std::vector<DatasetWithParamTag>& datasets_with_tag,
-                                                        FoundMetaListHandler handler) {
-        std::vector<DatasetMetaWithParamTag> meta_list;
-        std::map<std::string, DatasetMetaWithParamTag> meta_map; // key: dataset_id
-        meta_map.clear();
-        std::mutex meta_map_mtx;
-        std::condition_variable meta_cond;
-        std::atomic get_value{false};
-        auto t_start = std::chrono::high_resolution_clock::now();
+    void DatasetMetaService::cacheMeta(const std::string& key,
+                                       std::shared_ptr<DatasetMeta> meta) {
+        auto expire_at = std::chrono::steady_clock::now() +
+                         std::chrono::seconds(meta_cache_ttl_);
+        std::lock_guard<std::mutex> lck(meta_cache_mtx_);
+        meta_cache_[key] = MetaCacheEntry{std::move(meta), expire_at};
+    }
+
+    void DatasetMetaService::cacheNotFound(const std::string& key) {
+        auto expire_at = std::chrono::steady_clock::now() +
+                         std::chrono::seconds(meta_negative_ttl_);
+        std::lock_guard<std::mutex> lck(meta_cache_mtx_);
+        auto it = meta_cache_.find(key);
+        // never let a miss shadow a meta we already know
+        if (it != meta_cache_.end() && it->second.meta != nullptr) {
+            return;
+        }
+        meta_cache_[key] = MetaCacheEntry{nullptr, expire_at};
+    }
+
+    void DatasetMetaService::recordLookup(uint64_t latency_ms, bool is_timeout) {
+        auto& metrics = metaLookupMetrics();
+        stat_lookups_++;
+        metrics.lookups.inc();
+        stat_total_latency_ms_ += latency_ms;
+        metrics.latency.observe(latency_ms);
+        if (is_timeout) {
+            stat_timeouts_++;
+            metrics.timeouts.inc();
+        }
+        uint64_t max_latency = stat_max_latency_ms_.load();
+        while (latency_ms > max_latency &&
+               !stat_max_latency_ms_.compare_exchange_weak(max_latency, latency_ms)) {
+        }
+    }
+
+    MetaLookupStats DatasetMetaService::getMetaLookupStats() const {
+        MetaLookupStats stats;
+        stats.lookups = stat_lookups_.load();
+        stats.cache_hits = stat_cache_hits_.load();
+        stats.dht_queries = stat_dht_queries_.load();
+        stats.timeouts = stat_timeouts_.load();
+        stats.total_latency_ms = stat_total_latency_ms_.load();
+        stats.max_latency_ms = stat_max_latency_ms_.load();
+        return stats;
+    }
+
+    /**
+     * Resolve metas of all datasets at once: every dataset which is neither
+     * cached nor stored locally gets its own DHT query, all of them in flight
+     * together, and the whole search shares one deadline.
+     * A DHT query without answer is sent again after dht_retry, a dataset the
+     * DHT did not know is asked again once its negative cache entry expires.
+     */
+    outcome::result<void> DatasetMetaService::findPeerListFromDatasets(
+            const std::vector<DatasetWithParamTag>& datasets_with_tag,
+            FoundMetaListHandler handler) {
+        // shared with DHT callbacks, they may fire after a timeout returned
+        struct LookupState {
+            std::mutex mtx;
+            std::condition_variable cond;
+            std::map<std::string, std::shared_ptr<DatasetMeta>> found; // key: dataset name
+            std::map<std::string, std::chrono::steady_clock::time_point> in_flight;
+            uint64_t replies{0};
+        };
+        using Clock = std::chrono::steady_clock;
+        const auto dht_retry = std::chrono::seconds(2);
+        const auto max_wait = std::chrono::milliseconds(1000);
+        auto state = std::make_shared<LookupState>();
+        std::set<std::string> dataset_names;
+        for (const auto& dataset_item : datasets_with_tag) {
+            dataset_names.insert(std::get<0>(dataset_item));
+        }
+        auto t_start = Clock::now();
+        auto deadline = t_start + std::chrono::seconds(this->meta_search_timeout_);
+        auto wait_interval = std::chrono::milliseconds(50);
         bool is_timeout = false;
         for (;;) {
-            // TODO timeout guard
-            auto t_now = std::chrono::high_resolution_clock::now();
-            if (std::chrono::duration_cast<std::chrono::seconds>(t_now - t_start).count() > this->meta_search_timeout_) {
-                LOG(ERROR) << " 🔍 ⏱️  Timeout while searching meta list.";
-                is_timeout = true;
-                break;
+            std::vector<std::string> to_query;
+            for (const auto& dataset_name : dataset_names) {
+                {
+                    std::lock_guard<std::mutex> lck(state->mtx);
+                    if (state->found.count(dataset_name)) {
+                        continue;
+                    }
+                }
+                std::shared_ptr<DatasetMeta> meta;
+                auto cache_state = lookupCache(dataset_name, &meta);
+                if (cache_state == CacheState::MISS) {
+                    // Try get meta from local storage
+                    auto res = localKv_->getValue(DatasetId(dataset_name));
+                    if (res.has_value()) {
+                        LOG(INFO) << "Found local meta: " << res.value();
+                        meta = std::make_shared<DatasetMeta>(res.value());
+                        cacheMeta(dataset_name, meta);
+                    }
+                } else if (cache_state == CacheState::HIT) {
+                    stat_cache_hits_++;
+                    metaLookupMetrics().cache_hits.inc();
+                }
+                std::lock_guard<std::mutex> lck(state->mtx);
+                if (meta != nullptr) {
+                    state->found[dataset_name] = meta;
+                    continue;
+                }
+                if (cache_state == CacheState::NOT_FOUND) {
+                    continue;
+                }
+                auto now = Clock::now();
+                auto it = state->in_flight.find(dataset_name);
+                if (it != state->in_flight.end() && now - it->second < dht_retry) {
+                    continue;
+                }
+                state->in_flight[dataset_name] = now;
+                to_query.push_back(dataset_name);
             }
 
-            for (auto dataset_item : datasets_with_tag) {
-                auto dataset_name = std::get<0>(dataset_item);
-                auto dataset_tag = std::get<1>(dataset_item);
-                DatasetId id(dataset_name);
-                // Try get meta from local storage or p2p network
-                auto res = localKv_->getValue(id);
-                if (res.has_value()) {
-                    // construct dataset meta from json meta.
-                    auto _meta = std::make_shared<DatasetMeta>(res.value());
-                    // meta_list.push_back(std::move(_meta));
-                    LOG(INFO) << "Found local meta: " << res.value();
-                    auto k = _meta->getDescription();
-                    meta_map.insert({k, std::make_pair(_meta, dataset_tag)});
-
-                } else {
-                    // Find in DHT
-                    p2pStub_->getDHTValue(id,
-                        [&, dataset_tag](libp2p::outcome::result<libp2p::protocol::kademlia::Value> result) {
-                            if (result.has_value()) {
-                                try {
-                                    std::vector<std::shared_ptr<DatasetMeta>> meta_list;
-                                    auto r = result.value();
-                                    std::stringstream rs;
-                                    std::copy(r.begin(), r.end(), std::ostream_iterator<uint8_t>(rs, ""));
-                                    LOG(INFO) << "Fount remote meta: " << rs.str();
-                                    auto _meta = std::make_shared<DatasetMeta>(std::move(rs.str()));
-                                    auto k = _meta->getDescription();
-                                    VLOG(5) << "Fount remote meta key: " << k;
-                                    meta_map.insert({k, std::make_pair(_meta, dataset_tag)});
-                                } catch (std::exception& e) {
-                                    LOG(ERROR) << "<< Get meta failed: " << e.what();
-                                }
-
+            // Find in DHT
+            for (const auto& dataset_name : to_query) {
+                stat_dht_queries_++;
+                metaLookupMetrics().dht_queries.inc();
+                p2pStub_->getDHTValue(DatasetId(dataset_name),
+                    [this, state, dataset_name](libp2p::outcome::result<libp2p::protocol::kademlia::Value> result) {
+                        std::shared_ptr<DatasetMeta> meta;
+                        if (result.has_value()) {
+                            try {
+                                auto r = result.value();
+                                std::stringstream rs;
+                                std::copy(r.begin(), r.end(), std::ostream_iterator<uint8_t>(rs, ""));
+                                LOG(INFO) << "Fount remote meta: " << rs.str();
+                                meta = std::make_shared<DatasetMeta>(std::move(rs.str()));
+                                cacheMeta(dataset_name, meta);
+                            } catch (std::exception& e) {
+                                LOG(ERROR) << "<< Get meta failed: " << e.what();
+                                meta = nullptr;
+                                // a malformed value is not asked again
+                                // before the negative entry expires
+                                cacheNotFound(dataset_name);
                             }
-                            get_value.store(true);
-                            meta_cond.notify_all();
-                        });
-                    std::unique_lock<std::mutex> lck(meta_map_mtx);
-                    while (!get_value.load()) {
-                        meta_cond.wait(lck);
-                    }
-                    get_value.store(false);
-                }
+                        } else {
+                            cacheNotFound(dataset_name);
+                        }
+                        {
+                            std::lock_guard<std::mutex> lck(state->mtx);
+                            state->in_flight.erase(dataset_name);
+                            if (meta != nullptr) {
+                                state->found[dataset_name] = meta;
+                            }
+                            state->replies++;
+                        }
+                        state->cond.notify_all();
+                    });
             }
-            if (meta_map.size() < datasets_with_tag.size()) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-            } else {
+
+            std::unique_lock<std::mutex> lck(state->mtx);
+            if (state->found.size() >= dataset_names.size()) {
                 break;
             }
+            auto now = Clock::now();
+            if (now >= deadline) {
+                LOG(ERROR) << " 🔍 ⏱️  Timeout while searching meta list.";
+                is_timeout = true;
+                break;
+            }
+            auto replies = state->replies;
+            state->cond.wait_until(lck, std::min(deadline, now + wait_interval),
+                [&state, replies] { return state->replies != replies; });
+            wait_interval = std::min<std::chrono::milliseconds>(wait_interval * 2, max_wait);
         }
+        auto latency_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            Clock::now() - t_start).count();
+        recordLookup(latency_ms, is_timeout);
+        VLOG(5) << "meta lookup for " << dataset_names.size() << " datasets took "
+                << latency_ms << " ms";
         if (is_timeout) {
             return outcome::success();
         }
+
+        std::vector<DatasetMetaWithParamTag> meta_list;
+        std::map<std::string, DatasetMetaWithParamTag> meta_map; // key: dataset description
+        {
+            std::lock_guard<std::mutex> lck(state->mtx);
+            for (const auto& dataset_item : datasets_with_tag) {
+                auto& _meta = state->found[std::get<0>(dataset_item)];
+                auto k = _meta->getDescription();
+                meta_map.insert({k, std::make_pair(_meta, std::get<1>(dataset_item))});
+            }
+        }
         for (auto& meta : meta_map) {
             meta_list.push_back(std::make_pair(meta.second.first, meta.second.second));
         }
         handler(meta_list);
         return outcome::success();
-     }
+    }
 
 
 
 ////////////////Flight Server ///////
 
+namespace {
+// Applies the column projection and row range of a flight ticket on top of
+// the batches produced by a data cursor, one batch at a time.
+class SelectedBatchReader : public arrow::RecordBatchReader {
+  public:
+    SelectedBatchReader(std::shared_ptr<arrow::RecordBatchReader> reader,
+                        std::shared_ptr<arrow::Schema> schema,
+                        std::vector<int> column_indices,
+                        int64_t offset, int64_t limit)
+        : reader_(std::move(reader)), schema_(std::move(schema)),
+          column_indices_(std::move(column_indices)),
+          skip_(offset), remain_(limit) {}
+
+    std::shared_ptr<arrow::Schema> schema() const override { return schema_; }
+
+    arrow::Status ReadNext(std::shared_ptr<arrow::RecordBatch> *batch) override {
+        while (remain_ != 0) {
+            std::shared_ptr<arrow::RecordBatch> next;
+            RETURN_NOT_OK(reader_->ReadNext(&next));
+            if (next == nullptr) {
+                break;
+            }
+            int64_t num_rows = next->num_rows();
+            if (skip_ >= num_rows) {
+                skip_ -= num_rows;
+                continue;
+            }
+            int64_t length = num_rows - skip_;
+            if (remain_ > 0 && length > remain_) {
+                length = remain_;
+            }
+            if (skip_ != 0 || length != num_rows) {
+                next = next->Slice(skip_, length);
+            }
+            skip_ = 0;
+            if (remain_ > 0) {
+                remain_ -= length;
+            }
+            if (!column_indices_.empty()) {
+                std::vector<std::shared_ptr<arrow::Array>> columns;
+                for (int index : column_indices_) {
+                    columns.push_back(next->column(index));
+                }
+                next = arrow::RecordBatch::Make(schema_, next->num_rows(), columns);
+            }
+            *batch = std::move(next);
+            return arrow::Status::OK();
+        }
+        *batch = nullptr;
+        return arrow::Status::OK();
+    }
+
+  private:
+    std::shared_ptr<arrow::RecordBatchReader> reader_;
+    std::shared_ptr<arrow::Schema> schema_;
+    std::vector<int> column_indices_;
+    int64_t skip_;
+    int64_t remain_;
+};
+}  // namespace
+
 arrow::Status FlightIntegrationServer::DoGet(const arrow::flight::ServerCallContext &context,
                             const arrow::flight::Ticket &request,
                             std::unique_ptr<FlightDataStream> *data_stream)  {
-            // NOTE fligth ticket format : fligt.{dataset_id_str}
-            DatasetId id(request.ticket);
+            // NOTE fligth ticket format : {dataset description}[?columns=..&offset=..&limit=..]
+            FlightTicket ticket;
+            if (ParseFlightTicket(request.ticket, &ticket) != 0) {
+                return arrow::Status::Invalid("Invalid flight ticket: ", request.ticket);
+            }
+            DatasetId id(ticket.dataset);
             std::shared_ptr<DatasetMeta> meta = dataset_service_->metaService_->getLocalMeta(id);
             if (meta == nullptr) {
                 LOG(WARNING) << "Could not find flight ticket: " << request.ticket;
@@ -378,25 +680,108 @@ arrow::Status FlightIntegrationServer::DoGet(const arrow::flight::ServerCallCont
             DataURLToDetail(data_url, node_id, node_ip, node_port, dataset_path);
             LOG(INFO) << "DoGet dataset path:" << dataset_path;
             auto cursor = driver->read(dataset_path);  // TODO only support Local file path now.
-            auto dataset = cursor->read();
-            LOG(INFO) << "DoGet dataset read done";
-
-            // NOTE that we can't directly pass TableBatchReader to
-            // RecordBatchStream because TableBatchReader keeps a non-owning
-            // reference to the underlying Table, which would then get freed
-            // when we exit this function
-            auto table = std::get<0>(dataset->data);
-            std::vector<std::shared_ptr<arrow::RecordBatch>> batches;
-            arrow::TableBatchReader batch_reader(*table);
-            // ARROW_ASSIGN_OR_RAISE(batches, batch_reader.ToRecordBatches());
-            batch_reader.ReadAll(&batches);
-
-            ARROW_ASSIGN_OR_RAISE(auto owning_reader, arrow::RecordBatchReader::Make(
-                                                  std::move(batches), table->schema()));
+            // batches are pulled from the cursor while the stream is sent,
+            // so the dataset is never materialized here
+            auto reader = cursor->readBatches();
+            if (reader == nullptr) {
+                return arrow::Status::IOError("Read dataset failed: ", ticket.dataset);
+            }
+
+            auto schema = reader->schema();
+            std::vector<int> column_indices;
+            if (!ticket.columns.empty()) {
+                std::vector<std::shared_ptr<arrow::Field>> fields;
+                for (const auto& column : ticket.columns) {
+                    int index = schema->GetFieldIndex(column);
+                    if (index < 0) {
+                        return arrow::Status::KeyError("Column not found: ", column);
+                    }
+                    column_indices.push_back(index);
+                    fields.push_back(schema->field(index));
+                }
+                schema = arrow::schema(fields);
+            }
+            if (!column_indices.empty() || ticket.offset > 0 || ticket.limit >= 0) {
+                reader = std::make_shared<SelectedBatchReader>(
+                    std::move(reader), schema, std::move(column_indices),
+                    ticket.offset, ticket.limit);
+            }
             *data_stream = std::unique_ptr<arrow::flight::FlightDataStream>(
-                     new arrow::flight::RecordBatchStream(owning_reader));
-            LOG(INFO) << "DoGet dataset send to client done";
+                     new arrow::flight::RecordBatchStream(reader));
+            LOG(INFO) << "DoGet dataset stream created";
             return arrow::Status::OK();
         }
 
+arrow::Status FlightIntegrationServer::DoPut(const ServerCallContext &context,
+                            std::unique_ptr<FlightMessageReader> reader,
+                            std::unique_ptr<FlightMetadataWriter> writer) {
+        const FlightDescriptor &descriptor = reader->descriptor();
+
+        if (descriptor.type !=
+            arrow::flight::FlightDescriptor::DescriptorType::PATH) {
+            return arrow::Status::Invalid("Must specify a path");
+        } else if (descriptor.path.size() < 1) {
+            return arrow::Status::Invalid("Must specify a path");
+        }
+
+        std::string key = descriptor.path[0];
+        LOG(INFO) << "DoPut dataest key: " << key;
+        ARROW_ASSIGN_OR_RAISE(auto schema, reader->GetSchema());
+
+        // Register dataset and write dataset by driver, every uploaded chunk
+        // goes to the csv file as soon as it is received.
+        auto driver = primihub::DataDirverFactory::getDriver(
+            "CSV", dataset_service_->getNodeletAddr());
+        driver->initCursor(key + ".csv");
+        ARROW_ASSIGN_OR_RAISE(auto output,
+            arrow::io::FileOutputStream::Open(driver->getDataURL()));
+        // arrow 4.0 has no streaming csv writer, write batch by batch and
+        // only put the header before the first one
+        auto write_options = arrow::csv::WriteOptions::Defaults();
+        auto* pool = arrow::default_memory_pool();
+        int64_t total_rows = 0;
+        arrow::flight::FlightStreamChunk chunk;
+        while (true) {
+            RETURN_NOT_OK(reader->Next(&chunk));
+            if (chunk.data == nullptr)
+                break;
+            RETURN_NOT_OK(chunk.data->ValidateFull());
+            RETURN_NOT_OK(arrow::csv::WriteCSV(*chunk.data, write_options,
+                                               pool, output.get()));
+            write_options.include_header = false;
+            total_rows += chunk.data->num_rows();
+            if (chunk.app_metadata) {
+                RETURN_NOT_OK(writer->WriteMetadata(
+                    *chunk.app_metadata)); // TODO metadata include dataset meta
+            }
+        }
+        if (write_options.include_header) {
+            // nothing uploaded, keep the header so the dataset can be read
+            std::vector<std::shared_ptr<arrow::Array>> empty_columns;
+            for (const auto& field : schema->fields()) {
+                ARROW_ASSIGN_OR_RAISE(auto column,
+                    arrow::MakeArrayOfNull(field->type(), 0, pool));
+                empty_columns.push_back(std::move(column));
+            }
+            auto empty_batch = arrow::RecordBatch::Make(schema, 0, empty_columns);
+            RETURN_NOT_OK(arrow::csv::WriteCSV(*empty_batch, write_options,
+                                               pool, output.get()));
+        }
+        RETURN_NOT_OK(output->Close());
+        LOG(INFO) << "DoPut write " << total_rows << " rows to " << driver->getDataURL();
+
+        // meta only needs the schema, use an empty table instead of the data
+        ARROW_ASSIGN_OR_RAISE(auto empty_table,
+            arrow::Table::FromRecordBatches(
+                schema, std::vector<std::shared_ptr<arrow::RecordBatch>>{}));
+        auto ph_dataset = std::make_shared<primihub::Dataset>(empty_table, driver);
+        DatasetMeta meta(ph_dataset, key /*NOTE from upload description*/,
+                         DatasetVisbility::PUBLIC);
+        meta.setTotalRecords(total_rows);
+        dataset_service_->regDataset(meta);
+        auto metadata_buf = arrow::Buffer::FromString(meta.toJSON());
+        RETURN_NOT_OK(writer->WriteMetadata(*metadata_buf));
+        return arrow::Status::OK();
+    }
+
 } // namespace primihub::service
@@ -18,6 +18,9 @@
 #define SRC_PRIMIHUB_SERVICE_DATASET_SERVICE_H_
 #include <glog/logging.h>
 
+#include <atomic>
+#include <chrono>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -71,6 +74,15 @@ using arrow::fs::FileSystem;
 
 using primihub::DataDirverFactory;
 
+struct MetaLookupStats {
+    uint64_t lookups{0};          // findPeerListFromDatasets calls
+    uint64_t cache_hits{0};       // datasets answered from the meta cache
+    uint64_t dht_queries{0};      // getDHTValue requests sent
+    uint64_t timeouts{0};
+    uint64_t total_latency_ms{0};
+    uint64_t max_latency_ms{0};
+};
+
 class DatasetMetaService {
   public:
     DatasetMetaService(std::shared_ptr<primihub::p2p::NodeStub> p2pStub,
@@ -78,6 +90,8 @@ class DatasetMetaService {
     ~DatasetMetaService() {}
 
     void putMeta(DatasetMeta &meta);
+    // one local batch write for all metas, then publish each of them
+    void putMetas(std::vector<DatasetMeta> &metas);
     outcome::result<void> getAllLocalMetas(std::vector<DatasetMeta> &metas);
     std::shared_ptr<DatasetMeta> getLocalMeta(const DatasetId &id);
     outcome::result<void> getMeta(const DatasetId &id,
@@ -88,12 +102,38 @@ class DatasetMetaService {
     void setMetaSearchTimeout(unsigned int timeout) {
         meta_search_timeout_ = timeout;
     }
+    // ttl of found metas and of datasets the DHT did not know, in seconds
+    void setMetaCacheTTL(unsigned int ttl, unsigned int negative_ttl) {
+        meta_cache_ttl_ = ttl;
+        meta_negative_ttl_ = negative_ttl;
+    }
+    MetaLookupStats getMetaLookupStats() const;
 
   private:
+    enum class CacheState { MISS, HIT, NOT_FOUND };
+    struct MetaCacheEntry {
+        std::shared_ptr<DatasetMeta> meta;  // nullptr: negative entry
+        std::chrono::steady_clock::time_point expire_at;
+    };
+    CacheState lookupCache(const std::string& key,
+                           std::shared_ptr<DatasetMeta>* meta);
+    void cacheMeta(const std::string& key, std::shared_ptr<DatasetMeta> meta);
+    void cacheNotFound(const std::string& key);
+    void recordLookup(uint64_t latency_ms, bool is_timeout);
+
     std::shared_ptr<StorageBackend> localKv_;
     std::shared_ptr<primihub::p2p::NodeStub> p2pStub_;
-    // std::map<std::string, DatasetMetaWithParamTag> meta_map_; // key: dataset_id
     unsigned int meta_search_timeout_ = 60; // seconds
+    unsigned int meta_cache_ttl_ = 300; // seconds
+    unsigned int meta_negative_ttl_ = 2; // seconds
+    std::mutex meta_cache_mtx_;
+    std::map<std::string, MetaCacheEntry> meta_cache_; // key: dataset name
+    std::atomic<uint64_t> stat_lookups_{0};
+    std::atomic<uint64_t> stat_cache_hits_{0};
+    std::atomic<uint64_t> stat_dht_queries_{0};
+    std::atomic<uint64_t> stat_timeouts_{0};
+    std::atomic<uint64_t> stat_total_latency_ms_{0};
+    std::atomic<uint64_t> stat_max_latency_ms_{0};
 };
 
 class DatasetService  {
@@ -105,11 +145,15 @@ class DatasetService  {
 
     //////////////////// Arrow Flight Server End
     ////////////////////////////////////
-    // create dataset from DataDriver reader
+    // create dataset from DataDriver reader, csv datasets are converted to
+    // the columnar format first if one is set
     std::shared_ptr<primihub::Dataset>
     newDataset(std::shared_ptr<primihub::DataDriver> driver,
                const std::string &description, DatasetMeta &meta /*output*/);
 
+    // "parquet" or "arrow", empty keeps csv datasets as they are
+    void setColumnarFormat(const std::string &format) { columnar_format_ = format; }
+
     // create dataset from arrow data and write data using driver
     void writeDataset(const std::shared_ptr<primihub::Dataset> &dataset,
                       const std::string &description,
@@ -127,6 +171,8 @@ class DatasetService  {
     void loadDefaultDatasets(const std::string &config_file_path);
     void restoreDatasetFromLocalStorage(void);
     void setMetaSearchTimeout(unsigned int timeout);
+    // ttl of found metas and of datasets the DHT did not know, in seconds
+    void setMetaCacheTTL(unsigned int ttl, unsigned int negative_ttl);
     std::string getNodeletAddr(void);
     // void
     // findPeerListFromDatasets(const std::vector<std::string>
@@ -141,8 +187,12 @@ class DatasetService  {
     // DatasetSchema &getDatasetSchema(const std::string &id) const {}
 
     //  private:
+    std::shared_ptr<primihub::DataDriver>
+    convertToColumnar(std::shared_ptr<primihub::DataDriver> csv_driver);
+
     std::shared_ptr<DatasetMetaService> metaService_;
     std::string nodelet_addr_;
+    std::string columnar_format_;
 
 };
 
@@ -226,59 +276,19 @@ class FlightIntegrationServer : public arrow::flight::FlightServerBase {
         }
     }
 
-    // NOTE Only allow get dataset from local driver
+    // NOTE Only allow get dataset from local driver, the ticket may select
+    // columns and a row range, see FlightTicket.
     arrow::Status
     DoGet(const arrow::flight::ServerCallContext &context,
           const arrow::flight::Ticket &request,
           std::unique_ptr<FlightDataStream> *data_stream) override;
 
+    // Upload a dataset, chunks are written to a csv file while received
+    // and the dataset meta is sent back as the last metadata message.
     arrow::Status DoPut(const ServerCallContext &context,
                         std::unique_ptr<FlightMessageReader> reader,
-                        std::unique_ptr<FlightMetadataWriter> writer) override {
-        LOG(INFO) << "====DoPut 1====";
-        const FlightDescriptor &descriptor = reader->descriptor();
-
-        if (descriptor.type !=
-            arrow::flight::FlightDescriptor::DescriptorType::PATH) {
-            return arrow::Status::Invalid("Must specify a path");
-        } else if (descriptor.path.size() < 1) {
-            return arrow::Status::Invalid("Must specify a path");
-        }
+                        std::unique_ptr<FlightMetadataWriter> writer) override;
 
-        std::string key = descriptor.path[0];
-        LOG(INFO) << "DoPut dataest key: " << key;
-        IntegrationDataset dataset;
-        ARROW_ASSIGN_OR_RAISE(dataset.schema, reader->GetSchema());
-        arrow::flight::FlightStreamChunk chunk;
-        while (true) {
-            RETURN_NOT_OK(reader->Next(&chunk));
-            if (chunk.data == nullptr)
-                break;
-            RETURN_NOT_OK(chunk.data->ValidateFull());
-            dataset.chunks.push_back(chunk.data);
-            if (chunk.app_metadata) {
-                RETURN_NOT_OK(writer->WriteMetadata(
-                    *chunk.app_metadata)); // TODO metadata include dataset meta
-            }
-        }
-        LOG(INFO) << "====DoPut 2====";
-        // Register dataset and  write dataset by driver
-        // TODO stream writer
-        auto driver = primihub::DataDirverFactory::getDriver(
-            "CSV", dataset_service_->getNodeletAddr());
-        driver->initCursor(key+".csv");
-        auto ph_dataset =
-            std::make_shared<primihub::Dataset>(dataset.chunks, driver);
-        LOG(INFO) << "====DoPut 3====";
-        DatasetMeta meta;
-        dataset_service_->writeDataset(
-            ph_dataset, key /*NOTE from upload description*/, meta);
-        LOG(INFO) << "====DoPut 4====";    
-        auto metadata_buf = arrow::Buffer::FromString(meta.toJSON());
-        RETURN_NOT_OK(writer->WriteMetadata(*metadata_buf));
-        LOG(INFO) << "====DoPut 5====";
-        return arrow::Status::OK();
-    }
     // TODO temporary solution for integration test
     // std::unordered_map<std::string, IntegrationDataset> uploaded_chunks;
     std::shared_ptr<DatasetService> dataset_service_;
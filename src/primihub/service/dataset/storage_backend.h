@@ -20,7 +20,10 @@
 #define SRC_PRIMIHUB_DATA_STORE_STORGE_BACKEND_H_
 
 
+#include <functional>
 #include <string>
+#include <utility>
+#include <vector>
 #include <libp2p/protocol/kademlia/content_id.hpp>
 
 #include "src/primihub/service/outcome.hpp"
@@ -30,6 +33,8 @@ namespace primihub::service {
   
   using Key = kade::ContentId;
   using Value = std::string;
+  // return false to stop the iteration
+  using KVVisitor = std::function<bool(const Key &key, const Value &value)>;
 
   /**
    * Backend of key-value storage
@@ -51,6 +56,33 @@ namespace primihub::service {
     // Get all key and value pairs from the storage.
     virtual outcome::result<std::vector<std::pair<Key, Value>>> getAll() const = 0;
 
+    /// Adds all pairs of @param kvs, backends with batch support apply them
+    /// atomically.
+    virtual outcome::result<void> putValues(
+        const std::vector<std::pair<Key, Value>> &kvs) {
+      for (const auto &kv : kvs) {
+        auto r = putValue(kv.first, kv.second);
+        if (!r) {
+          return r;
+        }
+      }
+      return outcome::success();
+    }
+
+    /// Visits all pairs without collecting them first.
+    virtual outcome::result<void> forEach(const KVVisitor &visitor) const {
+      auto r = getAll();
+      if (!r) {
+        return r.error();
+      }
+      for (const auto &kv : r.value()) {
+        if (!visitor(kv.first, kv.second)) {
+          break;
+        }
+      }
+      return outcome::success();
+    }
+
   };  // class StorageBackend
 
 
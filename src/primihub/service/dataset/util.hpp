@@ -19,6 +19,7 @@
 
 #include <glog/logging.h>
 #include <string>
+#include <vector>
 #include <glog/logging.h>
 
 #include <libp2p/multi/content_identifier_codec.hpp>
@@ -52,6 +53,69 @@ static int DataURLToDetail(const std::string &data_url,
      return 1;
 }
 
+// Flight ticket format:
+//   <dataset description>[?columns=c1,c2&offset=N&limit=M]
+// a plain description keeps meaning the whole dataset.
+struct FlightTicket {
+    std::string dataset;
+    std::vector<std::string> columns;  // empty: all columns
+    int64_t offset{0};
+    int64_t limit{-1};                 // negative: until the end
+};
+
+static int ParseFlightTicket(const std::string &ticket, FlightTicket *result) {
+    auto pos = ticket.find('?');
+    result->dataset = ticket.substr(0, pos);
+    result->columns.clear();
+    result->offset = 0;
+    result->limit = -1;
+    if (result->dataset.empty()) {
+        LOG(ERROR) << "ParseFlightTicket: dataset is empty: " << ticket;
+        return -1;
+    }
+    if (pos == std::string::npos) {
+        return 0;
+    }
+    std::vector<std::string> options;
+    primihub::str_split(ticket.substr(pos + 1), &options, '&');
+    for (const auto &option : options) {
+        auto eq_pos = option.find('=');
+        if (eq_pos == std::string::npos) {
+            LOG(ERROR) << "ParseFlightTicket: invalid option: " << option;
+            return -1;
+        }
+        auto key = option.substr(0, eq_pos);
+        auto value = option.substr(eq_pos + 1);
+        size_t parsed = value.size();
+        try {
+            if (key == "columns") {
+                primihub::str_split(value, &result->columns, ',');
+            } else if (key == "offset") {
+                result->offset = std::stoll(value, &parsed);
+            } else if (key == "limit") {
+                result->limit = std::stoll(value, &parsed);
+            } else {
+                LOG(ERROR) << "ParseFlightTicket: unknown option: " << key;
+                return -1;
+            }
+        } catch (std::exception &e) {
+            LOG(ERROR) << "ParseFlightTicket: invalid value of " << key
+                       << ": " << value;
+            return -1;
+        }
+        if (parsed != value.size()) {
+            LOG(ERROR) << "ParseFlightTicket: invalid value of " << key
+                       << ": " << value;
+            return -1;
+        }
+    }
+    if (result->offset < 0) {
+        LOG(ERROR) << "ParseFlightTicket: offset must not be negative";
+        return -1;
+    }
+    return 0;
+}
+
 static  std::string Key2Str(const Key &key) {
      auto s = libp2p::multi::ContentIdentifierCodec::toString(
           libp2p::multi::ContentIdentifierCodec::decode(key.data).value());
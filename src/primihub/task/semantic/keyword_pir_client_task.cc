@@ -17,6 +17,7 @@
 
 #include <thread>
 #include <chrono>
+#include "src/primihub/util/metrics.h"
 #include "src/primihub/util/util.h"
 #include "apsi/network/zmq/zmq_channel.h"
 #include "apsi/receiver.h"
@@ -70,6 +71,10 @@ int KeywordPIRClientTask::_LoadParams(Task &task) {
             LOG(ERROR) << "no keyword: serverAddress match found";
             return -1;
         }
+        auto sender_port_it = param_map.find("senderPort");
+        if (sender_port_it != param_map.end()) {
+            sender_port_ = sender_port_it->second.value_int32();
+        }
     } catch (std::exception &e) {
         LOG(ERROR) << "Failed to load params: " << e.what();
         return -1;
@@ -156,11 +161,14 @@ int KeywordPIRClientTask::saveResult(
 }
 
 int KeywordPIRClientTask::execute() {
+    SCopedTimer timer;
     auto ret = _LoadParams(task_param_);
     if (ret) {
         LOG(ERROR) << "Pir client load task params failed.";
         return ret;
     }
+    auto load_params_ts = timer.timeElapse();
+    record_task_phase("keyword_pir_client", "load_params", load_params_ts);
     ZMQReceiverChannel channel;
     // extract server ip from server_address_
 
@@ -170,7 +178,7 @@ int KeywordPIRClientTask::execute() {
     if (pos != std::string::npos) {
         server_ip = server_address_.substr(0, pos);
     }
-    server_address_ = "tcp://" + server_ip + ":2222";
+    server_address_ = "tcp://" + server_ip + ":" + std::to_string(sender_port_);
     VLOG(5) << "begin to connect to server: " << server_address_;
     channel.connect(server_address_);
     VLOG(5) << "connect to server: " << server_address_ << " end";
@@ -196,6 +204,9 @@ int KeywordPIRClientTask::execute() {
         LOG(ERROR) << "Failed to receive keyword PIR valid parameters: " << ex.what();
         return -1;
     }
+    auto request_params_ts = timer.timeElapse();
+    record_task_phase("keyword_pir_client", "request_params",
+                      request_params_ts - load_params_ts);
 
     ThreadPoolMgr::SetThreadCount(8);
     VLOG(5) << "Keyword PIR setting thread count to " << ThreadPoolMgr::GetThreadCount();
@@ -208,7 +219,15 @@ int KeywordPIRClientTask::execute() {
     }
 
     auto& items = std::get<CSVReader::UnlabeledData>(*query_data);
+    auto load_dataset_ts = timer.timeElapse();
+    record_task_phase("keyword_pir_client", "load_dataset",
+                      load_dataset_ts - request_params_ts);
 
+    // the zmq channel can not be closed from another thread, so the
+    // cancellation is checked between the round trips
+    if (isCancelled()) {
+        return -1;
+    }
     std::vector<Item> items_vec(items.begin(), items.end());
     std::vector<HashedItem> oprf_items;
     std::vector<LabelKey> label_keys;
@@ -223,7 +242,12 @@ int KeywordPIRClientTask::execute() {
         return -1;
     }
     VLOG(5) << "Receiver::RequestOPRF end, begin to receiver.request_query";
+    auto oprf_ts = timer.timeElapse();
+    record_task_phase("keyword_pir_client", "oprf", oprf_ts - load_dataset_ts);
 
+    if (isCancelled()) {
+        return -1;
+    }
     std::vector<MatchRecord> query_result;
     try {
         query_result = receiver.request_query(oprf_items, label_keys, channel);
@@ -232,8 +256,13 @@ int KeywordPIRClientTask::execute() {
         return -1;
     }
     VLOG(5) << "receiver.request_query end";
+    auto query_ts = timer.timeElapse();
+    record_task_phase("keyword_pir_client", "query", query_ts - oprf_ts);
+    record_channel_bytes("keyword_pir_client", channel.bytes_sent(),
+                         channel.bytes_received());
 
     this->saveResult(orig_items, items, query_result);
+    record_task_phase("keyword_pir_client", "save_result", timer.timeElapse() - query_ts);
     return 0;
 }
 } // namespace primihub::task
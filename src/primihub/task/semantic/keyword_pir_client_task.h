@@ -59,6 +59,7 @@ class KeywordPIRClientTask : public TaskBase {
     std::string dataset_path_;
     std::string result_file_path_;
     std::string server_address_;
+    int sender_port_{2222};
     bool recv_query_data_direct{false};
 };
 }  // namespace primihub::task
@@ -0,0 +1,206 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "src/primihub/task/semantic/keyword_pir_params.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <sstream>
+
+namespace primihub::task {
+
+namespace {
+// latency model used to rank profiles: 100Mbps link and the coefficient
+// throughput of one core, the sender splits its work over the thread pool
+constexpr double kBytesPerMs = 12.5 * 1024;
+constexpr double kOpsPerMs = 2e5;
+// receiver cuckoo table load with three hash functions
+constexpr double kCuckooFactor = 1.3;
+// bins are not filled evenly, leave room for the fullest one
+constexpr double kBinImbalance = 1.2;
+
+uint32_t plainBits(uint64_t plain_modulus) {
+    uint32_t bits = 0;
+    while ((plain_modulus >> (bits + 1)) != 0) {
+        bits++;
+    }
+    return bits;
+}
+
+std::vector<uint32_t> queryPowers(const KeywordPirProfile& profile) {
+    std::vector<uint32_t> powers;
+    if (profile.ps_low_degree == 0) {
+        for (uint32_t i = 1; i <= profile.max_items_per_bin; i++) {
+            powers.push_back(i);
+        }
+        return powers;
+    }
+    for (uint32_t i = 1; i <= profile.ps_low_degree; i++) {
+        powers.push_back(i);
+    }
+    uint32_t step = profile.ps_low_degree + 1;
+    for (uint32_t i = step; i <= profile.max_items_per_bin; i += step) {
+        powers.push_back(i);
+    }
+    return powers;
+}
+
+void tableShape(const KeywordPirProfile& profile, size_t query_batch,
+                uint32_t* table_size, uint32_t* hash_func_count) {
+    uint32_t bins_per_bundle = profile.poly_modulus_degree / profile.felts_per_item;
+    // a single item needs no cuckoo hashing
+    *hash_func_count = query_batch <= 1 ? 1 : 3;
+    uint64_t min_size = static_cast<uint64_t>(std::ceil(query_batch * kCuckooFactor));
+    uint64_t bundles = std::max<uint64_t>(1,
+        (min_size + bins_per_bundle - 1) / bins_per_bundle);
+    *table_size = static_cast<uint32_t>(bundles * bins_per_bundle);
+}
+}  // namespace
+
+const std::vector<KeywordPirProfile>& keywordPirProfiles() {
+    static const std::vector<KeywordPirProfile> kProfiles = {
+        // the former config/pir_server_config.json, for toy sets
+        {"2048-20", 2048, 65537, {48}, 5, 20, 0},
+        {"4096-64", 4096, 40961, {48, 32, 24}, 8, 64, 7},
+        {"8192-256", 8192, 65537, {56, 56, 56, 50}, 5, 256, 15},
+        {"8192-1024", 8192, 65537, {56, 56, 56, 50}, 5, 1024, 31},
+    };
+    return kProfiles;
+}
+
+const KeywordPirProfile* findKeywordPirProfile(const std::string& name) {
+    for (const auto& profile : keywordPirProfiles()) {
+        if (profile.name == name) {
+            return &profile;
+        }
+    }
+    return nullptr;
+}
+
+int estimateKeywordPirCost(const KeywordPirProfile& profile, size_t db_size,
+                           size_t label_byte_count, size_t query_batch,
+                           KeywordPirCost* cost) {
+    uint32_t item_bits = profile.felts_per_item * plainBits(profile.plain_modulus);
+    if (item_bits < 80 || item_bits > 128) {
+        return -1;
+    }
+    tableShape(profile, query_batch, &cost->table_size, &cost->hash_func_count);
+    uint32_t bins_per_bundle = profile.poly_modulus_degree / profile.felts_per_item;
+    uint64_t bundle_idx_count = cost->table_size / bins_per_bundle;
+    double items_per_bin = static_cast<double>(db_size) * cost->hash_func_count /
+                           cost->table_size * kBinImbalance;
+    uint64_t bin_bundles_per_idx = std::max<uint64_t>(1,
+        static_cast<uint64_t>(std::ceil(items_per_bin / profile.max_items_per_bin)));
+    cost->bin_bundles = bin_bundles_per_idx * bundle_idx_count;
+
+    uint64_t coeff_bits = std::accumulate(profile.coeff_modulus_bits.begin(),
+                                          profile.coeff_modulus_bits.end(), 0);
+    uint64_t query_ct_bytes = 2ULL * profile.poly_modulus_degree * coeff_bits / 8;
+    // results are switched down to the last prime before they are sent
+    uint64_t result_ct_bytes =
+        2ULL * profile.poly_modulus_degree * profile.coeff_modulus_bits.back() / 8;
+    uint64_t label_parts = (label_byte_count * 8 + item_bits - 1) / item_bits;
+
+    cost->upload_bytes = bundle_idx_count * queryPowers(profile).size() * query_ct_bytes;
+    cost->download_bytes = cost->bin_bundles * (1 + label_parts) * result_ct_bytes;
+    // one plaintext multiplication per polynomial coefficient and residue
+    cost->sender_ops = cost->bin_bundles * (1 + label_parts) *
+        profile.max_items_per_bin * profile.poly_modulus_degree *
+        profile.coeff_modulus_bits.size();
+    cost->estimated_ms = (cost->upload_bytes + cost->download_bytes) / kBytesPerMs +
+                         cost->sender_ops / kOpsPerMs;
+    return 0;
+}
+
+std::string keywordPirParamsJson(const KeywordPirProfile& profile,
+                                 size_t query_batch) {
+    uint32_t table_size = 0;
+    uint32_t hash_func_count = 0;
+    tableShape(profile, query_batch, &table_size, &hash_func_count);
+    auto join = [](const auto& values) {
+        std::stringstream ss;
+        for (size_t i = 0; i < values.size(); i++) {
+            ss << (i ? ", " : "") << values[i];
+        }
+        return ss.str();
+    };
+    std::stringstream json;
+    json << "{\n"
+         << "    \"table_params\": {\n"
+         << "        \"hash_func_count\": " << hash_func_count << ",\n"
+         << "        \"table_size\": " << table_size << ",\n"
+         << "        \"max_items_per_bin\": " << profile.max_items_per_bin << "\n"
+         << "    },\n"
+         << "    \"item_params\": {\n"
+         << "        \"felts_per_item\": " << profile.felts_per_item << "\n"
+         << "    },\n"
+         << "    \"query_params\": {\n"
+         << "        \"ps_low_degree\": " << profile.ps_low_degree << ",\n"
+         << "        \"query_powers\": [ " << join(queryPowers(profile)) << " ]\n"
+         << "    },\n"
+         << "    \"seal_params\": {\n"
+         << "        \"plain_modulus\": " << profile.plain_modulus << ",\n"
+         << "        \"poly_modulus_degree\": " << profile.poly_modulus_degree << ",\n"
+         << "        \"coeff_modulus_bits\": [ " << join(profile.coeff_modulus_bits) << " ]\n"
+         << "    }\n"
+         << "}\n";
+    return json.str();
+}
+
+std::unique_ptr<apsi::PSIParams> selectKeywordPirParams(size_t db_size,
+                                                        size_t label_byte_count,
+                                                        size_t query_batch,
+                                                        std::string* profile_name) {
+    const KeywordPirProfile* best = nullptr;
+    KeywordPirCost best_cost;
+    for (const auto& profile : keywordPirProfiles()) {
+        KeywordPirCost cost;
+        if (estimateKeywordPirCost(profile, db_size, label_byte_count,
+                                   query_batch, &cost)) {
+            continue;
+        }
+        VLOG(5) << "keyword pir profile " << profile.name
+                << " estimated ms: " << cost.estimated_ms
+                << " upload: " << cost.upload_bytes
+                << " download: " << cost.download_bytes;
+        if (best == nullptr || cost.estimated_ms < best_cost.estimated_ms) {
+            best = &profile;
+            best_cost = cost;
+        }
+    }
+    if (best == nullptr) {
+        LOG(ERROR) << "No keyword pir profile fits db size " << db_size;
+        return nullptr;
+    }
+    LOG(INFO) << "keyword pir profile " << best->name << " selected for db size "
+              << db_size << ", label bytes " << label_byte_count
+              << ", query batch " << query_batch;
+    if (profile_name != nullptr) {
+        *profile_name = best->name;
+    }
+    try {
+        return std::make_unique<apsi::PSIParams>(
+            apsi::PSIParams::Load(keywordPirParamsJson(*best, query_batch)));
+    } catch (const std::exception& ex) {
+        LOG(ERROR) << "APSI threw an exception creating PSIParams: " << ex.what();
+        return nullptr;
+    }
+}
+
+} // namespace primihub::task
@@ -0,0 +1,82 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#ifndef SRC_PRIMIHUB_TASK_SEMANTIC_KEYWORD_PIR_PARAMS_H_
+#define SRC_PRIMIHUB_TASK_SEMANTIC_KEYWORD_PIR_PARAMS_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "apsi/psi_params.h"
+
+namespace primihub::task {
+
+/**
+ * Built-in APSI parameter profile. Table size and hash count are not part
+ * of a profile, they are derived from the expected query batch size.
+ */
+struct KeywordPirProfile {
+    std::string name;
+    uint32_t poly_modulus_degree;
+    uint64_t plain_modulus;
+    std::vector<int> coeff_modulus_bits;
+    uint32_t felts_per_item;
+    uint32_t max_items_per_bin;
+    // 0: every power up to max_items_per_bin is sent, otherwise powers
+    // 1..ps_low_degree and multiples of ps_low_degree + 1 are sent and
+    // the sender evaluates with Paterson-Stockmeyer
+    uint32_t ps_low_degree;
+};
+
+struct KeywordPirCost {
+    uint32_t table_size{0};
+    uint32_t hash_func_count{0};
+    uint64_t bin_bundles{0};
+    uint64_t upload_bytes{0};
+    uint64_t download_bytes{0};
+    // coefficient operations of the sender, a proxy of query latency
+    uint64_t sender_ops{0};
+    double estimated_ms{0};
+};
+
+const std::vector<KeywordPirProfile>& keywordPirProfiles();
+const KeywordPirProfile* findKeywordPirProfile(const std::string& name);
+
+/**
+ * Estimate the cost of one query batch with the profile.
+ * return 0 on success, -1 if the profile can not hold the items.
+ */
+int estimateKeywordPirCost(const KeywordPirProfile& profile, size_t db_size,
+                           size_t label_byte_count, size_t query_batch,
+                           KeywordPirCost* cost);
+
+// APSI params json of the profile, same format as pir_server_config.json
+std::string keywordPirParamsJson(const KeywordPirProfile& profile,
+                                 size_t query_batch);
+
+/**
+ * Pick the profile with the lowest estimated latency for the sender
+ * size, label size and expected query batch size.
+ */
+std::unique_ptr<apsi::PSIParams> selectKeywordPirParams(size_t db_size,
+                                                        size_t label_byte_count,
+                                                        size_t query_batch,
+                                                        std::string* profile_name = nullptr);
+
+} // namespace primihub::task
+#endif // SRC_PRIMIHUB_TASK_SEMANTIC_KEYWORD_PIR_PARAMS_H_
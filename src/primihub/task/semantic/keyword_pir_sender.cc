@@ -0,0 +1,372 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "src/primihub/task/semantic/keyword_pir_sender.h"
+
+#include <glog/logging.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <tuple>
+#include <variant>
+#include <vector>
+
+#include "apsi/thread_pool_mgr.h"
+#include "apsi/zmq/sender_dispatcher.h"
+
+#include "src/primihub/util/file_util.h"
+
+using apsi::Item;
+using apsi::Label;
+using apsi::PSIParams;
+using apsi::ThreadPoolMgr;
+using apsi::sender::SenderDB;
+using apsi::sender::ZMQSenderDispatcher;
+using apsi::util::CSVReader;
+
+namespace primihub::task {
+
+namespace {
+std::string itemKey(const Item& item) {
+    const auto& value = item.value();
+    return std::string(reinterpret_cast<const char*>(value.data()), value.size());
+}
+
+Item keyItem(const std::string& key) {
+    Item::value_type value;
+    memcpy(value.data(), key.data(), std::min(key.size(), value.size()));
+    return Item(value);
+}
+
+size_t labelHash(const Label& label) {
+    return std::hash<std::string>{}(std::string(label.begin(), label.end()));
+}
+
+std::string dbFileHeader(const std::string& version, const std::string& params) {
+    return version + "#" + std::to_string(std::hash<std::string>{}(params));
+}
+}  // namespace
+
+KeywordPirSender::~KeywordPirSender() {
+    stopAll();
+}
+
+void KeywordPirSender::setThreadCount(size_t thread_count) {
+    if (thread_count > 0 && thread_count != ThreadPoolMgr::GetThreadCount()) {
+        ThreadPoolMgr::SetThreadCount(thread_count);
+        VLOG(5) << "keyword pir sender thread count: " << thread_count;
+    }
+}
+
+int KeywordPirSender::_LoadLabeledData(const std::string& dataset_path,
+                                       CSVReader::LabeledData* data,
+                                       Snapshot* snapshot) {
+    CSVReader::DBData db_data;
+    try {
+        CSVReader reader(dataset_path);
+        std::tie(db_data, std::ignore) = reader.read();
+    } catch (const std::exception& ex) {
+        LOG(ERROR) << "Could not open or read file `"
+                   << dataset_path << "`: " << ex.what();
+        return -1;
+    }
+    if (!std::holds_alternative<CSVReader::LabeledData>(db_data)) {
+        LOG(ERROR) << "Loaded keyword pir database is without label";
+        return -1;
+    }
+    *data = std::move(std::get<CSVReader::LabeledData>(db_data));
+    snapshot->clear();
+    snapshot->reserve(data->size());
+    for (const auto& item_label : *data) {
+        (*snapshot)[itemKey(item_label.first)] = labelHash(item_label.second);
+    }
+    return 0;
+}
+
+std::shared_ptr<SenderDB> KeywordPirSender::_BuildDB(
+        const PSIParams& params, const CSVReader::LabeledData& data) {
+    if (data.empty()) {
+        LOG(ERROR) << "Keyword pir database is empty";
+        return nullptr;
+    }
+    // Find the longest label and use that as label size
+    size_t label_byte_count =
+        std::max_element(data.begin(), data.end(),
+            [](auto &a, auto &b) {
+                return a.second.size() < b.second.size();
+            })->second.size();
+    try {
+        auto sender_db = std::make_shared<SenderDB>(params, label_byte_count,
+                                                    kNonceByteCount, false);
+        sender_db->set_data(data);
+        return sender_db;
+    } catch (const std::exception& ex) {
+        LOG(ERROR) << "Failed to create keyword pir SenderDB: " << ex.what();
+        return nullptr;
+    }
+}
+
+int KeywordPirSender::_UpdateDB(Endpoint* endpoint,
+                                const CSVReader::LabeledData& data,
+                                const Snapshot& snapshot) {
+    const auto& old_snapshot = endpoint->snapshot;
+    auto& sender_db = endpoint->sender_db;
+    std::vector<Item> removed;
+    std::vector<std::pair<Item, Label>> upserts;
+    for (const auto& item_label : data) {
+        auto key = itemKey(item_label.first);
+        auto it = old_snapshot.find(key);
+        if (it != old_snapshot.end() && it->second == labelHash(item_label.second)) {
+            continue;
+        }
+        if (item_label.second.size() > sender_db->get_label_byte_count()) {
+            VLOG(5) << "label longer than the db label size, rebuild";
+            return -1;
+        }
+        upserts.push_back(item_label);
+    }
+    for (const auto& key_hash : old_snapshot) {
+        if (snapshot.find(key_hash.first) == snapshot.end()) {
+            removed.push_back(keyItem(key_hash.first));
+        }
+    }
+    size_t changed = removed.size() + upserts.size();
+    if (changed > kMaxUpdateRatio * std::max<size_t>(old_snapshot.size(), 1)) {
+        VLOG(5) << changed << " items changed, rebuild";
+        return -1;
+    }
+    try {
+        if (!removed.empty()) {
+            sender_db->remove(removed);
+        }
+        if (!upserts.empty()) {
+            sender_db->insert_or_assign(upserts);
+        }
+    } catch (const std::exception& ex) {
+        LOG(WARNING) << "Update keyword pir SenderDB failed, rebuild: " << ex.what();
+        return -1;
+    }
+    LOG(INFO) << "keyword pir db of " << endpoint->dataset_path << " updated, removed: "
+              << removed.size() << " inserted or relabeled: " << upserts.size();
+    return 0;
+}
+
+std::shared_ptr<SenderDB> KeywordPirSender::_LoadDB(const std::string& path,
+                                                    const std::string& version,
+                                                    const std::string& params) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open()) {
+        return nullptr;
+    }
+    std::string header;
+    std::getline(ifs, header);
+    if (header != dbFileHeader(version, params)) {
+        VLOG(5) << "saved keyword pir db " << path << " is out of date";
+        return nullptr;
+    }
+    try {
+        auto loaded = SenderDB::Load(ifs);
+        auto sender_db = std::make_shared<SenderDB>(std::move(loaded.first));
+        if (sender_db->is_stripped() || sender_db->get_params().to_string() != params) {
+            return nullptr;
+        }
+        LOG(INFO) << "load keyword pir db from " << path << ", "
+                  << loaded.second << " bytes";
+        return sender_db;
+    } catch (const std::exception& ex) {
+        LOG(WARNING) << "Load keyword pir db " << path << " failed: " << ex.what();
+        return nullptr;
+    }
+}
+
+int KeywordPirSender::_SaveDB(const std::string& path, const std::string& version,
+                              const SenderDB& sender_db) {
+    std::string tmp_path = path + ".tmp";
+    try {
+        std::ofstream ofs(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open()) {
+            LOG(WARNING) << "open " << tmp_path << " failed";
+            return -1;
+        }
+        // the unstripped db carries the OPRF key
+        chmod(tmp_path.c_str(), S_IRUSR | S_IWUSR);
+        ofs << dbFileHeader(version, sender_db.get_params().to_string()) << "\n";
+        size_t size = sender_db.save(ofs);
+        ofs.close();
+        if (!ofs || rename(tmp_path.c_str(), path.c_str()) != 0) {
+            LOG(WARNING) << "save keyword pir db " << path << " failed";
+            unlink(tmp_path.c_str());
+            return -1;
+        }
+        VLOG(5) << "save keyword pir db to " << path << ", " << size << " bytes";
+    } catch (const std::exception& ex) {
+        LOG(WARNING) << "save keyword pir db " << path << " failed: " << ex.what();
+        unlink(tmp_path.c_str());
+        return -1;
+    }
+    return 0;
+}
+
+void KeywordPirSender::_StartDispatcher(Endpoint* endpoint, int port) {
+    auto sender_db = endpoint->sender_db;
+    auto* stop = &endpoint->stop;
+    endpoint->thread = std::thread([sender_db, stop, port]() {
+        ZMQSenderDispatcher dispatcher(sender_db, sender_db->get_oprf_key());
+        LOG(INFO) << "keyword pir sender listens on port " << port;
+        dispatcher.run(*stop, port);
+        LOG(INFO) << "keyword pir sender on port " << port << " stopped";
+    });
+}
+
+void KeywordPirSender::_StopDispatcher(Endpoint* endpoint) {
+    endpoint->stop = true;
+    if (endpoint->thread.joinable()) {
+        endpoint->thread.join();
+    }
+}
+
+std::shared_ptr<std::mutex> KeywordPirSender::_PortMutex(int port) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    auto& port_mtx = port_mtxs_[port];
+    if (port_mtx == nullptr) {
+        port_mtx = std::make_shared<std::mutex>();
+    }
+    return port_mtx;
+}
+
+int KeywordPirSender::serve(const std::string& dataset_path, int port,
+                            const std::string& params_policy,
+                            const ParamsSelector& select_params) {
+    std::string version = FileVersion(dataset_path);
+    if (version.empty()) {
+        LOG(ERROR) << "keyword pir dataset " << dataset_path << " is not accessible";
+        return -1;
+    }
+    std::string db_file = dataset_path + ".senderdb";
+    auto port_mtx = _PortMutex(port);
+    std::lock_guard<std::mutex> port_lck(*port_mtx);
+    Endpoint* endpoint = nullptr;
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        auto it = endpoints_.find(port);
+        if (it != endpoints_.end()) {
+            endpoint = it->second.get();
+        }
+    }
+    if (endpoint != nullptr && endpoint->dataset_path == dataset_path &&
+            endpoint->params_policy == params_policy) {
+        if (endpoint->version == version) {
+            VLOG(5) << "keyword pir sender on port " << port << " is up to date";
+            return 0;
+        }
+        CSVReader::LabeledData data;
+        Snapshot snapshot;
+        if (_LoadLabeledData(dataset_path, &data, &snapshot)) {
+            return -1;
+        }
+        // SenderDB locks itself, the dispatcher keeps serving meanwhile
+        if (_UpdateDB(endpoint, data, snapshot) == 0) {
+            endpoint->snapshot = std::move(snapshot);
+            endpoint->version = version;
+            _SaveDB(db_file, version, *endpoint->sender_db);
+            return 0;
+        }
+    }
+
+    auto new_endpoint = std::make_unique<Endpoint>();
+    new_endpoint->dataset_path = dataset_path;
+    new_endpoint->version = version;
+    new_endpoint->params_policy = params_policy;
+    CSVReader::LabeledData data;
+    if (_LoadLabeledData(dataset_path, &data, &new_endpoint->snapshot)) {
+        return -1;
+    }
+    size_t label_byte_count = 0;
+    for (const auto& item_label : data) {
+        label_byte_count = std::max(label_byte_count, item_label.second.size());
+    }
+    auto params = select_params(data.size(), label_byte_count);
+    if (params == nullptr) {
+        return -1;
+    }
+    std::string params_str = params->to_string();
+    new_endpoint->sender_db = _LoadDB(db_file, version, params_str);
+    if (new_endpoint->sender_db == nullptr) {
+        LOG(INFO) << "build keyword pir db for " << dataset_path
+                  << ", items: " << data.size();
+        new_endpoint->sender_db = _BuildDB(*params, data);
+        if (new_endpoint->sender_db == nullptr) {
+            return -1;
+        }
+        _SaveDB(db_file, version, *new_endpoint->sender_db);
+    }
+
+    // the old dispatcher releases the port before the new one binds it
+    std::unique_ptr<Endpoint> old_endpoint;
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        auto it = endpoints_.find(port);
+        if (it != endpoints_.end()) {
+            old_endpoint = std::move(it->second);
+            endpoints_.erase(it);
+        }
+    }
+    if (old_endpoint != nullptr) {
+        _StopDispatcher(old_endpoint.get());
+    }
+    _StartDispatcher(new_endpoint.get(), port);
+    std::lock_guard<std::mutex> lck(mtx_);
+    endpoints_[port] = std::move(new_endpoint);
+    return 0;
+}
+
+void KeywordPirSender::stop(int port) {
+    auto port_mtx = _PortMutex(port);
+    std::lock_guard<std::mutex> port_lck(*port_mtx);
+    std::unique_ptr<Endpoint> endpoint;
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        auto it = endpoints_.find(port);
+        if (it == endpoints_.end()) {
+            return;
+        }
+        endpoint = std::move(it->second);
+        endpoints_.erase(it);
+    }
+    if (endpoint != nullptr) {
+        _StopDispatcher(endpoint.get());
+    }
+}
+
+void KeywordPirSender::stopAll() {
+    std::vector<int> ports;
+    {
+        std::lock_guard<std::mutex> lck(mtx_);
+        for (const auto& port_endpoint : endpoints_) {
+            ports.push_back(port_endpoint.first);
+        }
+    }
+    for (auto port : ports) {
+        stop(port);
+    }
+}
+
+} // namespace primihub::task
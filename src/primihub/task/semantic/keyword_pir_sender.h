@@ -0,0 +1,128 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#ifndef SRC_PRIMIHUB_TASK_SEMANTIC_KEYWORD_PIR_SENDER_H_
+#define SRC_PRIMIHUB_TASK_SEMANTIC_KEYWORD_PIR_SENDER_H_
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "apsi/psi_params.h"
+#include "apsi/sender_db.h"
+#include "apsi/util/csv_reader.h"
+
+namespace primihub::task {
+
+/**
+ * Long lived keyword pir sender of the node.
+ *
+ * One dispatcher thread serves each port, so a task no longer blocks a
+ * worker for the life of the service. The SenderDB of a dataset is built
+ * once, saved next to the dataset with APSI serialization and loaded on
+ * restart. When the dataset file changes, removed items are dropped and
+ * new or relabeled ones are inserted in place, the dispatcher keeps
+ * serving with the same db and OPRF key.
+ *
+ * The db is kept unstripped for incremental updates, so the saved file
+ * holds the OPRF key and is written with owner only permission.
+ */
+class KeywordPirSender {
+public:
+    KeywordPirSender(const KeywordPirSender&) = delete;
+    KeywordPirSender& operator=(const KeywordPirSender&) = delete;
+
+    static KeywordPirSender& getInstance() {
+        static KeywordPirSender kSingleInstance;
+        return kSingleInstance;
+    }
+    ~KeywordPirSender();
+
+    // params for a db of db_size items and label_byte_count label bytes
+    using ParamsSelector = std::function<std::unique_ptr<apsi::PSIParams>(
+        size_t db_size, size_t label_byte_count)>;
+
+    /**
+     * Start serving dataset on port, or bring the running db up to date.
+     * params_policy names how select_params picks params. Params are only
+     * selected again when the policy changes or the db is rebuilt, so a
+     * growing dataset keeps updating in place.
+     * Returns once the db is ready, the dispatcher runs in background.
+     * return 0 on success, -1 on failure.
+     */
+    int serve(const std::string& dataset_path, int port,
+              const std::string& params_policy,
+              const ParamsSelector& select_params);
+    // thread count of the APSI thread pool used for queries
+    void setThreadCount(size_t thread_count);
+    void stop(int port);
+    void stopAll();
+
+private:
+    KeywordPirSender() = default;
+
+    // item -> hash of its label, to find what changed between versions
+    using Snapshot = std::unordered_map<std::string, size_t>;
+
+    struct Endpoint {
+        std::string dataset_path;
+        std::string version;
+        std::string params_policy;
+        std::shared_ptr<apsi::sender::SenderDB> sender_db;
+        Snapshot snapshot;
+        std::atomic<bool> stop{false};
+        std::thread thread;
+    };
+
+    int _LoadLabeledData(const std::string& dataset_path,
+                         apsi::util::CSVReader::LabeledData* data,
+                         Snapshot* snapshot);
+    std::shared_ptr<apsi::sender::SenderDB> _BuildDB(
+        const apsi::PSIParams& params,
+        const apsi::util::CSVReader::LabeledData& data);
+    // update in place, return -1 if a full rebuild is needed
+    int _UpdateDB(Endpoint* endpoint,
+                  const apsi::util::CSVReader::LabeledData& data,
+                  const Snapshot& snapshot);
+    std::shared_ptr<apsi::sender::SenderDB> _LoadDB(const std::string& path,
+                                                    const std::string& version,
+                                                    const std::string& params);
+    int _SaveDB(const std::string& path, const std::string& version,
+                const apsi::sender::SenderDB& sender_db);
+    void _StartDispatcher(Endpoint* endpoint, int port);
+    void _StopDispatcher(Endpoint* endpoint);
+    // serializes serve and stop of one port, a db build of one port does
+    // not hold up the others
+    std::shared_ptr<std::mutex> _PortMutex(int port);
+
+    static constexpr size_t kNonceByteCount = 16;
+    // rebuild instead of updating when more items than this ratio change
+    static constexpr double kMaxUpdateRatio = 0.5;
+
+    // guards the maps only, an endpoint is changed by the holder of its
+    // port mutex
+    std::mutex mtx_;
+    std::map<int, std::shared_ptr<std::mutex>> port_mtxs_;
+    std::map<int, std::unique_ptr<Endpoint>> endpoints_;
+};
+
+} // namespace primihub::task
+#endif // SRC_PRIMIHUB_TASK_SEMANTIC_KEYWORD_PIR_SENDER_H_
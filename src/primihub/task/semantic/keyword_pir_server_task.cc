@@ -16,69 +16,19 @@
 
 #include "src/primihub/task/semantic/keyword_pir_server_task.h"
 
-#include "apsi/thread_pool_mgr.h"
-#include "apsi/sender_db.h"
-#include "apsi/oprf/oprf_sender.h"
-#include "apsi/zmq/sender_dispatcher.h"
+#include <algorithm>
+#include <fstream>
+#include <thread>
 
-#include "seal/context.h"
-#include "seal/modulus.h"
-#include "seal/util/common.h"
-#include "seal/util/defines.h"
+#include "src/primihub/task/semantic/keyword_pir_params.h"
+#include "src/primihub/task/semantic/keyword_pir_sender.h"
+#include "src/primihub/util/metrics.h"
+#include "src/primihub/util/util.h"
 
 using namespace apsi;
-using namespace apsi::sender;
-using namespace apsi::oprf;
-using namespace apsi::network;
-
-using namespace seal;
-using namespace seal::util;
 
 namespace primihub::task {
 
-std::shared_ptr<SenderDB>
-    KeywordPIRServerTask::create_sender_db(
-        const CSVReader::DBData &db_data,
-        std::unique_ptr<PSIParams> psi_params,
-        OPRFKey &oprf_key,
-        size_t nonce_byte_count,
-        bool compress) {
-    if (!psi_params) {
-        LOG(ERROR) << "No Keyword pir parameters were given";
-        return nullptr;
-    }
-
-    std::shared_ptr<SenderDB> sender_db;
-    if (holds_alternative<CSVReader::LabeledData>(db_data)) {
-        VLOG(5) << "CSVReader::LabeledData";
-        try {
-            auto &labeled_db_data = std::get<CSVReader::LabeledData>(db_data);
-            // Find the longest label and use that as label size
-            size_t label_byte_count =
-                 std::max_element(labeled_db_data.begin(), labeled_db_data.end(),
-                    [](auto &a, auto &b) {
-                        return a.second.size() < b.second.size();
-                    })->second.size();
-            VLOG(5) << "label_byte_count: " << label_byte_count << " nonce_byte_count: " << nonce_byte_count;
-            sender_db =
-                std::make_shared<SenderDB>(*psi_params, label_byte_count, nonce_byte_count, compress);
-            sender_db->set_data(labeled_db_data);
-        } catch (const exception &ex) {
-            LOG(ERROR) << "Failed to create keyword pir SenderDB: " << ex.what();
-            return nullptr;
-        }
-    } else if (holds_alternative<CSVReader::UnlabeledData>(db_data)) {
-        LOG(ERROR) << "Loaded keyword pir database is without label";
-        return nullptr;
-    } else {
-        LOG(ERROR) << "Loaded keyword pir database is in an invalid state";
-        return nullptr;
-    }
-
-    oprf_key = sender_db->strip();
-    return sender_db;
-}
-
 KeywordPIRServerTask::KeywordPIRServerTask(const std::string &node_id,
                                            const std::string &job_id,
                                            const std::string &task_id,
@@ -98,6 +48,22 @@ int KeywordPIRServerTask::_LoadParams(Task &task) {
             return -1;
         }
         // dataset_path_ = param_map["serverData"].value_string();
+        it = param_map.find("senderPort");
+        if (it != param_map.end()) {
+            port_ = it->second.value_int32();
+        }
+        it = param_map.find("threadNum");
+        if (it != param_map.end()) {
+            thread_num_ = it->second.value_int32();
+        }
+        it = param_map.find("apsiProfile");
+        if (it != param_map.end() && !it->second.value_string().empty()) {
+            profile_ = it->second.value_string();
+        }
+        it = param_map.find("queryBatchSize");
+        if (it != param_map.end() && it->second.value_int32() > 0) {
+            query_batch_ = it->second.value_int32();
+        }
     } catch (std::exception &e) {
         LOG(ERROR) << "Failed to load params: " << e.what();
         return -1;
@@ -105,23 +71,29 @@ int KeywordPIRServerTask::_LoadParams(Task &task) {
     return 0;
 }
 
-std::unique_ptr<CSVReader::DBData> KeywordPIRServerTask::_LoadDataset(void) {
-    CSVReader::DBData db_data;
-
+std::unique_ptr<PSIParams> KeywordPIRServerTask::_SetPsiParams(
+        size_t db_size, size_t label_byte_count) {
+    if (profile_ == "config") {
+        return _LoadPsiParamsFile();
+    }
+    if (profile_ == "auto") {
+        return selectKeywordPirParams(db_size, label_byte_count, query_batch_);
+    }
+    auto profile = findKeywordPirProfile(profile_);
+    if (profile == nullptr) {
+        LOG(ERROR) << "Unknown keyword pir profile: " << profile_;
+        return nullptr;
+    }
     try {
-        VLOG(5) << "begin to read data, dataset path: " << dataset_path_;
-        CSVReader reader(dataset_path_);
-        tie(db_data, ignore) = reader.read();
-    } catch (const exception &ex) {
-        LOG(ERROR) << "Could not open or read file `"
-                   << dataset_path_ << "`: " << ex.what();
+        return std::make_unique<PSIParams>(
+            PSIParams::Load(keywordPirParamsJson(*profile, query_batch_)));
+    } catch (const std::exception &ex) {
+        LOG(ERROR) << "APSI threw an exception creating PSIParams: " << ex.what();
         return nullptr;
     }
-    auto reader_ptr = std::make_unique<CSVReader::DBData>(std::move(db_data));
-    return reader_ptr;
 }
 
-std::unique_ptr<PSIParams> KeywordPIRServerTask::_SetPsiParams() {
+std::unique_ptr<PSIParams> KeywordPIRServerTask::_LoadPsiParamsFile() {
     std::string params_json;
     std::string pir_server_config_path{"config/pir_server_config.json"};
     VLOG(5) << "pir_server_config_path: " << pir_server_config_path;
@@ -154,35 +126,33 @@ std::unique_ptr<PSIParams> KeywordPIRServerTask::_SetPsiParams() {
 }
 
 int KeywordPIRServerTask::execute() {
+    SCopedTimer timer;
     int ret = _LoadParams(task_param_);
     if (ret) {
         LOG(ERROR) << "Pir client load task params failed.";
         return ret;
     }
-    ThreadPoolMgr::SetThreadCount(1);
-    OPRFKey oprf_key;
-    std::unique_ptr<PSIParams> params = _SetPsiParams();
-    std::unique_ptr<CSVReader::DBData> db_data = _LoadDataset();
-    std::shared_ptr<SenderDB> sender_db
-        = create_sender_db(*db_data, move(params), oprf_key, 16, false);
-    uint32_t max_bin_bundles_per_bundle_idx = 0;
-    for (uint32_t bundle_idx = 0; bundle_idx < sender_db->get_params().bundle_idx_count();
-         bundle_idx++) {
-        max_bin_bundles_per_bundle_idx =
-            std::max(max_bin_bundles_per_bundle_idx,
-                static_cast<uint32_t>(sender_db->get_bin_bundle_count(bundle_idx)));
+    if (thread_num_ == 0) {
+        thread_num_ = std::max(1u, std::thread::hardware_concurrency());
     }
-
-    atomic<bool> stop = false;
-    VLOG(5) << "begin to create ZMQSenderDispatcher";
-    ZMQSenderDispatcher dispatcher(sender_db, oprf_key);
-    int port = 2222;
-    // bool done_exit = true;
-    VLOG(5) << "ZMQSenderDispatcher begin to run port: " << std::to_string(port);
-    dispatcher.run(stop, port);
-    if (stop.load(std::memory_order::memory_order_relaxed)) {
-        VLOG(5) << "key word pir task execute finished";
+    auto load_params_ts = timer.timeElapse();
+    record_task_phase("keyword_pir_server", "load_params", load_params_ts);
+    // the sender outlives the task, it keeps serving receivers and only
+    // updates its db when the dataset changes. The queries go through the
+    // zmq dispatcher of the sender, their bytes are counted by the client.
+    auto& sender = KeywordPirSender::getInstance();
+    sender.setThreadCount(thread_num_);
+    std::string params_policy = profile_ + ":" + std::to_string(query_batch_);
+    ret = sender.serve(dataset_path_, port_, params_policy,
+        [this](size_t db_size, size_t label_byte_count) {
+            return _SetPsiParams(db_size, label_byte_count);
+        });
+    if (ret) {
+        LOG(ERROR) << "Start keyword pir sender failed.";
+        return -1;
     }
+    record_task_phase("keyword_pir_server", "serve", timer.timeElapse() - load_params_ts);
+    VLOG(5) << "keyword pir sender serves " << dataset_path_ << " on port " << port_;
     return 0;
 }
 
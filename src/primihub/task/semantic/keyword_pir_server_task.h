@@ -20,10 +20,7 @@
 #include "src/primihub/protos/common.grpc.pb.h"
 #include "src/primihub/task/semantic/task.h"
 
-#include "apsi/util/csv_reader.h"
-#include "apsi/util/common_utils.h"
-#include "apsi/sender.h"
-#include "apsi/oprf/oprf_sender.h"
+#include "apsi/psi_params.h"
 
 namespace primihub::task {
 
@@ -40,21 +37,21 @@ class KeywordPIRServerTask : public TaskBase {
 
  private:
     int _LoadParams(Task &task);
-    std::unique_ptr<apsi::util::CSVReader::DBData> _LoadDataset(void);
-    std::unique_ptr<apsi::PSIParams> _SetPsiParams();
-    std::shared_ptr<apsi::sender::SenderDB> create_sender_db(
-        const apsi::util::CSVReader::DBData &db_data,
-        std::unique_ptr<apsi::PSIParams> psi_params,
-        apsi::oprf::OPRFKey &oprf_key,
-        size_t nonce_byte_count,
-        bool compress);
+    // params from apsiProfile: "auto" (default), a built-in profile name
+    // or "config" for config/pir_server_config.json
+    std::unique_ptr<apsi::PSIParams> _SetPsiParams(size_t db_size,
+                                                   size_t label_byte_count);
+    std::unique_ptr<apsi::PSIParams> _LoadPsiParamsFile();
 
  private:
     std::string node_id_;
     std::string job_id_;
     std::string task_id_;
     std::string dataset_path_;
-
+    int port_{2222};
+    size_t thread_num_{0};
+    std::string profile_{"auto"};
+    size_t query_batch_{1};
 };
 } // namespace primihub::task
 #endif // SRC_PRIMIHUB_TASK_SEMANTIC_KEYWORD_PIR_SERVER_TASK_H_
@@ -19,6 +19,8 @@
 #include "src/primihub/util/network/socket/session.h"
 #include "src/primihub/algorithm/arithmetic.h"
 #include "src/primihub/algorithm/missing_val_processing.h"
+#include "src/primihub/util/metrics.h"
+#include "src/primihub/util/util.h"
 
 #ifndef __APPLE__
 #include "src/primihub/algorithm/falcon_lenet.h"
@@ -30,7 +32,7 @@ namespace primihub::task
   MPCTask::MPCTask(const std::string &node_id, const std::string &function_name,
                    const TaskParam *task_param,
                    std::shared_ptr<DatasetService> dataset_service)
-      : TaskBase(task_param, dataset_service)
+      : TaskBase(task_param, dataset_service), function_name_(function_name)
   {
     if (function_name == "logistic_regression")
     {
@@ -162,7 +164,16 @@ namespace primihub::task
       return -1;
     }
 
+    // phases of every algorithm, the algorithms break execute down further
+    SCopedTimer timer;
+    double phase_ts = 0;
+    auto record_phase = [&](const std::string &phase) {
+      double now = timer.timeElapse();
+      record_task_phase(function_name_, phase, now - phase_ts);
+      phase_ts = now;
+    };
     algorithm_->loadParams(task_param_);
+    record_phase("load_params");
     int ret = 0;
     do
     {
@@ -172,23 +183,39 @@ namespace primihub::task
         LOG(ERROR) << "Load dataset from file failed.";
         break;
       }
+      record_phase("load_dataset");
 
-      ret = algorithm_->initPartyComm();
-      if (ret)
+      if (isCancelled())
       {
-        LOG(ERROR) << "Initialize party communicate failed.";
+        ret = -1;
         break;
       }
 
-      ret = algorithm_->execute();
-      if (ret)
       {
-        LOG(ERROR) << "Run train failed.";
-        break;
+        // a cancelled task fails with the exception of its blocked channel,
+        // the algorithm must not be cancelled after finishPartyComm.
+        CancelScope cancel_scope(cancel_token_,
+                                 [this]() { algorithm_->cancelPartyComm(); });
+        ret = algorithm_->initPartyComm();
+        if (ret)
+        {
+          LOG(ERROR) << "Initialize party communicate failed.";
+          break;
+        }
+        record_phase("init_party_comm");
+
+        ret = algorithm_->execute();
+        if (ret)
+        {
+          LOG(ERROR) << "Run train failed.";
+          break;
+        }
+        record_phase("execute");
       }
 
       algorithm_->finishPartyComm();
       algorithm_->saveModel();
+      record_phase("save_model");
     } while (0);
 
     return ret;
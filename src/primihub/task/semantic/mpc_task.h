@@ -39,6 +39,7 @@ class MPCTask : public TaskBase {
 
   private:
     std::shared_ptr<AlgorithmBase> algorithm_;
+    std::string function_name_;
 };
 
 } // namespace primihub::task
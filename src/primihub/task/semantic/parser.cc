@@ -58,6 +58,16 @@ void ProtocolSemanticParser::parseTaskSyntaxTree(
   }
 }
 
+void ProtocolSemanticParser::dispatchTask(
+    const std::shared_ptr<VMScheduler> &scheduler,
+    const PushTaskRequest &pushTaskRequest) {
+    scheduler->setCancelToken(cancel_token_);
+    scheduler->dispatch(&pushTaskRequest);
+    const auto &parties = scheduler->dispatchedParties();
+    party_addresses_.insert(party_addresses_.end(),
+                            parties.begin(), parties.end());
+}
+
 void ProtocolSemanticParser::scheduleProtoTask(
     std::shared_ptr<LanguageParser> proto_parser) {
     auto _proto_parser = std::dynamic_pointer_cast<ProtoParser>(proto_parser);
@@ -91,13 +101,13 @@ void ProtocolSemanticParser::scheduleProtoTask(
                         std::make_shared<CRYPTFLOW2Scheduler>(
                             node_id_, peer_list_, peer_dataset_map,
                             singleton_);
-                    scheduler->dispatch(&pushTaskRequest);
+                    dispatchTask(scheduler, pushTaskRequest);
                 } else if (pushTaskRequest.task().code() == "lenet") {
                     std::shared_ptr<VMScheduler> scheduler =
                         std::make_shared<FalconScheduler>(node_id_, peer_list,
                                                           peer_dataset_map,
                                                           singleton_);
-                    scheduler->dispatch(&pushTaskRequest);
+                    dispatchTask(scheduler, pushTaskRequest);
                 } else {
                     //  Generate ABY3 scheduler
                     std::shared_ptr<VMScheduler> scheduler =
@@ -105,7 +115,7 @@ void ProtocolSemanticParser::scheduleProtoTask(
                                                         peer_dataset_map,
                                                         singleton_);
                     scheduler->set_dataset_owner(dataset_owner);
-                    scheduler->dispatch(&pushTaskRequest);
+                    dispatchTask(scheduler, pushTaskRequest);
                 }
 
                 // TEE task scheduler
@@ -115,7 +125,7 @@ void ProtocolSemanticParser::scheduleProtoTask(
                         std::make_shared<TEEScheduler>(
                             node_id_, peer_list_, peer_dataset_map,
                             pushTaskRequest.task().params(), singleton_);
-                    scheduler->dispatch(&pushTaskRequest);
+                    dispatchTask(scheduler, pushTaskRequest);
                 }
             });
     });
@@ -152,7 +162,7 @@ void ProtocolSemanticParser::schedulePythonTask(
 
                 // Dispatch task to worker nodes
                 auto pushTaskRequest = _python_parser->getPushTaskRequest();
-                scheduler->dispatch(&pushTaskRequest);
+                dispatchTask(scheduler, pushTaskRequest);
             });
     });
     t.join();
@@ -198,7 +208,7 @@ void ProtocolSemanticParser::schedulePirTask(
                                                    peer_dataset_map_,
                                                    singleton_);
                 auto pushTaskRequest = _proto_parser->getPushTaskRequest();
-                scheduler->dispatch(&pushTaskRequest);
+                dispatchTask(scheduler, pushTaskRequest);
             });
     }
 }
@@ -228,7 +238,7 @@ void ProtocolSemanticParser::schedulePsiTask(
                                                    peer_dataset_map_,
                                                    singleton_);
                 auto pushTaskRequest = _proto_parser->getPushTaskRequest();
-                scheduler->dispatch(&pushTaskRequest);
+                dispatchTask(scheduler, pushTaskRequest);
 	    });
     }
 }
@@ -56,8 +56,18 @@ class ProtocolSemanticParser {
     void schedulePsiTask(std::shared_ptr<LanguageParser> lan_parser);
     int transformPirRequest(std::shared_ptr<LanguageParser> lan_parser,
                             PushTaskRequest &taskRequest);
+    // schedulers stop dispatching once token is cancelled
+    void setCancelToken(std::shared_ptr<CancellationToken> token) {
+        cancel_token_ = std::move(token);
+    }
+    // ip:port of every node a party task was dispatched to
+    const std::vector<std::string>& getPartyAddresses() const {
+        return party_addresses_;
+    }
 
   private:
+    void dispatchTask(const std::shared_ptr<VMScheduler> &scheduler,
+                      const PushTaskRequest &pushTaskRequest);
     void scheduleProtoTask(std::shared_ptr<LanguageParser> proto_parser);
     void schedulePythonTask( std::shared_ptr<LanguageParser> python_parser);
     void metasToPeerList(
@@ -83,6 +93,8 @@ class ProtocolSemanticParser {
     const std::string node_id_;
     bool singleton_;
     std::shared_ptr<DatasetService> dataset_service_;
+    std::shared_ptr<CancellationToken> cancel_token_;
+    std::vector<std::string> party_addresses_;
 
     // proto task use
     std::vector<Node> peer_list_;
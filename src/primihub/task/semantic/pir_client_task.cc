@@ -15,10 +15,14 @@
  */
 #include "src/primihub/task/semantic/pir_client_task.h"
 
+#include <algorithm>
+#include <map>
 #include <string>
 
 #include "src/primihub/data_store/factory.h"
+#include "src/primihub/util/metrics.h"
 #include "src/primihub/util/util.h"
+#include "src/primihub/util/network/grpc_channel_pool.h"
 
 
 using arrow::Table;
@@ -58,7 +62,16 @@ int PIRClientTask::_LoadParams(Task &task) {
         result_file_path_ = param_map["outputFullFilename"].value_string();
         server_address_ = param_map["serverAddress"].value_string();
         server_dataset_ = param_map[server_address_].value_string();
-        db_size_ = stoi(param_map["databaseSize"].value_string());  // temperarily read db size direly from frontend
+        // only a hint, the server corrects it with its real size
+        if (param_map.count("databaseSize")) {
+            db_size_ = stoll(param_map["databaseSize"].value_string());
+        }
+        if (param_map.count("pirDimensions")) {
+            dimensions_ = param_map["pirDimensions"].value_int32();
+        }
+        if (param_map.count("pirBatch")) {
+            use_batch_ = param_map["pirBatch"].value_int32() > 0;
+        }
         std::vector<std::string> tmp_indices;
         str_split(param_map["queryIndeies"].value_string(), &tmp_indices, ',');
         for (std::string &index : tmp_indices) {
@@ -74,14 +87,57 @@ int PIRClientTask::_LoadParams(Task &task) {
 }
 
 
-int PIRClientTask::_SetUpDB(size_t __dbsize, size_t dimensions, size_t elem_size,
-                             uint32_t plain_mod_bit_size, uint32_t bits_per_coeff,
-                             bool use_ciphertext_multiplication = false) {
-    // db_size_ = dbsize;
-    encryption_params_ = pir::GenerateEncryptionParams(POLY_MODULUS_DEGREE,
-                                                       plain_mod_bit_size);
-    pir_params_ = *(pir::CreatePIRParameters(db_size_, elem_size, dimensions, encryption_params_,
-                                        use_ciphertext_multiplication, bits_per_coeff));
+int PIRClientTask::_Plan() {
+    std::vector<uint64_t> distinct(indices_.begin(), indices_.end());
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+    if (distinct.empty() || distinct.back() >= static_cast<uint64_t>(db_size_)) {
+        LOG(ERROR) << "Pir query index out of database size " << db_size_;
+        return -1;
+    }
+    PirCost cost;
+    plan_.Clear();
+    bucket_index_.clear();
+    uint32_t num_buckets = PirBuckets::numBuckets(distinct.size());
+    if (use_batch_ && distinct.size() > PirBuckets::kNumHashes &&
+            PirBuckets::assign(distinct, num_buckets, &bucket_index_)) {
+        std::vector<uint64_t> positions;
+        bucket_size_ = PirBuckets::positions(db_size_, num_buckets,
+                                             bucket_index_, &positions);
+        if (planPir(bucket_size_, ELEM_SIZE, num_buckets, dimensions_, 0,
+                    &plan_, &cost)) {
+            LOG(ERROR) << "No pir plan fits bucket size " << bucket_size_;
+            return -1;
+        }
+        plan_.set_database_size(db_size_);
+        plan_.set_num_buckets(num_buckets);
+        query_positions_.assign(positions.begin(), positions.end());
+    } else {
+        bucket_index_.clear();
+        bucket_size_ = 0;
+        if (planPir(db_size_, ELEM_SIZE, distinct.size(), dimensions_, 0,
+                    &plan_, &cost)) {
+            LOG(ERROR) << "No pir plan fits database size " << db_size_;
+            return -1;
+        }
+        query_positions_.assign(distinct.begin(), distinct.end());
+    }
+    LOG(INFO) << "pir plan: " << plan_.ShortDebugString()
+              << ", queries: " << query_positions_.size()
+              << ", expected upload bytes: " << cost.upload_bytes
+              << ", expected download bytes: " << cost.download_bytes;
+    return 0;
+}
+
+int PIRClientTask::_SetUpDB() {
+    bool use_ciphertext_multiplication = true;
+    uint32_t bits_per_coeff = 0;
+    size_t dbsize = plan_.num_buckets() ? bucket_size_ : plan_.database_size();
+    encryption_params_ = pir::GenerateEncryptionParams(plan_.poly_modulus_degree(),
+                                                       plan_.plain_mod_bit_size());
+    pir_params_ = *(pir::CreatePIRParameters(dbsize, plan_.elem_size(),
+        plan_.dimensions(), encryption_params_,
+        use_ciphertext_multiplication, bits_per_coeff));
     client_ = *(PIRClient::Create(pir_params_));
     if (client_ == nullptr) {
         LOG(ERROR) << "Failed to create pir client.";
@@ -103,10 +159,19 @@ int PIRClientTask::_ProcessResponse(const ExecuteTaskResponse &taskResponse) {
             ptr_reply->add_ct(taskResponse.pir_response().reply()[i].ct()[j]);
         }
     }
-    auto result = client_->ProcessResponse(indices_, response);
+    auto result = client_->ProcessResponse(query_positions_, response);
     if (result.ok()) {
-        for (size_t i = 0; i < std::move(result).value().size(); i++) {
-            result_.push_back(std::move(result).value()[i]);
+        auto values = std::move(result).value();
+        std::map<size_t, std::string> index_value;
+        for (size_t i = 0; i < values.size(); i++) {
+            if (bucket_index_.empty()) {
+                index_value[query_positions_[i]] = std::move(values[i]);
+            } else if (bucket_index_[i] >= 0) {
+                index_value[bucket_index_[i]] = std::move(values[i]);
+            }
+        }
+        for (auto index : indices_) {
+            result_.push_back(index_value[index]);
         }
     } else {
         LOG(ERROR) << "Failed to process pir server response: "
@@ -154,78 +219,36 @@ int PIRClientTask::saveResult() {
     return 0;
 }
 
-uint32_t compute_plain_mod_bit_size(size_t dbsize, size_t elem_size) {
-    uint32_t plain_mod_bit_size = PLAIN_MOD_BIT_SIZE_UPBOUND;
-    while (true) {
-        plain_mod_bit_size--;
-        uint64_t elem_per_plaintext = POLY_MODULUS_DEGREE \
-                                    * (plain_mod_bit_size - 1) / 8 / elem_size;
-        uint64_t num_plaintext = dbsize / elem_per_plaintext + 1;
-        if (num_plaintext <=
-                (uint64_t)1 << (NOISE_BUDGET_BASE - 2 * plain_mod_bit_size))
-        {
-            break;
-        }
-    }
-    return plain_mod_bit_size;
-}
-
-int PIRClientTask::execute() {
-    int ret = _LoadParams(task_param_);
-    if (ret) {
-        LOG(ERROR) << "Pir client load task params failed.";
-        return ret;
-    }
-
-    size_t dimensions = 1;
-    size_t elem_size = ELEM_SIZE;
-    uint32_t plain_mod_bit_size = compute_plain_mod_bit_size(db_size_, elem_size);
-    bool use_ciphertext_multiplication = true;
-    uint32_t poly_modulus_degree = POLY_MODULUS_DEGREE;
-    uint32_t bits_per_coeff = 0;
-
-    ret = _SetUpDB(0, dimensions, elem_size,                // temperarily read db size direly from frontend
-                       plain_mod_bit_size, bits_per_coeff,
-                       use_ciphertext_multiplication);
-
-    if (ret) {
-        LOG(ERROR) << "Failed to initialize pir client.";
-        return -1;
-    }
-    //pir::Request request_proto = std::move(client_->CreateRequest(indices_)).value();
-    pir::Request request_proto;
-    auto request_or = client_->CreateRequest(indices_);
-    if (request_or.ok()) {
-        request_proto = std::move(request_or).value();
-    } else {
-        LOG(ERROR) << "Pir create request failed: "
-                   << request_or.status();
-        return -1;
-    }
+int PIRClientTask::_SendRequest(const pir::Request* request_proto,
+                                ExecuteTaskResponse* taskResponse) {
     grpc::ClientContext client_context;
-    grpc::ChannelArguments channel_args;
-    channel_args.SetMaxReceiveMessageSize(128*1024*1024);
-    std::shared_ptr<grpc::Channel> channel =
-        grpc::CreateCustomChannel(server_address_, grpc::InsecureChannelCredentials(), channel_args);
-    std::unique_ptr<VMNode::Stub> stub = VMNode::NewStub(channel);
+    setClientDeadline(&client_context);
+    CancelScope cancel_scope(cancel_token_, [&client_context]() {
+        client_context.TryCancel();
+    });
+    auto stub = GrpcChannelPool::getInstance().getVMNodeStub(server_address_);
     using stream_t = std::shared_ptr<grpc::ClientReaderWriter<ExecuteTaskRequest, ExecuteTaskResponse>>;
     stream_t client_stream(stub->ExecuteTask(&client_context));
 
     size_t limited_size = 1 << 21;
-    size_t query_num = request_proto.query().size();
-    const auto& querys = request_proto.query();
+    size_t query_num = request_proto ? request_proto->query().size() : 0;
     size_t sended_index{0};
     std::vector<ExecuteTaskRequest> send_requests;
     do {
         ExecuteTaskRequest taskRequest;
         PirRequest * ptr_request = taskRequest.mutable_pir_request();
-        ptr_request->set_galois_keys(request_proto.galois_keys());
-        ptr_request->set_relin_keys(request_proto.relin_keys());
+        if (send_requests.empty()) {
+            ptr_request->mutable_plan()->CopyFrom(plan_);
+        }
+        if (request_proto) {
+            ptr_request->set_galois_keys(request_proto->galois_keys());
+            ptr_request->set_relin_keys(request_proto->relin_keys());
+        }
         size_t pack_size = 0;
         for (size_t i = sended_index; i < query_num; i++) {
             // calculate length of query
             size_t query_size = 0;
-            const auto& query = querys[i];
+            const auto& query = request_proto->query()[i];
             for (const auto& ct : query.ct()) {
                 query_size += ct.size();
             }
@@ -249,18 +272,23 @@ int PIRClientTask::execute() {
         }
     } while (true);
     // send request to server
+    uint64_t sent_bytes = 0;
+    uint64_t recv_bytes = 0;
     for (const auto& request : send_requests) {
         client_stream->Write(request);
+        sent_bytes += request.ByteSizeLong();
     }
     client_stream->WritesDone();
-    ExecuteTaskResponse taskResponse;
     ExecuteTaskResponse recv_response;
-    auto pir_response = taskResponse.mutable_pir_response();
+    auto pir_response = taskResponse->mutable_pir_response();
     bool is_initialized{false};
     while (client_stream->Read(&recv_response)) {
+        recv_bytes += recv_response.ByteSizeLong();
         const auto& recv_pir_response = recv_response.pir_response();
         if (!is_initialized) {
             pir_response->set_ret_code(recv_pir_response.ret_code());
+            pir_response->set_database_size(recv_pir_response.database_size());
+            pir_response->mutable_plan()->CopyFrom(recv_pir_response.plan());
             is_initialized = true;
         }
         for (const auto& reply : recv_pir_response.reply()) {
@@ -271,28 +299,94 @@ int PIRClientTask::execute() {
         }
     }
     Status status = client_stream->Finish();
-    if (status.ok()) {
-        if (taskResponse.psi_response().ret_code()) {
+    record_channel_bytes("pir_client", sent_bytes, recv_bytes);
+    if (!status.ok()) {
+        LOG(ERROR) << "Pir server return error: "
+                   << status.error_code() << " " << status.error_message().c_str();
+        return -1;
+    }
+    return 0;
+}
+
+int PIRClientTask::execute() {
+    SCopedTimer timer;
+    int ret = _LoadParams(task_param_);
+    if (ret) {
+        LOG(ERROR) << "Pir client load task params failed.";
+        return ret;
+    }
+    record_task_phase("pir_client", "load_params", timer.timeElapse());
+
+    for (int attempt = 0; attempt < PIR_MAX_PLAN_ATTEMPTS; attempt++) {
+        ExecuteTaskResponse taskResponse;
+        auto attempt_ts = timer.timeElapse();
+        if (db_size_ <= 0) {
+            // database size unknown, an empty request gets it from the server
+            plan_.Clear();
+            plan_.set_database_size(-1);
+            ret = _SendRequest(nullptr, &taskResponse);
+            record_task_phase("pir_client", "size_probe", timer.timeElapse() - attempt_ts);
+        } else {
+            ret = _Plan();
+            if (ret) {
+                return -1;
+            }
+            ret = _SetUpDB();
+            if (ret) {
+                LOG(ERROR) << "Failed to initialize pir client.";
+                return -1;
+            }
+            auto request_or = client_->CreateRequest(query_positions_);
+            if (!request_or.ok()) {
+                LOG(ERROR) << "Pir create request failed: "
+                           << request_or.status();
+                return -1;
+            }
+            pir::Request request_proto = std::move(request_or).value();
+            auto request_ts = timer.timeElapse();
+            record_task_phase("pir_client", "build_request", request_ts - attempt_ts);
+            ret = _SendRequest(&request_proto, &taskResponse);
+            record_task_phase("pir_client", "send_request", timer.timeElapse() - request_ts);
+        }
+        if (ret) {
+            return -1;
+        }
+        const auto& pir_response = taskResponse.pir_response();
+        if (pir_response.database_size() > 0 &&
+                pir_response.database_size() != db_size_) {
+            LOG(INFO) << "Pir server database size is " << pir_response.database_size()
+                      << ", plan again. server plan: "
+                      << pir_response.plan().ShortDebugString();
+            db_size_ = pir_response.database_size();
+            continue;
+        }
+        if (pir_response.ret_code()) {
             LOG(ERROR) << "Node pir server process request error.";
             return -1;
         }
-        int ret = _ProcessResponse(taskResponse);
+        if (db_size_ <= 0) {
+            LOG(ERROR) << "Pir server does not answer the database size probe.";
+            return -1;
+        }
+        auto response_ts = timer.timeElapse();
+        ret = _ProcessResponse(taskResponse);
         if (ret) {
             LOG(ERROR) << "Node pir client process response failed.";
             return -1;
         }
+        auto save_ts = timer.timeElapse();
+        record_task_phase("pir_client", "process_response", save_ts - response_ts);
 
         ret = saveResult();
         if (ret) {
             LOG(ERROR) << "Pir save result failed.";
             return -1;
         }
-    } else {
-        LOG(ERROR) << "Pir server return error: "
-                   << status.error_code() << " " << status.error_message().c_str();
-        return -1;
+        record_task_phase("pir_client", "save_result", timer.timeElapse() - save_ts);
+        return 0;
     }
-    return 0;
+    LOG(ERROR) << "Pir client and server can not agree on database size.";
+    return -1;
 }
 
 }
@@ -33,6 +33,7 @@
 #include "src/primihub/protos/common.grpc.pb.h"
 #include "src/primihub/protos/psi.grpc.pb.h"
 #include "src/primihub/protos/worker.grpc.pb.h"
+#include "src/primihub/task/semantic/pir_planner.h"
 #include "src/primihub/task/semantic/task.h"
 
 using pir::PIRParameters;
@@ -49,16 +50,15 @@ using primihub::rpc::ParamValue;
 using primihub::rpc::PsiType;
 using primihub::rpc::ExecuteTaskRequest;
 using primihub::rpc::ExecuteTaskResponse;
+using primihub::rpc::PirPlan;
 using primihub::rpc::PirRequest;
 using primihub::rpc::PirResponse;
 using primihub::rpc::VMNode;
 
 namespace primihub::task {
 
-constexpr uint32_t POLY_MODULUS_DEGREE = 4096;
 constexpr uint32_t ELEM_SIZE = 1024;
-constexpr uint32_t PLAIN_MOD_BIT_SIZE_UPBOUND = 29;
-constexpr uint32_t NOISE_BUDGET_BASE = 57;
+constexpr int PIR_MAX_PLAN_ATTEMPTS = 3;
 
 class PIRClientTask : public TaskBase {
 public:
@@ -73,9 +73,12 @@ public:
     int saveResult(void);
 private:
     int _LoadParams(Task &task);
-    int _SetUpDB(size_t dbsize, size_t dimensions, size_t elem_size,
-		 uint32_t plain_mod_bit_size, uint32_t bits_per_coeff,
-                 bool use_ciphertext_multiplication);
+    // choose plan_ for db_size_, batched into cuckoo buckets when it pays
+    int _Plan();
+    int _SetUpDB();
+    // send request with plan_, nullptr sends the plan only
+    int _SendRequest(const pir::Request* request_proto,
+                     ExecuteTaskResponse* taskResponse);
     int _ProcessResponse(const ExecuteTaskResponse &taskResponse);
 
     const std::string node_id_;
@@ -85,10 +88,19 @@ private:
     std::string result_file_path_;
     std::vector<size_t> indices_;
     std::vector<std::string> result_;   
+    // positions queried in the (bucket) database, one per query
+    std::vector<size_t> query_positions_;
+    // index assigned to each bucket, -1 for empty buckets
+    std::vector<int64_t> bucket_index_;
+    uint64_t bucket_size_{0};
+    PirPlan plan_;
+    uint32_t dimensions_{0};
+    bool use_batch_{true};
 
     std::string server_dataset_;
 
-    size_t db_size_;
+    // 0 if unknown, the server reports it on the first request
+    int64_t db_size_{0};
     std::shared_ptr<PIRParameters> pir_params_;
     EncryptionParameters encryption_params_;
     std::unique_ptr<PIRClient> client_;
@@ -0,0 +1,250 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "src/primihub/task/semantic/pir_planner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace primihub::task {
+
+namespace {
+struct PirParameterSet {
+    uint32_t poly_modulus_degree;
+    // bits of the default BFV coefficient modulus
+    uint32_t coeff_modulus_bits;
+    // primes of the coefficient modulus without the special prime, the
+    // words per coefficient of a plaintext in NTT form
+    uint32_t data_primes;
+    uint32_t max_dimensions;
+    // noise budget base used by the feasibility rule
+    uint32_t noise_budget_base;
+};
+
+// Sets every plan is drawn from. 57 is the base the 4096 servers have been
+// running with on one dimension. 8192 has no production history, its base
+// is the one pir_round_trip_test decodes with at one and two dimensions on
+// the largest plaintext modulus the rule allows. Raise a base or add a
+// dimension only together with a round trip test at the new limit.
+constexpr PirParameterSet kParameterSets[] = {
+    {4096, 109, 2, 1, 57},
+    {8192, 218, 4, 2, 100},
+};
+
+uint32_t ceilLog2(uint64_t value) {
+    uint32_t bits = 0;
+    while ((uint64_t{1} << bits) < value) {
+        bits++;
+    }
+    return bits;
+}
+
+uint64_t ceilRoot(uint64_t value, uint32_t d) {
+    auto root = static_cast<uint64_t>(std::ceil(std::pow(value, 1.0 / d)));
+    // pow is not exact, fix the rounding
+    while (root > 1 && std::pow(root - 1, d) >= value) {
+        root--;
+    }
+    while (std::pow(root, d) < value) {
+        root++;
+    }
+    return std::max<uint64_t>(root, 1);
+}
+
+uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+const PirParameterSet* parameterSet(uint32_t poly_modulus_degree) {
+    for (const auto& set : kParameterSets) {
+        if (set.poly_modulus_degree == poly_modulus_degree) {
+            return &set;
+        }
+    }
+    return nullptr;
+}
+
+// rows of elem_size bytes packed into plaintexts of plain_mod_bits - 1 bits
+// per coefficient, 0 if one row does not fit a plaintext
+uint64_t numPlaintexts(int64_t num_rows, uint32_t elem_size,
+                       uint32_t poly_modulus_degree, uint32_t plain_mod_bits) {
+    uint64_t elem_per_plaintext =
+        uint64_t{poly_modulus_degree} * (plain_mod_bits - 1) / 8 / elem_size;
+    if (elem_per_plaintext == 0) {
+        return 0;
+    }
+    return num_rows / elem_per_plaintext + 1;
+}
+
+uint64_t noiseOf(uint64_t dim_size, uint32_t dimensions, uint32_t plain_mod_bits) {
+    return uint64_t{ceilLog2(dim_size)} * dimensions + 2ULL * plain_mod_bits * dimensions;
+}
+}  // namespace
+
+int planPir(int64_t db_size, uint32_t elem_size, size_t num_queries,
+            uint32_t dimensions, uint32_t poly_modulus_degree,
+            rpc::PirPlan* plan, PirCost* cost) {
+    if (db_size <= 0 || elem_size == 0 || dimensions > PIR_MAX_DIMENSIONS) {
+        return -1;
+    }
+    num_queries = std::max<size_t>(num_queries, 1);
+    bool found = false;
+    uint64_t best_bytes = std::numeric_limits<uint64_t>::max();
+    for (const auto& info : kParameterSets) {
+        if (poly_modulus_degree && poly_modulus_degree != info.poly_modulus_degree) {
+            continue;
+        }
+        uint64_t ct_bytes = 2ULL * info.poly_modulus_degree * info.coeff_modulus_bits / 8;
+        uint32_t d_begin = dimensions ? dimensions : 1;
+        uint32_t d_end = dimensions ? dimensions : info.max_dimensions;
+        for (uint32_t d = d_begin; d <= std::min(d_end, info.max_dimensions); d++) {
+            // largest plaintext modulus that fits gives the fewest plaintexts
+            for (uint32_t t = PIR_PLAIN_MOD_BIT_SIZE_UPBOUND - 1;
+                    t >= PIR_PLAIN_MOD_BIT_SIZE_LOWBOUND; t--) {
+                uint64_t num_plaintexts =
+                    numPlaintexts(db_size, elem_size, info.poly_modulus_degree, t);
+                if (num_plaintexts == 0) {
+                    break;
+                }
+                uint64_t dim_size = ceilRoot(num_plaintexts, d);
+                if (noiseOf(dim_size, d, t) > info.noise_budget_base) {
+                    continue;
+                }
+                uint64_t cts_per_dim =
+                    (dim_size + info.poly_modulus_degree - 1) / info.poly_modulus_degree;
+                uint64_t upload = cts_per_dim * d * ct_bytes * num_queries;
+                // ciphertext multiplication folds every dimension into one reply
+                uint64_t download = ct_bytes * num_queries;
+                if (upload + download < best_bytes) {
+                    best_bytes = upload + download;
+                    found = true;
+                    plan->set_database_size(db_size);
+                    plan->set_dimensions(d);
+                    plan->set_poly_modulus_degree(info.poly_modulus_degree);
+                    plan->set_plain_mod_bit_size(t);
+                    plan->set_elem_size(elem_size);
+                    if (cost != nullptr) {
+                        cost->num_plaintexts = num_plaintexts;
+                        cost->upload_bytes = upload;
+                        cost->download_bytes = download;
+                        cost->database_bytes = num_plaintexts * info.poly_modulus_degree *
+                            info.data_primes * sizeof(uint64_t);
+                    }
+                }
+                break;
+            }
+        }
+    }
+    return found ? 0 : -1;
+}
+
+int validatePirPlan(int64_t num_rows, const rpc::PirPlan& plan) {
+    const auto* info = parameterSet(plan.poly_modulus_degree());
+    uint32_t d = plan.dimensions();
+    uint32_t t = plan.plain_mod_bit_size();
+    if (info == nullptr || num_rows <= 0 || plan.elem_size() == 0 ||
+            d < 1 || d > info->max_dimensions ||
+            t < PIR_PLAIN_MOD_BIT_SIZE_LOWBOUND || t >= PIR_PLAIN_MOD_BIT_SIZE_UPBOUND) {
+        return -1;
+    }
+    uint64_t num_plaintexts =
+        numPlaintexts(num_rows, plan.elem_size(), info->poly_modulus_degree, t);
+    if (num_plaintexts == 0 ||
+            noiseOf(ceilRoot(num_plaintexts, d), d, t) > info->noise_budget_base) {
+        return -1;
+    }
+    return 0;
+}
+
+uint32_t PirBuckets::numBuckets(size_t num_queries) {
+    return static_cast<uint32_t>(std::ceil(num_queries * kBucketFactor));
+}
+
+std::vector<uint32_t> PirBuckets::candidates(uint64_t index, uint32_t num_buckets) {
+    std::vector<uint32_t> buckets;
+    buckets.reserve(kNumHashes);
+    for (uint32_t i = 0; i < kNumHashes; i++) {
+        uint32_t bucket = splitmix64(index * kNumHashes + i) % num_buckets;
+        if (std::find(buckets.begin(), buckets.end(), bucket) == buckets.end()) {
+            buckets.push_back(bucket);
+        }
+    }
+    return buckets;
+}
+
+std::vector<std::vector<uint64_t>> PirBuckets::layout(int64_t db_size,
+                                                      uint32_t num_buckets) {
+    std::vector<std::vector<uint64_t>> buckets(num_buckets);
+    for (int64_t i = 0; i < db_size; i++) {
+        for (auto bucket : candidates(i, num_buckets)) {
+            buckets[bucket].push_back(i);
+        }
+    }
+    return buckets;
+}
+
+bool PirBuckets::assign(const std::vector<uint64_t>& indices, uint32_t num_buckets,
+                        std::vector<int64_t>* bucket_index) {
+    constexpr size_t kMaxEvictions = 500;
+    bucket_index->assign(num_buckets, -1);
+    for (auto index : indices) {
+        int64_t current = index;
+        size_t evictions = 0;
+        while (current >= 0) {
+            auto buckets = candidates(current, num_buckets);
+            bool placed = false;
+            for (auto bucket : buckets) {
+                if ((*bucket_index)[bucket] < 0) {
+                    (*bucket_index)[bucket] = current;
+                    placed = true;
+                    break;
+                }
+            }
+            if (placed) {
+                break;
+            }
+            if (++evictions > kMaxEvictions) {
+                return false;
+            }
+            // evict from a pseudo random candidate and retry with the victim
+            auto bucket = buckets[splitmix64(current + evictions) % buckets.size()];
+            std::swap(current, (*bucket_index)[bucket]);
+        }
+    }
+    return true;
+}
+
+uint64_t PirBuckets::positions(int64_t db_size, uint32_t num_buckets,
+                               const std::vector<int64_t>& bucket_index,
+                               std::vector<uint64_t>* bucket_position) {
+    std::vector<uint64_t> counts(num_buckets, 0);
+    bucket_position->assign(num_buckets, 0);
+    for (int64_t i = 0; i < db_size; i++) {
+        for (auto bucket : candidates(i, num_buckets)) {
+            if (bucket_index[bucket] == i) {
+                (*bucket_position)[bucket] = counts[bucket];
+            }
+            counts[bucket]++;
+        }
+    }
+    return *std::max_element(counts.begin(), counts.end());
+}
+
+} // namespace primihub::task
@@ -0,0 +1,99 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#ifndef SRC_PRIMIHUB_TASK_SEMANTIC_PIR_PLANNER_H_
+#define SRC_PRIMIHUB_TASK_SEMANTIC_PIR_PLANNER_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "src/primihub/protos/pir.grpc.pb.h"
+
+namespace primihub::task {
+
+constexpr uint32_t PIR_MAX_DIMENSIONS = 2;
+constexpr uint32_t PIR_PLAIN_MOD_BIT_SIZE_UPBOUND = 29;
+constexpr uint32_t PIR_PLAIN_MOD_BIT_SIZE_LOWBOUND = 12;
+
+struct PirCost {
+    uint64_t num_plaintexts{0};
+    // bytes of query ciphertexts, galois keys are not included
+    uint64_t upload_bytes{0};
+    uint64_t download_bytes{0};
+    // memory of the encoded database, plaintexts are kept in NTT form
+    uint64_t database_bytes{0};
+};
+
+/**
+ * Pick dimensions, polynomial degree and plaintext modulus for a database.
+ *
+ * Only validated parameter sets are planned: one dimension on 4096, the
+ * set the servers have been running with, and up to two dimensions on
+ * 8192. Noise is estimated with the rule the servers used for one
+ * dimension, log2(plaintexts) + 2 * plain_mod_bits <= noise budget base,
+ * applied to every dimension: sum(log2(dim_size)) + 2 * plain_mod_bits * d
+ * <= base. Among the feasible plans the one with the least communication
+ * for num_queries queries is chosen.
+ *
+ * dimensions/poly_modulus_degree 0 means chosen by the planner.
+ * return 0 on success, -1 if no parameter set fits.
+ */
+int planPir(int64_t db_size, uint32_t elem_size, size_t num_queries,
+            uint32_t dimensions, uint32_t poly_modulus_degree,
+            rpc::PirPlan* plan, PirCost* cost);
+
+/**
+ * Check a plan of a client against the validated parameter sets for
+ * num_rows rows per query, the bucket size of a batched plan.
+ * return 0 if the plan is one planPir can produce, -1 otherwise.
+ */
+int validatePirPlan(int64_t num_rows, const rpc::PirPlan& plan);
+
+/**
+ * Cuckoo bucketing for batched queries. Every row is stored in each of
+ * its kNumHashes candidate buckets, the client places its k indices in
+ * distinct buckets and sends one query per bucket. The server touches
+ * about kNumHashes * n rows in total instead of k * n.
+ */
+class PirBuckets {
+public:
+    static constexpr uint32_t kNumHashes = 3;
+    static constexpr double kBucketFactor = 1.5;
+
+    static uint32_t numBuckets(size_t num_queries);
+    // distinct candidate buckets of a row
+    static std::vector<uint32_t> candidates(uint64_t index, uint32_t num_buckets);
+    // rows of every bucket in increasing order
+    static std::vector<std::vector<uint64_t>> layout(int64_t db_size,
+                                                     uint32_t num_buckets);
+    /**
+     * Place distinct indices into distinct buckets, bucket_index[b] is
+     * the index assigned to bucket b or -1. return false on failure.
+     */
+    static bool assign(const std::vector<uint64_t>& indices, uint32_t num_buckets,
+                       std::vector<int64_t>* bucket_index);
+    /**
+     * Position of the assigned index inside its bucket, 0 for empty
+     * buckets. return the size of the largest bucket.
+     */
+    static uint64_t positions(int64_t db_size, uint32_t num_buckets,
+                              const std::vector<int64_t>& bucket_index,
+                              std::vector<uint64_t>* bucket_position);
+};
+
+} // namespace primihub::task
+#endif // SRC_PRIMIHUB_TASK_SEMANTIC_PIR_PLANNER_H_
@@ -0,0 +1,266 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "src/primihub/task/semantic/pir_server_cache.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+
+namespace primihub::task {
+
+namespace {
+constexpr char kPirRowFileMagic[8] = {'P', 'H', 'P', 'I', 'R', 'D', 'B', '1'};
+
+void writeUint64(std::ofstream& out, uint64_t value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+bool readUint64(const char* data, size_t size, size_t* offset, uint64_t* value) {
+    if (*offset + sizeof(uint64_t) > size) {
+        return false;
+    }
+    memcpy(value, data + *offset, sizeof(uint64_t));
+    *offset += sizeof(uint64_t);
+    return true;
+}
+}  // namespace
+
+int PirRowFile::write(const std::string& path, const std::string& version,
+                      const std::vector<std::string>& rows, size_t elem_size) {
+    // write to a temp file and rename, readers never see a partial file
+    std::string tmp_path = path + ".tmp";
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        LOG(WARNING) << "open pir row file " << tmp_path << " failed";
+        return -1;
+    }
+    out.write(kPirRowFileMagic, sizeof(kPirRowFileMagic));
+    writeUint64(out, version.size());
+    out.write(version.data(), version.size());
+    writeUint64(out, rows.size());
+    writeUint64(out, elem_size);
+    std::string padding(elem_size, 0);
+    for (const auto& row : rows) {
+        size_t len = std::min(row.size(), elem_size);
+        out.write(row.data(), len);
+        out.write(padding.data(), elem_size - len);
+    }
+    out.close();
+    if (!out || rename(tmp_path.c_str(), path.c_str()) != 0) {
+        LOG(WARNING) << "write pir row file " << path << " failed";
+        unlink(tmp_path.c_str());
+        return -1;
+    }
+    return 0;
+}
+
+PirRowFile::~PirRowFile() {
+    close();
+}
+
+void PirRowFile::close() {
+    if (addr_ != nullptr) {
+        munmap(addr_, size_);
+    }
+    addr_ = nullptr;
+    size_ = 0;
+    rows_ = nullptr;
+    num_rows_ = 0;
+    elem_size_ = 0;
+}
+
+int PirRowFile::open(const std::string& path, const std::string& version,
+                     size_t elem_size) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return -1;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        LOG(WARNING) << "mmap pir row file " << path << " failed";
+        return -1;
+    }
+    const char* data = static_cast<const char*>(addr);
+    size_t offset = sizeof(kPirRowFileMagic);
+    uint64_t version_len = 0;
+    uint64_t num_rows = 0;
+    uint64_t file_elem_size = 0;
+    if (size < offset || memcmp(data, kPirRowFileMagic, offset) != 0 ||
+            !readUint64(data, size, &offset, &version_len) ||
+            version_len > size - offset ||
+            version != std::string_view(data + offset, version_len)) {
+        munmap(addr, size);
+        return -1;
+    }
+    offset += version_len;
+    if (!readUint64(data, size, &offset, &num_rows) ||
+            !readUint64(data, size, &offset, &file_elem_size) ||
+            file_elem_size != elem_size || elem_size == 0 ||
+            num_rows > (size - offset) / elem_size) {
+        munmap(addr, size);
+        return -1;
+    }
+    addr_ = addr;
+    size_ = size;
+    rows_ = data + offset;
+    num_rows_ = num_rows;
+    elem_size_ = elem_size;
+    return static_cast<int>(num_rows);
+}
+
+PirDatabaseCache::Entry& PirDatabaseCache::getEntry(const std::string& dataset,
+                                                    const std::string& version) {
+    auto& entry = entries_[dataset];
+    if (entry.version != version) {
+        VLOG(5) << "pir database cache reset " << dataset
+                << ", version: " << version;
+        dropDatabases(&entry);
+        entry = Entry();
+        entry.version = version;
+    }
+    return entry;
+}
+
+void PirDatabaseCache::dropDatabases(Entry* entry) {
+    for (auto& [param_key, slot] : entry->databases) {
+        bytes_ -= slot.database.bytes;
+        lru_.erase(slot.lru_it);
+    }
+    entry->databases.clear();
+}
+
+void PirDatabaseCache::evict() {
+    while (bytes_ > options_.max_bytes && !lru_.empty()) {
+        const auto& [dataset, param_key] = lru_.back();
+        auto& databases = entries_[dataset].databases;
+        auto it = databases.find(param_key);
+        VLOG(5) << "pir database cache evict " << dataset << ", " << param_key;
+        bytes_ -= it->second.database.bytes;
+        databases.erase(it);
+        lru_.pop_back();
+    }
+}
+
+int64_t PirDatabaseCache::numRows(const std::string& dataset,
+                                  const std::string& version) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    return getEntry(dataset, version).num_rows;
+}
+
+void PirDatabaseCache::setNumRows(const std::string& dataset,
+                                  const std::string& version,
+                                  int64_t num_rows) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    getEntry(dataset, version).num_rows = num_rows;
+}
+
+bool PirDatabaseCache::get(const std::string& dataset,
+                           const std::string& version,
+                           const std::string& param_key,
+                           Database* database) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    auto& entry = getEntry(dataset, version);
+    auto it = entry.databases.find(param_key);
+    if (it == entry.databases.end()) {
+        return false;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lru_it);
+    *database = it->second.database;
+    return true;
+}
+
+void PirDatabaseCache::put(const std::string& dataset,
+                           const std::string& version,
+                           const std::string& param_key,
+                           const Database& database) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    if (database.bytes > options_.max_bytes) {
+        VLOG(5) << "pir database of " << database.bytes << " bytes is not cached";
+        return;
+    }
+    auto& databases = getEntry(dataset, version).databases;
+    auto it = databases.find(param_key);
+    if (it != databases.end()) {
+        bytes_ -= it->second.database.bytes;
+        lru_.erase(it->second.lru_it);
+        databases.erase(it);
+    }
+    lru_.emplace_front(dataset, param_key);
+    databases[param_key] = Slot{database, lru_.begin()};
+    bytes_ += database.bytes;
+    evict();
+}
+
+void PirDatabaseCache::erase(const std::string& dataset) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    auto it = entries_.find(dataset);
+    if (it == entries_.end()) {
+        return;
+    }
+    dropDatabases(&it->second);
+    entries_.erase(it);
+}
+
+uint64_t PirDatabaseCache::bytes() {
+    std::lock_guard<std::mutex> lck(mtx_);
+    return bytes_;
+}
+
+void PirDatabaseCache::setOptions(const Options& options) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    options_ = options;
+    evict();
+}
+
+PirDatabaseCache::Options PirDatabaseCache::options() {
+    std::lock_guard<std::mutex> lck(mtx_);
+    return options_;
+}
+
+std::string PirDatabaseCache::rowFilePath(const std::string& dataset) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    if (options_.row_file_dir.empty()) {
+        return "";
+    }
+    // hashed name keeps the file inside the directory whatever the dataset
+    // path is, the full path is also part of the file version
+    char name[32];
+    snprintf(name, sizeof(name), "%016zx.pirdb", std::hash<std::string>()(dataset));
+    std::string dir = options_.row_file_dir;
+    if (dir.back() != '/') {
+        dir += '/';
+    }
+    return dir + name;
+}
+
+} // namespace primihub::task
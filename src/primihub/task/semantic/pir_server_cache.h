@@ -0,0 +1,148 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#ifndef SRC_PRIMIHUB_TASK_SEMANTIC_PIR_SERVER_CACHE_H_
+#define SRC_PRIMIHUB_TASK_SEMANTIC_PIR_SERVER_CACHE_H_
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "pir/cpp/database.h"
+
+namespace primihub::task {
+
+/**
+ * Fixed width row file of a pir database, the layout is
+ *   magic(8) | version length(8) | version | num_rows(8) | elem_size(8) | rows
+ * rows are num_rows * elem_size bytes, already padded to elem_size. An
+ * opened file stays mapped, rows are views into the mapping and are only
+ * valid while the PirRowFile lives.
+ */
+class PirRowFile {
+public:
+    PirRowFile() = default;
+    ~PirRowFile();
+    PirRowFile(const PirRowFile&) = delete;
+    PirRowFile& operator=(const PirRowFile&) = delete;
+
+    static int write(const std::string& path, const std::string& version,
+                     const std::vector<std::string>& rows, size_t elem_size);
+    // map the file, return number of rows, -1 if missing or built from
+    // another version
+    int open(const std::string& path, const std::string& version,
+             size_t elem_size);
+    void close();
+
+    size_t numRows() const { return num_rows_; }
+    std::string_view row(size_t index) const {
+        return std::string_view(rows_ + index * elem_size_, elem_size_);
+    }
+
+private:
+    void* addr_{nullptr};
+    size_t size_{0};
+    const char* rows_{nullptr};
+    size_t num_rows_{0};
+    size_t elem_size_{0};
+};
+
+/**
+ * Process wide cache of encoded pir databases. An entry belongs to one
+ * dataset version, and keeps one encoded database per parameter set.
+ * A new dataset version drops all databases of the old one. Databases of
+ * all datasets share one LRU bounded by Options::max_bytes.
+ */
+class PirDatabaseCache {
+public:
+    struct Database {
+        std::shared_ptr<pir::PIRParameters> params;
+        std::shared_ptr<pir::PIRDatabase> db;
+        // bucket databases of a batched plan, all share params
+        std::vector<std::shared_ptr<pir::PIRDatabase>> buckets;
+        // encoded size, counted against Options::max_bytes
+        uint64_t bytes{0};
+    };
+
+    // node level settings, loaded from the pir_server_cache section of the
+    // node config. Clients can not change them.
+    struct Options {
+        bool enabled{true};
+        // directory of the row files, no row file is kept if empty
+        std::string row_file_dir;
+        // encoded databases kept in memory, least recently used go first
+        uint64_t max_bytes{uint64_t{4} << 30};
+    };
+
+    PirDatabaseCache(const PirDatabaseCache&) = delete;
+    PirDatabaseCache& operator=(const PirDatabaseCache&) = delete;
+
+    static PirDatabaseCache& getInstance() {
+        static PirDatabaseCache kSingleInstance;
+        return kSingleInstance;
+    }
+
+    // number of dataset rows recorded for the version, -1 if unknown
+    int64_t numRows(const std::string& dataset, const std::string& version);
+    void setNumRows(const std::string& dataset, const std::string& version,
+                    int64_t num_rows);
+    // param_key must come from the plan of the server, see PIRServerTask
+    bool get(const std::string& dataset, const std::string& version,
+             const std::string& param_key, Database* database);
+    void put(const std::string& dataset, const std::string& version,
+             const std::string& param_key, const Database& database);
+    void erase(const std::string& dataset);
+    // bytes of the cached databases
+    uint64_t bytes();
+
+    void setOptions(const Options& options);
+    Options options();
+    // row file of the dataset under the configured directory, empty if
+    // row files are disabled
+    std::string rowFilePath(const std::string& dataset);
+
+private:
+    PirDatabaseCache() = default;
+
+    // dataset and param_key of a database, most recently used first
+    using LruList = std::list<std::pair<std::string, std::string>>;
+    struct Slot {
+        Database database;
+        LruList::iterator lru_it;
+    };
+    struct Entry {
+        std::string version;
+        int64_t num_rows{-1};
+        std::map<std::string, Slot> databases;
+    };
+    Entry& getEntry(const std::string& dataset, const std::string& version);
+    void dropDatabases(Entry* entry);
+    void evict();
+
+    std::mutex mtx_;
+    Options options_;
+    std::map<std::string, Entry> entries_;
+    LruList lru_;
+    uint64_t bytes_{0};
+};
+
+} // namespace primihub::task
+#endif // SRC_PRIMIHUB_TASK_SEMANTIC_PIR_SERVER_CACHE_H_
@@ -14,25 +14,16 @@
  limitations under the License.
  */
 
+#include <algorithm>
+#include <cstring>
 
 #include "src/primihub/task/semantic/pir_server_task.h"
+#include "src/primihub/util/file_util.h"
+#include "src/primihub/util/metrics.h"
+#include "src/primihub/util/util.h"
 
 namespace primihub::task {
 
-void initRequest(const PirRequest * request, pir::Request & pir_request) {
-    pir_request.set_galois_keys(request->galois_keys());
-    pir_request.set_relin_keys(request->relin_keys());
-    const size_t num_query = static_cast<size_t>(request->query().size());
-    for (size_t i = 0; i < num_query; i++) {
-        pir::Ciphertexts* ptr_query = pir_request.add_query();
-        const size_t num_ct =
-            static_cast<size_t>(request->query()[i].ct().size());
-        for (size_t j = 0; j < num_ct; j++) {
-            ptr_query->add_ct(request->query()[i].ct()[j]);
-        }
-    }
-}
-
 PIRServerTask::PIRServerTask(const std::string &node_id,
                              const ExecuteTaskRequest& request,
                              ExecuteTaskResponse *response,
@@ -50,6 +41,10 @@ int PIRServerTask::loadParams(Params & params) {
         LOG(ERROR) << "Failed to load pir server params: " << e.what();
         return -1;
     }
+    // cache settings belong to the node, never to the requesting client
+    auto& db_cache = PirDatabaseCache::getInstance();
+    use_cache_ = db_cache.options().enabled;
+    row_file_path_ = use_cache_ ? db_cache.rowFilePath(dataset_path_) : "";
     return 0;
 }
 
@@ -67,70 +62,220 @@ int PIRServerTask::loadDataset() {
     return ret;
 }
 
-int PIRServerTask::_SetUpDB(size_t dbsize, size_t dimensions,
-                            size_t elem_size, uint32_t poly_modulus_degree,
-                            uint32_t plain_mod_bit_size, uint32_t bits_per_coeff,
-                            bool use_ciphertext_multiplication) {
-    encryption_params_ = 
-        pir::GenerateEncryptionParams(poly_modulus_degree, plain_mod_bit_size);
-    pir_params_ = *(pir::CreatePIRParameters(dbsize, elem_size, dimensions, encryption_params_,
-                                        use_ciphertext_multiplication, bits_per_coeff));
-    db_size_ = dbsize;
+std::string PIRServerTask::_DatasetVersion() {
+    return FileVersion(dataset_path_);
+}
 
-    if (elements_.size() > dbsize) {
-        LOG(ERROR) << "Dataset size is not equal dbsize:" << elements_.size();
-        for (int i = 0; i < elements_.size(); i++) {
-            LOG(INFO) << "elem: " << elements_[i];
+int PIRServerTask::_LoadRows(size_t elem_size) {
+    bool use_row_file = !dataset_version_.empty() && !row_file_path_.empty();
+    std::string file_version = dataset_path_ + "#" + dataset_version_ + "#" +
+        std::to_string(elem_size);
+    if (use_row_file) {
+        int ret = row_file_.open(row_file_path_, file_version, elem_size);
+        if (ret > 0) {
+            LOG(INFO) << "map " << ret << " rows from " << row_file_path_;
+            return ret;
         }
+    }
+    int ret = loadDataset();
+    if (ret <= 0) {
+        return ret;
+    }
+    if (use_row_file && ValidateDir(row_file_path_) == 0) {
+        PirRowFile::write(row_file_path_, file_version, elements_, elem_size);
+    }
+    return ret;
+}
+
+size_t PIRServerTask::_NumRows() const {
+    return row_file_.numRows() ? row_file_.numRows() : elements_.size();
+}
+
+std::string_view PIRServerTask::_Row(size_t index) const {
+    return row_file_.numRows() ? row_file_.row(index) : elements_[index];
+}
+
+int PIRServerTask::_SetUpDB(const PirPlan& plan) {
+    bool use_ciphertext_multiplication = true;
+    uint32_t bits_per_coeff = 0;
+    size_t elem_size = plan.elem_size();
+    size_t dbsize = plan.database_size();
+    encryption_params_ = pir::GenerateEncryptionParams(plan.poly_modulus_degree(),
+                                                       plan.plain_mod_bit_size());
+    db_size_ = dbsize;
+    if (_NumRows() != dbsize) {
+        LOG(ERROR) << "Dataset size is not equal dbsize:" << _NumRows();
         return -1;
-    } else if (elements_.size() < dbsize) {
-        uint32_t seed = 42;
-        auto prng =
-	    seal::UniformRandomGeneratorFactory::DefaultFactory()->create({seed});
-        for (int64_t i = elements_.size(); i < dbsize; i++) {
-            int rand_num = rand() % 80;
+    }
 
-            std::string rand_str(rand_num, 0);
-            prng->generate(rand_str.size(), reinterpret_cast<seal::SEAL_BYTE*>(rand_str.data()));
-	        elements_.push_back(std::to_string(i) + std::to_string(i) + std::to_string(i) + rand_str);
+    if (plan.num_buckets() == 0) {
+        if (validatePirPlan(dbsize, plan)) {
+            LOG(ERROR) << "Pir plan is not validated for " << dbsize
+                       << " rows: " << plan.ShortDebugString();
+            return -1;
+        }
+        pir_params_ = *(pir::CreatePIRParameters(dbsize, elem_size, plan.dimensions(),
+            encryption_params_, use_ciphertext_multiplication, bits_per_coeff));
+        if (row_file_.numRows()) {
+            // the database only takes owned rows, mapped ones are padded already
+            elements_.reserve(dbsize);
+            for (size_t i = 0; i < dbsize; i++) {
+                elements_.emplace_back(row_file_.row(i));
+            }
+            row_file_.close();
+        } else {
+            // pad rows to elem_size in place, the database copies them when encoding
+            for (auto& element : elements_) {
+                element.resize(elem_size, 0);
+            }
+        }
+        auto db_status = pir::PIRDatabase::Create(elements_, pir_params_);
+        if (!db_status.ok()) {
+            LOG(ERROR) << db_status.status();
+            return -1;
         }
+        pir_db_ = std::move(db_status).value();
+        std::vector<std::string>().swap(elements_);
+        return 0;
     }
 
-    std::vector<std::string> string_db;
-    string_db.resize(dbsize, std::string(elem_size, 0));
-    for (size_t i = 0; i < dbsize; ++i) {
-        for (int j = 0; j < elements_[i].length(); j++) {
-            string_db[i][j] = elements_[i][j];
+    // every bucket is padded to the largest one, so one parameter set
+    // and one client serve all of them
+    auto layout = PirBuckets::layout(dbsize, plan.num_buckets());
+    size_t bucket_size = 0;
+    for (const auto& rows : layout) {
+        bucket_size = std::max(bucket_size, rows.size());
+    }
+    if (validatePirPlan(bucket_size, plan)) {
+        LOG(ERROR) << "Pir plan is not validated for buckets of " << bucket_size
+                   << " rows: " << plan.ShortDebugString();
+        return -1;
+    }
+    pir_params_ = *(pir::CreatePIRParameters(bucket_size, elem_size, plan.dimensions(),
+        encryption_params_, use_ciphertext_multiplication, bits_per_coeff));
+    bucket_dbs_.clear();
+    for (const auto& rows : layout) {
+        std::vector<std::string> bucket_db(bucket_size, std::string(elem_size, 0));
+        for (size_t i = 0; i < rows.size(); i++) {
+            auto element = _Row(rows[i]);
+            memcpy(&bucket_db[i][0], element.data(), std::min(element.size(), elem_size));
+        }
+        auto db_status = pir::PIRDatabase::Create(bucket_db, pir_params_);
+        if (!db_status.ok()) {
+            LOG(ERROR) << db_status.status();
+            return -1;
         }
+        bucket_dbs_.push_back(std::move(db_status).value());
+    }
+    row_file_.close();
+    std::vector<std::string>().swap(elements_);
+    LOG(INFO) << "create " << bucket_dbs_.size() << " bucket databases of "
+              << bucket_size << " rows";
+    return 0;
+}
+
+int PIRServerTask::_CheckPlan(const PirPlan& plan) {
+    if (plan.database_size() <= 0) {
+        // legacy client or size probe, planned on the real size once it
+        // is known
+        return 0;
     }
-    auto db_status = pir::PIRDatabase::Create(string_db, pir_params_);
-    if (!db_status.ok()) {
-        LOG(ERROR) << db_status.status();
+    // rows are not known yet, one row gives the least noise a plan can have,
+    // _SetUpDB checks again with the rows of a query
+    if (plan.elem_size() == 0 || plan.elem_size() > MAX_ELEM_SIZE_SVR ||
+            plan.num_buckets() > MAX_NUM_BUCKETS_SVR ||
+            validatePirPlan(1, plan)) {
+        LOG(ERROR) << "Invalid pir plan: " << plan.ShortDebugString();
+        return -1;
+    }
+    if (plan.num_buckets() > 0 &&
+            static_cast<uint32_t>(request_->query().size()) != plan.num_buckets()) {
+        LOG(ERROR) << "Batched pir request needs one query per bucket, buckets: "
+                   << plan.num_buckets() << " queries: " << request_->query().size();
+        return -1;
+    }
+    return 0;
+}
+
+int PIRServerTask::_MatchPlan(int64_t db_size, PirPlan* plan) {
+    if (plan->database_size() == 0) {
+        // legacy client, fixed one dimension plan on the real size
+        if (planPir(db_size, ELEM_SIZE_SVR, 1, 1, POLY_MODULUS_DEGREE_SVR, plan, nullptr)) {
+            LOG(ERROR) << "No legacy pir plan fits " << db_size << " rows";
+            return -2;
+        }
+        return 0;
+    }
+    if (plan->database_size() != db_size) {
         return -1;
-    } else {
-        pir_db_ = std::move(db_status).value();
     }
+    return 0;
+}
 
+int PIRServerTask::_NormalizePlan(int64_t db_size, PirPlan* plan, uint64_t* db_bytes) {
+    int64_t rows = db_size;
+    if (plan->num_buckets() > 0) {
+        std::vector<uint64_t> positions;
+        std::vector<int64_t> no_index(plan->num_buckets(), -1);
+        rows = PirBuckets::positions(db_size, plan->num_buckets(), no_index, &positions);
+    }
+    PirPlan normalized;
+    PirCost cost;
+    if (planPir(rows, plan->elem_size(), 1, plan->dimensions(),
+                plan->poly_modulus_degree(), &normalized, &cost) ||
+            normalized.plain_mod_bit_size() != plan->plain_mod_bit_size()) {
+        LOG(ERROR) << "Pir plan is not the one planned for " << rows
+                   << " rows: " << plan->ShortDebugString();
+        return -1;
+    }
+    normalized.set_database_size(db_size);
+    normalized.set_num_buckets(plan->num_buckets());
+    *plan = normalized;
+    *db_bytes = cost.database_bytes * std::max<uint32_t>(plan->num_buckets(), 1);
     return 0;
 }
 
-uint32_t compute_plain_mod_bit_size_server(size_t dbsize, size_t elem_size) {
-    uint32_t plain_mod_bit_size = PLAIN_MOD_BIT_SIZE_UPBOUND_SVR;
-    while (true) {
-        plain_mod_bit_size--;
-        uint64_t elem_per_plaintext = POLY_MODULUS_DEGREE_SVR \
-                                    * (plain_mod_bit_size - 1) / 8 / elem_size;
-        uint64_t num_plaintext = dbsize / elem_per_plaintext + 1;
-        if (num_plaintext <= 
-                (uint64_t)1 << (NOISE_BUDGET_BASE_SVR - 2 * plain_mod_bit_size)) 
-        {
-            break;
+int PIRServerTask::_ProcessRequest(const PirPlan& plan) {
+    size_t num_query = static_cast<size_t>(request_->query().size());
+    for (size_t i = 0; i < num_query; i++) {
+        if (isCancelled()) {
+            LOG(WARNING) << "pir server task is cancelled.";
+            return -1;
+        }
+        auto& db = plan.num_buckets() ? bucket_dbs_[i] : pir_db_;
+        pir::Request pir_request;
+        pir_request.set_galois_keys(request_->galois_keys());
+        pir_request.set_relin_keys(request_->relin_keys());
+        // one query per call, so a bucket query only meets its bucket
+        auto ptr_query = pir_request.add_query();
+        for (const auto& ct : request_->query()[i].ct()) {
+            ptr_query->add_ct(ct);
+        }
+        auto server_status = pir::PIRServer::Create(db, pir_params_);
+        if (!server_status.ok()) {
+            LOG(ERROR) << "Failed to create pir server: " << server_status.status();
+            return -1;
+        }
+        auto server = std::move(server_status).value();
+        auto result_status = server->ProcessRequest(pir_request);
+        if (!result_status.ok()) {
+            LOG(ERROR) << "Process pir request failed:"
+                       << result_status.status();
+            return -1;
+        }
+        auto result_raw = std::move(result_status).value();
+        for (const auto& reply : result_raw.reply()) {
+            Ciphertexts* ptr_reply = response_->add_reply();
+            for (const auto& ct : reply.ct()) {
+                ptr_reply->add_ct(ct);
+            }
         }
     }
-    return plain_mod_bit_size;
+    return 0;
 }
 
 int PIRServerTask::execute() {
+    SCopedTimer timer;
     LOG(INFO) << "load parameters";
     int ret = loadParams(params_);
     if (ret) {
@@ -138,64 +283,122 @@ int PIRServerTask::execute() {
         return -1;
     }
     LOG(INFO) << "parameters loaded";
+    auto load_params_ts = timer.timeElapse();
+    record_task_phase("pir_server", "load_params", load_params_ts);
 
-    LOG(INFO) << "load dataset";
-    int db_size = loadDataset();
-    if (db_size <= 0) {
-        LOG(ERROR) << "Load dataset for pir server failed.";
-        return -1;
-    }
-    LOG(INFO) << "dataset loaded";
-
-    size_t dimensions = 1;
-    size_t elem_size = ELEM_SIZE_SVR;
-    uint32_t plain_mod_bit_size = compute_plain_mod_bit_size_server(db_size, elem_size);
-    bool use_ciphertext_multiplication = true;
-    uint32_t poly_modulus_degree = POLY_MODULUS_DEGREE_SVR;
-    uint32_t bits_per_coeff = 0;
-
-    LOG(INFO) << "create database";
-    ret = _SetUpDB(db_size, dimensions, elem_size, poly_modulus_degree,
-                       plain_mod_bit_size, bits_per_coeff,
-                       use_ciphertext_multiplication);
+    // the plan comes from the client, nothing is read or written with it
+    // before it passes the checks
+    PirPlan plan = request_->plan();
+    ret = _CheckPlan(plan);
     if (ret) {
-        LOG(ERROR) << "Create pir db failed.";
+        response_->set_ret_code(2);
         return -1;
     }
-    LOG(INFO) << "database created";
+    size_t elem_size = plan.elem_size() ? plan.elem_size() : ELEM_SIZE_SVR;
 
-    pir::Request pir_request;
-    initRequest(request_, pir_request);
+    // encoded database is reused across requests until the dataset changes
+    auto& db_cache = PirDatabaseCache::getInstance();
+    dataset_version_ = use_cache_ ? _DatasetVersion() : "";
+    bool cacheable = !dataset_version_.empty();
+    int64_t db_size = -1;
+    if (cacheable) {
+        db_size = db_cache.numRows(dataset_path_, dataset_version_);
+    }
+    if (db_size <= 0) {
+        LOG(INFO) << "load dataset";
+        db_size = _LoadRows(elem_size);
+        if (db_size <= 0) {
+            LOG(ERROR) << "Load dataset for pir server failed.";
+            return -1;
+        }
+        LOG(INFO) << "dataset loaded";
+        if (cacheable) {
+            db_cache.setNumRows(dataset_path_, dataset_version_, db_size);
+        }
+    }
+    auto load_dataset_ts = timer.timeElapse();
+    record_task_phase("pir_server", "load_dataset", load_dataset_ts - load_params_ts);
 
-    LOG(INFO) << "create server";
-    std::unique_ptr<pir::PIRServer> server = 
-        *(pir::PIRServer::Create(pir_db_, pir_params_));
+    if (plan.database_size() < 0) {
+        // size probe, the client plans on the reply and sends its queries
+        response_->set_ret_code(0);
+        response_->set_database_size(db_size);
+        if (planPir(db_size, elem_size, 1, 0, 0, response_->mutable_plan(), nullptr)) {
+            LOG(ERROR) << "No pir plan fits " << db_size << " rows";
+            response_->set_ret_code(2);
+            return -1;
+        }
+        VLOG(5) << "pir size probe, plan: " << response_->plan().ShortDebugString();
+        record_channel_bytes("pir_server", response_->ByteSizeLong(),
+                             request_->ByteSizeLong());
+        return 0;
+    }
 
-    if (server == nullptr) {
-        LOG(ERROR) << "Failed to create pir server";
+    ret = _MatchPlan(db_size, &plan);
+    if (ret) {
+        // tell the client the real size, it plans again with it
+        response_->set_ret_code(2);
+        response_->set_database_size(db_size);
+        if (ret == -1) {
+            LOG(WARNING) << "Pir plan is built for " << request_->plan().database_size()
+                         << " rows, database has " << db_size;
+            return 0;
+        }
         return -1;
     }
-    LOG(INFO) << "server created";
-
-    LOG(INFO) << "process request";
-    auto  result_status = server->ProcessRequest(pir_request);
-    if (!result_status.ok()) {
-        LOG(ERROR) << "Process pir request failed:"
-                   << result_status.status();
+    // the cache key comes from the plan of the server, a client only picks
+    // among the plans the planner makes, the cache LRU bounds the rest
+    uint64_t db_bytes = 0;
+    if (_NormalizePlan(db_size, &plan, &db_bytes)) {
+        response_->set_ret_code(2);
         return -1;
     }
-    LOG(INFO) << "request processed";
+    VLOG(5) << "pir plan: " << plan.ShortDebugString();
 
-    auto result_raw = std::move(result_status).value();
-    const size_t num_reply = static_cast<size_t>(result_raw.reply().size());
-    for (size_t i = 0; i < num_reply; i++) {
-	Ciphertexts* ptr_reply = response_->add_reply();
-        const size_t num_ct = static_cast<size_t>(result_raw.reply()[i].ct().size());
-        for (size_t j = 0; j < num_ct; j++) {
-            ptr_reply->add_ct(result_raw.reply()[i].ct()[j]);
+    std::string param_key = std::to_string(plan.database_size()) + "-" +
+        std::to_string(plan.dimensions()) + "-" + std::to_string(plan.elem_size()) + "-" +
+        std::to_string(plan.poly_modulus_degree()) + "-" +
+        std::to_string(plan.plain_mod_bit_size()) + "-" +
+        std::to_string(plan.num_buckets());
+    PirDatabaseCache::Database cached_db;
+    if (cacheable && db_cache.get(dataset_path_, dataset_version_, param_key, &cached_db)) {
+        LOG(INFO) << "use cached database";
+        pir_params_ = cached_db.params;
+        pir_db_ = cached_db.db;
+        bucket_dbs_ = cached_db.buckets;
+        db_size_ = db_size;
+    } else {
+        if (_NumRows() == 0 && _LoadRows(elem_size) != db_size) {
+            LOG(ERROR) << "Dataset changed during loading, retry later.";
+            return -1;
+        }
+        LOG(INFO) << "create database";
+        ret = _SetUpDB(plan);
+        if (ret) {
+            response_->set_ret_code(2);
+            LOG(ERROR) << "Create pir db failed.";
+            return -1;
+        }
+        LOG(INFO) << "database created";
+        if (cacheable) {
+            db_cache.put(dataset_path_, dataset_version_, param_key,
+                         {pir_params_, pir_db_, bucket_dbs_, db_bytes});
         }
+        record_task_phase("pir_server", "setup_db", timer.timeElapse() - load_dataset_ts);
     }
 
+    LOG(INFO) << "process request";
+    auto process_request_ts = timer.timeElapse();
+    ret = _ProcessRequest(plan);
+    if (ret) {
+        response_->set_ret_code(2);
+        return -1;
+    }
+    LOG(INFO) << "request processed";
+    record_task_phase("pir_server", "process_request",
+                      timer.timeElapse() - process_request_ts);
+    record_channel_bytes("pir_server", response_->ByteSizeLong(),
+                         request_->ByteSizeLong());
     return 0;
 }
 
@@ -20,6 +20,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <stdlib.h>
 
 #include "pir/cpp/server.h"
@@ -31,11 +32,14 @@
 #include "src/primihub/protos/psi.grpc.pb.h"
 #include "src/primihub/protos/worker.grpc.pb.h"
 #include "src/primihub/task/semantic/private_server_base.h"
+#include "src/primihub/task/semantic/pir_planner.h"
+#include "src/primihub/task/semantic/pir_server_cache.h"
 
 using std::shared_ptr;
 
 using primihub::rpc::Params;
 using primihub::rpc::Ciphertexts;
+using primihub::rpc::PirPlan;
 using primihub::rpc::PirRequest;
 using primihub::rpc::PirResponse;
 using primihub::rpc::ExecuteTaskRequest;
@@ -45,8 +49,8 @@ namespace primihub::task {
 
 constexpr uint32_t POLY_MODULUS_DEGREE_SVR = 4096;
 constexpr uint32_t ELEM_SIZE_SVR = 1024;
-constexpr uint32_t PLAIN_MOD_BIT_SIZE_UPBOUND_SVR = 29;
-constexpr uint32_t NOISE_BUDGET_BASE_SVR = 57;
+constexpr uint32_t MAX_ELEM_SIZE_SVR = 1 << 16;
+constexpr uint32_t MAX_NUM_BUCKETS_SVR = 1 << 14;
 
 
 class PIRServerTask : public ServerTaskBase {
@@ -62,18 +66,37 @@ public:
     int execute() override;
 
 private:
-    int _SetUpDB(size_t dbsize, size_t dimensions,
-                 size_t elem_size, uint32_t poly_modulus_degree,
-                 uint32_t plain_mod_bit_size, uint32_t bits_per_coeff,
-                 bool use_ciphertext_multiplication);
-                 
+    // bounds of the client plan, checked before any data is touched
+    int _CheckPlan(const PirPlan& plan);
+    // plan against the database size, the legacy one if the client sent none
+    int _MatchPlan(int64_t db_size, PirPlan* plan);
+    // replace the client plan with the one the server plans for the same
+    // dimensions and degree, fail if they disagree. db_bytes is the size of
+    // the encoded database.
+    int _NormalizePlan(int64_t db_size, PirPlan* plan, uint64_t* db_bytes);
+    int _SetUpDB(const PirPlan& plan);
+    int _ProcessRequest(const PirPlan& plan);
+    // dataset rows, from the row file cache when it matches the dataset
+    int _LoadRows(size_t elem_size);
+    size_t _NumRows() const;
+    std::string_view _Row(size_t index) const;
+    // mtime and size of the dataset file, empty if unknown
+    std::string _DatasetVersion();
+
     //int data_col_;
     std::string dataset_path_;
+    std::string dataset_version_;
+    // preprocessed row file under the node cache dir, empty if disabled
+    std::string row_file_path_;
+    PirRowFile row_file_;
+    bool use_cache_{true};
     size_t db_size_;
     shared_ptr<pir::PIRParameters> pir_params_;
     pir::EncryptionParameters encryption_params_;
     std::vector<std::string> elements_;
     shared_ptr<pir::PIRDatabase> pir_db_;
+    // one database per cuckoo bucket, for batched requests
+    std::vector<shared_ptr<pir::PIRDatabase>> bucket_dbs_;
 
     const PirRequest * request_;
     PirResponse * response_;
@@ -18,12 +18,9 @@
 
 #include "src/primihub/task/semantic/private_server_base.h"
 #include "src/primihub/data_store/factory.h"
+#include "src/primihub/data_store/key_column.h"
 #include <fstream>
 
-using arrow::Array;
-using arrow::StringArray;
-using arrow::Table;
-
 namespace primihub::task {
 
 ServerTaskBase::ServerTaskBase(const Params *params,
@@ -42,62 +39,30 @@ void ServerTaskBase::setTaskParam(const Params *params) {
 
 int ServerTaskBase::loadDatasetFromSQLite(const std::string& conn_str, int data_col,
 		                  std::vector<std::string>& col_array, int64_t max_num) {
-    std::string nodeaddr("localhost"); // TODO
-    // std::shared_ptr<DataDriver>
-    auto driver = DataDirverFactory::getDriver("SQLITE", nodeaddr);
-    if (driver == nullptr) {
-        LOG(ERROR) << "create sqlite db driver failed";
-        return -1;
-    }
-    // std::shared_ptr<Cursor> &cursor
-    auto& cursor = driver->read(conn_str);
-    // std::shared_ptr<Dataset>
-    auto ds = cursor->read();
-    if (ds == nullptr) {
-        return -1;
-    }
-    auto table = std::get<std::shared_ptr<Table>>(ds->data);
-    int num_col = table->num_columns();
-    if (num_col < data_col) {
-        LOG(ERROR) << "psi dataset colunum number is smaller than data_col";
+    KeyColumn keys;
+    auto ret = keys.load("SQLITE", conn_str, data_col, max_num);
+    if (ret < 0) {
+        LOG(ERROR) << "load psi dataset from sqlite failed";
         return -1;
     }
-    auto array = std::static_pointer_cast<StringArray>(table->column(data_col)->chunk(0));
-    for (int64_t i = 0; i < array->length(); i++) {
-        if (max_num > 0 && max_num == i) {
-            break;
-        }
-        col_array.push_back(array->GetString(i));
-    }
+    col_array = keys.toStrings();
     VLOG(5) << "psi server loaded data records: " << col_array.size();
-    return array->length();
+    return col_array.size();
 }
 
 int ServerTaskBase::loadDatasetFromCSV(const std::string& filename, int data_col,
                                        std::vector<std::string> &col_array,
                                        int64_t max_num) {
-    std::string nodeaddr("test address"); // TODO
-    std::shared_ptr<DataDriver> driver =
-        DataDirverFactory::getDriver("CSV", nodeaddr);
-    std::shared_ptr<Cursor> &cursor = driver->read(filename);
-    std::shared_ptr<Dataset> ds = cursor->read();
-    std::shared_ptr<Table> table = std::get<std::shared_ptr<Table>>(ds->data);
-
-    int num_col = table->num_columns();
-    if (num_col < data_col) {
-        LOG(ERROR) << "psi dataset colunum number is smaller than data_col";
+    // csv, or a columnar file converted from csv
+    KeyColumn keys;
+    auto ret = keys.load(DataDirverFactory::getDriverNameByPath(filename),
+                         filename, data_col, max_num);
+    if (ret < 0) {
+        LOG(ERROR) << "load psi dataset from csv failed";
         return -1;
     }
-
-    auto array = std::static_pointer_cast<StringArray>(
-        table->column(data_col)->chunk(0));
-    for (int64_t i = 0; i < array->length(); i++) {
-        if (max_num > 0 && max_num == i) {
-            break;
-        }
-        col_array.push_back(array->GetString(i));
-    }
-    return array->length();
+    col_array = keys.toStrings();
+    return col_array.size();
 }
 
 int ServerTaskBase::loadDatasetFromTXT(std::string &filename,
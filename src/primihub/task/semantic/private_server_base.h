@@ -23,6 +23,7 @@
 
 #include "src/primihub/protos/common.grpc.pb.h"
 #include "src/primihub/service/dataset/service.h"
+#include "src/primihub/util/cancellation.h"
 
 
 using primihub::rpc::Params;
@@ -43,6 +44,14 @@ public:
     }
     void setTaskParam(const Params *params);
     Params* getTaskParam();
+    // the server task runs on the rpc thread, the token is cancelled when
+    // the client goes away or its deadline expires
+    void setCancellationToken(std::shared_ptr<CancellationToken> token) {
+        cancel_token_ = std::move(token);
+    }
+    bool isCancelled() const {
+        return cancel_token_ != nullptr && cancel_token_->isCancelled();
+    }
 
 protected:
     int loadDatasetFromCSV(const std::string &filename, int data_col,
@@ -54,6 +63,7 @@ protected:
 
     Params params_;
     std::shared_ptr<DatasetService> dataset_service_;
+    std::shared_ptr<CancellationToken> cancel_token_;
 };
 } // namespace primihub::task
 
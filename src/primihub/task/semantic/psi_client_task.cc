@@ -15,11 +15,23 @@
  */
 
 #include "private_set_intersection/cpp/psi_client.h"
+#include "private_set_intersection/cpp/bloom_filter.h"
+#include "private_set_intersection/cpp/gcs.h"
+#include "private_join_and_compute/crypto/ec_commutative_cipher.h"
 
 #include "src/primihub/task/semantic/psi_client_task.h"
 #include "src/primihub/data_store/factory.h"
+#include "src/primihub/node/result_sink.h"
 #include "src/primihub/util/file_util.h"
+#include "src/primihub/util/metrics.h"
 #include "src/primihub/util/util.h"
+#include "src/primihub/util/network/grpc_channel_pool.h"
+
+#include <openssl/obj_mac.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 
 using arrow::Table;
@@ -31,6 +43,85 @@ using primihub::rpc::VarType;
 using std::map;
 
 namespace primihub::task {
+namespace {
+using private_join_and_compute::ECCommutativeCipher;
+using private_set_intersection::BloomFilter;
+using private_set_intersection::GCS;
+
+/*
+ * Matches response chunks against the server setup, which is decoded only
+ * once. PsiClient::GetIntersection decodes the whole server set again for
+ * every call. Elements are decrypted with the key of the PsiClient that
+ * encrypted the request, as GetIntersection does.
+ */
+class ChunkIntersector {
+public:
+    int init(const PsiClient& client, const psi_proto::ServerSetup& setup) {
+        auto cipher = ECCommutativeCipher::CreateFromKey(
+            NID_X9_62_prime256v1, client.GetPrivateKeyBytes(),
+            ECCommutativeCipher::HashType::SHA256);
+        if (!cipher.ok()) {
+            LOG(ERROR) << "psi client create cipher failed: " << cipher.status();
+            return -1;
+        }
+        cipher_ = std::move(cipher).value();
+        if (setup.data_structure_case() == psi_proto::ServerSetup::kGcs) {
+            auto gcs = GCS::CreateFromProtobuf(setup);
+            if (!gcs.ok()) {
+                LOG(ERROR) << "psi client decode gcs failed: " << gcs.status();
+                return -1;
+            }
+            gcs_ = std::move(gcs).value();
+        } else if (setup.data_structure_case() ==
+                   psi_proto::ServerSetup::kBloomFilter) {
+            auto bloom_filter = BloomFilter::CreateFromProtobuf(setup);
+            if (!bloom_filter.ok()) {
+                LOG(ERROR) << "psi client decode bloom filter failed: "
+                           << bloom_filter.status();
+                return -1;
+            }
+            bloom_filter_ = std::move(bloom_filter).value();
+        } else {
+            LOG(ERROR) << "psi client got unknown server setup.";
+            return -1;
+        }
+        return 0;
+    }
+
+    // appends offset + index of every element of the chunk in the server set
+    int intersect(const psi_proto::Response& response, int64_t offset,
+                  std::vector<int64_t>* intersection) {
+        std::vector<std::string> decrypted;
+        decrypted.reserve(response.encrypted_elements_size());
+        for (const auto& element : response.encrypted_elements()) {
+            auto plain = cipher_->Decrypt(element);
+            if (!plain.ok()) {
+                LOG(ERROR) << "psi client decrypt element failed: "
+                           << plain.status();
+                return -1;
+            }
+            decrypted.push_back(std::move(plain).value());
+        }
+        if (gcs_ != nullptr) {
+            for (auto index : gcs_->Intersect(decrypted)) {
+                intersection->push_back(offset + index);
+            }
+        } else {
+            for (size_t i = 0; i < decrypted.size(); i++) {
+                if (bloom_filter_->Check(decrypted[i])) {
+                    intersection->push_back(offset + i);
+                }
+            }
+        }
+        return 0;
+    }
+
+private:
+    std::unique_ptr<ECCommutativeCipher> cipher_;
+    std::unique_ptr<GCS> gcs_;
+    std::unique_ptr<BloomFilter> bloom_filter_;
+};
+}  // namespace
 
 PSIClientTask::PSIClientTask(const std::string &node_id,
                              const std::string &job_id,
@@ -59,6 +150,11 @@ int PSIClientTask::_LoadParams(Task &task) {
             server_result_path = it->second.value_string();
             VLOG(5) << "server_outputFullFilname: " << server_result_path;
         }
+        it = param_map.find("streamMode");
+        if (it != param_map.end()) {
+            stream_mode_ = it->second.value_int32() > 0;
+            VLOG(5) << "streamMode: " << stream_mode_;
+        }
         server_index_ = param_map["serverIndex"];
         server_address_ = param_map["serverAddress"].value_string();
         server_dataset_ = param_map[server_address_].value_string();
@@ -70,53 +166,6 @@ int PSIClientTask::_LoadParams(Task &task) {
     return 0;
 }
 
-int PSIClientTask::_LoadDatasetFromSQLite(std::string &conn_str, int data_col, std::vector<std::string>& col_array) {
-    //
-    std::string nodeaddr{"localhost"};
-    // std::shared_ptr<DataDriver>
-    auto driver = DataDirverFactory::getDriver("SQLITE", nodeaddr);
-    auto& cursor = driver->read(conn_str);
-    auto ds = cursor->read();
-    auto table = std::get<std::shared_ptr<Table>>(ds->data);
-    int col_count = table->num_columns();
-    if(col_count < data_col) {
-        LOG(ERROR) << "psi dataset colunum number is smaller than data_col, "
-            << "dataset total colum: " << col_count
-            << "expected col index: " << data_col;
-        return -1;
-    }
-    auto array = std::static_pointer_cast<StringArray>(table->column(data_col)->chunk(0));
-    for (int64_t i = 0; i < array->length(); i++) {
-        col_array.push_back(array->GetString(i));
-    }
-    VLOG(0) << "loaded records number: " << col_array.size();
-    return col_array.size();
-}
-
-int PSIClientTask::_LoadDatasetFromCSV(std::string &filename,
-                        int data_col,
-                        std::vector <std::string> &col_array) {
-    std::string nodeaddr("test address"); // TODO
-    std::shared_ptr<DataDriver> driver =
-        DataDirverFactory::getDriver("CSV", nodeaddr);
-    std::shared_ptr<Cursor> &cursor = driver->read(filename);
-    std::shared_ptr<Dataset> ds = cursor->read();
-    std::shared_ptr<Table> table = std::get<std::shared_ptr<Table>>(ds->data);
-
-    int num_col = table->num_columns();
-    if (num_col < data_col) {
-        LOG(ERROR) << "psi dataset colunum number is smaller than data_col";
-        return -1;
-    }
-
-    auto array = std::static_pointer_cast<StringArray>(
-        table->column(data_col)->chunk(0));
-    for (int64_t i = 0; i < array->length(); i++) {
-        col_array.push_back(array->GetString(i));
-    }
-    return array->length();
-}
-
 int PSIClientTask::_LoadDataset(void) {
     // TODO fixme trick method, search sqlite as keyword and if find then laod data from sqlite
     std::string match_word{"sqlite"};
@@ -127,11 +176,12 @@ int PSIClientTask::_LoadDataset(void) {
         driver_type = dataset_path_;
     }
     // current we supportes only two type of strage type [csv, sqlite] as dataset
-    int ret = 0;
+    int64_t ret = 0;
     if (match_word == driver_type) {
-        ret = _LoadDatasetFromSQLite(dataset_path_, data_index_, elements_);
+        ret = keys_.load("SQLITE", dataset_path_, data_index_);
     } else {
-        ret = _LoadDatasetFromCSV(dataset_path_, data_index_, elements_);
+        ret = keys_.load(DataDirverFactory::getDriverNameByPath(dataset_path_),
+                         dataset_path_, data_index_);
     }
     // load datasets encountes error or file empty
     if (ret <= 0) {
@@ -141,6 +191,25 @@ int PSIClientTask::_LoadDataset(void) {
     return 0;
 }
 
+int PSIClientTask::_BuildServerSetup(const primihub::rpc::ServerSetup& setup,
+                                     psi_proto::ServerSetup* server_setup) {
+    server_setup->set_bits(setup.bits());
+    if (setup.data_structure_case() ==
+        primihub::rpc::ServerSetup::DataStructureCase::kGcs) {
+        auto *ptr_gcs = server_setup->mutable_gcs();
+        ptr_gcs->set_div(setup.gcs().div());
+        ptr_gcs->set_hash_range(setup.gcs().hash_range());
+    } else if (setup.data_structure_case() ==
+               primihub::rpc::ServerSetup::DataStructureCase::kBloomFilter) {
+        auto *ptr_bloom_filter = server_setup->mutable_bloom_filter();
+        ptr_bloom_filter->set_num_hash_functions(
+            setup.bloom_filter().num_hash_functions());
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
 int PSIClientTask::_GetIntsection(const std::unique_ptr<PsiClient> &client,
                               ExecuteTaskResponse & taskResponse) {
     SCopedTimer timer;
@@ -153,50 +222,26 @@ int PSIClientTask::_GetIntsection(const std::unique_ptr<PsiClient> &client,
     }
 
     psi_proto::ServerSetup server_setup;
-    server_setup.set_bits(taskResponse.psi_response().server_setup().bits());
-    if (taskResponse.psi_response().server_setup().data_structure_case() ==
-        psi_proto::ServerSetup::DataStructureCase::kGcs) {
-        auto *ptr_gcs = server_setup.mutable_gcs();
-        ptr_gcs->set_div(taskResponse.psi_response().server_setup().gcs().div());
-        ptr_gcs->set_hash_range(taskResponse.psi_response().server_setup().gcs().hash_range());
-    } else if (taskResponse.psi_response().server_setup().data_structure_case() ==
-               psi_proto::ServerSetup::DataStructureCase::kBloomFilter) {
-        auto *ptr_bloom_filter = server_setup.mutable_bloom_filter();
-        ptr_bloom_filter->set_num_hash_functions(
-            taskResponse.psi_response().server_setup().bloom_filter().num_hash_functions()
-        );
-    } else {
+    if (_BuildServerSetup(taskResponse.psi_response().server_setup(), &server_setup)) {
         LOG(ERROR) << "Node psi client get intersection error!";
         return -1;
     }
     auto build_response_time_cost = timer.timeElapse();
     VLOG(5) << "build_response_time_cost(ms): " << build_response_time_cost;
+    record_task_phase("psi_client", "build_response", build_response_time_cost);
 
     std::vector <int64_t> intersection =
         std::move(client->GetIntersection(server_setup, entrpy_response)).value();
     auto get_intersection_ts = timer.timeElapse();
     auto get_intersection_time_cost = get_intersection_ts - build_response_time_cost;
     VLOG(5) << "get_intersection_time_cost: " << get_intersection_time_cost;
-    const std::int64_t num_intersection =
-        static_cast<std::int64_t>(intersection.size());
-
-    if (psi_type_ == PsiType::DIFFERENCE) {
-        map<int64_t, int> inter_map;
-        std::int64_t num_elements = static_cast<std::int64_t>(elements_.size());
-        for (std::int64_t i = 0; i < num_intersection; i++) {
-            inter_map[intersection[i]] = 1;
-        }
-        for (std::int64_t i = 0; i < num_elements; i++) {
-            if (inter_map.find(i) == inter_map.end()) {
-                // outFile << i << std::endl;
-                result_.push_back(elements_[i]);
-            }
-        }
-    } else {
-        for (std::int64_t i = 0; i < num_intersection; i++) {
-            // outFile << intersection[i] << std::endl;
-            result_.push_back(elements_[intersection[i]]);
-        }
+    record_task_phase("psi_client", "get_intersection", get_intersection_time_cost);
+    // intersection and difference are both assembled by one pass of
+    // arrow filter over the key column with a bitmap of hit indexes.
+    result_ = keys_.select(intersection, psi_type_ == PsiType::DIFFERENCE);
+    if (result_ == nullptr) {
+        LOG(ERROR) << "Node psi client assemble result failed.";
+        return -1;
     }
     return 0;
 }
@@ -210,6 +255,7 @@ int PSIClientTask::execute() {
     }
     auto load_param_time_cost = timer.timeElapse();
     VLOG(5) << "load params time cost(ms): " << load_param_time_cost;
+    record_task_phase("psi_client", "load_params", load_param_time_cost);
 
     ret = _LoadDataset();
     if (ret) {
@@ -219,23 +265,45 @@ int PSIClientTask::execute() {
     auto load_dataset_ts = timer.timeElapse();
     auto load_dataset_time_cost = load_dataset_ts - load_param_time_cost;
     VLOG(5) << "load dataset time cost(ms): " << load_dataset_time_cost;
+    record_task_phase("psi_client", "load_dataset", load_dataset_time_cost);
+
+    if (stream_mode_) {
+        ret = _ExecuteStream();
+        if (ret) {
+            LOG(ERROR) << "Node psi client stream execute failed.";
+            return -1;
+        }
+        auto stream_ts = timer.timeElapse();
+        VLOG(5) << "stream psi time cost(ms): " << stream_ts - load_dataset_ts;
+        record_task_phase("psi_client", "stream", stream_ts - load_dataset_ts);
+        ret = saveResult();
+        if (ret) {
+            LOG(ERROR) << "Save psi result failed.";
+            return -1;
+        }
+        if (this->reveal_intersection_ && this->sync_result_to_server) {
+            send_result_to_server();
+        }
+        return 0;
+    }
 
+    // PsiClient::CreateRequest only accepts std::string elements
+    elements_ = keys_.toStrings();
     std::unique_ptr<PsiClient> client =
         std::move(PsiClient::CreateWithNewKey(reveal_intersection_)).value();
     psi_proto::Request client_request =
         std::move(client->CreateRequest(elements_)).value();
+    // encrypted request holds everything needed from now on
+    std::vector<std::string>().swap(elements_);
     psi_proto::Response server_response;
     auto build_request_ts = timer.timeElapse();
     auto build_request_time_cost = build_request_ts - load_dataset_ts;
     VLOG(5) << "client build request time cost(ms): " << build_request_time_cost;
+    record_task_phase("psi_client", "build_request", build_request_time_cost);
     grpc::ClientContext context;
-    grpc::ChannelArguments channel_args;
-    channel_args.SetMaxReceiveMessageSize(128*1024*1024);
-    std::shared_ptr<grpc::Channel> channel =
-        grpc::CreateCustomChannel(server_address_, grpc::InsecureChannelCredentials(), channel_args);
-    std::unique_ptr<VMNode::Stub> stub = VMNode::NewStub(channel);
-    // std::unique_ptr<VMNode::Stub> stub = VMNode::NewStub(grpc::CreateChannel(
-    //     server_address_, grpc::InsecureChannelCredentials()));
+    setClientDeadline(&context);
+    CancelScope cancel_scope(cancel_token_, [&context]() { context.TryCancel(); });
+    auto stub = GrpcChannelPool::getInstance().getVMNodeStub(server_address_);
     using stream_t = std::shared_ptr<grpc::ClientReaderWriter<ExecuteTaskRequest, ExecuteTaskResponse>>;
     stream_t client_stream(stub->ExecuteTask(&context));
 
@@ -280,6 +348,7 @@ int PSIClientTask::execute() {
     auto send_data_ts = timer.timeElapse();
     auto send_data_time_cost = send_data_ts - build_request_ts;
     VLOG(5) << "client send request to server time cost(ms): " << send_data_time_cost;
+    record_task_phase("psi_client", "send_request", send_data_time_cost);
     ExecuteTaskResponse taskResponse;
     ExecuteTaskResponse recv_response;
     auto psi_response = taskResponse.mutable_psi_response();
@@ -327,18 +396,151 @@ int PSIClientTask::execute() {
     return 0;
 }
 
+/*
+ * Stream mode pipeline, a writer thread encrypts one chunk of elements at a
+ * time and writes it to the server while the calling thread reads the
+ * re-encrypted chunk of an earlier request and intersects it with server
+ * setup. Server answers chunks in order, so chunk offset of a response is
+ * the number of elements received before it.
+ */
+int PSIClientTask::_ExecuteStream() {
+    std::unique_ptr<PsiClient> client =
+        std::move(PsiClient::CreateWithNewKey(reveal_intersection_)).value();
+    grpc::ClientContext context;
+    setClientDeadline(&context);
+    CancelScope cancel_scope(cancel_token_, [&context]() { context.TryCancel(); });
+    auto stub = GrpcChannelPool::getInstance().getVMNodeStub(server_address_);
+    using stream_t = std::shared_ptr<grpc::ClientReaderWriter<ExecuteTaskRequest, ExecuteTaskResponse>>;
+    stream_t client_stream(stub->ExecuteTask(&context));
+
+    const int64_t num_elements = keys_.size();
+    std::atomic<bool> write_failed{false};
+    std::thread writer([&]() {
+        int64_t sended_index = 0;
+        bool first_chunk = true;
+        std::vector<std::string> chunk;
+        do {
+            int64_t chunk_end = std::min(num_elements, sended_index + kStreamChunkSize);
+            chunk.clear();
+            for (int64_t i = sended_index; i < chunk_end; i++) {
+                chunk.emplace_back(keys_[i]);
+            }
+            auto client_request = client->CreateRequest(chunk);
+            if (!client_request.ok()) {
+                LOG(ERROR) << "psi client encrypt elements failed: "
+                           << client_request.status();
+                write_failed = true;
+                break;
+            }
+            ExecuteTaskRequest taskRequest;
+            PsiRequest* ptr_request = taskRequest.mutable_psi_request();
+            ptr_request->set_reveal_intersection(reveal_intersection_);
+            ptr_request->set_stream_mode(true);
+            ptr_request->set_num_client_elements(num_elements);
+            for (auto& element : *(client_request.value().mutable_encrypted_elements())) {
+                ptr_request->add_encrypted_elements(std::move(element));
+            }
+            if (first_chunk) {
+                ptr_request->set_job_id(job_id_);
+                ptr_request->set_task_id(task_id_);
+                auto *ptr_params = taskRequest.mutable_params()->mutable_param_map();
+                ParamValue pv;
+                pv.set_var_type(VarType::STRING);
+                pv.set_value_string(server_dataset_);
+                (*ptr_params)["serverData"] = pv;
+                (*ptr_params)["serverIndex"] = server_index_;
+                first_chunk = false;
+            }
+            if (!client_stream->Write(taskRequest)) {
+                LOG(ERROR) << "psi client write request chunk failed.";
+                write_failed = true;
+                break;
+            }
+            sended_index = chunk_end;
+        } while (sended_index < num_elements);
+        client_stream->WritesDone();
+    });
+
+    ExecuteTaskResponse recv_response;
+    ChunkIntersector intersector;
+    bool is_initialized{false};
+    int ret = 0;
+    int64_t recved_index = 0;
+    std::vector<int64_t> intersection;
+    while (client_stream->Read(&recv_response)) {
+        const auto& _psi_response = recv_response.psi_response();
+        if (_psi_response.ret_code()) {
+            LOG(ERROR) << "Node psi server process request error.";
+            ret = -1;
+            break;
+        }
+        if (!is_initialized) {
+            psi_proto::ServerSetup server_setup;
+            if (_BuildServerSetup(_psi_response.server_setup(), &server_setup) ||
+                intersector.init(*client, server_setup)) {
+                LOG(ERROR) << "Node psi client get server setup failed.";
+                ret = -1;
+                break;
+            }
+            is_initialized = true;
+        }
+        int64_t num_response_elements = _psi_response.encrypted_elements().size();
+        if (num_response_elements == 0) {
+            continue;
+        }
+        psi_proto::Response entrpy_response;
+        for (const auto& element : _psi_response.encrypted_elements()) {
+            entrpy_response.add_encrypted_elements(element);
+        }
+        if (intersector.intersect(entrpy_response, recved_index, &intersection)) {
+            LOG(ERROR) << "psi client get intersection failed.";
+            ret = -1;
+            break;
+        }
+        recved_index += num_response_elements;
+    }
+    if (ret) {
+        context.TryCancel();
+    }
+    writer.join();
+    Status status = client_stream->Finish();
+    if (ret || write_failed) {
+        return -1;
+    }
+    if (!status.ok()) {
+        LOG(ERROR) << "Node push psi server task rpc failed.";
+        LOG(ERROR) << status.error_code() << ": " << status.error_message();
+        return -1;
+    }
+    if (recved_index != num_elements) {
+        LOG(ERROR) << "psi client expects " << num_elements << " elements, "
+                   << "but server returns " << recved_index;
+        return -1;
+    }
+    result_ = keys_.select(intersection, psi_type_ == PsiType::DIFFERENCE);
+    if (result_ == nullptr) {
+        LOG(ERROR) << "Node psi client assemble result failed.";
+        return -1;
+    }
+    return 0;
+}
+
 int PSIClientTask::send_result_to_server() {
     grpc::ClientContext context;
+    setClientDeadline(&context);
+    CancelScope cancel_scope(cancel_token_, [&context]() { context.TryCancel(); });
     VLOG(5) << "send_result_to_server";
-     // std::unique_ptr<VMNode::Stub>
-    auto channel = grpc::InsecureChannelCredentials();
-    auto stub = VMNode::NewStub(grpc::CreateChannel(server_address_, channel));
+    auto stub = GrpcChannelPool::getInstance().getVMNodeStub(server_address_);
     primihub::rpc::TaskResponse task_response;
     std::unique_ptr<grpc::ClientWriter<primihub::rpc::TaskRequest>> writer(stub->Send(&context, &task_response));
     constexpr size_t limited_size = 1 << 22;  // limit data size 4M
     size_t sended_size = 0;
     size_t sended_index = 0;
+    size_t result_size = this->result_->length();
+    int chunk_index = 0;
+    int64_t row_index = 0;
     bool add_head_flag = false;
+    ResultSink::Checksum checksum;
     do {
         primihub::rpc::TaskRequest task_request;
         task_request.set_job_id(this->job_id_);
@@ -347,25 +549,38 @@ int PSIClientTask::send_result_to_server() {
         task_request.set_storage_info(server_result_path);
         size_t pack_size = 0;
         if (!add_head_flag) {
-            task_request.add_data("\"intersection_row\"");
+            std::string head = "\"intersection_row\"";
+            checksum.addRow(task_request.mutable_data(), head.data(), head.size());
             add_head_flag = true;
         }
-        for (size_t i = sended_index; i < this->result_.size(); i++) {
-            auto& data_item = this->result_[i];
+        while (chunk_index < this->result_->num_chunks()) {
+            auto array = std::static_pointer_cast<arrow::StringArray>(
+                this->result_->chunk(chunk_index));
+            if (row_index >= array->length()) {
+                chunk_index++;
+                row_index = 0;
+                continue;
+            }
+            auto data_item = array->GetView(row_index);
             size_t item_len = data_item.size();
             if (pack_size + item_len > limited_size) {
                 break;
             }
-            task_request.add_data(data_item);
+            checksum.addRow(task_request.mutable_data(), data_item.data(), item_len);
             pack_size += item_len;
+            row_index++;
             sended_index++;
         }
+        bool last_pack = sended_index >= result_size;
+        if (last_pack) {
+            task_request.set_checksum(checksum.value());
+        }
         writer->Write(task_request);
         sended_size += pack_size;
         VLOG(5) << "sended_size: " << sended_size << " "
                 << "sended_index: " << sended_index << " "
-                << "result size: " << this->result_.size();
-        if (sended_index >= this->result_.size()) {
+                << "result size: " << result_size;
+        if (last_pack) {
             break;
         }
     } while(true);
@@ -383,25 +598,16 @@ int PSIClientTask::send_result_to_server() {
         return -1;
     }
     VLOG(5) << "send result to server success";
+    return 0;
 }
 
 int PSIClientTask::saveResult() {
-    arrow::MemoryPool *pool = arrow::default_memory_pool();
-    arrow::StringBuilder builder(pool);
-
-    for (std::int64_t i = 0; i < result_.size(); i++) {
-        builder.Append(result_[i]);
-    }
-
-    std::shared_ptr<arrow::Array> array;
-    builder.Finish(&array);
-
     std::string col_title =
         psi_type_ == PsiType::DIFFERENCE ? "difference_row" : "intersection_row";
     std::vector<std::shared_ptr<arrow::Field>> schema_vector = {
-        arrow::field(col_title, arrow::int64())};
+        arrow::field(col_title, arrow::utf8())};
     auto schema = std::make_shared<arrow::Schema>(schema_vector);
-    std::shared_ptr<arrow::Table> table = arrow::Table::Make(schema, {array});
+    std::shared_ptr<arrow::Table> table = arrow::Table::Make(schema, {result_});
 
     std::shared_ptr<DataDriver> driver =
         DataDirverFactory::getDriver("CSV", "psi result");
@@ -27,6 +27,7 @@
 
 #include "private_set_intersection/cpp/psi_client.h"
 
+#include "src/primihub/data_store/key_column.h"
 #include "src/primihub/protos/common.grpc.pb.h"
 #include "src/primihub/protos/psi.grpc.pb.h"
 #include "src/primihub/protos/worker.grpc.pb.h"
@@ -64,12 +65,14 @@ public:
 private:
     int _LoadParams(Task &task);
     int _LoadDataset(void);
-    int _LoadDatasetFromCSV(std::string &filename, int data_col,
-                            std::vector <std::string> &col_array);
-    int _LoadDatasetFromSQLite(std::string &conn_str, int data_col,
-                                std::vector <std::string> &col_array);
     int _GetIntsection(const std::unique_ptr<PsiClient> &client,
                        ExecuteTaskResponse & taskResponse);
+    int _BuildServerSetup(const primihub::rpc::ServerSetup& setup,
+                          psi_proto::ServerSetup* server_setup);
+    int _ExecuteStream();
+
+    // number of elements encrypted and sent in one request in stream mode
+    static constexpr int64_t kStreamChunkSize = 50000;
     const std::string node_id_;
     const std::string job_id_;
     const std::string task_id_;
@@ -78,14 +81,17 @@ private:
     std::string dataset_path_;
     std::string result_file_path_;
     bool reveal_intersection_;
+    KeyColumn keys_;
     std::vector<std::string> elements_;
-    std::vector<std::string> result_;
+    // selected from the key column without copying elements one by one
+    std::shared_ptr<arrow::ChunkedArray> result_{nullptr};
 
     std::string server_address_;
     std::string server_dataset_;
     ParamValue server_index_;
     bool sync_result_to_server{false};
     std::string server_result_path;
+    bool stream_mode_{false};
 };
 
 } // namespace primihub::task
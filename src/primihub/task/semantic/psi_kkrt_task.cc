@@ -28,8 +28,11 @@
 
 #include "src/primihub/task/semantic/psi_kkrt_task.h"
 #include "src/primihub/data_store/factory.h"
+#include "src/primihub/node/result_sink.h"
+#include "src/primihub/util/metrics.h"
 #include "src/primihub/util/util.h"
 #include "src/primihub/util/file_util.h"
+#include "src/primihub/util/network/grpc_channel_pool.h"
 #include <glog/logging.h>
 #include <chrono>
 
@@ -41,7 +44,11 @@
 #include "libOTe/NChooseOne/NcoOtExt.h"
 #endif
 
+#include <algorithm>
+#include <cstring>
+#include <exception>
 #include <numeric>
+#include <thread>
 
 
 #ifndef __APPLE__
@@ -67,6 +74,12 @@ PSIKkrtTask::PSIKkrtTask(const std::string &node_id,
 
 int PSIKkrtTask::_LoadParams(Task &task) {
     auto param_map = task.params().param_map();
+    // both parties must use the same shard number
+    auto shard_it = param_map.find("shardNum");
+    if (shard_it != param_map.end() && shard_it->second.value_int32() > 0) {
+        shard_num_ = shard_it->second.value_int32();
+    }
+    VLOG(5) << "kkrt shard number: " << shard_num_;
     auto param_map_it = param_map.find("serverAddress");
 
     if (param_map_it != param_map.end()) {
@@ -110,59 +123,6 @@ int PSIKkrtTask::_LoadParams(Task &task) {
     return 0;
 }
 
-int PSIKkrtTask::_LoadDatasetFromSQLite(std::string& conn_str, int data_col,
-                                        std::vector<std::string>& col_array) {
-    std::string nodeaddr("localhost");
-    // std::shared_ptr<DataDriver>
-    auto driver = DataDirverFactory::getDriver("SQLITE", nodeaddr);
-    if (driver == nullptr) {
-        LOG(ERROR) << "create sqlite db driver failed";
-        return -1;
-    }
-    // std::shared_ptr<Cursor> &cursor
-    auto& cursor = driver->read(conn_str);
-    // std::shared_ptr<Dataset>
-    auto ds = cursor->read();
-    if (ds == nullptr) {
-        return -1;
-    }
-    auto table = std::get<std::shared_ptr<Table>>(ds->data);
-    int num_col = table->num_columns();
-    if (num_col < data_col) {
-        LOG(ERROR) << "psi dataset colunum number is smaller than data_col";
-        return -1;
-    }
-
-    auto array = std::static_pointer_cast<StringArray>(table->column(data_col)->chunk(0));
-    for (int64_t i = 0; i < array->length(); i++) {
-        col_array.push_back(array->GetString(i));
-    }
-    VLOG(5) << "psi server loaded data records: " << col_array.size();
-    return 0;
-}
-
-int PSIKkrtTask::_LoadDatasetFromCSV(std::string &filename, int data_col,
-                                     std::vector <std::string> &col_array) {
-    std::string nodeaddr("test address"); // TODO
-    std::shared_ptr<DataDriver> driver =  DataDirverFactory::getDriver("CSV", nodeaddr);
-    std::shared_ptr<Cursor> &cursor = driver->read(filename);
-    std::shared_ptr<Dataset> ds = cursor->read();
-    std::shared_ptr<Table> table = std::get<std::shared_ptr<Table>>(ds->data);
-
-    int num_col = table->num_columns();
-    if (num_col < data_col) {
-        LOG(ERROR) << "psi dataset colunum number is smaller than data_col";
-        return -1;
-    }
-
-    auto array = std::static_pointer_cast<StringArray>(
-        table->column(data_col)->chunk(0));
-    for (int64_t i = 0; i < array->length(); i++) {
-        col_array.push_back(array->GetString(i));
-    }
-    return 0;
-}
-
 int PSIKkrtTask::_LoadDataset(void) {
     std::string match_word{"sqlite"};
     std::string driver_type;
@@ -172,14 +132,15 @@ int PSIKkrtTask::_LoadDataset(void) {
         driver_type = dataset_path_;
     }
     // current we supportes [csv, sqlite] as dataset
-    int ret = -1;
+    int64_t ret = -1;
     if (match_word == driver_type) {
-        ret = _LoadDatasetFromSQLite(dataset_path_, data_index_, elements_);
+        ret = elements_.load("SQLITE", dataset_path_, data_index_);
     } else {
-        ret = _LoadDatasetFromCSV(dataset_path_, data_index_, elements_);
+        ret = elements_.load(DataDirverFactory::getDriverNameByPath(dataset_path_),
+                             dataset_path_, data_index_);
     }
-     // file reading error or file empty
-    if (ret) {
+     // file reading error
+    if (ret < 0) {
         LOG(ERROR) << "Load dataset for psi server failed. dataset size: " << ret;
         return -1;
     }
@@ -187,121 +148,187 @@ int PSIKkrtTask::_LoadDataset(void) {
 }
 
 #ifndef __APPLE__
-void PSIKkrtTask::_kkrtRecv(Channel& chl) {
+namespace {
+// run func(shard_index) for every shard in its own thread, the first
+// exception thrown by any shard is rethrown after all shards finished.
+template <typename Func>
+void runShards(size_t shard_num, Func&& func) {
+    std::vector<std::exception_ptr> errors(shard_num);
+    std::vector<std::thread> workers;
+    workers.reserve(shard_num);
+    for (size_t i = 0; i < shard_num; i++) {
+        workers.emplace_back([&, i]() {
+            try {
+                func(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+}  // namespace
+
+void PSIKkrtTask::_hashToShards(std::vector<std::vector<block>>* shard_sets,
+                                std::vector<std::vector<u64>>* shard_indexes) {
+    u64 num_elements = elements_.size();
+    std::vector<block> hashed(num_elements);
+    // hash elements in parallel, each thread owns a range of elements
+    size_t thread_num = std::max<size_t>(1, std::min<u64>(shard_num_, num_elements));
+    u64 step = (num_elements + thread_num - 1) / thread_num;
+    runShards(thread_num, [&](size_t t) {
+        u8 block_size = sizeof(block);
+        RandomOracle sha1(block_size);
+        u8 hash_dest[block_size];
+        u64 end = std::min<u64>(num_elements, (t + 1) * step);
+        for (u64 i = t * step; i < end; ++i) {
+            sha1.Update((u8 *)elements_[i].data(), elements_[i].size());
+            sha1.Final((u8 *)hash_dest);
+            hashed[i] = toBlock(hash_dest);
+            sha1.Reset();
+        }
+    });
+
+    shard_sets->clear();
+    shard_indexes->clear();
+    if (shard_num_ == 1) {
+        shard_sets->emplace_back(std::move(hashed));
+        return;
+    }
+    // both parties partition by the same hash value, so equal elements
+    // always meet in the same shard.
+    shard_sets->resize(shard_num_);
+    shard_indexes->resize(shard_num_);
+    for (auto& shard_set : *shard_sets) {
+        shard_set.reserve(num_elements / shard_num_ + 1);
+    }
+    for (auto& shard_index : *shard_indexes) {
+        shard_index.reserve(num_elements / shard_num_ + 1);
+    }
+    for (u64 i = 0; i < num_elements; ++i) {
+        u64 hash_value;
+        memcpy(&hash_value, &hashed[i], sizeof(u64));
+        size_t shard = hash_value % shard_num_;
+        (*shard_sets)[shard].push_back(hashed[i]);
+        (*shard_indexes)[shard].push_back(i);
+    }
+}
+
+void PSIKkrtTask::_kkrtRecvShard(Channel& chl, std::vector<block>& recvSet,
+                                 block seed, std::vector<u64>* intersection) {
     u8 dummy[1];
-    PRNG prng(_mm_set_epi32(4253465, 3434565, 234435, 23987045));
+    PRNG prng(seed);
 
     u64 sendSize;
-    //u64 recvSize = 10;
-    u64 recvSize = elements_.size();
+    u64 recvSize = recvSet.size();
 
     std::vector<u64> data{recvSize};
     chl.asyncSend(std::move(data));
     std::vector<u64> dest;
     chl.recv(dest);
-
-    //LOG(INFO) << "send size:" << dest[0];
     sendSize = dest[0];
-    std::vector<block> sendSet(sendSize), recvSet(recvSize);
-
-    u8 block_size = sizeof(block);
-    RandomOracle  sha1(block_size);
-    u8 hash_dest[block_size];
-    for (u64 i = 0; i < recvSize; ++i) {
-        sha1.Update((u8 *)elements_[i].data(), elements_[i].size());
-        sha1.Final((u8 *)hash_dest);
-        recvSet[i] = toBlock(hash_dest);
-        sha1.Reset();
+    // nothing to intersect, both parties skip this shard
+    if (sendSize == 0 || recvSize == 0) {
+        intersection->clear();
+        return;
     }
+
     KkrtNcoOtReceiver otRecv;
     KkrtPsiReceiver recvPSIs;
-    //LOG(INFO) << "client step 1";
-
-    //recvPSIs.setTimer(gTimer);
     chl.recv(dummy, 1);
-    //LOG(INFO) << "client step 2";
-    //gTimer.reset();
     chl.asyncSend(dummy, 1);
-    //LOG(INFO) << "client step 3";
-    //Timer timer;
-    //auto start = timer.setTimePoint("start");
     recvPSIs.init(sendSize, recvSize, 40, chl, otRecv, prng.get<block>());
-    //LOG(INFO) << "client step 4";
-    //auto mid = timer.setTimePoint("init");
     recvPSIs.sendInput(recvSet, chl);
-    //LOG(INFO) << "client step 5";
-    //auto end = timer.setTimePoint("done");
-
-    _GetIntsection(recvPSIs);
+    *intersection = std::move(recvPSIs.mIntersection);
+    record_channel_bytes("psi_kkrt", chl.getTotalDataSent(), chl.getTotalDataRecv());
+    chl.resetStats();
 }
 
-void PSIKkrtTask::_kkrtSend(Channel& chl) {
+void PSIKkrtTask::_kkrtSendShard(Channel& chl, std::vector<block>& sendSet,
+                                 block seed) {
     u8 dummy[1];
-    PRNG prng(_mm_set_epi32(4253465, 3434565, 234435, 23987045));
+    PRNG prng(seed);
 
-    u64 sendSize = elements_.size();
+    u64 sendSize = sendSet.size();
     u64 recvSize;
 
     std::vector<u64> data{sendSize};
     chl.asyncSend(std::move(data));
     std::vector<u64> dest;
     chl.recv(dest);
-
-    //LOG(INFO) << "recv size:" << dest[0];
     recvSize = dest[0];
-    std::vector<block> set(sendSize);
-    u8 block_size = sizeof(block);
-    RandomOracle  sha1(block_size);
-    u8 hash_dest[block_size];
-    //prng.get(set.data(), set.size());
-    for (u64 i = 0; i < sendSize; ++i) {
-        sha1.Update((u8 *)elements_[i].data(), elements_[i].size());
-        sha1.Final((u8 *)hash_dest);
-        set[i] = toBlock(hash_dest);
-        sha1.Reset();
+    if (sendSize == 0 || recvSize == 0) {
+        return;
     }
 
     KkrtNcoOtSender otSend;
     KkrtPsiSender sendPSIs;
-    //LOG(INFO) << "server step 1";
-
-    sendPSIs.setTimer(gTimer);
     chl.asyncSend(dummy, 1);
-    //LOG(INFO) << "server step 2";
     chl.recv(dummy, 1);
-    //LOG(INFO) << "server step 3";
     sendPSIs.init(sendSize, recvSize, 40, chl, otSend, prng.get<block>());
-    //LOG(INFO) << "server step 4";
-    sendPSIs.sendInput(set, chl);
-    //LOG(INFO) << "server step 5";
-
-    u64 dataSent = chl.getTotalDataSent();
-    //LOG(INFO) << "server step 6";
-
+    sendPSIs.sendInput(sendSet, chl);
+    VLOG(5) << "kkrt shard data sent: " << chl.getTotalDataSent();
+    record_channel_bytes("psi_kkrt", chl.getTotalDataSent(), chl.getTotalDataRecv());
     chl.resetStats();
-    //LOG(INFO) << "server step 7";
 }
 
-int PSIKkrtTask::_GetIntsection(KkrtPsiReceiver &receiver) {
-    /*for (auto pos : receiver.mIntersection) {
-        LOG(INFO) << pos;
-    }*/
-
-    if (psi_type_ == PsiType::DIFFERENCE) {
-        map<u64, int> inter_map;
-        for (auto pos : receiver.mIntersection) {
-            inter_map[pos] = 1;
+int PSIKkrtTask::_kkrtRecv(std::vector<Channel>& chls) {
+    PRNG prng(_mm_set_epi32(4253465, 3434565, 234435, 23987045));
+    std::vector<std::vector<block>> shard_sets;
+    std::vector<std::vector<u64>> shard_indexes;
+    _hashToShards(&shard_sets, &shard_indexes);
+
+    std::vector<block> seeds(shard_num_);
+    prng.get(seeds.data(), seeds.size());
+    std::vector<std::vector<u64>> shard_intersections(shard_num_);
+    runShards(shard_num_, [&](size_t i) {
+        _kkrtRecvShard(chls[i], shard_sets[i], seeds[i], &shard_intersections[i]);
+    });
+
+    // map shard local positions back to element indexes
+    std::vector<u64> intersection;
+    if (shard_num_ == 1) {
+        intersection = std::move(shard_intersections[0]);
+    } else {
+        size_t total = 0;
+        for (const auto& shard_intersection : shard_intersections) {
+            total += shard_intersection.size();
         }
-        u64 num_elements = elements_.size();
-        for (u64 i = 0; i < num_elements; i++) {
-            if (inter_map.find(i) == inter_map.end()) {
-                result_.push_back(elements_[i]);
+        intersection.reserve(total);
+        for (size_t i = 0; i < shard_num_; i++) {
+            for (auto pos : shard_intersections[i]) {
+                intersection.push_back(shard_indexes[i][pos]);
             }
         }
-    } else {
-        for (auto pos : receiver.mIntersection) {
-            result_.push_back(elements_[pos]);
-        }
+    }
+    return _GetIntsection(intersection);
+}
+
+void PSIKkrtTask::_kkrtSend(std::vector<Channel>& chls) {
+    PRNG prng(_mm_set_epi32(4253465, 3434565, 234435, 23987045));
+    std::vector<std::vector<block>> shard_sets;
+    std::vector<std::vector<u64>> shard_indexes;
+    _hashToShards(&shard_sets, &shard_indexes);
+
+    std::vector<block> seeds(shard_num_);
+    prng.get(seeds.data(), seeds.size());
+    runShards(shard_num_, [&](size_t i) {
+        _kkrtSendShard(chls[i], shard_sets[i], seeds[i]);
+    });
+}
+
+int PSIKkrtTask::_GetIntsection(const std::vector<u64>& intersection) {
+    result_ = elements_.select(intersection, psi_type_ == PsiType::DIFFERENCE);
+    if (result_ == nullptr) {
+        LOG(ERROR) << "Kkrt psi client assemble result failed.";
+        return -1;
     }
     return 0;
 }
@@ -313,17 +340,21 @@ int PSIKkrtTask::send_result_to_server() {
     // cause grpc port is alive along with node life duration,
     // so send result data to server by grpc
     grpc::ClientContext context;
+    setClientDeadline(&context);
+    CancelScope cancel_scope(cancel_token_, [&context]() { context.TryCancel(); });
     VLOG(5) << "send_result_to_server";
-    auto channel = grpc::InsecureChannelCredentials();
-    // std::unique_ptr<VMNode::Stub>
-    auto stub = primihub::rpc::VMNode::NewStub(grpc::CreateChannel(host_address_, channel));
+    auto stub = GrpcChannelPool::getInstance().getVMNodeStub(host_address_);
     primihub::rpc::TaskResponse task_response;
     std::unique_ptr<grpc::ClientWriter<primihub::rpc::TaskRequest>>
         writer(stub->Send(&context, &task_response));
     constexpr size_t limited_size = 1 << 22;  // limit data size 4M
     size_t sended_size = 0;
     size_t sended_index = 0;
+    size_t result_size = this->result_->length();
+    int chunk_index = 0;
+    int64_t row_index = 0;
     bool add_head_flag = false;
+    ResultSink::Checksum checksum;
     do {
         primihub::rpc::TaskRequest task_request;
         task_request.set_job_id(this->job_id_);
@@ -331,28 +362,41 @@ int PSIKkrtTask::send_result_to_server() {
         task_request.set_storage_type(primihub::rpc::TaskRequest::FILE);
         task_request.set_storage_info(server_result_path);
         if (!add_head_flag) {
-            task_request.add_data("\"intersection_row\"");
+            std::string head = "\"intersection_row\"";
+            checksum.addRow(task_request.mutable_data(), head.data(), head.size());
             add_head_flag = true;
         }
         size_t pack_size = 0;
-        for (size_t i = sended_index; i < this->result_.size(); i++) {
-            auto& data_item = this->result_[i];
+        while (chunk_index < this->result_->num_chunks()) {
+            auto array = std::static_pointer_cast<arrow::StringArray>(
+                this->result_->chunk(chunk_index));
+            if (row_index >= array->length()) {
+                chunk_index++;
+                row_index = 0;
+                continue;
+            }
+            auto data_item = array->GetView(row_index);
             size_t item_len = data_item.size();
             if (pack_size + item_len > limited_size) {
                 break;
             }
-            task_request.add_data(data_item);
+            checksum.addRow(task_request.mutable_data(), data_item.data(), item_len);
             pack_size += item_len;
+            row_index++;
             sended_index++;
         }
+        bool last_pack = sended_index >= result_size;
+        if (last_pack) {
+            task_request.set_checksum(checksum.value());
+        }
         writer->Write(task_request);
         sended_size += pack_size;
         VLOG(5) << "sended_size: " << sended_size << " "
                 << "sended_index: " << sended_index << " "
-                << "result size: " << this->result_.size();
-        if (sended_index >= this->result_.size()) {
+                << "result size: " << result_size;
+        if (last_pack) {
             VLOG(5) << " sended_index: " << sended_index
-                    << " result size: " << this->result_.size() << " end of send";
+                    << " result size: " << result_size << " end of send";
             break;
         }
     } while(true);
@@ -376,22 +420,16 @@ int PSIKkrtTask::send_result_to_server() {
 }
 
 int PSIKkrtTask::saveResult(void) {
-    arrow::MemoryPool *pool = arrow::default_memory_pool();
-    arrow::StringBuilder builder(pool);
-
-    for (std::int64_t i = 0; i < result_.size(); i++) {
-        builder.Append(result_[i]);
+    if (result_ == nullptr) {
+        LOG(ERROR) << "Kkrt psi client has no result to save.";
+        return -1;
     }
-
-    std::shared_ptr<arrow::Array> array;
-    builder.Finish(&array);
-
     std::string col_title =
         psi_type_ == PsiType::DIFFERENCE ? "difference_row" : "intersection_row";
     std::vector<std::shared_ptr<arrow::Field>> schema_vector = {
-        arrow::field(col_title, arrow::int64())};
+        arrow::field(col_title, arrow::utf8())};
     auto schema = std::make_shared<arrow::Schema>(schema_vector);
-    std::shared_ptr<arrow::Table> table = arrow::Table::Make(schema, {array});
+    std::shared_ptr<arrow::Table> table = arrow::Table::Make(schema, {result_});
 
     std::shared_ptr<DataDriver> driver =
         DataDirverFactory::getDriver("CSV", "psi result");
@@ -432,6 +470,7 @@ int PSIKkrtTask::execute() {
     }
     auto load_params_ts = timer.timeElapse();
     VLOG(5) << "load_params time cost(ms): " << load_params_ts;
+    record_task_phase("psi_kkrt", "load_params", load_params_ts);
     ret = _LoadDataset();
     if (ret) {
         if (role_tag_ == 0) {
@@ -439,10 +478,15 @@ int PSIKkrtTask::execute() {
         } else {
             LOG(ERROR) << "Psi server load dataset failed.";
         }
+        return ret;
     }
     auto load_dataset_ts = timer.timeElapse();
     auto load_dataset_time_cost = load_dataset_ts - load_params_ts;
     VLOG(5) << "LoadDataset time cost(ms): " << load_dataset_time_cost;
+    record_task_phase("psi_kkrt", "load_dataset", load_dataset_time_cost);
+    if (isCancelled()) {
+        return -1;
+    }
 #ifndef __APPLE__
     osuCrypto::IOService ios;
     auto mode = role_tag_ ? EpMode::Server : EpMode::Client;
@@ -450,33 +494,54 @@ int PSIKkrtTask::execute() {
     str_split(host_address_, &addr_info, ':');
     std::string server_addr = addr_info[0] + ":1212";
     Endpoint ep(ios, server_addr, mode);
-    Channel chl = ep.addChannel();
+    // one channel per shard over the same endpoint
+    std::vector<Channel> chls;
+    for (size_t i = 0; i < shard_num_; i++) {
+        auto chl_name = "kkrt_shard_" + std::to_string(i);
+        chls.emplace_back(ep.addChannel(chl_name, chl_name));
+    }
+    auto close_channels = [&chls]() {
+        for (auto& chl : chls) {
+            chl.close();
+        }
+    };
+    // a peer which never shows up or stops sending leaves the shards
+    // blocked in recv, cancel the channels so they throw instead
+    auto cancel_scope = std::make_unique<CancelScope>(cancel_token_, [&chls]() {
+        for (auto& chl : chls) {
+            chl.cancel();
+        }
+    });
 
     if (mode == EpMode::Client) {
         LOG(INFO) << "start recv.";
         auto recv_data_start = timer.timeElapse();
         try {
-            _kkrtRecv(chl);
+            ret = _kkrtRecv(chls);
         } catch (std::exception &e) {
             LOG(ERROR) << "Kkrt psi client node task failed:"
 	               << e.what();
-            chl.close();
+            ret = -1;
+        }
+        if (ret) {
+            close_channels();
             ep.stop();
             ios.stop();
-	    return -1;
+            return -1;
         }
         auto recv_data_end = timer.timeElapse();
         auto time_cost = recv_data_end - recv_data_start;
         VLOG(5) << "kkrt client process data time cost(ms): " << time_cost;
+        record_task_phase("psi_kkrt", "recv", time_cost);
     } else {
         LOG(INFO) << "start send";
         auto recv_data_start = timer.timeElapse();
         try {
-            _kkrtSend(chl);
+            _kkrtSend(chls);
         } catch (std::exception &e) {
             LOG(ERROR) << "Kkrt psi server node task failed:"
 		       << e.what();
-            chl.close();
+            close_channels();
             ep.stop();
             ios.stop();
             return -1;
@@ -484,8 +549,10 @@ int PSIKkrtTask::execute() {
         auto recv_data_end = timer.timeElapse();
         auto time_cost = recv_data_end - recv_data_start;
         VLOG(5) << "kkrt server process data time cost(ms): " << time_cost;
+        record_task_phase("psi_kkrt", "send", time_cost);
     }
-    chl.close();
+    cancel_scope.reset();
+    close_channels();
     ep.stop();
     ios.stop();
     LOG(INFO) << "kkrt psi run success";
@@ -500,6 +567,7 @@ int PSIKkrtTask::execute() {
         auto _end = timer.timeElapse();
         auto time_cost = _end - _start;
         VLOG(5) << "kkrt client save result data time cost(ms): " << time_cost;
+        record_task_phase("psi_kkrt", "save_result", time_cost);
     }
 #endif
     return 0;
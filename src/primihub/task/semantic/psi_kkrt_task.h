@@ -33,6 +33,7 @@
 #include <string>
 #include <set>
 
+#include "src/primihub/data_store/key_column.h"
 #include "src/primihub/protos/common.grpc.pb.h"
 #include "src/primihub/protos/worker.grpc.pb.h"
 #include "src/primihub/task/semantic/task.h"
@@ -67,14 +68,19 @@ public:
 private:
     int _LoadParams(Task &task);
     int _LoadDataset(void);
-    int _LoadDatasetFromCSV(std::string &filename, int data_col,
-                            std::vector<std::string>& col_array);
-    int _LoadDatasetFromSQLite(std::string& conn_str, int data_col,
-                               std::vector<std::string>& col_array);
 #ifndef __APPLE__
-    void _kkrtRecv(Channel& chl);
-    void _kkrtSend(Channel& chl);
-    int _GetIntsection(KkrtPsiReceiver &receiver);
+    // hash elements into blocks and partition them into shard_num_ shards,
+    // shard_indexes maps shard local position to element index.
+    void _hashToShards(std::vector<std::vector<block>>* shard_sets,
+                       std::vector<std::vector<u64>>* shard_indexes);
+    void _kkrtRecvShard(Channel& chl, std::vector<block>& recvSet,
+                        block seed, std::vector<u64>* intersection);
+    void _kkrtSendShard(Channel& chl, std::vector<block>& sendSet,
+                        block seed);
+    // return 0 once result_ holds the intersection, -1 otherwise
+    int _kkrtRecv(std::vector<Channel>& chls);
+    void _kkrtSend(std::vector<Channel>& chls);
+    int _GetIntsection(const std::vector<u64>& intersection);
 #endif
 
     const std::string node_id_;
@@ -83,10 +89,13 @@ private:
     int data_index_;
     int psi_type_;
     int role_tag_;
+    // number of KKRT instances run concurrently, one channel each
+    size_t shard_num_{1};
     std::string dataset_path_;
     std::string result_file_path_;
-    std::vector <std::string> elements_;
-    std::vector <std::string> result_;
+    KeyColumn elements_;
+    // selected from the key column without copying elements one by one
+    std::shared_ptr<arrow::ChunkedArray> result_{nullptr};
 
     std::string host_address_;
     bool sync_result_to_server{false};
@@ -0,0 +1,177 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "src/primihub/task/semantic/psi_server_cache.h"
+
+#include <glog/logging.h>
+
+namespace primihub::task {
+
+int64_t PsiServerCache::clientSizeBucket(int64_t num_client_elements) {
+    int64_t bucket = kMinClientBucket;
+    while (bucket < num_client_elements) {
+        bucket <<= 1;
+    }
+    return bucket;
+}
+
+std::shared_ptr<PsiServerCache::Entry>
+PsiServerCache::getEntry(const std::string& key) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    auto& entry = entries_[key];
+    if (entry == nullptr) {
+        entry = std::make_shared<Entry>();
+        lru_.push_front(key);
+        entry->lru_it = lru_.begin();
+    } else {
+        lru_.splice(lru_.begin(), lru_, entry->lru_it);
+    }
+    return entry;
+}
+
+void PsiServerCache::updateBytes(const std::string& key,
+                                 const std::shared_ptr<Entry>& entry) {
+    uint64_t bytes = 0;
+    for (const auto& setup : entry->setups) {
+        bytes += setup.second.ByteSizeLong();
+    }
+    std::lock_guard<std::mutex> lck(mtx_);
+    auto it = entries_.find(key);
+    if (it == entries_.end() || it->second != entry) {
+        // erased or evicted while it was built
+        return;
+    }
+    bytes_ = bytes_ - entry->bytes + bytes;
+    entry->bytes = bytes;
+    if (bytes > options_.max_bytes) {
+        VLOG(5) << "psi server setups of " << bytes << " bytes are not cached";
+        dropEntry(it);
+        return;
+    }
+    evict();
+}
+
+void PsiServerCache::dropEntry(EntryMap::iterator it) {
+    bytes_ -= it->second->bytes;
+    lru_.erase(it->second->lru_it);
+    entries_.erase(it);
+}
+
+void PsiServerCache::evict() {
+    while (bytes_ > options_.max_bytes && !lru_.empty()) {
+        VLOG(5) << "psi server cache evict " << lru_.back();
+        dropEntry(entries_.find(lru_.back()));
+    }
+}
+
+int PsiServerCache::getServer(const std::string& dataset_key,
+                              const std::string& version,
+                              bool reveal_intersection,
+                              double fpr,
+                              int64_t num_client_elements,
+                              int64_t key_rotation_sec,
+                              const LoadDatasetFunc& load_dataset,
+                              std::shared_ptr<const PsiServer>* server,
+                              psi_proto::ServerSetup* server_setup) {
+    std::string key = dataset_key + (reveal_intersection ? "#reveal" : "#count");
+    auto entry = getEntry(key);
+    // hold the entry lock while building, so concurrent requests for the
+    // same dataset encrypt the server set only once.
+    std::lock_guard<std::mutex> lck(entry->mtx);
+    auto now = std::chrono::steady_clock::now();
+    bool key_expired = key_rotation_sec > 0 &&
+        now - entry->key_created > std::chrono::seconds(key_rotation_sec);
+    if (entry->server == nullptr || entry->version != version || key_expired) {
+        auto new_server = PsiServer::CreateWithNewKey(reveal_intersection);
+        if (!new_server.ok()) {
+            LOG(ERROR) << "create psi server failed: " << new_server.status();
+            return -1;
+        }
+        VLOG(5) << "psi server cache renew key for " << key
+                << ", version: " << version;
+        entry->server = std::move(new_server).value();
+        entry->version = version;
+        entry->key_created = now;
+        entry->setups.clear();
+        updateBytes(key, entry);
+    }
+
+    int64_t bucket = clientSizeBucket(num_client_elements);
+    auto it = entry->setups.find(bucket);
+    if (it == entry->setups.end()) {
+        std::vector<std::string> elements;
+        int ret = load_dataset(&elements);
+        if (ret) {
+            return -1;
+        }
+        auto setup = entry->server->CreateSetupMessage(fpr, bucket, elements);
+        if (!setup.ok()) {
+            LOG(ERROR) << "create psi server setup failed: " << setup.status();
+            return -1;
+        }
+        VLOG(5) << "psi server cache build setup for " << key
+                << ", client size bucket: " << bucket;
+        it = entry->setups.emplace(bucket, std::move(setup).value()).first;
+        updateBytes(key, entry);
+    } else {
+        VLOG(5) << "psi server cache hit for " << key
+                << ", client size bucket: " << bucket;
+    }
+    *server = entry->server;
+    *server_setup = it->second;
+    return 0;
+}
+
+void PsiServerCache::erase(const std::string& dataset_key) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    for (const char* mode : {"#reveal", "#count"}) {
+        auto it = entries_.find(dataset_key + mode);
+        if (it != entries_.end()) {
+            dropEntry(it);
+        }
+    }
+}
+
+void PsiServerCache::clear() {
+    std::lock_guard<std::mutex> lck(mtx_);
+    entries_.clear();
+    lru_.clear();
+    bytes_ = 0;
+}
+
+uint64_t PsiServerCache::bytes() {
+    std::lock_guard<std::mutex> lck(mtx_);
+    return bytes_;
+}
+
+int PsiServerCache::setOptions(const Options& options) {
+    if (options.key_rotation_sec <= 0) {
+        LOG(ERROR) << "invalid psi server key rotation interval: "
+                   << options.key_rotation_sec;
+        return -1;
+    }
+    std::lock_guard<std::mutex> lck(mtx_);
+    options_ = options;
+    evict();
+    return 0;
+}
+
+PsiServerCache::Options PsiServerCache::options() {
+    std::lock_guard<std::mutex> lck(mtx_);
+    return options_;
+}
+
+} // namespace primihub::task
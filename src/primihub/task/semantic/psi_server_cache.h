@@ -0,0 +1,130 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#ifndef SRC_PRIMIHUB_TASK_SEMANTIC_PSI_SERVER_CACHE_H_
+#define SRC_PRIMIHUB_TASK_SEMANTIC_PSI_SERVER_CACHE_H_
+
+#include <chrono>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "private_set_intersection/cpp/psi_server.h"
+
+namespace primihub::task {
+
+/**
+ * Process wide cache of ECDH psi server state, keyed by dataset and
+ * dataset version. An entry keeps the server key and the encrypted server
+ * set (as setup messages), so repeated requests against an unchanged
+ * dataset only pay for the client elements.
+ *
+ * The setup message depends on the client set size through the false
+ * positive rate, so one message is kept per power-of-two client size
+ * bucket. Building it for the bucket upper bound only lowers the false
+ * positive rate seen by smaller clients.
+ *
+ * An entry is rebuilt when the dataset version changes or its key is
+ * older than the requested rotation interval. So there is one entry per
+ * dataset and its current version, entries of all datasets share one LRU
+ * bounded by the bytes of their setup messages, Options::max_bytes.
+ */
+class PsiServerCache {
+public:
+    using PsiServer = private_set_intersection::PsiServer;
+    using LoadDatasetFunc = std::function<int(std::vector<std::string>*)>;
+
+    // node level settings, loaded from the psi_server_cache section of the
+    // node config. Clients can not change them.
+    struct Options {
+        bool enabled{false};
+        int64_t key_rotation_sec{86400};
+        // setup messages kept in memory, least recently used go first
+        uint64_t max_bytes{uint64_t{1} << 30};
+    };
+
+    PsiServerCache(const PsiServerCache&) = delete;
+    PsiServerCache& operator=(const PsiServerCache&) = delete;
+
+    static PsiServerCache& getInstance() {
+        static PsiServerCache kSingleInstance;
+        return kSingleInstance;
+    }
+
+    /**
+     * Get server and setup message for the dataset, create them on miss.
+     * load_dataset is only called when the server set has to be encrypted.
+     * return 0 on success, -1 on failure.
+     */
+    int getServer(const std::string& dataset_key,
+                  const std::string& version,
+                  bool reveal_intersection,
+                  double fpr,
+                  int64_t num_client_elements,
+                  int64_t key_rotation_sec,
+                  const LoadDatasetFunc& load_dataset,
+                  std::shared_ptr<const PsiServer>* server,
+                  psi_proto::ServerSetup* server_setup);
+
+    void erase(const std::string& dataset_key);
+    void clear();
+    // bytes of the cached setup messages
+    uint64_t bytes();
+
+    int setOptions(const Options& options);
+    Options options();
+
+    static int64_t clientSizeBucket(int64_t num_client_elements);
+
+private:
+    PsiServerCache() = default;
+
+    // entry keys, most recently used first
+    using LruList = std::list<std::string>;
+    struct Entry {
+        // guards the psi state below while it is built
+        std::mutex mtx;
+        std::string version;
+        std::shared_ptr<const PsiServer> server;
+        std::chrono::steady_clock::time_point key_created;
+        std::map<int64_t, psi_proto::ServerSetup> setups;
+        // guarded by the cache mutex
+        uint64_t bytes{0};
+        LruList::iterator lru_it;
+    };
+    using EntryMap = std::map<std::string, std::shared_ptr<Entry>>;
+
+    std::shared_ptr<Entry> getEntry(const std::string& key);
+    // recount the setups of a built entry, entry->mtx must be held
+    void updateBytes(const std::string& key, const std::shared_ptr<Entry>& entry);
+    void dropEntry(EntryMap::iterator it);
+    void evict();
+
+    static constexpr int64_t kMinClientBucket = 1 << 10;
+
+    std::mutex mtx_;
+    Options options_;
+    EntryMap entries_;
+    LruList lru_;
+    uint64_t bytes_{0};
+};
+
+} // namespace primihub::task
+#endif // SRC_PRIMIHUB_TASK_SEMANTIC_PSI_SERVER_CACHE_H_
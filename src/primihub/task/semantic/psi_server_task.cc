@@ -17,6 +17,8 @@
 #include "private_set_intersection/cpp/psi_server.h"
 
 #include "src/primihub/task/semantic/psi_server_task.h"
+#include "src/primihub/util/file_util.h"
+#include "src/primihub/util/metrics.h"
 #include "src/primihub/util/util.h"
 
 using psi_proto::Request;
@@ -33,6 +35,20 @@ void initRequest(const PsiRequest * request, Request & psi_request) {
     }
 }
 
+void fillServerSetup(const psi_proto::ServerSetup& server_setup,
+                     primihub::rpc::ServerSetup* ptr_server_setup) {
+    ptr_server_setup->set_bits(server_setup.bits());
+    if (server_setup.data_structure_case() ==
+        psi_proto::ServerSetup::DataStructureCase::kGcs) {
+        ptr_server_setup->mutable_gcs()->set_div(server_setup.gcs().div());
+        ptr_server_setup->mutable_gcs()->set_hash_range(server_setup.gcs().hash_range());
+    } else if (server_setup.data_structure_case() ==
+               psi_proto::ServerSetup::DataStructureCase::kBloomFilter) {
+        ptr_server_setup->mutable_bloom_filter()->
+            set_num_hash_functions(server_setup.bloom_filter().num_hash_functions());
+    }
+}
+
 PSIServerTask::PSIServerTask(const std::string &node_id,
                              const ExecuteTaskRequest& request,
                              ExecuteTaskResponse *response,
@@ -54,6 +70,10 @@ int PSIServerTask::loadParams(Params & params) {
         LOG(ERROR) << "Failed to load psi server params: " << e.what();
         return -1;
     }
+    // cache settings belong to the node, never to the requesting client
+    auto cache_options = PsiServerCache::getInstance().options();
+    use_cache_ = cache_options.enabled;
+    key_rotation_sec_ = cache_options.key_rotation_sec;
     return 0;
 }
 
@@ -81,6 +101,62 @@ int PSIServerTask::loadDataset() {
     return 0;
 }
 
+std::string PSIServerTask::datasetVersion() {
+    // csv file is versioned by its mtime and size
+    if (dataset_path_.compare(0, 6, "sqlite") == 0) {
+        return "";
+    }
+    return FileVersion(dataset_path_);
+}
+
+int PSIServerTask::prepareServer(bool reveal_intersection,
+        int64_t num_client_elements,
+        std::shared_ptr<const PsiServerCache::PsiServer>* server,
+        psi_proto::ServerSetup* server_setup) {
+    std::string version;
+    if (use_cache_) {
+        version = datasetVersion();
+        if (version.empty()) {
+            LOG(WARNING) << "unknown version of dataset " << dataset_path_
+                         << ", psi server cache is skipped.";
+        }
+    }
+    if (!version.empty()) {
+        std::string dataset_key = dataset_path_ + "#" + std::to_string(data_index_);
+        auto load_dataset = [this](std::vector<std::string>* elements) -> int {
+            if (loadDataset()) {
+                return -1;
+            }
+            elements->swap(elements_);
+            std::vector<std::string>().swap(elements_);
+            return 0;
+        };
+        return PsiServerCache::getInstance().getServer(dataset_key, version,
+            reveal_intersection, fpr_, num_client_elements, key_rotation_sec_,
+            load_dataset, server, server_setup);
+    }
+
+    int ret = loadDataset();
+    if (ret) {
+        return -1;
+    }
+    auto new_server = PsiServer::CreateWithNewKey(reveal_intersection);
+    if (!new_server.ok()) {
+        LOG(ERROR) << "create psi server failed: " << new_server.status();
+        return -1;
+    }
+    *server = std::move(new_server).value();
+    auto setup = (*server)->CreateSetupMessage(fpr_, num_client_elements, elements_);
+    if (!setup.ok()) {
+        LOG(ERROR) << "create psi server setup failed: " << setup.status();
+        return -1;
+    }
+    *server_setup = std::move(setup).value();
+    // server set is encoded in setup message, release the raw elements
+    std::vector<std::string>().swap(elements_);
+    return 0;
+}
+
 int PSIServerTask::execute() {
     SCopedTimer timer;
     int ret = loadParams(params_);
@@ -90,30 +166,32 @@ int PSIServerTask::execute() {
     }
     auto load_param_time_cost = timer.timeElapse();
     VLOG(5) << "load param time cost; " << load_param_time_cost;
-    ret = loadDataset();
-    if (ret) {
-        return -1;
-    }
-    auto load_dataset_ts = timer.timeElapse();
-    auto time_cost = load_dataset_ts - load_param_time_cost;
-    VLOG(5) << "loadDataset time cost(ms): " << time_cost;
+    record_task_phase("psi_server", "load_params", load_param_time_cost);
     Request psi_request;
     initRequest(request_, psi_request);
     auto init_req_ts = timer.timeElapse();
-    auto init_req_time_cost = init_req_ts - load_dataset_ts;
+    auto init_req_time_cost = init_req_ts - load_param_time_cost;
     VLOG(5) << "init_req_time_cost(ms): " << init_req_time_cost;
-    std::unique_ptr<PsiServer> server =
-        std::move(PsiServer::CreateWithNewKey(psi_request.reveal_intersection())).value();
+    record_task_phase("psi_server", "init_request", init_req_time_cost);
 
     std::int64_t num_client_elements =
         static_cast<std::int64_t>(psi_request.encrypted_elements().size());
-    psi_proto::ServerSetup server_setup =
-        std::move(server->CreateSetupMessage(fpr_, num_client_elements, elements_)).value();
+    std::shared_ptr<const PsiServer> server;
+    psi_proto::ServerSetup server_setup;
+    ret = prepareServer(psi_request.reveal_intersection(), num_client_elements,
+                        &server, &server_setup);
+    if (ret) {
+        return -1;
+    }
+    auto setup_ts = timer.timeElapse();
+    VLOG(5) << "prepare server time cost(ms): " << setup_ts - init_req_ts;
+    record_task_phase("psi_server", "prepare_server", setup_ts - init_req_ts);
 
     psi_proto::Response server_response = std::move(server->ProcessRequest(psi_request)).value();
     auto proceess_request_ts = timer.timeElapse();
-    auto proceess_request_time_cost = proceess_request_ts - init_req_ts;
+    auto proceess_request_time_cost = proceess_request_ts - setup_ts;
     VLOG(5) << "proceess_request_time_cost(ms): " << proceess_request_time_cost;
+    record_task_phase("psi_server", "process_request", proceess_request_time_cost);
     std::int64_t num_response_elements =
         static_cast<std::int64_t>(server_response.encrypted_elements().size());
 
@@ -121,22 +199,86 @@ int PSIServerTask::execute() {
         response_->add_encrypted_elements(server_response.encrypted_elements()[i]);
     }
 
-    auto ptr_server_setup = response_->mutable_server_setup();
-    ptr_server_setup->set_bits(server_setup.bits());
-    if (server_setup.data_structure_case() ==
-        psi_proto::ServerSetup::DataStructureCase::kGcs) {
-        ptr_server_setup->mutable_gcs()->set_div(server_setup.gcs().div());
-        ptr_server_setup->mutable_gcs()->set_hash_range(server_setup.gcs().hash_range());
-    } else if (server_setup.data_structure_case() ==
-               psi_proto::ServerSetup::DataStructureCase::kBloomFilter) {
-        ptr_server_setup->mutable_bloom_filter()->
-            set_num_hash_functions(server_setup.bloom_filter().num_hash_functions());
-    }
+    fillServerSetup(server_setup, response_->mutable_server_setup());
     auto build_response_ts = timer.timeElapse();
     auto build_response_time_cost = build_response_ts - proceess_request_ts;
     VLOG(5) << "build_response_time_cost(ms): " << build_response_time_cost;
+    record_task_phase("psi_server", "build_response", build_response_time_cost);
     return 0;
 
 }
 
+int PSIServerTask::executeStream(ReadRequestFunc read_request,
+                                 WriteResponseFunc write_response) {
+    SCopedTimer timer;
+    int ret = loadParams(params_);
+    if (ret) {
+        LOG(ERROR) << "Load parameters for psi server fialed.";
+        return -1;
+    }
+    auto load_dataset_ts = timer.timeElapse();
+    std::shared_ptr<const PsiServer> server;
+    psi_proto::ServerSetup server_setup;
+    ret = prepareServer(request_->reveal_intersection(),
+                        request_->num_client_elements(), &server, &server_setup);
+    if (ret) {
+        return -1;
+    }
+    ExecuteTaskResponse setup_response;
+    auto setup_psi_response = setup_response.mutable_psi_response();
+    setup_psi_response->set_ret_code(0);
+    fillServerSetup(server_setup, setup_psi_response->mutable_server_setup());
+    if (!write_response(setup_response)) {
+        LOG(ERROR) << "psi server write server setup failed.";
+        return -1;
+    }
+    auto setup_ts = timer.timeElapse();
+    VLOG(5) << "create setup message time cost(ms): " << setup_ts - load_dataset_ts;
+    record_task_phase("psi_server", "load_params", load_dataset_ts);
+    record_task_phase("psi_server", "prepare_server", setup_ts - load_dataset_ts);
+
+    // process the chunk carried by the first request, then the following
+    // ones as they arrive.
+    ExecuteTaskRequest chunk_request;
+    const PsiRequest* chunk = request_;
+    std::int64_t processed_num = 0;
+    do {
+        if (isCancelled()) {
+            LOG(WARNING) << "psi server stream task is cancelled.";
+            return -1;
+        }
+        if (chunk->encrypted_elements().size() > 0) {
+            Request psi_request;
+            initRequest(chunk, psi_request);
+            auto server_response = server->ProcessRequest(psi_request);
+            if (!server_response.ok()) {
+                LOG(ERROR) << "psi server process request chunk failed: "
+                           << server_response.status();
+                return -1;
+            }
+            ExecuteTaskResponse chunk_response;
+            auto psi_response = chunk_response.mutable_psi_response();
+            psi_response->set_ret_code(0);
+            for (auto& element :
+                    *(server_response.value().mutable_encrypted_elements())) {
+                psi_response->add_encrypted_elements(std::move(element));
+            }
+            processed_num += psi_response->encrypted_elements().size();
+            if (!write_response(chunk_response)) {
+                LOG(ERROR) << "psi server write response chunk failed.";
+                return -1;
+            }
+        }
+        if (!read_request(&chunk_request)) {
+            break;
+        }
+        chunk = &(chunk_request.psi_request());
+    } while (true);
+    auto process_time_cost = timer.timeElapse() - setup_ts;
+    VLOG(5) << "psi server processed " << processed_num << " elements in "
+            << process_time_cost << " ms";
+    record_task_phase("psi_server", "stream", process_time_cost);
+    return 0;
+}
+
 } //namespace primihub::task
@@ -17,6 +17,7 @@
 #ifndef SRC_PRIMIHUB_TASK_SEMANTIC_PSI_SERVER_TASK_H_
 #define SRC_PRIMIHUB_TASK_SEMANTIC_PSI_SERVER_TASK_H_
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -25,6 +26,7 @@
 #include "src/primihub/protos/psi.grpc.pb.h"
 #include "src/primihub/protos/worker.grpc.pb.h"
 #include "src/primihub/task/semantic/private_server_base.h"
+#include "src/primihub/task/semantic/psi_server_cache.h"
 
 using primihub::rpc::Params;
 using primihub::rpc::PsiRequest;
@@ -46,8 +48,24 @@ public:
     int loadDataset(void) override;
     int execute() override;
 
+    using ReadRequestFunc = std::function<bool(ExecuteTaskRequest*)>;
+    using WriteResponseFunc = std::function<bool(const ExecuteTaskResponse&)>;
+    // stream mode, the request passed to constructor is the first chunk.
+    // setup message is written first, then every request chunk is
+    // re-encrypted and written back before the next one is read.
+    int executeStream(ReadRequestFunc read_request, WriteResponseFunc write_response);
+
 private:
+    // create server and setup message, from PsiServerCache if enabled
+    int prepareServer(bool reveal_intersection, int64_t num_client_elements,
+                      std::shared_ptr<const PsiServerCache::PsiServer>* server,
+                      psi_proto::ServerSetup* server_setup);
+    // dataset version used as cache key, empty if unknown
+    std::string datasetVersion();
+
     const double fpr_;
+    bool use_cache_{false};
+    int64_t key_rotation_sec_{86400};
     int data_index_;
     std::string dataset_path_;
     std::vector <std::string> elements_;
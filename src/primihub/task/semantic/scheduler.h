@@ -26,8 +26,11 @@
 #include <thread>
 #include <vector>
 
+#include <glog/logging.h>
+
 #include "src/primihub/protos/worker.grpc.pb.h"
 #include "src/primihub/service/dataset/service.h"
+#include "src/primihub/util/cancellation.h"
 
 
 using primihub::rpc::Node;
@@ -51,10 +54,35 @@ class VMScheduler {
     std::string get_node_id() const {
       return node_id_;
     }
+    // dispatch stops sending party tasks and cancels the pending
+    // SubmitTask rpcs once token is cancelled
+    void setCancelToken(std::shared_ptr<CancellationToken> token) {
+      cancel_token_ = std::move(token);
+    }
+    // ip:port of every node dispatch sent a party task to
+    const std::vector<std::string>& dispatchedParties() const {
+      return dispatched_parties_;
+    }
 
   protected:
+    bool isCancelled() const {
+      return cancel_token_ != nullptr && cancel_token_->isCancelled();
+    }
+    // called by dispatch before it sends to dest_node_address,
+    // returns false once the task is cancelled
+    bool beginPush(const std::string &dest_node_address) {
+      if (isCancelled()) {
+        LOG(WARNING) << "stop dispatching task: " << cancel_token_->reason();
+        return false;
+      }
+      dispatched_parties_.push_back(dest_node_address);
+      return true;
+    }
+
     const std::string node_id_;
     bool singleton_;
+    std::shared_ptr<CancellationToken> cancel_token_;
+    std::vector<std::string> dispatched_parties_;
 };
 } // namespace primihub::task
 
@@ -26,6 +26,7 @@
 #include "absl/strings/str_cat.h"
 
 #include "src/primihub/task/semantic/scheduler/aby3_scheduler.h"
+#include "src/primihub/util/network/grpc_channel_pool.h"
 
 using primihub::rpc::EndPoint;
 using primihub::rpc::LinkType;
@@ -41,7 +42,8 @@ void node_push_task(const std::string &node_id,
                     const PeerDatasetMap &peer_dataset_map,
                     const PushTaskRequest &nodePushTaskRequest,
                     const std::map<std::string, std::string> &dataset_owner,
-                    std::string dest_node_address) {
+                    std::string dest_node_address,
+                    std::shared_ptr<CancellationToken> token) {
     grpc::ClientContext context;
     PushTaskReply pushTaskReply;
     PushTaskRequest _1NodePushTaskRequest;
@@ -74,9 +76,10 @@ void node_push_task(const std::string &node_id,
         DLOG(INFO) << "Insert " << pair.first << ":" << pair.second << "into params.";
     }
    
+    // a cancelled dispatch gives up the rpc instead of waiting on it
+    CancelScope cancel_scope(token, [&context] { context.TryCancel(); });
     // send request
-    std::unique_ptr<VMNode::Stub> stub_ = VMNode::NewStub(grpc::CreateChannel(
-        dest_node_address, grpc::InsecureChannelCredentials()));
+    auto stub_ = GrpcChannelPool::getInstance().getVMNodeStub(dest_node_address);
     Status status =
         stub_->SubmitTask(&context, _1NodePushTaskRequest, &pushTaskReply);
     if (status.ok()) {
@@ -155,19 +158,22 @@ void ABY3Scheduler::dispatch(const PushTaskRequest *actorPushTaskRequest) {
     google::protobuf::Map<std::string, Node> node_map =
         nodePushTaskRequest.task().node_map();
     //  3 nodes request paramaeter are differents.
-    for (int i = 0; i < 3; i++) {
+    for (int i = 0; i < 3 && !isCancelled(); i++) {
         for (auto &pair : node_map) {
             if ("node" + std::to_string(i) == pair.first) {
                 std::string dest_node_address(
                     absl::StrCat(pair.second.ip(), ":", pair.second.port()));
                 DLOG(INFO) << "dest_node_address: " << dest_node_address;
-              
+                if (!beginPush(dest_node_address)) {
+                    break;
+                }
                 thrds.emplace_back(std::thread(node_push_task,
                                                pair.first,              // node_id
                                                this->peer_dataset_map_,  // peer_dataset_map
                                                std::ref(nodePushTaskRequest),  // nodePushTaskRequest
                                                this->dataset_owner_,
-                                               dest_node_address));
+                                               dest_node_address,
+                                               this->cancel_token_));
             }
         }
     }
@@ -29,6 +29,7 @@
 #include "src/primihub/protos/common.pb.h"
 #include "src/primihub/service/dataset/util.hpp"
 #include "src/primihub/service/notify/model.h"
+#include "src/primihub/util/network/grpc_channel_pool.h"
 
 using grpc::Channel;
 using grpc::ClientReader;
@@ -105,7 +106,8 @@ namespace primihub::task {
                           const std::string &dest_node_address,
                           const PushTaskRequest &nodePushTaskRequest,
                           const PeerContextMap peer_context_map,
-                          const std::vector<std::shared_ptr<DatasetMeta>> &dataset_meta_list) {
+                          const std::vector<std::shared_ptr<DatasetMeta>> &dataset_meta_list,
+                          std::shared_ptr<CancellationToken> token) {
         grpc::ClientContext context;
         PushTaskReply pushTaskReply;
         PushTaskRequest _1NodePushTaskRequest;
@@ -113,8 +115,9 @@ namespace primihub::task {
         NodeContext peer_context = peer_context_map.find(role)->second;
         nodeContext2TaskParam(peer_context, dataset_meta_list, &_1NodePushTaskRequest);
 
-        std::unique_ptr<VMNode::Stub> stub_ = VMNode::NewStub(grpc::CreateChannel(
-            dest_node_address, grpc::InsecureChannelCredentials()));
+        // a cancelled dispatch gives up the rpc instead of waiting on it
+        CancelScope cancel_scope(token, [&context] { context.TryCancel(); });
+        auto stub_ = GrpcChannelPool::getInstance().getVMNodeStub(dest_node_address);
         Status status =
             stub_->SubmitTask(&context, _1NodePushTaskRequest, &pushTaskReply);
 
@@ -180,6 +183,9 @@ namespace primihub::task {
             std::string dest_node_address(
                     absl::StrCat(peer_with_tag.first.ip(), ":", peer_with_tag.first.port()));
             LOG(INFO) << "dest_node_address: " << dest_node_address;
+            if (!beginPush(dest_node_address)) {
+                break;
+            }
             // TODO 获取当Role的data meta list
             std::vector<std::shared_ptr<DatasetMeta>> data_meta_list;
             getDataMetaListByRole(peer_with_tag.second, &data_meta_list);
@@ -189,7 +195,8 @@ namespace primihub::task {
                                                dest_node_address,               // dest_node_address
                                                std::ref(nodePushTaskRequest), // nodePushTaskRequest
                                                this->peer_context_map_,
-                                               data_meta_list
+                                               data_meta_list,
+                                               this->cancel_token_
                                                ));
             
         }
@@ -24,6 +24,7 @@ limitations under the License.
 #include "glog/logging.h"
 
 #include "src/primihub/task/semantic/scheduler/mpc_scheduler.h"
+#include "src/primihub/util/network/grpc_channel_pool.h"
 
 using grpc::Channel;
 // using grpc::ClientContext;
@@ -41,7 +42,8 @@ namespace primihub::task {
 void MPCScheduler::push_task(const std::string &node_id,
                              const PeerDatasetMap &peer_dataset_map,
                              const PushTaskRequest &nodePushTaskRequest,
-                             const std::string dest_node_address) {
+                             const std::string dest_node_address,
+                             std::shared_ptr<CancellationToken> token) {
   grpc::ClientContext context;
   PushTaskReply pushTaskReply;
   PushTaskRequest push_request;
@@ -68,9 +70,10 @@ void MPCScheduler::push_task(const std::string &node_id,
     (*param_map)[dataset_param.second] = pv;
   }
 
+  // a cancelled dispatch gives up the rpc instead of waiting on it
+  CancelScope cancel_scope(token, [&context] { context.TryCancel(); });
   // send request
-  std::unique_ptr<VMNode::Stub> stub_ = VMNode::NewStub(grpc::CreateChannel(
-      dest_node_address, grpc::InsecureChannelCredentials()));
+  auto stub_ = GrpcChannelPool::getInstance().getVMNodeStub(dest_node_address);
   Status status = stub_->SubmitTask(&context, push_request, &pushTaskReply);
   if (status.ok()) {
     LOG(INFO) << "Node push task rpc succeeded.";
@@ -113,10 +116,13 @@ void MPCScheduler::dispatch(const PushTaskRequest *push_request) {
 
     std::string node_addr =
         absl::StrCat(iter->second.ip(), ":", iter->second.port());
+    if (!beginPush(node_addr)) {
+      break;
+    }
 
     threads.emplace_back(std::thread(push_task, iter->first,
                                      this->peer_dataset_map_, std::ref(request),
-                                     node_addr));
+                                     node_addr, this->cancel_token_));
   }
 
   for (auto &t : threads)
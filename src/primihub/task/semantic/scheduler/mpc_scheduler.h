@@ -47,7 +47,8 @@ private:
   static void push_task(const std::string &node_id,
                         const PeerDatasetMap &peer_dataset_map,
                         const PushTaskRequest &request,
-                        const std::string node_addr);
+                        const std::string node_addr,
+                        std::shared_ptr<CancellationToken> token);
 
   virtual void add_vm(Node *node, int i,
                       const PushTaskRequest *push_request) = 0;
@@ -14,6 +14,7 @@
  limitations under the License.
  */
 #include "src/primihub/task/semantic/scheduler/pir_scheduler.h"
+#include "src/primihub/util/network/grpc_channel_pool.h"
 
 #include <grpc/grpc.h>
 #include <grpcpp/channel.h>
@@ -159,7 +160,8 @@ void set_keyword_pir_request_param(const std::string &node_id,
 void node_push_pir_task(const std::string &node_id,
                         const PeerDatasetMap &peer_dataset_map,
                         const PushTaskRequest &nodePushTaskRequest,
-                        std::string dest_node_address, bool is_client) {
+                        std::string dest_node_address, bool is_client,
+                        std::shared_ptr<CancellationToken> token) {
     grpc::ClientContext context;
     PushTaskReply pushTaskReply;
     PushTaskRequest _1NodePushTaskRequest;
@@ -183,10 +185,11 @@ void node_push_pir_task(const std::string &node_id,
         return ;
     }
 
+    // a cancelled dispatch gives up the rpc instead of waiting on it
+    CancelScope cancel_scope(token, [&context] { context.TryCancel(); });
     // send request
     VLOG(5) << "begin to submit task to: " << dest_node_address;
-    std::unique_ptr<VMNode::Stub> stub_ = VMNode::NewStub(grpc::CreateChannel(
-        dest_node_address, grpc::InsecureChannelCredentials()));
+    auto stub_ = GrpcChannelPool::getInstance().getVMNodeStub(dest_node_address);
     Status status =
         stub_->SubmitTask(&context, _1NodePushTaskRequest, &pushTaskReply);
     if (status.ok()) {
@@ -254,13 +257,17 @@ void PIRScheduler::dispatch(const PushTaskRequest *pushTaskRequest) {
                 continue;
             }
             duplicate_server.emplace(dest_node_address);
+            if (!beginPush(dest_node_address)) {
+                break;
+            }
             thrds.emplace_back(
                 std::thread(node_push_pir_task,
                             pair.first,                      // node_id
                             this->peer_dataset_map_,         // peer_dataset_map
                             std::ref(nodePushTaskRequest),   // nodePushTaskRequest
                             dest_node_address,
-                            is_client));
+                            is_client,
+                            this->cancel_token_));
         } else if (pirType == PirType::KEY_PIR) {
             auto peer_dataset_map_it = this->peer_dataset_map_.find(pair.first);
             for (const auto& it : peer_dataset_map_) {
@@ -290,13 +297,17 @@ void PIRScheduler::dispatch(const PushTaskRequest *pushTaskRequest) {
                 continue;
             }
             duplicate_server.emplace(dest_node_address);
+            if (!beginPush(dest_node_address)) {
+                break;
+            }
             thrds.emplace_back(
                 std::thread(node_push_pir_task,
                             pair.first,                     // node_id
                             this->peer_dataset_map_,        // peer_dataset_map
                             std::ref(nodePushTaskRequest),  // nodePushTaskRequest
                             dest_node_address,
-                            is_client));
+                            is_client,
+                            this->cancel_token_));
             // }
         } else {
             LOG(ERROR) << "The pir type is error";
@@ -26,6 +26,7 @@
 #include "absl/strings/str_cat.h"
 
 #include "src/primihub/task/semantic/scheduler/psi_scheduler.h"
+#include "src/primihub/util/network/grpc_channel_pool.h"
 
 
 //using primihub::rpc::EndPoint;
@@ -171,7 +172,8 @@ void node_push_psi_task(const std::string &node_id,
                     const PeerDatasetMap &peer_dataset_map,
                     const PushTaskRequest &nodePushTaskRequest,
                     std::string dest_node_address,
-                    bool is_client) {
+                    bool is_client,
+                    std::shared_ptr<CancellationToken> token) {
     grpc::ClientContext context;
 
     PushTaskReply pushTaskReply;
@@ -196,10 +198,11 @@ void node_push_psi_task(const std::string &node_id,
         return ;
     }
 
+    // a cancelled dispatch gives up the rpc instead of waiting on it
+    CancelScope cancel_scope(token, [&context] { context.TryCancel(); });
     // send request
     LOG(INFO) << "dest node " << dest_node_address;
-    std::unique_ptr<VMNode::Stub> stub_ = VMNode::NewStub(grpc::CreateChannel(
-        dest_node_address, grpc::InsecureChannelCredentials()));
+    auto stub_ = GrpcChannelPool::getInstance().getVMNodeStub(dest_node_address);
     Status status =
         stub_->SubmitTask(&context, _1NodePushTaskRequest, &pushTaskReply);
     if (status.ok()) {
@@ -258,6 +261,9 @@ void PSIScheduler::dispatch(const PushTaskRequest *pushTaskRequest) {
     const auto& node_map = nodePushTaskRequest.task().node_map();
      std::set<std::string> duplicate_filter;
     for (auto &pair : node_map) {
+        if (isCancelled()) {
+            break;
+        }
         auto peer_dataset_map_it = this->peer_dataset_map_.find(pair.first);
         if (peer_dataset_map_it == this->peer_dataset_map_.end()) {
             LOG(ERROR) << "dispatchTask: peer_dataset_map not found";
@@ -278,13 +284,17 @@ void PSIScheduler::dispatch(const PushTaskRequest *pushTaskRequest) {
             }
             duplicate_filter.emplace(dest_node_address);
             VLOG(5) << "dest_node_address: " << dest_node_address;
+            if (!beginPush(dest_node_address)) {
+                break;
+            }
 
             thrds.emplace_back(std::thread(node_push_psi_task,
                                            pair.first,              // node_id
                                            this->peer_dataset_map_,  // peer_dataset_map
                                            std::ref(nodePushTaskRequest),  // nodePushTaskRequest
                                            dest_node_address,
-                                           is_client));
+                                           is_client,
+                                           this->cancel_token_));
         }
     }
 
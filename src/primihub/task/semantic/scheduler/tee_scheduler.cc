@@ -24,6 +24,7 @@
 #include "absl/strings/str_cat.h"
 
 #include "src/primihub/task/semantic/scheduler/tee_scheduler.h"
+#include "src/primihub/util/network/grpc_channel_pool.h"
 
 using primihub::rpc::EndPoint;
 using primihub::rpc::LinkType;
@@ -79,6 +80,9 @@ void TEEScheduler::dispatch(const PushTaskRequest *push_request) {
             absl::StrCat(pair.second.ip(), ":", pair.second.port()));
 
         LOG(INFO) << " 📧  Dispatching task to: " << dest_node_address;
+        if (!beginPush(dest_node_address)) {
+            break;
+        }
         this->push_task_to_node(pair.first, 
                                 this->peer_dataset_map_,
                                 std::ref(request),
@@ -139,10 +143,11 @@ void TEEScheduler::push_task_to_node (const std::string &node_id,
         pv.set_value_string(dataset_param.first);
         (*param_map)[dataset_param.second] = pv;
     }
+    // a cancelled dispatch gives up the rpc instead of waiting on it
+    CancelScope cancel_scope(cancel_token_,
+                             [&context] { context.TryCancel(); });
     // send request
-    auto channel = grpc::CreateChannel(
-        dest_node_address, grpc::InsecureChannelCredentials());
-    std::unique_ptr<VMNode::Stub> stub = VMNode::NewStub(channel);
+    auto stub = GrpcChannelPool::getInstance().getVMNodeStub(dest_node_address);
     primihub::rpc::PushTaskReply response;
     grpc::Status status = stub->SubmitTask(&context, _1NodePushTaskRequest, &response);
     if (status.ok()) {
@@ -16,12 +16,18 @@
 
 #include "src/primihub/task/semantic/task.h"
 
+#include <glog/logging.h>
+
+#include <chrono>
+
 namespace primihub::task {
 
     TaskBase::TaskBase(const TaskParam *task_param,
                        std::shared_ptr<DatasetService> dataset_service) {
         setTaskParam(task_param);
         dataset_service_ = dataset_service;
+        cancel_token_ = std::make_shared<CancellationToken>();
+        cancel_token_->setTimeout(task_param_.timeout_ms());
     }
 
     TaskParam* TaskBase::getTaskParam()  {
@@ -31,5 +37,31 @@ namespace primihub::task {
     void TaskBase::setTaskParam(const TaskParam *task_param) {
         task_param_.CopyFrom(*task_param);
     }
+
+    void TaskBase::setCancellationToken(std::shared_ptr<CancellationToken> token) {
+        cancel_token_ = std::move(token);
+    }
+
+    std::shared_ptr<CancellationToken> TaskBase::getCancellationToken() {
+        return cancel_token_;
+    }
+
+    bool TaskBase::isCancelled() const {
+        if (cancel_token_ == nullptr || !cancel_token_->isCancelled()) {
+            return false;
+        }
+        LOG(WARNING) << "task " << task_param_.task_id() << " is cancelled: "
+                     << cancel_token_->reason();
+        return true;
+    }
+
+    void TaskBase::setClientDeadline(grpc::ClientContext* context) {
+        if (cancel_token_ == nullptr || !cancel_token_->hasDeadline()) {
+            return;
+        }
+        auto remain = std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            cancel_token_->deadline() - std::chrono::steady_clock::now());
+        context->set_deadline(std::chrono::system_clock::now() + remain);
+    }
  
 } // namespace primihub::task
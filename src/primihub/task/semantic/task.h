@@ -17,8 +17,11 @@
 #ifndef SRC_PRIMIHUB_TASK_SEMANTIC_TASK_H_
 #define SRC_PRIMIHUB_TASK_SEMANTIC_TASK_H_
 
+#include <grpcpp/grpcpp.h>
+
 #include "src/primihub/protos/common.grpc.pb.h"
 #include "src/primihub/service/dataset/service.h"
+#include "src/primihub/util/cancellation.h"
 
 using primihub::rpc::Task;
 using primihub::service::DatasetService;
@@ -40,9 +43,19 @@ class TaskBase {
     void setTaskParam(const TaskParam *task_param);
     TaskParam* getTaskParam();
 
+    // the token is shared with whoever may cancel the task, by default the
+    // task owns one with the deadline of task_param.timeout_ms
+    void setCancellationToken(std::shared_ptr<CancellationToken> token);
+    std::shared_ptr<CancellationToken> getCancellationToken();
+    bool isCancelled() const;
+
  protected:
+    // let the deadline of the task bound the rpc as well
+    void setClientDeadline(grpc::ClientContext* context);
+
     TaskParam task_param_;
     std::shared_ptr<DatasetService> dataset_service_;
+    std::shared_ptr<CancellationToken> cancel_token_;
 };
 
 } // namespace primihub::task
@@ -0,0 +1,223 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "src/primihub/util/cancellation.h"
+
+#include <glog/logging.h>
+
+#include <exception>
+#include <utility>
+#include <vector>
+
+namespace primihub {
+
+CancellationToken::~CancellationToken() {
+  if (watch_id_ != 0) {
+    DeadlineWatchdog::getInstance().unwatch(watch_id_);
+  }
+}
+
+bool CancellationToken::cancel(const std::string& reason) {
+  std::lock_guard<std::mutex> run_lck(run_mtx_);
+  std::map<uint64_t, Callback> callbacks;
+  uint64_t watch_id = 0;
+  {
+    std::lock_guard<std::mutex> lck(mtx_);
+    if (cancelled_.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    reason_ = reason;
+    cancelled_.store(true, std::memory_order_release);
+    callbacks.swap(callbacks_);
+    std::swap(watch_id, watch_id_);
+  }
+  if (watch_id != 0) {
+    DeadlineWatchdog::getInstance().unwatch(watch_id);
+  }
+  VLOG(3) << "cancel token: " << reason;
+  for (auto& it : callbacks) {
+    try {
+      it.second();
+    } catch (std::exception& e) {
+      LOG(WARNING) << "cancel callback throw: " << e.what();
+    }
+  }
+  return true;
+}
+
+std::string CancellationToken::reason() const {
+  std::lock_guard<std::mutex> lck(mtx_);
+  return reason_;
+}
+
+void CancellationToken::setTimeout(int64_t timeout_ms) {
+  if (timeout_ms <= 0) {
+    return;
+  }
+  auto deadline = Clock::now() + std::chrono::milliseconds(timeout_ms);
+  auto& watchdog = DeadlineWatchdog::getInstance();
+  uint64_t watch_id = watchdog.watch(deadline, weak_from_this());
+  // the new deadline replaces the old one, a cancelled token needs none
+  uint64_t unused_watch_id = watch_id;
+  {
+    std::lock_guard<std::mutex> lck(mtx_);
+    has_deadline_ = true;
+    deadline_ = deadline;
+    if (!cancelled_.load(std::memory_order_relaxed)) {
+      std::swap(unused_watch_id, watch_id_);
+    }
+  }
+  watchdog.unwatch(unused_watch_id);
+}
+
+bool CancellationToken::hasDeadline() const {
+  std::lock_guard<std::mutex> lck(mtx_);
+  return has_deadline_;
+}
+
+CancellationToken::Clock::time_point CancellationToken::deadline() const {
+  std::lock_guard<std::mutex> lck(mtx_);
+  return deadline_;
+}
+
+int64_t CancellationToken::remainingMs() const {
+  std::lock_guard<std::mutex> lck(mtx_);
+  if (!has_deadline_) {
+    return -1;
+  }
+  auto remain = std::chrono::duration_cast<std::chrono::milliseconds>(
+      deadline_ - Clock::now()).count();
+  return remain > 0 ? remain : 0;
+}
+
+uint64_t CancellationToken::onCancel(Callback callback) {
+  {
+    std::lock_guard<std::mutex> lck(mtx_);
+    if (!cancelled_.load(std::memory_order_relaxed)) {
+      uint64_t id = ++next_id_;
+      callbacks_.emplace(id, std::move(callback));
+      return id;
+    }
+  }
+  callback();
+  return 0;
+}
+
+void CancellationToken::removeCallback(uint64_t id) {
+  if (id == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> run_lck(run_mtx_);
+  std::lock_guard<std::mutex> lck(mtx_);
+  callbacks_.erase(id);
+}
+
+CancelScope::CancelScope(std::shared_ptr<CancellationToken> token,
+                         CancellationToken::Callback callback)
+    : token_(std::move(token)) {
+  if (token_ != nullptr) {
+    id_ = token_->onCancel(std::move(callback));
+  }
+}
+
+CancelScope::~CancelScope() {
+  if (token_ != nullptr) {
+    token_->removeCallback(id_);
+  }
+}
+
+DeadlineWatchdog::~DeadlineWatchdog() {
+  {
+    std::lock_guard<std::mutex> lck(mtx_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+uint64_t DeadlineWatchdog::watch(CancellationToken::Clock::time_point deadline,
+                                 std::weak_ptr<CancellationToken> token) {
+  uint64_t id = 0;
+  {
+    std::lock_guard<std::mutex> lck(mtx_);
+    if (stop_) {
+      return 0;
+    }
+    if (!thread_.joinable()) {
+      thread_ = std::thread(&DeadlineWatchdog::_Run, this);
+    }
+    id = ++next_id_;
+    index_.emplace(id, tokens_.emplace(deadline, std::make_pair(id, std::move(token))));
+  }
+  cv_.notify_one();
+  return id;
+}
+
+void DeadlineWatchdog::unwatch(uint64_t id) {
+  if (id == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lck(mtx_);
+  auto it = index_.find(id);
+  if (it == index_.end()) {
+    return;
+  }
+  tokens_.erase(it->second);
+  index_.erase(it);
+}
+
+size_t DeadlineWatchdog::numWatched() {
+  std::lock_guard<std::mutex> lck(mtx_);
+  return tokens_.size();
+}
+
+void DeadlineWatchdog::_Run() {
+  std::unique_lock<std::mutex> lck(mtx_);
+  while (!stop_) {
+    if (tokens_.empty()) {
+      cv_.wait(lck);
+      continue;
+    }
+    auto deadline = tokens_.begin()->first;
+    if (CancellationToken::Clock::now() < deadline) {
+      cv_.wait_until(lck, deadline);
+      continue;
+    }
+    std::vector<std::shared_ptr<CancellationToken>> expired;
+    auto now = CancellationToken::Clock::now();
+    while (!tokens_.empty() && tokens_.begin()->first <= now) {
+      auto token = tokens_.begin()->second.second.lock();
+      if (token != nullptr) {
+        expired.push_back(std::move(token));
+      }
+      index_.erase(tokens_.begin()->second.first);
+      tokens_.erase(tokens_.begin());
+    }
+    // callbacks may block on sockets, never run them under the lock
+    lck.unlock();
+    for (auto& token : expired) {
+      if (token->cancel("deadline exceeded")) {
+        LOG(WARNING) << "task deadline exceeded, cancel it";
+      }
+    }
+    expired.clear();
+    lck.lock();
+  }
+}
+
+}  // namespace primihub
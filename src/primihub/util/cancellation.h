@@ -0,0 +1,140 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#ifndef SRC_PRIMIHUB_UTIL_CANCELLATION_H_
+#define SRC_PRIMIHUB_UTIL_CANCELLATION_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace primihub {
+
+/**
+ * Cooperative cancellation of one task.
+ *
+ * Long running code polls isCancelled() between steps, code blocked in
+ * a recv registers a callback which unblocks it, e.g. cancels the
+ * channel or the grpc context it waits on. A deadline set by setTimeout
+ * cancels the token from the watchdog thread once it expires.
+ */
+class CancellationToken
+    : public std::enable_shared_from_this<CancellationToken> {
+ public:
+  using Callback = std::function<void()>;
+  using Clock = std::chrono::steady_clock;
+
+  // drops the deadline from the watchdog, which would otherwise keep the
+  // memory of a make_shared token until the deadline.
+  ~CancellationToken();
+
+  // returns false if the token is already cancelled.
+  bool cancel(const std::string& reason);
+  bool isCancelled() const { return cancelled_.load(std::memory_order_acquire); }
+  std::string reason() const;
+
+  // the token must be owned by a shared_ptr, timeout_ms <= 0 is ignored.
+  void setTimeout(int64_t timeout_ms);
+  bool hasDeadline() const;
+  Clock::time_point deadline() const;
+  // -1 if there is no deadline
+  int64_t remainingMs() const;
+
+  // callback runs once, on the cancelling thread or right away if the
+  // token is already cancelled. It must not add or remove callbacks nor
+  // cancel the token itself.
+  uint64_t onCancel(Callback callback);
+  // after return the callback is neither running nor called any more.
+  void removeCallback(uint64_t id);
+
+ private:
+  std::atomic<bool> cancelled_{false};
+  mutable std::mutex mtx_;
+  // held while callbacks run, so removeCallback waits for them
+  std::mutex run_mtx_;
+  std::string reason_;
+  bool has_deadline_{false};
+  Clock::time_point deadline_;
+  uint64_t watch_id_{0};
+  uint64_t next_id_{0};
+  std::map<uint64_t, Callback> callbacks_;
+};
+
+/**
+ * Registers callback on token for the lifetime of the scope, which should
+ * not outlive the objects the callback refers to. A null token is allowed.
+ */
+class CancelScope {
+ public:
+  CancelScope(std::shared_ptr<CancellationToken> token,
+              CancellationToken::Callback callback);
+  ~CancelScope();
+
+  CancelScope(const CancelScope&) = delete;
+  CancelScope& operator=(const CancelScope&) = delete;
+
+ private:
+  std::shared_ptr<CancellationToken> token_;
+  uint64_t id_{0};
+};
+
+/**
+ * Single thread cancelling tokens whose deadline has expired. A token
+ * removes its entry when it is cancelled or destroyed, so finished tasks
+ * with long deadlines leave nothing behind.
+ */
+class DeadlineWatchdog {
+ public:
+  static DeadlineWatchdog& getInstance() {
+    static DeadlineWatchdog kSingleInstance;
+    return kSingleInstance;
+  }
+  ~DeadlineWatchdog();
+
+  // returns the id to unwatch the token with, 0 if the watchdog is stopped.
+  uint64_t watch(CancellationToken::Clock::time_point deadline,
+                 std::weak_ptr<CancellationToken> token);
+  // no-op if the deadline has already fired.
+  void unwatch(uint64_t id);
+  size_t numWatched();
+
+ private:
+  using Entries = std::multimap<CancellationToken::Clock::time_point,
+                                std::pair<uint64_t, std::weak_ptr<CancellationToken>>>;
+
+  DeadlineWatchdog() = default;
+  void _Run();
+
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  bool stop_{false};
+  uint64_t next_id_{0};
+  Entries tokens_;
+  std::unordered_map<uint64_t, Entries::iterator> index_;
+  std::thread thread_;
+};
+
+}  // namespace primihub
+
+#endif  // SRC_PRIMIHUB_UTIL_CANCELLATION_H_
@@ -42,4 +42,12 @@ int ValidateDir(const std::string &file_path) {
     return 0;
 }
 
+std::string FileVersion(const std::string& file_path) {
+    struct stat st;
+    if (stat(file_path.c_str(), &st) != 0) {
+        return "";
+    }
+    return std::to_string(st.st_mtime) + "-" + std::to_string(st.st_size);
+}
+
 }
@@ -16,6 +16,8 @@ namespace primihub {
 
 std::vector<std::string> GetFiles(const std::string& path);
 int ValidateDir(const std::string &file_path);
+// mtime and size of a file as "mtime-size", empty if it can not be stat
+std::string FileVersion(const std::string& file_path);
 
 }
 
@@ -0,0 +1,385 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "src/primihub/util/metrics.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace primihub {
+
+namespace {
+
+std::string format_labels(const MetricLabels& labels) {
+  std::string result;
+  for (const auto& label : labels) {
+    if (!result.empty()) {
+      result.push_back(',');
+    }
+    result.append(label.first).append("=\"");
+    for (char c : label.second) {
+      switch (c) {
+      case '\\':
+        result.append("\\\\");
+        break;
+      case '"':
+        result.append("\\\"");
+        break;
+      case '\n':
+        result.append("\\n");
+        break;
+      default:
+        result.push_back(c);
+      }
+    }
+    result.push_back('"');
+  }
+  return result;
+}
+
+void write_series(std::ostringstream& out, const std::string& name,
+                  const std::string& labels, const std::string& extra_label) {
+  out << name;
+  if (!labels.empty() || !extra_label.empty()) {
+    out << '{' << labels;
+    if (!labels.empty() && !extra_label.empty()) {
+      out << ',';
+    }
+    out << extra_label << '}';
+  }
+  out << ' ';
+}
+
+}  // namespace
+
+int Histogram::bucketIndex(uint64_t v) {
+  if (v < kSubBuckets) {
+    return static_cast<int>(v);
+  }
+  int shift = 63 - __builtin_clzll(v) - kSubBucketBits;
+  int sub = static_cast<int>((v >> shift) & (kSubBuckets - 1));
+  return kSubBuckets * (shift + 1) + sub;
+}
+
+uint64_t Histogram::bucketUpperBound(int index) {
+  if (index < kSubBuckets) {
+    return index;
+  }
+  int shift = index / kSubBuckets - 1;
+  uint64_t sub = index % kSubBuckets;
+  uint64_t lower = (kSubBuckets + sub) << shift;
+  return lower + ((uint64_t{1} << shift) - 1);
+}
+
+void Histogram::observe(uint64_t v) {
+  buckets_[bucketIndex(v)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(v, std::memory_order_relaxed);
+  uint64_t cur = max_.load(std::memory_order_relaxed);
+  while (v > cur &&
+         !max_.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {
+  }
+}
+
+uint64_t Histogram::quantile(double q) const {
+  std::vector<uint64_t> snapshot(kBucketNum);
+  uint64_t total = 0;
+  for (int i = 0; i < kBucketNum; i++) {
+    snapshot[i] = buckets_[i].load(std::memory_order_relaxed);
+    total += snapshot[i];
+  }
+  if (total == 0) {
+    return 0;
+  }
+  q = std::min(std::max(q, 0.0), 1.0);
+  uint64_t rank = std::max<uint64_t>(1, std::ceil(q * total));
+  uint64_t seen = 0;
+  for (int i = 0; i < kBucketNum; i++) {
+    seen += snapshot[i];
+    if (seen >= rank) {
+      return std::min(bucketUpperBound(i), max_.load(std::memory_order_relaxed));
+    }
+  }
+  return max_.load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::countRange(int first, int last) const {
+  uint64_t result = 0;
+  for (int i = first; i <= last; i++) {
+    result += buckets_[i].load(std::memory_order_relaxed);
+  }
+  return result;
+}
+
+MetricsRegistry::Family& MetricsRegistry::family(const std::string& name,
+                                                 Type type,
+                                                 const std::string& help) {
+  auto it = families_.find(name);
+  if (it == families_.end()) {
+    it = families_.emplace(name, Family()).first;
+    it->second.type = type;
+    it->second.help = help;
+  } else if (it->second.type != type) {
+    LOG(ERROR) << "metric " << name << " is registered with another type";
+  }
+  return it->second;
+}
+
+Counter& MetricsRegistry::counter(const std::string& name,
+                                  const MetricLabels& labels,
+                                  const std::string& help) {
+  std::lock_guard<std::mutex> lck(mtx_);
+  auto& series = family(name, Type::COUNTER, help).counters[format_labels(labels)];
+  if (series == nullptr) {
+    series = std::make_unique<Counter>();
+  }
+  return *series;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name,
+                              const MetricLabels& labels,
+                              const std::string& help) {
+  std::lock_guard<std::mutex> lck(mtx_);
+  auto& series = family(name, Type::GAUGE, help).gauges[format_labels(labels)];
+  if (series == nullptr) {
+    series = std::make_unique<Gauge>();
+  }
+  return *series;
+}
+
+const std::vector<double> MetricsRegistry::kDefaultBounds = {
+    0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1,
+    2.5,   5,      10,    30,   60,    120,  300, 600,  1800, 3600};
+
+Histogram& MetricsRegistry::histogram(const std::string& name,
+                                      const MetricLabels& labels,
+                                      const std::string& help, double unit,
+                                      const std::vector<double>& bounds) {
+  std::lock_guard<std::mutex> lck(mtx_);
+  auto& entry = family(name, Type::HISTOGRAM, help);
+  entry.unit = unit;
+  if (!bounds.empty()) {
+    entry.bounds = bounds;
+    std::sort(entry.bounds.begin(), entry.bounds.end());
+  } else if (entry.bounds.empty()) {
+    entry.bounds = kDefaultBounds;
+  }
+  auto& series = entry.histograms[format_labels(labels)];
+  if (series == nullptr) {
+    series = std::make_unique<Histogram>();
+  }
+  return *series;
+}
+
+std::string MetricsRegistry::exportText() {
+  std::ostringstream out;
+  out.precision(12);
+  std::lock_guard<std::mutex> lck(mtx_);
+  for (const auto& it : families_) {
+    const std::string& name = it.first;
+    const Family& entry = it.second;
+    if (!entry.help.empty()) {
+      out << "# HELP " << name << ' ' << entry.help << '\n';
+    }
+    switch (entry.type) {
+    case Type::COUNTER:
+      out << "# TYPE " << name << " counter\n";
+      for (const auto& series : entry.counters) {
+        write_series(out, name, series.first, "");
+        out << series.second->value() << '\n';
+      }
+      break;
+    case Type::GAUGE:
+      out << "# TYPE " << name << " gauge\n";
+      for (const auto& series : entry.gauges) {
+        write_series(out, name, series.first, "");
+        out << series.second->value() << '\n';
+      }
+      break;
+    case Type::HISTOGRAM:
+      out << "# TYPE " << name << " histogram\n";
+      for (const auto& series : entry.histograms) {
+        const Histogram& hist = *series.second;
+        // the same fixed bounds for every series. A bound falling inside a
+        // log-linear bucket counts that bucket in the next `le`, which is
+        // within the 1 / kSubBuckets error of the histogram.
+        uint64_t total = hist.count();
+        uint64_t prev = 0;
+        int next = 0;
+        for (double bound : entry.bounds) {
+          // recorded values are integers, allow for the rounding of
+          // e.g. 0.001 / 1e-6
+          double raw = bound / entry.unit * (1 + 1e-9);
+          int last = Histogram::kBucketNum - 1;
+          if (raw < 0) {
+            last = -1;
+          } else if (raw < 18446744073709551615.0) {
+            uint64_t limit = static_cast<uint64_t>(raw);
+            last = Histogram::bucketIndex(limit);
+            if (Histogram::bucketUpperBound(last) > limit) {
+              last--;
+            }
+          }
+          if (last >= next) {
+            prev += hist.countRange(next, last);
+            next = last + 1;
+          }
+          std::ostringstream le;
+          le.precision(12);
+          le << "le=\"" << bound << '"';
+          write_series(out, name + "_bucket", series.first, le.str());
+          out << prev << '\n';
+        }
+        write_series(out, name + "_bucket", series.first, "le=\"+Inf\"");
+        out << std::max(prev, total) << '\n';
+        write_series(out, name + "_sum", series.first, "");
+        out << static_cast<double>(hist.sum()) * entry.unit << '\n';
+        write_series(out, name + "_count", series.first, "");
+        out << std::max(prev, total) << '\n';
+      }
+      break;
+    }
+  }
+  return out.str();
+}
+
+int MetricsHttpServer::start(const std::string& address, int port) {
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) {
+    LOG(ERROR) << "invalid metrics address: " << address;
+    return -1;
+  }
+  listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_fd_ < 0) {
+    LOG(ERROR) << "create metrics socket failed: " << strerror(errno);
+    return -1;
+  }
+  int on = 1;
+  setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      listen(listen_fd_, 16) != 0) {
+    LOG(ERROR) << "listen on " << address << ":" << port
+               << " failed: " << strerror(errno);
+    close(listen_fd_);
+    listen_fd_ = -1;
+    return -1;
+  }
+  stop_ = false;
+  thread_ = std::thread(&MetricsHttpServer::serve, this);
+  LOG(INFO) << "metrics served on http://" << address << ":" << port << "/metrics";
+  return 0;
+}
+
+void MetricsHttpServer::stop() {
+  stop_ = true;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  if (listen_fd_ >= 0) {
+    close(listen_fd_);
+    listen_fd_ = -1;
+  }
+}
+
+void MetricsHttpServer::serve() {
+  while (!stop_) {
+    pollfd pfd{listen_fd_, POLLIN, 0};
+    int ret = poll(&pfd, 1, 200);
+    if (ret <= 0) {
+      continue;
+    }
+    int fd = accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) {
+      continue;
+    }
+    handle(fd);
+    close(fd);
+  }
+}
+
+void MetricsHttpServer::handle(int fd) {
+  timeval timeout{1, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+  std::string request;
+  char buf[1024];
+  while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n <= 0) {
+      break;
+    }
+    request.append(buf, n);
+  }
+
+  std::string status = "404 Not Found";
+  std::string body = "not found\n";
+  if (request.compare(0, 13, "GET /metrics ") == 0 ||
+      request.compare(0, 13, "GET /metrics?") == 0) {
+    status = "200 OK";
+    body = MetricsRegistry::getInstance().exportText();
+  }
+  std::ostringstream response;
+  response << "HTTP/1.1 " << status << "\r\n"
+           << "Content-Type: text/plain; version=0.0.4\r\n"
+           << "Content-Length: " << body.size() << "\r\n"
+           << "Connection: close\r\n\r\n"
+           << body;
+  std::string data = response.str();
+  size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n <= 0) {
+      break;
+    }
+    sent += n;
+  }
+}
+
+void record_task_phase(const std::string& task_type, const std::string& phase,
+                       double elapsed_ms) {
+  auto& hist = MetricsRegistry::getInstance().histogram(
+      "primihub_task_phase_duration_seconds",
+      {{"task_type", task_type}, {"phase", phase}},
+      "Elapsed time of each task phase.", 1e-6);
+  hist.observe(elapsed_ms > 0 ? static_cast<uint64_t>(elapsed_ms * 1000) : 0);
+}
+
+void record_channel_bytes(const std::string& task_type, uint64_t sent,
+                          uint64_t received) {
+  auto& registry = MetricsRegistry::getInstance();
+  registry.counter("primihub_channel_sent_bytes_total", {{"task_type", task_type}},
+                   "Bytes sent over task channels.").inc(sent);
+  registry.counter("primihub_channel_received_bytes_total",
+                   {{"task_type", task_type}},
+                   "Bytes received over task channels.").inc(received);
+}
+
+}  // namespace primihub
@@ -0,0 +1,166 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#ifndef SRC_PRIMIHUB_UTIL_METRICS_H_
+#define SRC_PRIMIHUB_UTIL_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace primihub {
+
+using MetricLabels = std::map<std::string, std::string>;
+
+class Counter {
+ public:
+  void inc(uint64_t v = 1) { value_.fetch_add(v, std::memory_order_relaxed); }
+  uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint64_t> value_{0};
+};
+
+class Gauge {
+ public:
+  void set(int64_t v) { value_.store(v, std::memory_order_relaxed); }
+  void add(int64_t v) { value_.fetch_add(v, std::memory_order_relaxed); }
+  int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<int64_t> value_{0};
+};
+
+/**
+ * Log-linear histogram in the style of HdrHistogram: every power of two
+ * is split into kSubBuckets linear buckets, so any recorded value is kept
+ * with a relative error below 1 / kSubBuckets. Recording is a couple of
+ * relaxed atomic adds.
+ */
+class Histogram {
+ public:
+  static constexpr int kSubBucketBits = 4;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  static constexpr int kBucketNum = kSubBuckets * (64 - kSubBucketBits + 1);
+
+  void observe(uint64_t v);
+  uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+  uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+  // upper bound of the bucket holding the q-th quantile, q in [0, 1]
+  uint64_t quantile(double q) const;
+  // number of recorded values in buckets [first, last]
+  uint64_t countRange(int first, int last) const;
+
+  static int bucketIndex(uint64_t v);
+  static uint64_t bucketUpperBound(int index);
+
+ private:
+  std::array<std::atomic<uint64_t>, kBucketNum> buckets_{};
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> max_{0};
+};
+
+/**
+ * Process wide metrics, exported in Prometheus text format.
+ *
+ * Looking up a series takes a lock, updating it does not, so hot paths
+ * should keep the returned reference. Series are never removed, the
+ * references stay valid for the lifetime of the process.
+ */
+class MetricsRegistry {
+ public:
+  static MetricsRegistry& getInstance() {
+    static MetricsRegistry kSingleInstance;
+    return kSingleInstance;
+  }
+
+  Counter& counter(const std::string& name, const MetricLabels& labels = {},
+                   const std::string& help = "");
+  Gauge& gauge(const std::string& name, const MetricLabels& labels = {},
+               const std::string& help = "");
+  // unit scales recorded values on export, e.g. 1e-6 for microseconds
+  // recorded into a *_seconds histogram. bounds are the exported `le`
+  // buckets in exported units, kDefaultBounds when empty; every series of
+  // a family exports all of them, so rate() and histogram_quantile() can
+  // aggregate across series and scrapes.
+  Histogram& histogram(const std::string& name, const MetricLabels& labels = {},
+                       const std::string& help = "", double unit = 1.0,
+                       const std::vector<double>& bounds = {});
+
+  // seconds, from 1ms up to an hour
+  static const std::vector<double> kDefaultBounds;
+
+  std::string exportText();
+
+ private:
+  enum class Type { COUNTER, GAUGE, HISTOGRAM };
+  struct Family {
+    Type type;
+    std::string help;
+    double unit{1.0};
+    std::vector<double> bounds;
+    // key: formatted label set
+    std::map<std::string, std::unique_ptr<Counter>> counters;
+    std::map<std::string, std::unique_ptr<Gauge>> gauges;
+    std::map<std::string, std::unique_ptr<Histogram>> histograms;
+  };
+
+  MetricsRegistry() = default;
+  Family& family(const std::string& name, Type type, const std::string& help);
+
+  std::mutex mtx_;
+  std::map<std::string, Family> families_;
+};
+
+/**
+ * Serves GET /metrics of the registry over plain http on its own thread.
+ */
+class MetricsHttpServer {
+ public:
+  MetricsHttpServer() = default;
+  ~MetricsHttpServer() { stop(); }
+
+  int start(const std::string& address, int port);
+  void stop();
+
+ private:
+  void serve();
+  void handle(int fd);
+
+  int listen_fd_{-1};
+  std::atomic<bool> stop_{false};
+  std::thread thread_;
+};
+
+// elapsed time of one phase of a task,
+// primihub_task_phase_duration_seconds{task_type, phase}
+void record_task_phase(const std::string& task_type, const std::string& phase,
+                       double elapsed_ms);
+// bytes moved over the mpc/psi channels of a task,
+// primihub_channel_{sent,received}_bytes_total{task_type}
+void record_channel_bytes(const std::string& task_type, uint64_t sent,
+                          uint64_t received);
+
+}  // namespace primihub
+
+#endif  // SRC_PRIMIHUB_UTIL_METRICS_H_
@@ -0,0 +1,137 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include "src/primihub/util/network/grpc_channel_pool.h"
+
+#include <glog/logging.h>
+
+#include <iomanip>
+#include <sstream>
+
+namespace primihub {
+
+namespace {
+std::string DurationStr(int ms) {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(3) << ms / 1000.0 << "s";
+    return ss.str();
+}
+
+// VMNode methods safe to call again, a retried SubmitTask, ExecuteTask or
+// Send may start a task or deliver a result twice when the first attempt
+// reached the peer before the connection failed
+const char* const kRetryableMethods[] = {"KillTask"};
+
+// retry on UNAVAILABLE for the idempotent VMNode methods only
+std::string RetryServiceConfig(const GrpcChannelOptions& options) {
+    std::stringstream ss;
+    ss << R"({"methodConfig":[{"name":[)";
+    bool first = true;
+    for (const auto& method : kRetryableMethods) {
+        ss << (first ? "" : ",")
+           << R"({"service":"primihub.rpc.VMNode","method":")" << method << R"("})";
+        first = false;
+    }
+    ss << R"(],"retryPolicy":{"maxAttempts":)" << options.max_attempts
+       << R"(,"initialBackoff":")" << DurationStr(options.initial_backoff_ms)
+       << R"(","maxBackoff":")" << DurationStr(options.max_backoff_ms)
+       << R"(","backoffMultiplier":2,"retryableStatusCodes":["UNAVAILABLE"]}}]})";
+    return ss.str();
+}
+}  // namespace
+
+void GrpcChannelPool::setOptions(const GrpcChannelOptions& options) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    options_ = options;
+    channels_.clear();
+    LOG(INFO) << "grpc channel options, max_message_size: "
+              << options_.max_message_size
+              << " keepalive_time_ms: " << options_.keepalive_time_ms
+              << " compression: " << options_.compression
+              << " max_attempts: " << options_.max_attempts;
+}
+
+GrpcChannelOptions GrpcChannelPool::options() {
+    std::lock_guard<std::mutex> lck(mtx_);
+    return options_;
+}
+
+std::shared_ptr<grpc::Channel> GrpcChannelPool::createChannel(
+        const std::string& address) {
+    grpc::ChannelArguments channel_args;
+    channel_args.SetMaxReceiveMessageSize(options_.max_message_size);
+    channel_args.SetMaxSendMessageSize(options_.max_message_size);
+    if (options_.keepalive_time_ms > 0) {
+        channel_args.SetInt(GRPC_ARG_KEEPALIVE_TIME_MS, options_.keepalive_time_ms);
+        channel_args.SetInt(GRPC_ARG_KEEPALIVE_TIMEOUT_MS,
+                            options_.keepalive_timeout_ms);
+        channel_args.SetInt(GRPC_ARG_KEEPALIVE_PERMIT_WITHOUT_CALLS,
+                            options_.keepalive_permit_without_calls ? 1 : 0);
+        channel_args.SetInt(GRPC_ARG_HTTP2_MAX_PINGS_WITHOUT_DATA, 0);
+    }
+    if (options_.compression == "gzip") {
+        channel_args.SetCompressionAlgorithm(GRPC_COMPRESS_GZIP);
+    } else if (options_.compression == "deflate") {
+        channel_args.SetCompressionAlgorithm(GRPC_COMPRESS_DEFLATE);
+    }
+    if (options_.max_attempts > 1) {
+        channel_args.SetInt(GRPC_ARG_ENABLE_RETRIES, 1);
+        channel_args.SetServiceConfigJSON(RetryServiceConfig(options_));
+    } else {
+        channel_args.SetInt(GRPC_ARG_ENABLE_RETRIES, 0);
+    }
+    VLOG(5) << "create grpc channel to " << address;
+    return grpc::CreateCustomChannel(
+        address, grpc::InsecureChannelCredentials(), channel_args);
+}
+
+GrpcChannelPool::Entry& GrpcChannelPool::getEntry(const std::string& address) {
+    auto& entry = channels_[address];
+    if (entry.channel == nullptr ||
+            entry.channel->GetState(false) == GRPC_CHANNEL_SHUTDOWN) {
+        entry.channel = createChannel(address);
+        entry.vm_node_stub = nullptr;
+    }
+    return entry;
+}
+
+std::shared_ptr<grpc::Channel> GrpcChannelPool::getChannel(
+        const std::string& address) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    return getEntry(address).channel;
+}
+
+std::shared_ptr<rpc::VMNode::Stub> GrpcChannelPool::getVMNodeStub(
+        const std::string& address) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    auto& entry = getEntry(address);
+    if (entry.vm_node_stub == nullptr) {
+        entry.vm_node_stub = rpc::VMNode::NewStub(entry.channel);
+    }
+    return entry.vm_node_stub;
+}
+
+void GrpcChannelPool::remove(const std::string& address) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    channels_.erase(address);
+}
+
+size_t GrpcChannelPool::size() {
+    std::lock_guard<std::mutex> lck(mtx_);
+    return channels_.size();
+}
+
+}  // namespace primihub
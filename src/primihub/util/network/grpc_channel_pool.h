@@ -0,0 +1,83 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#ifndef SRC_PRIMIHUB_UTIL_NETWORK_GRPC_CHANNEL_POOL_H_
+#define SRC_PRIMIHUB_UTIL_NETWORK_GRPC_CHANNEL_POOL_H_
+
+#include <grpcpp/grpcpp.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "src/primihub/protos/worker.grpc.pb.h"
+
+namespace primihub {
+
+// settings of the "grpc_channel" section in node config
+struct GrpcChannelOptions {
+    int max_message_size{128 * 1024 * 1024};  // bytes, send and receive
+    int keepalive_time_ms{60000};
+    int keepalive_timeout_ms{20000};
+    bool keepalive_permit_without_calls{false};
+    std::string compression{"none"};  // none, deflate or gzip
+    int max_attempts{3};               // idempotent calls only, 1 disables retry
+    int initial_backoff_ms{200};
+    int max_backoff_ms{2000};
+};
+
+/**
+ * Node wide pool of gRPC channels to peer nodes, keyed by peer address.
+ * A channel multiplexes all calls to its peer over one HTTP/2 connection
+ * and reconnects by itself, so channels and stubs are created once and
+ * shared by every scheduler and task of the node.
+ */
+class GrpcChannelPool {
+ public:
+    static GrpcChannelPool& getInstance() {
+        static GrpcChannelPool kSingleInstance;
+        return kSingleInstance;
+    }
+
+    // channels created before are dropped, new calls use the new options
+    void setOptions(const GrpcChannelOptions& options);
+    GrpcChannelOptions options();
+
+    std::shared_ptr<grpc::Channel> getChannel(const std::string& address);
+    std::shared_ptr<rpc::VMNode::Stub> getVMNodeStub(const std::string& address);
+    void remove(const std::string& address);
+    size_t size();
+
+ private:
+    struct Entry {
+        std::shared_ptr<grpc::Channel> channel;
+        std::shared_ptr<rpc::VMNode::Stub> vm_node_stub;
+    };
+
+    GrpcChannelPool() = default;
+    // both must be called with mtx_ held
+    std::shared_ptr<grpc::Channel> createChannel(const std::string& address);
+    Entry& getEntry(const std::string& address);
+
+    std::mutex mtx_;
+    GrpcChannelOptions options_;
+    std::unordered_map<std::string, Entry> channels_;
+};
+
+}  // namespace primihub
+
+#endif  // SRC_PRIMIHUB_UTIL_NETWORK_GRPC_CHANNEL_POOL_H_
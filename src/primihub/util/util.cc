@@ -17,6 +17,8 @@
 
 #include "src/primihub/util/util.h"
 
+#include <array>
+
 namespace primihub {
 
 void str_split(const std::string& str, std::vector<std::string>* v,
@@ -62,4 +64,24 @@ void sort_peers(std::vector<std::string>* peers) {
   }
 }
 
+uint32_t crc32_update(uint32_t crc, const void* data, size_t len) {
+  static const auto crc_table = [] {
+    std::array<uint32_t, 256> table;
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++) {
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      }
+      table[i] = c;
+    }
+    return table;
+  }();
+  auto buf = static_cast<const uint8_t*>(data);
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc = crc_table[(crc ^ buf[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
 }  // namespace primihub
@@ -32,6 +32,9 @@ void peer_to_list(const std::vector<std::string>& peer,
 
 void sort_peers(std::vector<std::string>* peers);
 
+// CRC-32 (IEEE 802.3) of data continued from crc, start with crc = 0
+uint32_t crc32_update(uint32_t crc, const void* data, size_t len);
+
 
 class IOService;
 
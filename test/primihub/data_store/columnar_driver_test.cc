@@ -0,0 +1,116 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include <fstream>
+#include <string>
+
+#include <arrow/api.h>
+
+#include "gtest/gtest.h"
+#include "src/primihub/data_store/factory.h"
+
+namespace primihub {
+
+// convert a csv file with columns id, value into file_path
+static void writeColumnar(const std::string &file_path, int64_t num_rows) {
+  std::string csv_path = "columnar_driver_test.csv";
+  std::ofstream out(csv_path);
+  out << "id,value\n";
+  for (int64_t i = 0; i < num_rows; i++) {
+    out << i << "," << i * 2 << "\n";
+  }
+  out.close();
+
+  auto csv_driver = DataDirverFactory::getDriver("CSV", "test address");
+  auto csv_cursor = std::dynamic_pointer_cast<CSVCursor>(csv_driver->read(csv_path));
+  // many small batches, so the columnar file has many batches / row groups
+  csv_cursor->setBlockSize(1 << 10);
+  auto driver = DataDirverFactory::getDriver(
+      DataDirverFactory::getDriverNameByPath(file_path), "test address");
+  ASSERT_EQ(driver->initCursor(file_path)->writeBatches(csv_cursor->readBatches()), 0);
+}
+
+static void checkRange(const std::shared_ptr<Dataset> &ds, int64_t first,
+                       int64_t num_rows) {
+  ASSERT_NE(ds, nullptr);
+  auto table = std::get<std::shared_ptr<arrow::Table>>(ds->data);
+  ASSERT_EQ(table->num_rows(), num_rows);
+  auto column = table->GetColumnByName("id");
+  ASSERT_NE(column, nullptr);
+  int64_t expected = first;
+  for (const auto &chunk : column->chunks()) {
+    auto array = std::static_pointer_cast<arrow::Int64Array>(chunk);
+    for (int64_t i = 0; i < array->length(); i++) {
+      ASSERT_EQ(array->Value(i), expected++);
+    }
+  }
+}
+
+class ColumnarDriverTest : public ::testing::TestWithParam<std::string> {};
+
+TEST_P(ColumnarDriverTest, ReadWrite) {
+  std::string file_path = "columnar_driver_test" + GetParam();
+  writeColumnar(file_path, 1000);
+
+  auto driver = DataDirverFactory::getDriver(
+      DataDirverFactory::getDriverNameByPath(file_path), "test address");
+  auto &cursor = driver->read(file_path);
+  checkRange(cursor->read(), 0, 1000);
+  checkRange(cursor->read(150, 300), 150, 300);
+  // limit beyond the end of file returns the remaining rows.
+  checkRange(cursor->read(900, 500), 900, 100);
+  // offset beyond the end of file returns an empty table.
+  checkRange(cursor->read(2000, 10), 2000, 0);
+
+  int64_t total = 0;
+  auto reader = cursor->readBatches();
+  ASSERT_NE(reader, nullptr);
+  std::shared_ptr<arrow::RecordBatch> batch;
+  while (reader->ReadNext(&batch).ok() && batch != nullptr) {
+    total += batch->num_rows();
+  }
+  EXPECT_EQ(total, 1000);
+
+  // write() replaces the file with the given dataset
+  auto half = cursor->read(0, 500);
+  ASSERT_EQ(cursor->write(half), 0);
+  checkRange(driver->read(file_path)->read(), 0, 500);
+}
+
+TEST_P(ColumnarDriverTest, ColumnProjection) {
+  std::string file_path = "columnar_driver_projection_test" + GetParam();
+  writeColumnar(file_path, 100);
+
+  auto driver = DataDirverFactory::getDriver(
+      DataDirverFactory::getDriverNameByPath(file_path), "test address");
+  auto &cursor = driver->read(file_path);
+  if (auto ipc_cursor = std::dynamic_pointer_cast<IPCCursor>(cursor)) {
+    ipc_cursor->setColumns({"value"});
+  } else {
+    std::dynamic_pointer_cast<ParquetCursor>(cursor)->setColumns({"value"});
+  }
+  auto ds = cursor->read();
+  ASSERT_NE(ds, nullptr);
+  auto table = std::get<std::shared_ptr<arrow::Table>>(ds->data);
+  ASSERT_EQ(table->num_columns(), 1);
+  EXPECT_EQ(table->schema()->field(0)->name(), "value");
+  EXPECT_EQ(table->num_rows(), 100);
+}
+
+INSTANTIATE_TEST_SUITE_P(Formats, ColumnarDriverTest,
+                         ::testing::Values(".arrow", ".parquet"));
+
+} // namespace primihub
@@ -0,0 +1,122 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include <fstream>
+#include <string>
+
+#include <arrow/api.h>
+
+#include "gtest/gtest.h"
+#include "src/primihub/data_store/csv/csv_driver.h"
+#include "src/primihub/data_store/factory.h"
+
+namespace primihub {
+
+static std::string writeTestCSV(int64_t num_rows) {
+  std::string file_path = "csv_driver_test.csv";
+  std::ofstream out(file_path);
+  out << "id,value\n";
+  for (int64_t i = 0; i < num_rows; i++) {
+    out << i << "," << i * 2 << "\n";
+  }
+  out.close();
+  return file_path;
+}
+
+static std::shared_ptr<CSVCursor> makeCursor(const std::string &file_path) {
+  auto driver = DataDirverFactory::getDriver("CSV", "test address");
+  auto cursor = std::dynamic_pointer_cast<CSVCursor>(driver->read(file_path));
+  // use a tiny block so that the file is split into many batches.
+  cursor->setBlockSize(1 << 10);
+  return cursor;
+}
+
+TEST(CSVDriverTest, ReadAll) {
+  auto file_path = writeTestCSV(1000);
+  auto cursor = makeCursor(file_path);
+  auto ds = cursor->read();
+  ASSERT_NE(ds, nullptr);
+  auto table = std::get<std::shared_ptr<arrow::Table>>(ds->data);
+  EXPECT_EQ(table->num_rows(), 1000);
+  EXPECT_EQ(table->num_columns(), 2);
+  EXPECT_GT(table->column(0)->num_chunks(), 1);
+}
+
+TEST(CSVDriverTest, ReadOffsetLimit) {
+  auto file_path = writeTestCSV(1000);
+  auto cursor = makeCursor(file_path);
+  auto ds = cursor->read(150, 300);
+  ASSERT_NE(ds, nullptr);
+  auto table = std::get<std::shared_ptr<arrow::Table>>(ds->data);
+  ASSERT_EQ(table->num_rows(), 300);
+  auto column = table->column(0);
+  auto first_chunk =
+      std::static_pointer_cast<arrow::Int64Array>(column->chunk(0));
+  auto last_chunk = std::static_pointer_cast<arrow::Int64Array>(
+      column->chunk(column->num_chunks() - 1));
+  EXPECT_EQ(first_chunk->Value(0), 150);
+  EXPECT_EQ(last_chunk->Value(last_chunk->length() - 1), 449);
+
+  // limit beyond the end of file returns the remaining rows.
+  ds = cursor->read(900, 500);
+  table = std::get<std::shared_ptr<arrow::Table>>(ds->data);
+  EXPECT_EQ(table->num_rows(), 100);
+
+  // offset beyond the end of file returns an empty table.
+  ds = cursor->read(2000, 10);
+  table = std::get<std::shared_ptr<arrow::Table>>(ds->data);
+  EXPECT_EQ(table->num_rows(), 0);
+}
+
+TEST(CSVDriverTest, ReadBatches) {
+  auto file_path = writeTestCSV(1000);
+  auto cursor = makeCursor(file_path);
+  auto reader = cursor->readBatches();
+  ASSERT_NE(reader, nullptr);
+  int64_t num_rows = 0;
+  int num_batches = 0;
+  std::shared_ptr<arrow::RecordBatch> batch;
+  while (reader->ReadNext(&batch).ok() && batch != nullptr) {
+    num_rows += batch->num_rows();
+    num_batches++;
+  }
+  EXPECT_EQ(num_rows, 1000);
+  EXPECT_GT(num_batches, 1);
+}
+
+TEST(CSVDriverTest, InferTypesAcrossBlocks) {
+  std::string file_path = "csv_driver_infer_test.csv";
+  std::ofstream out(file_path);
+  out << "id,score,name\n";
+  for (int64_t i = 0; i < 1000; i++) {
+    out << i << "," << i << "," << i << "\n";
+  }
+  // contradicts the types of the first block
+  out << "1000,0.5,alice\n";
+  out.close();
+
+  auto cursor = makeCursor(file_path);
+  auto ds = cursor->read();
+  ASSERT_NE(ds, nullptr);
+  auto table = std::get<std::shared_ptr<arrow::Table>>(ds->data);
+  EXPECT_EQ(table->num_rows(), 1001);
+  auto schema = table->schema();
+  EXPECT_EQ(schema->field(0)->type()->id(), arrow::Type::INT64);
+  EXPECT_EQ(schema->field(1)->type()->id(), arrow::Type::DOUBLE);
+  EXPECT_EQ(schema->field(2)->type()->id(), arrow::Type::STRING);
+}
+
+}  // namespace primihub
@@ -0,0 +1,86 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include <arrow/api.h>
+
+#include "gtest/gtest.h"
+#include "src/primihub/data_store/key_column.h"
+
+namespace primihub {
+
+TEST(KeyColumnTest, MultiChunkStringColumn) {
+  arrow::StringBuilder builder;
+  std::shared_ptr<arrow::Array> chunk0, chunk1;
+  ASSERT_TRUE(builder.AppendValues({"a", "b", "c"}).ok());
+  ASSERT_TRUE(builder.Finish(&chunk0).ok());
+  ASSERT_TRUE(builder.AppendValues({"d", "e"}).ok());
+  ASSERT_TRUE(builder.Finish(&chunk1).ok());
+  auto schema = arrow::schema({arrow::field("key", arrow::utf8())});
+  auto column = std::make_shared<arrow::ChunkedArray>(
+      arrow::ArrayVector{chunk0, chunk1});
+  auto table = arrow::Table::Make(schema, {column});
+
+  KeyColumn keys;
+  ASSERT_EQ(keys.load(table, 0), 5);
+  EXPECT_EQ(keys[0], "a");
+  EXPECT_EQ(keys[4], "e");
+
+  ASSERT_EQ(keys.load(table, 0, 4), 4);
+  EXPECT_EQ(keys[3], "d");
+
+  EXPECT_EQ(keys.load(table, 1), -1);
+}
+
+TEST(KeyColumnTest, NumericColumn) {
+  arrow::Int64Builder builder;
+  std::shared_ptr<arrow::Array> array;
+  ASSERT_TRUE(builder.AppendValues({10, 20, 30}).ok());
+  ASSERT_TRUE(builder.Finish(&array).ok());
+  auto schema = arrow::schema({arrow::field("id", arrow::int64())});
+  auto table = arrow::Table::Make(schema, {array});
+
+  KeyColumn keys;
+  ASSERT_EQ(keys.load(table, 0), 3);
+  auto strs = keys.toStrings();
+  EXPECT_EQ(strs[0], "10");
+  EXPECT_EQ(strs[2], "30");
+}
+
+TEST(KeyColumnTest, SelectIntersectionAndDifference) {
+  arrow::StringBuilder builder;
+  std::shared_ptr<arrow::Array> array;
+  ASSERT_TRUE(builder.AppendValues({"a", "b", "c", "d", "e"}).ok());
+  ASSERT_TRUE(builder.Finish(&array).ok());
+  auto schema = arrow::schema({arrow::field("key", arrow::utf8())});
+  auto table = arrow::Table::Make(schema, {array});
+
+  KeyColumn keys;
+  ASSERT_EQ(keys.load(table, 0), 5);
+  std::vector<int64_t> hits{3, 0};
+  auto intersection = keys.select(hits);
+  ASSERT_EQ(intersection->length(), 2);
+  auto chunk = std::static_pointer_cast<arrow::StringArray>(intersection->chunk(0));
+  EXPECT_EQ(chunk->GetString(0), "a");
+  EXPECT_EQ(chunk->GetString(1), "d");
+
+  auto difference = keys.select(hits, true);
+  ASSERT_EQ(difference->length(), 3);
+  chunk = std::static_pointer_cast<arrow::StringArray>(difference->chunk(0));
+  EXPECT_EQ(chunk->GetString(0), "b");
+  EXPECT_EQ(chunk->GetString(2), "e");
+}
+
+}  // namespace primihub
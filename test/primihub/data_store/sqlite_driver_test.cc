@@ -0,0 +1,155 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include <cstdio>
+#include <string>
+
+#include <arrow/api.h>
+
+#include "gtest/gtest.h"
+#include "SQLiteCpp/SQLiteCpp.h"
+#include "src/primihub/data_store/factory.h"
+
+namespace primihub {
+
+// table with columns id, value and name, id is the row number
+static std::shared_ptr<arrow::Table> makeTable(int64_t num_rows) {
+  arrow::Int64Builder id_builder;
+  arrow::DoubleBuilder value_builder;
+  arrow::StringBuilder name_builder;
+  for (int64_t i = 0; i < num_rows; i++) {
+    EXPECT_TRUE(id_builder.Append(i).ok());
+    EXPECT_TRUE(value_builder.Append(i * 0.5).ok());
+    EXPECT_TRUE(name_builder.Append("name_" + std::to_string(i)).ok());
+  }
+  std::shared_ptr<arrow::Array> ids, values, names;
+  EXPECT_TRUE(id_builder.Finish(&ids).ok());
+  EXPECT_TRUE(value_builder.Finish(&values).ok());
+  EXPECT_TRUE(name_builder.Finish(&names).ok());
+  auto schema = arrow::schema({arrow::field("id", arrow::int64()),
+                               arrow::field("value", arrow::float64()),
+                               arrow::field("name", arrow::utf8())});
+  return arrow::Table::Make(schema, {ids, values, names});
+}
+
+static int writeTable(const std::string &db_path, int64_t num_rows) {
+  auto driver = DataDirverFactory::getDriver("SQLITE", "test address");
+  auto &cursor = driver->initCursor("sqlite#" + db_path + "#test_table");
+  if (cursor == nullptr) {
+    return -1;
+  }
+  auto dataset = std::make_shared<Dataset>(makeTable(num_rows), driver);
+  return cursor->write(dataset);
+}
+
+static void checkRange(const std::shared_ptr<Dataset> &ds, int64_t first,
+                       int64_t num_rows) {
+  ASSERT_NE(ds, nullptr);
+  auto table = std::get<std::shared_ptr<arrow::Table>>(ds->data);
+  ASSERT_EQ(table->num_rows(), num_rows);
+  ASSERT_EQ(table->num_columns(), 3);
+  EXPECT_TRUE(table->schema()->field(0)->type()->Equals(arrow::int64()));
+  EXPECT_TRUE(table->schema()->field(1)->type()->Equals(arrow::float64()));
+  EXPECT_TRUE(table->schema()->field(2)->type()->Equals(arrow::utf8()));
+  int64_t expected = first;
+  for (int c = 0; c < table->column(0)->num_chunks(); c++) {
+    auto ids = std::static_pointer_cast<arrow::Int64Array>(
+        table->column(0)->chunk(c));
+    auto values = std::static_pointer_cast<arrow::DoubleArray>(
+        table->column(1)->chunk(c));
+    auto names = std::static_pointer_cast<arrow::StringArray>(
+        table->column(2)->chunk(c));
+    for (int64_t i = 0; i < ids->length(); i++, expected++) {
+      ASSERT_EQ(ids->Value(i), expected);
+      ASSERT_DOUBLE_EQ(values->Value(i), expected * 0.5);
+      ASSERT_EQ(names->GetString(i), "name_" + std::to_string(expected));
+    }
+  }
+}
+
+// 1000 rows take several full multi-row INSERTs and a shorter last one
+TEST(SQLiteDriverTest, WriteThenRead) {
+  std::string db_path = "sqlite_driver_test.db";
+  std::remove(db_path.c_str());
+  ASSERT_EQ(writeTable(db_path, 1000), 0);
+
+  auto driver = DataDirverFactory::getDriver("SQLITE", "test address");
+  auto &cursor = driver->read("sqlite#" + db_path + "#test_table");
+  ASSERT_NE(cursor, nullptr);
+  checkRange(cursor->read(), 0, 1000);
+}
+
+TEST(SQLiteDriverTest, ReadOffsetLimit) {
+  std::string db_path = "sqlite_driver_range_test.db";
+  std::remove(db_path.c_str());
+  ASSERT_EQ(writeTable(db_path, 1000), 0);
+
+  auto driver = DataDirverFactory::getDriver("SQLITE", "test address");
+  auto &cursor = driver->read("sqlite#" + db_path + "#test_table");
+  ASSERT_NE(cursor, nullptr);
+  checkRange(cursor->read(150, 300), 150, 300);
+  // limit beyond the last row returns the remaining rows.
+  checkRange(cursor->read(900, 500), 900, 100);
+  // a negative limit reads until the last row.
+  checkRange(cursor->read(990, -1), 990, 10);
+  // offset beyond the last row returns an empty table.
+  checkRange(cursor->read(2000, 10), 2000, 0);
+}
+
+// the rows of one write are committed together or not at all
+TEST(SQLiteDriverTest, WriteIsOneTransaction) {
+  std::string db_path = "sqlite_driver_txn_test.db";
+  std::remove(db_path.c_str());
+  {
+    SQLite::Database db(db_path, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
+    db.exec("CREATE TABLE test_table (id INTEGER UNIQUE, value REAL, name TEXT)");
+    db.exec("INSERT INTO test_table VALUES (700, 0, 'taken')");
+  }
+  // row 700 breaks the unique id, after rows of earlier INSERTs succeeded
+  EXPECT_NE(writeTable(db_path, 1000), 0);
+
+  SQLite::Database db(db_path, SQLite::OPEN_READONLY);
+  EXPECT_EQ(db.execAndGet("SELECT count(*) FROM test_table").getInt(), 1);
+}
+
+TEST(SQLiteDriverTest, QueryConditionPassedThrough) {
+  std::string db_path = "sqlite_driver_query_test.db";
+  std::remove(db_path.c_str());
+  ASSERT_EQ(writeTable(db_path, 10), 0);
+
+  auto driver = DataDirverFactory::getDriver("SQLITE", "test address");
+  auto &cursor = driver->read("sqlite#" + db_path +
+                              "#test_table#id, max(value, 1) AS bounded");
+  ASSERT_NE(cursor, nullptr);
+  auto ds = cursor->read();
+  ASSERT_NE(ds, nullptr);
+  auto table = std::get<std::shared_ptr<arrow::Table>>(ds->data);
+  ASSERT_EQ(table->num_columns(), 2);
+  EXPECT_EQ(table->schema()->field(0)->name(), "id");
+  EXPECT_EQ(table->schema()->field(1)->name(), "bounded");
+  EXPECT_EQ(table->num_rows(), 10);
+}
+
+TEST(SQLiteDriverTest, ReadOpensReadOnly) {
+  std::string db_path = "sqlite_driver_missing_test.db";
+  std::remove(db_path.c_str());
+  auto driver = DataDirverFactory::getDriver("SQLITE", "test address");
+  EXPECT_EQ(driver->read("sqlite#" + db_path + "#test_table"), nullptr);
+  // reading never creates the db
+  EXPECT_EQ(std::fopen(db_path.c_str(), "r"), nullptr);
+}
+
+} // namespace primihub
@@ -0,0 +1,183 @@
+#include <string>
+#include <vector>
+
+#include "src/primihub/executor/express.h"
+#include "gtest/gtest.h"
+
+namespace primihub {
+
+// Builds the express graph of party 0 without a MPC runtime. Column A and B
+// belong to party 0, column C belongs to party 1.
+class MPCExpressExecutorTest : public ::testing::Test {
+protected:
+  using Executor = MPCExpressExecutor<D32>;
+  using ExprNode = Executor::ExprNode;
+  using TokenValue = Executor::TokenValue;
+
+  int build(const std::string &expr, bool is_fp64) {
+    exec_.initColumnConfig(0);
+    exec_.importColumnOwner("A", 0);
+    exec_.importColumnOwner("B", 0);
+    exec_.importColumnOwner("C", 1);
+    for (auto col : {"A", "B", "C"})
+      exec_.importColumnDtype(col, is_fp64);
+
+    if (exec_.importExpress(expr) || exec_.resolveRunMode())
+      return -1;
+
+    exec_.InitFeedDict();
+    if (exec_.isFP64RunMode()) {
+      std::vector<double> a = {1.0, 2.0, 3.0};
+      std::vector<double> b = {4.0, 5.0, 6.0};
+      exec_.importColumnValues("A", a);
+      exec_.importColumnValues("B", b);
+    } else {
+      std::vector<int64_t> a = {1, 2, 3};
+      std::vector<int64_t> b = {4, 5, 6};
+      exec_.importColumnValues("A", a);
+      exec_.importColumnValues("B", b);
+    }
+
+    return exec_.buildExprGraph(nodes_, root_);
+  }
+
+  std::vector<size_t> operators(void) {
+    std::vector<size_t> ops;
+    for (size_t i = 0; i < nodes_.size(); i++)
+      if (nodes_[i].left != -1)
+        ops.emplace_back(i);
+    return ops;
+  }
+
+  size_t countToken(const std::string &token) {
+    size_t count = 0;
+    for (auto &node : nodes_)
+      if (node.token == token)
+        count++;
+    return count;
+  }
+
+  std::map<std::string, TokenValue> &tokenValues(void) {
+    return exec_.token_val_map_;
+  }
+
+  si64Matrix *newI64Share(void) { return exec_.newI64Share(); }
+
+  void releaseShare(const std::string &token) { exec_.releaseShare(token); }
+
+  size_t i64PoolSize(void) { return exec_.i64_share_pool_.size(); }
+
+  Executor exec_;
+  std::vector<ExprNode> nodes_;
+  int root_ = -1;
+};
+
+TEST_F(MPCExpressExecutorTest, foldI64Constant) {
+  ASSERT_EQ(build("A+2*3", false), 0);
+
+  auto ops = operators();
+  ASSERT_EQ(ops.size(), 1u);
+  ExprNode &add = nodes_[ops[0]];
+  EXPECT_EQ(add.token, "+");
+  EXPECT_EQ(add.level, 1);
+  EXPECT_EQ(static_cast<int>(ops[0]), root_);
+
+  TokenValue &folded = nodes_[add.right].val;
+  EXPECT_EQ(folded.type, 3);
+  EXPECT_EQ(folded.val_union.i64_val, 6);
+}
+
+TEST_F(MPCExpressExecutorTest, foldFP64Constant) {
+  ASSERT_EQ(build("A*(1.5+0.5)", true), 0);
+
+  auto ops = operators();
+  ASSERT_EQ(ops.size(), 1u);
+  ExprNode &mul = nodes_[ops[0]];
+  EXPECT_EQ(mul.token, "*");
+
+  TokenValue &folded = nodes_[mul.right].val;
+  EXPECT_EQ(folded.type, 2);
+  EXPECT_DOUBLE_EQ(folded.val_union.fp64_val, 2.0);
+}
+
+TEST_F(MPCExpressExecutorTest, rejectConstantExpress) {
+  EXPECT_NE(build("2+3", false), 0);
+}
+
+TEST_F(MPCExpressExecutorTest, reuseCommutedSubExpress) {
+  ASSERT_EQ(build("A*B+B*A", false), 0);
+
+  auto ops = operators();
+  ASSERT_EQ(ops.size(), 2u);
+  ExprNode &add = nodes_[root_];
+  EXPECT_EQ(add.token, "+");
+  EXPECT_EQ(add.left, add.right);
+
+  // The product is read by the level of the add, its share is released
+  // after that level.
+  ExprNode &mul = nodes_[add.left];
+  EXPECT_EQ(mul.token, "*");
+  EXPECT_EQ(mul.last_use, add.level);
+  EXPECT_EQ(add.last_use, -1);
+
+  // Every column has only one node, so it's shared once.
+  EXPECT_EQ(countToken("A"), 1u);
+  EXPECT_EQ(countToken("B"), 1u);
+}
+
+TEST_F(MPCExpressExecutorTest, keepOrderOfSubtract) {
+  ASSERT_EQ(build("(A-C)*(C-A)", false), 0);
+
+  auto ops = operators();
+  EXPECT_EQ(ops.size(), 3u);
+  EXPECT_EQ(countToken("-"), 2u);
+  EXPECT_EQ(countToken("A"), 1u);
+  EXPECT_EQ(countToken("C"), 1u);
+  EXPECT_EQ(nodes_[root_].level, 2);
+}
+
+TEST_F(MPCExpressExecutorTest, operatorsHaveNoValueBeforeEvaluate) {
+  ASSERT_EQ(build("A*B+C", false), 0);
+
+  for (auto idx : operators()) {
+    EXPECT_EQ(nodes_[idx].val.type, 7);
+    EXPECT_EQ(tokenValues().count(nodes_[idx].name), 0u);
+  }
+  EXPECT_EQ(tokenValues().at("A").type, 1);
+  EXPECT_EQ(tokenValues().at("C").type, 4);
+
+  // Nothing is evaluated, Clean must not free any share.
+  exec_.Clean();
+  EXPECT_TRUE(tokenValues().empty());
+}
+
+TEST_F(MPCExpressExecutorTest, releasedShareIsReused) {
+  ASSERT_EQ(build("A*B", false), 0);
+
+  si64Matrix *share = newI64Share();
+  ASSERT_NE(share, nullptr);
+  EXPECT_EQ(share->rows(), 3u);
+  TokenValue val;
+  val.type = 6;
+  val.val_union.sh_i64_m = share;
+  tokenValues()["(A*B)"] = val;
+
+  releaseShare("(A*B)");
+  EXPECT_EQ(tokenValues().count("(A*B)"), 0u);
+  EXPECT_EQ(i64PoolSize(), 1u);
+
+  // Release a value which isn't a share keeps it.
+  releaseShare("A");
+  EXPECT_EQ(tokenValues().count("A"), 1u);
+  EXPECT_EQ(i64PoolSize(), 1u);
+
+  EXPECT_EQ(newI64Share(), share);
+  EXPECT_EQ(i64PoolSize(), 0u);
+
+  // Clean frees the shares in the pool.
+  tokenValues()["(A*B)"] = val;
+  releaseShare("(A*B)");
+  EXPECT_EQ(i64PoolSize(), 1u);
+}
+
+} // namespace primihub
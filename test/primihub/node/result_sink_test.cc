@@ -0,0 +1,119 @@
+#include "gtest/gtest.h"
+
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "src/primihub/node/result_sink.h"
+#include "src/primihub/util/util.h"
+
+using namespace primihub;
+
+namespace {
+bool exists(const std::string& path) {
+  struct stat st;
+  return ::stat(path.c_str(), &st) == 0;
+}
+
+std::string readFile(const std::string& path) {
+  std::ifstream in(path);
+  std::stringstream ss;
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+ResultSink::Rows makeRows(std::initializer_list<std::string> values) {
+  ResultSink::Rows rows;
+  for (const auto& value : values) {
+    *rows.Add() = value;
+  }
+  return rows;
+}
+
+class ResultSinkTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    dir_ = ::testing::TempDir() + "/result_sink_test.XXXXXX";
+    ASSERT_NE(mkdtemp(&dir_[0]), nullptr);
+  }
+  void TearDown() override {
+    std::string cmd = "rm -rf " + dir_;
+    ASSERT_EQ(system(cmd.c_str()), 0);
+  }
+
+  std::string dir_;
+};
+}  // namespace
+
+// nothing shows up at the result path before the commit
+TEST_F(ResultSinkTest, commitRenamesTmpFile) {
+  std::string path = dir_ + "/result.csv";
+  auto sink = ResultSink::Create(path);
+  ASSERT_NE(sink, nullptr);
+  ASSERT_EQ(sink->append(makeRows({"\"col\"", "a"})), 0);
+  ASSERT_EQ(sink->append(makeRows({"b"})), 0);
+  EXPECT_TRUE(exists(path + ".tmp"));
+  EXPECT_FALSE(exists(path));
+
+  ASSERT_EQ(sink->finish(true), 0);
+  EXPECT_FALSE(exists(path + ".tmp"));
+  EXPECT_EQ(readFile(path), "\"col\"\na\nb\n");
+}
+
+TEST_F(ResultSinkTest, discardRemovesTmpFile) {
+  std::string path = dir_ + "/result.csv";
+  auto sink = ResultSink::Create(path);
+  ASSERT_NE(sink, nullptr);
+  ASSERT_EQ(sink->append(makeRows({"\"col\"", "a"})), 0);
+
+  EXPECT_EQ(sink->finish(false), 0);
+  EXPECT_FALSE(exists(path + ".tmp"));
+  EXPECT_FALSE(exists(path));
+}
+
+// an earlier result at the path stays as it was
+TEST_F(ResultSinkTest, failedCommitKeepsOldResult) {
+  std::string path = dir_ + "/result.csv";
+  ASSERT_EQ(::mkdir(path.c_str(), 0755), 0);
+  ASSERT_EQ(::mkdir((path + "/old").c_str(), 0755), 0);
+  auto sink = ResultSink::Create(path);
+  ASSERT_NE(sink, nullptr);
+  ASSERT_EQ(sink->append(makeRows({"\"col\"", "a"})), 0);
+
+  EXPECT_NE(sink->finish(true), 0);
+  EXPECT_FALSE(exists(path + ".tmp"));
+  EXPECT_TRUE(exists(path + "/old"));
+}
+
+// the sender and the receiver agree, and both match the stored file
+TEST_F(ResultSinkTest, checksumOfStoredRows) {
+  ResultSink::Checksum sent;
+  ResultSink::Rows chunk;
+  for (const std::string row : {"\"col\"", "a", "b"}) {
+    sent.addRow(&chunk, row.data(), row.size());
+  }
+  ASSERT_EQ(chunk.size(), 3);
+  EXPECT_EQ(chunk.Get(2), "b");
+  EXPECT_EQ(sent.value(), "2983648107");
+
+  ResultSink::Checksum received;
+  received.add(makeRows({"\"col\"", "a"}));
+  received.add(makeRows({"b"}));
+  EXPECT_EQ(received.value(), sent.value());
+
+  std::string path = dir_ + "/result.csv";
+  auto sink = ResultSink::Create(path);
+  ASSERT_NE(sink, nullptr);
+  ASSERT_EQ(sink->append(chunk), 0);
+  ASSERT_EQ(sink->finish(true), 0);
+  std::string content = readFile(path);
+  EXPECT_EQ(std::to_string(crc32_update(0, content.data(), content.size())),
+            sent.value());
+
+  ResultSink::Checksum changed;
+  changed.add(makeRows({"\"col\"", "a", "c"}));
+  EXPECT_NE(changed.value(), sent.value());
+}
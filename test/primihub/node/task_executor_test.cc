@@ -0,0 +1,154 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "src/primihub/node/task_executor.h"
+
+using namespace primihub;
+
+namespace {
+// wait for the future from inside a job, gives up on cancel or timeout
+int waitParty(const TaskExecutor::Token& token, std::future<int>* party) {
+  auto start = std::chrono::steady_clock::now();
+  while (party->wait_for(std::chrono::milliseconds(5)) !=
+         std::future_status::ready) {
+    if (token->isCancelled() ||
+        std::chrono::steady_clock::now() - start > std::chrono::seconds(5)) {
+      return -1;
+    }
+  }
+  return party->get();
+}
+
+bool waitFor(const std::function<bool()>& done) {
+  auto start = std::chrono::steady_clock::now();
+  while (!done()) {
+    if (std::chrono::steady_clock::now() - start > std::chrono::seconds(10)) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  return true;
+}
+}  // namespace
+
+TEST(TaskExecutor_Test, jobKeySeparatesSchedulerAndPartyTask) {
+  auto scheduler_key = TaskExecutor::jobKey("job", "task", rpc::TaskType::PSI_TASK);
+  auto party_key = TaskExecutor::jobKey("job", "task", rpc::TaskType::NODE_PSI_TASK);
+  EXPECT_NE(scheduler_key, party_key);
+  EXPECT_EQ(party_key, "jobtask");
+  EXPECT_EQ(scheduler_key,
+            TaskExecutor::jobKey("job", "task", rpc::TaskType::ACTOR_TASK));
+  EXPECT_TRUE(TaskExecutor::isScheduler(rpc::TaskType::TEE_TASK));
+  EXPECT_FALSE(TaskExecutor::isScheduler(rpc::TaskType::NODE_TASK));
+}
+
+// the scheduling node is one of the parties of its own task
+TEST(TaskExecutor_Test, schedulerAndOwnPartyTaskOnSameNode) {
+  TaskExecutor::Options options;
+  options.worker_num = 2;
+  TaskExecutor executor(options);
+
+  std::atomic<int> party_admission{-1};
+  std::promise<int> scheduler_done;
+  auto scheduler_job = [&](const TaskExecutor::Token& token) -> int {
+    auto party = std::make_shared<std::promise<int>>();
+    auto party_future = party->get_future();
+    party_admission = executor.submit(
+        TaskExecutor::jobKey("job", "task", rpc::TaskType::NODE_TASK),
+        rpc::TaskType::NODE_TASK, "task", "client",
+        [party](const TaskExecutor::Token&) -> int {
+          party->set_value(0);
+          return 0;
+        });
+    int ret = waitParty(token, &party_future);
+    scheduler_done.set_value(ret);
+    return ret;
+  };
+  auto key = TaskExecutor::jobKey("job", "task", rpc::TaskType::ACTOR_TASK);
+  ASSERT_EQ(executor.submit(key, rpc::TaskType::ACTOR_TASK, "task", "client",
+                            scheduler_job),
+            TaskExecutor::ACCEPTED);
+  auto done = scheduler_done.get_future();
+  ASSERT_EQ(done.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+  EXPECT_EQ(done.get(), 0);
+  EXPECT_EQ(party_admission.load(), TaskExecutor::ACCEPTED);
+}
+
+// schedulers waiting on their party tasks can not take every worker
+TEST(TaskExecutor_Test, schedulersLeaveWorkerForPartyTasks) {
+  TaskExecutor::Options options;
+  options.worker_num = 2;
+  TaskExecutor executor(options);
+
+  constexpr int kNumSchedulers = 4;
+  std::atomic<int> succeeded{0};
+  std::atomic<int> finished{0};
+  for (int i = 0; i < kNumSchedulers; i++) {
+    std::string task_id = "task" + std::to_string(i);
+    auto scheduler_job = [&, task_id](const TaskExecutor::Token& token) -> int {
+      auto party = std::make_shared<std::promise<int>>();
+      auto party_future = party->get_future();
+      executor.submit(
+          TaskExecutor::jobKey("job", task_id, rpc::TaskType::NODE_TASK),
+          rpc::TaskType::NODE_TASK, task_id, "client",
+          [party](const TaskExecutor::Token&) -> int {
+            party->set_value(0);
+            return 0;
+          });
+      int ret = waitParty(token, &party_future);
+      if (ret == 0) {
+        succeeded++;
+      }
+      finished++;
+      return ret;
+    };
+    ASSERT_EQ(executor.submit(
+                  TaskExecutor::jobKey("job", task_id, rpc::TaskType::PSI_TASK),
+                  rpc::TaskType::PSI_TASK, task_id, "client", scheduler_job),
+              TaskExecutor::ACCEPTED);
+  }
+  ASSERT_TRUE(waitFor([&finished] { return finished == kNumSchedulers; }));
+  EXPECT_EQ(succeeded.load(), kNumSchedulers);
+}
+
+TEST(TaskExecutor_Test, duplicatedSubmitIsRunning) {
+  TaskExecutor executor{TaskExecutor::Options()};
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  auto job = [released](const TaskExecutor::Token&) -> int {
+    released.wait();
+    return 0;
+  };
+  auto key = TaskExecutor::jobKey("job", "task", rpc::TaskType::NODE_TASK);
+  ASSERT_EQ(executor.submit(key, rpc::TaskType::NODE_TASK, "task", "client", job),
+            TaskExecutor::ACCEPTED);
+  EXPECT_EQ(executor.submit(key, rpc::TaskType::NODE_TASK, "task", "client", job),
+            TaskExecutor::RUNNING);
+  release.set_value();
+  ASSERT_TRUE(waitFor([&executor, &key] { return !executor.isActive(key); }));
+}
+
+TEST(TaskExecutor_Test, defaultDeadline) {
+  TaskExecutor::Options options;
+  options.default_timeout_ms = 50;
+  TaskExecutor executor(options);
+
+  std::promise<std::string> reason;
+  auto job = [&reason](const TaskExecutor::Token& token) -> int {
+    waitFor([&token] { return token->isCancelled(); });
+    reason.set_value(token->reason());
+    return -1;
+  };
+  ASSERT_EQ(executor.submit("jobtask", rpc::TaskType::NODE_TASK, "task",
+                            "client", job),
+            TaskExecutor::ACCEPTED);
+  auto result = reason.get_future();
+  ASSERT_EQ(result.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+  EXPECT_EQ(result.get(), "deadline exceeded");
+}
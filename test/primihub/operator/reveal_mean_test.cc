@@ -0,0 +1,91 @@
+#include <glog/logging.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "src/primihub/operator/aby3_operator.h"
+#include "gtest/gtest.h"
+
+using namespace primihub;
+
+static void run_mpc(uint64_t party_id, std::string ip, uint16_t next_port,
+                    uint16_t prev_port, std::vector<double> &local_sums,
+                    std::vector<i64> &counts, std::vector<double> &means) {
+  std::string next_name, prev_name;
+  if (party_id == 0) {
+    next_name = "01";
+    prev_name = "02";
+  } else if (party_id == 1) {
+    next_name = "12";
+    prev_name = "01";
+  } else if (party_id == 2) {
+    next_name = "02";
+    prev_name = "12";
+  }
+
+  MPCOperator *mpc_exec = new MPCOperator(party_id, next_name, prev_name);
+  mpc_exec->setup(ip, ip, next_port, prev_port);
+
+  try {
+    means = mpc_exec->revealMeanAll<D16>(local_sums, counts);
+  } catch (std::exception &e) {
+    LOG(ERROR) << "In party " << party_id << ":\n" << e.what() << ".";
+  }
+
+  mpc_exec->fini();
+  delete mpc_exec;
+}
+
+TEST(reveal_mean, split_mean_part) {
+  i64 int_part = 0;
+  double frac_part = 0;
+  ASSERT_EQ(MPCOperator::splitMeanPart(3.0e14 + 0.25, &int_part, &frac_part), 0);
+  EXPECT_EQ(int_part, 300000000000000);
+  EXPECT_DOUBLE_EQ(frac_part, 0.25);
+
+  ASSERT_EQ(MPCOperator::splitMeanPart(-2.25, &int_part, &frac_part), 0);
+  EXPECT_EQ(int_part, -3);
+  EXPECT_DOUBLE_EQ(frac_part, 0.75);
+
+  EXPECT_EQ(MPCOperator::splitMeanPart(1.0e19, &int_part, &frac_part), -1);
+  EXPECT_EQ(MPCOperator::splitMeanPart(-1.0e19, &int_part, &frac_part), -1);
+}
+
+// Column sums far beyond 2^47, where a D16 share of the sum wraps around.
+TEST(reveal_mean, mpc_large_magnitude_mean) {
+  // the second column is held by party 0 only
+  std::vector<double> party_0_sum = {4.0e15 + 0.5, -1.5};
+  std::vector<double> party_1_sum = {6.0e15 + 0.25, 0};
+  std::vector<double> party_2_sum = {-2.0e15, 0};
+  std::vector<i64> counts = {40, 4};
+  std::vector<double> expected = {(8.0e15 + 0.75) / 40, -1.5 / 4};
+
+  pid_t pid = fork();
+  if (pid != 0) {
+    // Party 2.
+    std::vector<double> means;
+    run_mpc(2, "127.0.0.1", 10220, 10230, party_2_sum, counts, means);
+    return;
+  }
+
+  pid = fork();
+  if (pid != 0) {
+    // Party 1.
+    std::vector<double> means;
+    run_mpc(1, "127.0.0.1", 10230, 10210, party_1_sum, counts, means);
+    return;
+  }
+
+  // Party 0.
+  std::vector<double> means;
+  run_mpc(0, "127.0.0.1", 10210, 10220, party_0_sum, counts, means);
+  ASSERT_EQ(means.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    // within the D16 resolution of the fractions and the double one of
+    // the integer part
+    EXPECT_NEAR(means[i], expected[i], std::abs(expected[i]) * 1e-12 + 1e-3)
+        << "column " << i;
+  }
+}
@@ -2,6 +2,7 @@
 
 #include <fstream>
 #include <random>
+#include <thread>
 
 #include "gtest/gtest.h"
 
@@ -367,3 +368,24 @@ TEST(KoggeStone_int_Adder_test, KoggeStone_int_adder) {
         }
     }
 }
+
+TEST(CircuitTest, CircuitCache_Test) {
+    auto& cache = CircuitCache::getInstance();
+    std::vector<BetaCircuit*> cirs(4, nullptr);
+    std::vector<std::thread> threads;
+    for (u64 i = 0; i < cirs.size(); ++i) {
+        threads.emplace_back([&cache, &cirs, i]() {
+            cirs[i] = cache.int_int_add_msb(64);
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    // Built and levelled once, shared by all threads.
+    for (auto* cir : cirs) EXPECT_EQ(cir, cirs[0]);
+    EXPECT_NE(cirs[0]->mLevelCounts.size(), 0);
+    EXPECT_NE(cache.int_int_add_msb(32), cirs[0]);
+
+    auto* piecewise = cache.int_Sh3Piecewise_helper(64, 2);
+    EXPECT_EQ(piecewise, cache.int_Sh3Piecewise_helper(64, 2));
+    EXPECT_NE(piecewise->mLevelCounts.size(), 0);
+}
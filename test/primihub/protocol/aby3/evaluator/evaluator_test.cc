@@ -374,6 +374,45 @@ TEST(EvaluatorTest, Sh3_Evaluator_truncationPai_test) {
   }
 }
 
+TEST(EvaluatorTest, Sh3_Evaluator_preprocess_test) {
+  int size = 4;
+  int trials = 10;
+  auto dec = Decimal::D8;
+
+  // evals consume preprocessed pairs, online ones generate them on demand
+  Sh3Evaluator evals[3], online[3];
+  for (u64 i = 0; i < 3; ++i) {
+    evals[i].init(i, toBlock(1, i), toBlock(1, (i + 1) % 3));
+    online[i].init(i, toBlock(1, i), toBlock(1, (i + 1) % 3));
+    ASSERT_EQ(evals[i].preprocess(size * size * trials, dec),
+              size * size * trials);
+  }
+  EXPECT_EQ(evals[0].mTruncationStore.size(dec), size * size * trials);
+
+  // one more than preprocessed, the last one falls back to online
+  for (u64 t = 0; t <= trials; ++t) {
+    TruncationPair pairs[3];
+    for (u64 i = 0; i < 3; ++i) {
+      pairs[i] = evals[i].getTruncationTuple(size, size, dec);
+      auto expected = online[i].getTruncationTuple(size, size, dec);
+      if (t < trials) {
+        EXPECT_EQ(pairs[i].mR, expected.mR);
+        EXPECT_EQ(pairs[i].mRTrunc.mShares[0], expected.mRTrunc.mShares[0]);
+        EXPECT_EQ(pairs[i].mRTrunc.mShares[1], expected.mRTrunc.mShares[1]);
+      }
+    }
+
+    i64Matrix tr = pairs[0].mRTrunc.mShares[0] + pairs[1].mRTrunc.mShares[0]
+                 + pairs[2].mRTrunc.mShares[0];
+    i64Matrix r = pairs[0].mR + pairs[1].mR + pairs[2].mR;
+    for (u64 i = 0; i < r.size(); ++i) {
+      auto exp = r(i) >> dec;
+      EXPECT_TRUE(tr(i) > exp - 4 && tr(i) < exp + 4);
+    }
+  }
+  EXPECT_EQ(evals[0].mTruncationStore.size(), 0);
+}
+
 TEST(EvaluatorTest, Sh3_Evaluator_asyncMul_matrixFixed_test) {
   IOService ios;
   auto chl01 = Session(ios, "127.0.0.1:1313", SessionMode::Server,
@@ -0,0 +1,59 @@
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+#include "src/primihub/service/dataset/util.hpp"
+
+namespace primihub::service {
+
+TEST(FlightTicketTest, PlainDescription) {
+    FlightTicket ticket;
+    ASSERT_EQ(ParseFlightTicket("train_party_0", &ticket), 0);
+    EXPECT_EQ(ticket.dataset, "train_party_0");
+    EXPECT_TRUE(ticket.columns.empty());
+    EXPECT_EQ(ticket.offset, 0);
+    EXPECT_EQ(ticket.limit, -1);
+}
+
+TEST(FlightTicketTest, AllOptions) {
+    FlightTicket ticket;
+    ASSERT_EQ(ParseFlightTicket("breast_0?columns=id,age,label&offset=100&limit=20",
+                                &ticket), 0);
+    EXPECT_EQ(ticket.dataset, "breast_0");
+    EXPECT_EQ(ticket.columns, (std::vector<std::string>{"id", "age", "label"}));
+    EXPECT_EQ(ticket.offset, 100);
+    EXPECT_EQ(ticket.limit, 20);
+}
+
+TEST(FlightTicketTest, OptionsInAnyOrder) {
+    FlightTicket ticket;
+    ASSERT_EQ(ParseFlightTicket("breast_0?limit=0&columns=id", &ticket), 0);
+    EXPECT_EQ(ticket.columns, (std::vector<std::string>{"id"}));
+    EXPECT_EQ(ticket.offset, 0);
+    EXPECT_EQ(ticket.limit, 0);
+}
+
+TEST(FlightTicketTest, ResetsPreviousResult) {
+    FlightTicket ticket;
+    ASSERT_EQ(ParseFlightTicket("a?columns=x&offset=5&limit=1", &ticket), 0);
+    ASSERT_EQ(ParseFlightTicket("b", &ticket), 0);
+    EXPECT_EQ(ticket.dataset, "b");
+    EXPECT_TRUE(ticket.columns.empty());
+    EXPECT_EQ(ticket.offset, 0);
+    EXPECT_EQ(ticket.limit, -1);
+}
+
+TEST(FlightTicketTest, InvalidTickets) {
+    FlightTicket ticket;
+    EXPECT_EQ(ParseFlightTicket("", &ticket), -1);
+    EXPECT_EQ(ParseFlightTicket("?offset=1", &ticket), -1);
+    EXPECT_EQ(ParseFlightTicket("a?offset", &ticket), -1);
+    EXPECT_EQ(ParseFlightTicket("a?offset=x", &ticket), -1);
+    EXPECT_EQ(ParseFlightTicket("a?offset=5x", &ticket), -1);
+    EXPECT_EQ(ParseFlightTicket("a?limit=", &ticket), -1);
+    EXPECT_EQ(ParseFlightTicket("a?offset=-1", &ticket), -1);
+    EXPECT_EQ(ParseFlightTicket("a?rows=10", &ticket), -1);
+}
+
+}  // namespace primihub::service
@@ -0,0 +1,104 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+// Batched put and point get throughput of the LevelDB meta store.
+// bazel build --config=linux :local_kv_benchmark
+// ./bazel-bin/local_kv_benchmark --meta_num=1000000 --batch_size=1000
+
+#include <stdlib.h>
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "src/primihub/service/dataset/localkv/storage_leveldb.h"
+
+ABSL_FLAG(int64_t, meta_num, 1000000, "metas to put and get");
+ABSL_FLAG(int32_t, batch_size, 1000, "metas of one batch write");
+ABSL_FLAG(int32_t, meta_size, 256, "bytes of one meta");
+ABSL_FLAG(std::string, work_dir, "/tmp", "where the temp db is created");
+
+using namespace primihub::service;
+
+namespace {
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+int run(const std::string& db_path, int64_t meta_num, size_t batch_size,
+        const Value& meta) {
+    StorageBackendLevelDB storage(db_path);
+    std::vector<Key> keys;
+    keys.reserve(meta_num);
+    for (int64_t i = 0; i < meta_num; i++) {
+        keys.emplace_back("bench_meta_" + std::to_string(i));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::pair<Key, Value>> batch;
+    for (int64_t i = 0; i < meta_num; i++) {
+        batch.emplace_back(keys[i], meta);
+        if (batch.size() == batch_size || i + 1 == meta_num) {
+            if (!storage.putValues(batch)) {
+                std::cerr << "put metas failed" << std::endl;
+                return -1;
+            }
+            batch.clear();
+        }
+    }
+    double put_ms = elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < meta_num; i++) {
+        if (!storage.getValue(keys[i]).has_value()) {
+            std::cerr << "get meta " << i << " failed" << std::endl;
+            return -1;
+        }
+    }
+    double get_ms = elapsedMs(start);
+
+    std::cout << meta_num << " meta puts: " << put_ms << " ms, "
+              << meta_num << " meta gets: " << get_ms << " ms" << std::endl;
+    return 0;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    absl::ParseCommandLine(argc, argv);
+    int64_t meta_num = absl::GetFlag(FLAGS_meta_num);
+    int32_t batch_size = absl::GetFlag(FLAGS_batch_size);
+    if (meta_num <= 0 || batch_size <= 0) {
+        std::cerr << "meta_num and batch_size must be positive" << std::endl;
+        return 1;
+    }
+
+    std::string dir = absl::GetFlag(FLAGS_work_dir) + "/local_kv_bench.XXXXXX";
+    if (mkdtemp(&dir[0]) == nullptr) {
+        std::cerr << "create temp dir in " << absl::GetFlag(FLAGS_work_dir)
+                  << " failed" << std::endl;
+        return 1;
+    }
+    int ret = run(dir + "/db", meta_num, batch_size,
+                  Value(absl::GetFlag(FLAGS_meta_size), 'm'));
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    return ret == 0 ? 0 : 1;
+}
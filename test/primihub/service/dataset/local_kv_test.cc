@@ -1,12 +1,37 @@
 
 
+#include <stdlib.h>
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "src/primihub/service/dataset/localkv/storage_leveldb.h"
-#include "src/primihub/service/error.hpp" 
+#include "src/primihub/service/dataset/util.hpp"
+#include "src/primihub/service/error.hpp"
 
 namespace primihub::service {
-TEST(LocalKVLeTest, LevelDB_PutGetErase) {
-    StorageBackendLevelDB storage;
+// every test opens its db in a fresh temp dir, removed when it ends
+class LocalKVLeTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        char dir[] = "/tmp/local_kv_test.XXXXXX";
+        ASSERT_NE(mkdtemp(dir), nullptr);
+        db_dir_ = dir;
+    }
+
+    void TearDown() override {
+        std::error_code ec;
+        std::filesystem::remove_all(db_dir_, ec);
+    }
+
+    std::string db_dir_;
+};
+
+TEST_F(LocalKVLeTest, LevelDB_PutGetErase) {
+    StorageBackendLevelDB storage(db_dir_ + "/db");
     Key key("testkey");
     Value value = "testvalue";
     ASSERT_EQ(storage.putValue(key, value), outcome::success());
@@ -16,4 +41,51 @@ TEST(LocalKVLeTest, LevelDB_PutGetErase) {
     ASSERT_EQ(e.error(), Error::VALUE_NOT_FOUND);
 }
 
+TEST_F(LocalKVLeTest, LevelDB_BatchSnapshot) {
+    StorageBackendLevelDB storage(db_dir_ + "/db");
+    std::vector<std::pair<Key, Value>> kvs;
+    std::map<std::string, Value> expected;
+    for (int i = 0; i < 100; i++) {
+        kvs.emplace_back(Key("batch_key_" + std::to_string(i)), std::to_string(i));
+        expected[Key2Str(kvs.back().first)] = kvs.back().second;
+    }
+    ASSERT_EQ(storage.putValues(kvs), outcome::success());
+
+    auto snapshot = storage.snapshot();
+    Key added("added_key");
+    ASSERT_EQ(storage.putValue(kvs[0].first, "changed"), outcome::success());
+    ASSERT_EQ(storage.putValue(added, "added"), outcome::success());
+    ASSERT_EQ(storage.erase(kvs[1].first), outcome::success());
+    ASSERT_EQ(storage.getValue(kvs[0].first), outcome::success(Value("changed")));
+    ASSERT_EQ(snapshot->getValue(kvs[0].first), outcome::success(Value("0")));
+    ASSERT_EQ(snapshot->getValue(kvs[1].first), outcome::success(Value("1")));
+    ASSERT_EQ(snapshot->getValue(added).error(), Error::VALUE_NOT_FOUND);
+
+    auto collect = [](auto& source, std::map<std::string, Value>* visited) {
+        return source.forEach([visited](const Key& key, const Value& value) {
+            (*visited)[Key2Str(key)] = value;
+            return true;
+        });
+    };
+    // the snapshot holds exactly the batch as it was written
+    std::map<std::string, Value> visited;
+    ASSERT_EQ(collect(*snapshot, &visited), outcome::success());
+    EXPECT_EQ(visited, expected);
+
+    // the db holds the later writes and not the erased key
+    expected[Key2Str(kvs[0].first)] = "changed";
+    expected[Key2Str(added)] = "added";
+    expected.erase(Key2Str(kvs[1].first));
+    visited.clear();
+    ASSERT_EQ(collect(storage, &visited), outcome::success());
+    EXPECT_EQ(visited, expected);
+
+    // returning false stops the iteration
+    size_t count = 0;
+    ASSERT_EQ(storage.forEach([&count](const Key&, const Value&) {
+        return ++count < 10;
+    }), outcome::success());
+    EXPECT_EQ(count, 10u);
+}
+
 } // namespace primihub::service
@@ -0,0 +1,160 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+// Per profile keyword pir latency and communication on a synthetic db.
+// bazel build --config=linux --define microsoft-apsi=true :keyword_pir_benchmark
+// ./bazel-bin/keyword_pir_benchmark --db_size=1000000 --query_batch=16
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "apsi/item.h"
+#include "apsi/network/zmq/zmq_channel.h"
+#include "apsi/receiver.h"
+
+#include "src/primihub/task/semantic/keyword_pir_params.h"
+#include "src/primihub/task/semantic/keyword_pir_sender.h"
+
+ABSL_FLAG(int64_t, db_size, 100000, "sender items");
+ABSL_FLAG(int32_t, label_size, 16, "label bytes");
+ABSL_FLAG(int32_t, query_batch, 1, "items of one query");
+ABSL_FLAG(int32_t, rounds, 5, "queries per profile");
+ABSL_FLAG(int32_t, threads, 0, "sender threads, 0 for all cores");
+ABSL_FLAG(int32_t, port, 12222, "sender port");
+ABSL_FLAG(std::string, profiles, "", "comma separated profiles, empty for all");
+ABSL_FLAG(std::string, work_dir, "/tmp", "where the synthetic db is written");
+
+using namespace primihub::task;
+using apsi::Item;
+using apsi::receiver::Receiver;
+
+namespace {
+std::string itemOf(int64_t i) {
+    return "item_" + std::to_string(i);
+}
+
+int writeDataset(const std::string& path, int64_t db_size, int label_size) {
+    std::ofstream ofs(path, std::ios::trunc);
+    if (!ofs.is_open()) {
+        return -1;
+    }
+    for (int64_t i = 0; i < db_size; i++) {
+        std::string label = std::to_string(i);
+        label.resize(label_size, 'x');
+        ofs << itemOf(i) << "," << label << "\n";
+    }
+    return 0;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    absl::ParseCommandLine(argc, argv);
+    int64_t db_size = absl::GetFlag(FLAGS_db_size);
+    int label_size = absl::GetFlag(FLAGS_label_size);
+    int query_batch = absl::GetFlag(FLAGS_query_batch);
+    int rounds = absl::GetFlag(FLAGS_rounds);
+    int port = absl::GetFlag(FLAGS_port);
+    std::string selected = absl::GetFlag(FLAGS_profiles);
+
+    std::string dataset = absl::GetFlag(FLAGS_work_dir) + "/keyword_pir_benchmark_" +
+                          std::to_string(db_size) + ".csv";
+    if (writeDataset(dataset, db_size, label_size)) {
+        std::cerr << "write " << dataset << " failed" << std::endl;
+        return -1;
+    }
+    auto& sender = KeywordPirSender::getInstance();
+    int threads = absl::GetFlag(FLAGS_threads);
+    sender.setThreadCount(threads > 0 ? threads : std::thread::hardware_concurrency());
+
+    std::mt19937_64 rng(42);
+    std::cout << std::left << std::setw(12) << "profile"
+              << std::setw(12) << "setup_ms" << std::setw(12) << "query_ms"
+              << std::setw(14) << "sent_bytes" << std::setw(14) << "recv_bytes"
+              << std::setw(12) << "est_ms" << std::setw(14) << "est_up"
+              << std::setw(14) << "est_down" << "found" << std::endl;
+    for (const auto& profile : keywordPirProfiles()) {
+        if (!selected.empty() &&
+                ("," + selected + ",").find("," + profile.name + ",") == std::string::npos) {
+            continue;
+        }
+        KeywordPirCost cost;
+        if (estimateKeywordPirCost(profile, db_size, label_size, query_batch, &cost)) {
+            continue;
+        }
+        // a fresh db file per profile, the saved one belongs to another profile
+        std::remove((dataset + ".senderdb").c_str());
+        auto setup_start = std::chrono::steady_clock::now();
+        int ret = sender.serve(dataset, port, profile.name,
+            [&profile, query_batch](size_t, size_t) {
+                return std::make_unique<apsi::PSIParams>(apsi::PSIParams::Load(
+                    keywordPirParamsJson(profile, query_batch)));
+            });
+        if (ret) {
+            std::cerr << "profile " << profile.name << " setup failed" << std::endl;
+            continue;
+        }
+        double setup_ms = elapsedMs(setup_start);
+
+        apsi::network::ZMQReceiverChannel channel;
+        channel.connect("tcp://127.0.0.1:" + std::to_string(port));
+        Receiver receiver(Receiver::RequestParams(channel));
+        uint64_t sent_base = channel.bytes_sent();
+        uint64_t recv_base = channel.bytes_received();
+        double query_ms = 0;
+        size_t found = 0;
+        for (int r = 0; r < rounds; r++) {
+            std::vector<Item> items;
+            std::uniform_int_distribution<int64_t> dist(0, db_size * 2);
+            for (int i = 0; i < query_batch; i++) {
+                items.emplace_back(itemOf(dist(rng)));
+            }
+            auto query_start = std::chrono::steady_clock::now();
+            auto [oprf_items, label_keys] = Receiver::RequestOPRF(items, channel);
+            auto result = receiver.request_query(oprf_items, label_keys, channel);
+            query_ms += elapsedMs(query_start);
+            for (const auto& record : result) {
+                found += record.found;
+            }
+        }
+        std::cout << std::left << std::setw(12) << profile.name
+                  << std::setw(12) << setup_ms << std::setw(12) << query_ms / rounds
+                  << std::setw(14) << (channel.bytes_sent() - sent_base) / rounds
+                  << std::setw(14) << (channel.bytes_received() - recv_base) / rounds
+                  << std::setw(12) << cost.estimated_ms
+                  << std::setw(14) << cost.upload_bytes
+                  << std::setw(14) << cost.download_bytes
+                  << found << "/" << rounds * query_batch << std::endl;
+        channel.disconnect();
+        sender.stop(port);
+    }
+    std::remove((dataset + ".senderdb").c_str());
+    std::remove(dataset.c_str());
+    return 0;
+}
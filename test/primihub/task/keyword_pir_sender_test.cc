@@ -0,0 +1,220 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+// needs --define microsoft-apsi=true
+
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "apsi/item.h"
+#include "apsi/network/zmq/zmq_channel.h"
+#include "apsi/receiver.h"
+
+#include "src/primihub/task/semantic/keyword_pir_params.h"
+#include "src/primihub/task/semantic/keyword_pir_sender.h"
+#include "src/primihub/util/file_util.h"
+
+namespace primihub::task {
+
+namespace {
+// found items and their labels
+using QueryResult = std::map<std::string, std::string>;
+
+std::string itemOf(int i) {
+    return "item_" + std::to_string(i);
+}
+
+std::string readHeader(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    std::string header;
+    std::getline(ifs, header);
+    return header;
+}
+
+std::unique_ptr<apsi::PSIParams> profileParams(const KeywordPirProfile& profile) {
+    return std::make_unique<apsi::PSIParams>(apsi::PSIParams::Load(
+        keywordPirParamsJson(profile, 1)));
+}
+}  // namespace
+
+class KeywordPirSenderTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = ::testing::TempDir() + "/keyword_pir_sender.XXXXXX";
+        ASSERT_NE(mkdtemp(&dir_[0]), nullptr);
+        dataset_ = dir_ + "/dataset.csv";
+        db_file_ = dataset_ + ".senderdb";
+        for (const auto& profile : keywordPirProfiles()) {
+            KeywordPirCost cost;
+            if (estimateKeywordPirCost(profile, 1000, 16, 1, &cost) == 0) {
+                profiles_.push_back(&profile);
+            }
+        }
+        ASSERT_GE(profiles_.size(), 2u);
+    }
+    void TearDown() override {
+        KeywordPirSender::getInstance().stopAll();
+        std::string cmd = "rm -rf " + dir_;
+        ASSERT_EQ(system(cmd.c_str()), 0);
+    }
+
+    void writeDataset(const std::map<std::string, std::string>& rows) {
+        std::ofstream ofs(dataset_, std::ios::trunc);
+        for (const auto& row : rows) {
+            ofs << row.first << "," << row.second << "\n";
+        }
+    }
+
+    int serve(int port, const KeywordPirProfile& profile) {
+        return KeywordPirSender::getInstance().serve(dataset_, port, profile.name,
+            [&profile](size_t, size_t) { return profileParams(profile); });
+    }
+
+    QueryResult query(int port, const std::vector<std::string>& keys) {
+        apsi::network::ZMQReceiverChannel channel;
+        channel.connect("tcp://127.0.0.1:" + std::to_string(port));
+        apsi::receiver::Receiver receiver(
+            apsi::receiver::Receiver::RequestParams(channel));
+        std::vector<apsi::Item> items;
+        for (const auto& key : keys) {
+            items.emplace_back(key);
+        }
+        auto [oprf_items, label_keys] =
+            apsi::receiver::Receiver::RequestOPRF(items, channel);
+        auto records = receiver.request_query(oprf_items, label_keys, channel);
+        channel.disconnect();
+        QueryResult result;
+        for (size_t i = 0; i < records.size(); i++) {
+            if (records[i].found) {
+                // labels come back padded to the label size of the db
+                std::string label = records[i].label.to_string();
+                label.erase(label.find_last_not_of('\0') + 1);
+                result[keys[i]] = label;
+            }
+        }
+        return result;
+    }
+
+    std::string dir_;
+    std::string dataset_;
+    std::string db_file_;
+    std::vector<const KeywordPirProfile*> profiles_;
+};
+
+// a db updated in place answers like one built from the new dataset
+TEST_F(KeywordPirSenderTest, IncrementalUpdateMatchesRebuild) {
+    std::map<std::string, std::string> rows;
+    for (int i = 0; i < 200; i++) {
+        rows[itemOf(i)] = "label_" + std::to_string(i);
+    }
+    writeDataset(rows);
+    ASSERT_EQ(serve(12310, *profiles_[0]), 0);
+
+    // less than half of the items change and no label grows, so the db is
+    // updated in place. The file grows, its version changes in any case.
+    for (int i = 0; i < 10; i++) {
+        rows.erase(itemOf(i));
+        rows[itemOf(100 + i)] = "relabel_" + std::to_string(i);
+        rows[itemOf(1000 + i)] = "new_" + std::to_string(i);
+    }
+    writeDataset(rows);
+    ASSERT_EQ(serve(12310, *profiles_[0]), 0);
+
+    std::vector<std::string> keys = {itemOf(0), itemOf(9), itemOf(50), itemOf(100),
+                                     itemOf(109), itemOf(1000), itemOf(1009),
+                                     itemOf(5000)};
+    auto updated = query(12310, keys);
+
+    ASSERT_EQ(std::remove(db_file_.c_str()), 0);
+    ASSERT_EQ(serve(12311, *profiles_[0]), 0);
+    auto rebuilt = query(12311, keys);
+
+    QueryResult expected;
+    for (const auto& key : keys) {
+        auto it = rows.find(key);
+        if (it != rows.end()) {
+            expected[key] = it->second;
+        }
+    }
+    EXPECT_EQ(updated, expected);
+    EXPECT_EQ(rebuilt, expected);
+}
+
+// a saved db of other params is not loaded but built again
+TEST_F(KeywordPirSenderTest, LoadRejectsParamsMismatch) {
+    writeDataset({{itemOf(1), "a"}, {itemOf(2), "b"}});
+    std::string version = FileVersion(dataset_);
+    auto header_of = [&version](const KeywordPirProfile& profile) {
+        return version + "#" +
+            std::to_string(std::hash<std::string>{}(profileParams(profile)->to_string()));
+    };
+    ASSERT_EQ(serve(12312, *profiles_[0]), 0);
+    EXPECT_EQ(readHeader(db_file_), header_of(*profiles_[0]));
+    KeywordPirSender::getInstance().stop(12312);
+
+    ASSERT_EQ(serve(12312, *profiles_[1]), 0);
+    EXPECT_EQ(readHeader(db_file_), header_of(*profiles_[1]));
+    KeywordPirSender::getInstance().stop(12312);
+
+    // a file whose params hash does not match is rebuilt and saved again
+    std::string content;
+    {
+        std::ifstream ifs(db_file_, std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(ifs),
+                       std::istreambuf_iterator<char>());
+    }
+    content.replace(0, content.find('\n'), version + "#0");
+    {
+        std::ofstream ofs(db_file_, std::ios::binary | std::ios::trunc);
+        ofs << content;
+    }
+    ASSERT_EQ(serve(12312, *profiles_[1]), 0);
+    EXPECT_EQ(readHeader(db_file_), header_of(*profiles_[1]));
+    EXPECT_EQ(query(12312, {itemOf(1), itemOf(3)}), (QueryResult{{itemOf(1), "a"}}));
+}
+
+// the saved db holds the OPRF key
+TEST_F(KeywordPirSenderTest, SavedDbIsOwnerOnly) {
+    writeDataset({{itemOf(1), "a"}});
+    ASSERT_EQ(serve(12313, *profiles_[0]), 0);
+    struct stat st;
+    ASSERT_EQ(stat(db_file_.c_str(), &st), 0);
+    EXPECT_EQ(st.st_mode & 0777, 0600);
+}
+
+// stopping a port which never started is a no-op
+TEST_F(KeywordPirSenderTest, StopUnknownPort) {
+    KeywordPirSender::getInstance().stop(12314);
+    writeDataset({{itemOf(1), "a"}});
+    // a failed start leaves nothing behind on the port
+    EXPECT_NE(KeywordPirSender::getInstance().serve(dataset_, 12314, "none",
+        [](size_t, size_t) { return std::unique_ptr<apsi::PSIParams>(); }), 0);
+    KeywordPirSender::getInstance().stop(12314);
+    ASSERT_EQ(serve(12314, *profiles_[0]), 0);
+    EXPECT_EQ(query(12314, {itemOf(1)}), (QueryResult{{itemOf(1), "a"}}));
+}
+
+}  // namespace primihub::task
@@ -0,0 +1,221 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/primihub/task/semantic/pir_planner.h"
+
+namespace primihub::task {
+
+namespace {
+void checkPlanBounds(const rpc::PirPlan& plan, int64_t db_size, uint32_t elem_size) {
+    EXPECT_EQ(plan.database_size(), db_size);
+    EXPECT_EQ(plan.elem_size(), elem_size);
+    EXPECT_GE(plan.dimensions(), 1u);
+    EXPECT_LE(plan.dimensions(), PIR_MAX_DIMENSIONS);
+    // one dimension on 4096, up to two on 8192
+    EXPECT_TRUE((plan.poly_modulus_degree() == 4096 && plan.dimensions() == 1) ||
+                plan.poly_modulus_degree() == 8192);
+    EXPECT_GE(plan.plain_mod_bit_size(), PIR_PLAIN_MOD_BIT_SIZE_LOWBOUND);
+    EXPECT_LT(plan.plain_mod_bit_size(), PIR_PLAIN_MOD_BIT_SIZE_UPBOUND);
+}
+}  // namespace
+
+TEST(PirPlannerTest, RejectInvalidInput) {
+    rpc::PirPlan plan;
+    EXPECT_EQ(planPir(0, 64, 1, 0, 0, &plan, nullptr), -1);
+    EXPECT_EQ(planPir(-1, 64, 1, 0, 0, &plan, nullptr), -1);
+    EXPECT_EQ(planPir(1000, 0, 1, 0, 0, &plan, nullptr), -1);
+    EXPECT_EQ(planPir(1000, 64, 1, PIR_MAX_DIMENSIONS + 1, 0, &plan, nullptr), -1);
+    // no plaintext of the forced degree holds one such element
+    EXPECT_EQ(planPir(1000, 1 << 16, 1, 0, 4096, &plan, nullptr), -1);
+}
+
+// the server accepts every plan a client makes
+TEST(PirPlannerTest, PlansAreValidated) {
+    for (int64_t db_size : {1, 1000, 100000, 1 << 20, 1 << 24}) {
+        for (uint32_t elem_size : {8u, 64u, 1024u}) {
+            rpc::PirPlan plan;
+            PirCost cost;
+            ASSERT_EQ(planPir(db_size, elem_size, 1, 0, 0, &plan, &cost), 0)
+                << db_size << " rows of " << elem_size << " bytes";
+            checkPlanBounds(plan, db_size, elem_size);
+            uint64_t elem_per_plaintext = uint64_t{plan.poly_modulus_degree()} *
+                (plan.plain_mod_bit_size() - 1) / 8 / elem_size;
+            ASSERT_GT(elem_per_plaintext, 0u);
+            EXPECT_EQ(cost.num_plaintexts, db_size / elem_per_plaintext + 1);
+            EXPECT_GE(cost.database_bytes,
+                      cost.num_plaintexts * plan.poly_modulus_degree() * sizeof(uint64_t));
+            EXPECT_EQ(validatePirPlan(db_size, plan), 0) << plan.ShortDebugString();
+        }
+    }
+}
+
+TEST(PirPlannerTest, RejectUnvalidatedPlans) {
+    rpc::PirPlan plan;
+    ASSERT_EQ(planPir(50000, 256, 1, 2, 8192, &plan, nullptr), 0);
+    ASSERT_EQ(validatePirPlan(50000, plan), 0);
+
+    // more dimensions than the set is validated for
+    rpc::PirPlan changed = plan;
+    changed.set_dimensions(3);
+    EXPECT_EQ(validatePirPlan(50000, changed), -1);
+    changed = plan;
+    changed.set_poly_modulus_degree(4096);
+    EXPECT_EQ(validatePirPlan(50000, changed), -1);
+    // a plaintext modulus above the one the planner picked breaks the budget
+    changed = plan;
+    changed.set_plain_mod_bit_size(plan.plain_mod_bit_size() + 1);
+    EXPECT_EQ(validatePirPlan(50000, changed), -1);
+    changed = plan;
+    changed.set_poly_modulus_degree(16384);
+    EXPECT_EQ(validatePirPlan(50000, changed), -1);
+    changed = plan;
+    changed.set_elem_size(0);
+    EXPECT_EQ(validatePirPlan(50000, changed), -1);
+    EXPECT_EQ(validatePirPlan(0, plan), -1);
+}
+
+TEST(PirPlannerTest, FixedParametersAreKept) {
+    for (uint32_t d = 1; d <= PIR_MAX_DIMENSIONS; d++) {
+        rpc::PirPlan plan;
+        ASSERT_EQ(planPir(50000, 256, 1, d, 8192, &plan, nullptr), 0);
+        checkPlanBounds(plan, 50000, 256);
+        EXPECT_EQ(plan.dimensions(), d);
+        EXPECT_EQ(plan.poly_modulus_degree(), 8192u);
+    }
+    // the legacy plan, one dimension on 4096
+    rpc::PirPlan plan;
+    ASSERT_EQ(planPir(50000, 1024, 1, 1, 4096, &plan, nullptr), 0);
+    checkPlanBounds(plan, 50000, 1024);
+    EXPECT_EQ(plan.dimensions(), 1u);
+    EXPECT_EQ(plan.poly_modulus_degree(), 4096u);
+    // 4096 is validated on one dimension only
+    EXPECT_EQ(planPir(50000, 256, 1, 2, 4096, &plan, nullptr), -1);
+}
+
+TEST(PirPlannerTest, LargeDatabaseUsesMoreDimensions) {
+    rpc::PirPlan plan;
+    PirCost cost;
+    ASSERT_EQ(planPir(1 << 24, 64, 1, 0, 0, &plan, &cost), 0);
+    EXPECT_GT(plan.dimensions(), 1u);
+
+    // the chosen plan never costs more than the one dimension plan
+    rpc::PirPlan one_dim_plan;
+    PirCost one_dim_cost;
+    ASSERT_EQ(planPir(1 << 24, 64, 1, 1, 0, &one_dim_plan, &one_dim_cost), 0);
+    EXPECT_LE(cost.upload_bytes + cost.download_bytes,
+              one_dim_cost.upload_bytes + one_dim_cost.download_bytes);
+}
+
+TEST(PirPlannerTest, CostGrowsWithQueries) {
+    rpc::PirPlan plan;
+    PirCost one_query;
+    PirCost ten_queries;
+    ASSERT_EQ(planPir(100000, 64, 1, 2, 8192, &plan, &one_query), 0);
+    ASSERT_EQ(planPir(100000, 64, 10, 2, 8192, &plan, &ten_queries), 0);
+    EXPECT_EQ(ten_queries.upload_bytes, one_query.upload_bytes * 10);
+    EXPECT_EQ(ten_queries.download_bytes, one_query.download_bytes * 10);
+}
+
+TEST(PirBucketsTest, NumBuckets) {
+    EXPECT_EQ(PirBuckets::numBuckets(1), 2u);
+    EXPECT_EQ(PirBuckets::numBuckets(2), 3u);
+    EXPECT_EQ(PirBuckets::numBuckets(10), 15u);
+}
+
+TEST(PirBucketsTest, LayoutPlacesRowInEveryCandidate) {
+    constexpr int64_t kDbSize = 5000;
+    constexpr uint32_t kNumBuckets = 30;
+    auto layout = PirBuckets::layout(kDbSize, kNumBuckets);
+    ASSERT_EQ(layout.size(), kNumBuckets);
+
+    size_t total = 0;
+    for (const auto& rows : layout) {
+        EXPECT_TRUE(std::is_sorted(rows.begin(), rows.end()));
+        EXPECT_EQ(std::set<uint64_t>(rows.begin(), rows.end()).size(), rows.size());
+        total += rows.size();
+    }
+    size_t expected_total = 0;
+    for (int64_t i = 0; i < kDbSize; i++) {
+        auto candidates = PirBuckets::candidates(i, kNumBuckets);
+        EXPECT_GE(candidates.size(), 1u);
+        EXPECT_LE(candidates.size(), PirBuckets::kNumHashes);
+        EXPECT_EQ(std::set<uint32_t>(candidates.begin(), candidates.end()).size(),
+                  candidates.size());
+        for (auto bucket : candidates) {
+            ASSERT_LT(bucket, kNumBuckets);
+            EXPECT_TRUE(std::binary_search(layout[bucket].begin(),
+                                           layout[bucket].end(),
+                                           static_cast<uint64_t>(i)));
+        }
+        expected_total += candidates.size();
+    }
+    EXPECT_EQ(total, expected_total);
+}
+
+TEST(PirBucketsTest, SingleBucketHoldsAllRows) {
+    auto layout = PirBuckets::layout(100, 1);
+    ASSERT_EQ(layout.size(), 1u);
+    ASSERT_EQ(layout[0].size(), 100u);
+    for (uint64_t i = 0; i < 100; i++) {
+        EXPECT_EQ(layout[0][i], i);
+    }
+}
+
+TEST(PirBucketsTest, AssignAndPositionsMatchLayout) {
+    constexpr int64_t kDbSize = 20000;
+    std::vector<uint64_t> indices = {0, 7, 123, 999, 4242, 10000, 15001, 19999};
+    uint32_t num_buckets = PirBuckets::numBuckets(indices.size());
+
+    std::vector<int64_t> bucket_index;
+    ASSERT_TRUE(PirBuckets::assign(indices, num_buckets, &bucket_index));
+    ASSERT_EQ(bucket_index.size(), num_buckets);
+    std::set<int64_t> placed;
+    for (size_t b = 0; b < bucket_index.size(); b++) {
+        if (bucket_index[b] < 0) {
+            continue;
+        }
+        auto candidates = PirBuckets::candidates(bucket_index[b], num_buckets);
+        EXPECT_NE(std::find(candidates.begin(), candidates.end(), b), candidates.end());
+        placed.insert(bucket_index[b]);
+    }
+    EXPECT_EQ(placed, std::set<int64_t>(indices.begin(), indices.end()));
+
+    auto layout = PirBuckets::layout(kDbSize, num_buckets);
+    std::vector<uint64_t> bucket_position;
+    uint64_t max_bucket = PirBuckets::positions(kDbSize, num_buckets,
+                                                bucket_index, &bucket_position);
+    size_t largest = 0;
+    for (size_t b = 0; b < layout.size(); b++) {
+        largest = std::max(largest, layout[b].size());
+        if (bucket_index[b] >= 0) {
+            ASSERT_LT(bucket_position[b], layout[b].size());
+            EXPECT_EQ(layout[b][bucket_position[b]],
+                      static_cast<uint64_t>(bucket_index[b]));
+        } else {
+            EXPECT_EQ(bucket_position[b], 0u);
+        }
+    }
+    EXPECT_EQ(max_bucket, largest);
+}
+
+}  // namespace primihub::task
@@ -0,0 +1,235 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include <stdlib.h>
+
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "pir/cpp/client.h"
+
+#include "src/primihub/task/semantic/pir_planner.h"
+#include "src/primihub/task/semantic/pir_server_task.h"
+
+namespace primihub::task {
+
+// Encode -> query -> decode through PIRServerTask and the pir client, the
+// way PIRClientTask talks to the server, without the network.
+class PirRoundTripTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        PirDatabaseCache::Options options;
+        options.enabled = false;
+        PirDatabaseCache::getInstance().setOptions(options);
+        dir_ = ::testing::TempDir() + "/pir_round_trip.XXXXXX";
+        ASSERT_NE(mkdtemp(&dir_[0]), nullptr);
+        path_ = dir_ + "/pir_db.txt";
+    }
+    void TearDown() override {
+        std::string cmd = "rm -rf " + dir_;
+        ASSERT_EQ(system(cmd.c_str()), 0);
+    }
+
+    static std::string row(uint64_t index) {
+        return "row_" + std::to_string(index);
+    }
+
+    void writeDataset(int64_t num_rows) {
+        std::ofstream out(path_);
+        out << "value\n";
+        for (int64_t i = 0; i < num_rows; i++) {
+            out << row(i) << "\n";
+        }
+    }
+
+    int runServer(const rpc::PirRequest& pir_request, rpc::PirResponse* pir_response) {
+        ExecuteTaskRequest request;
+        *request.mutable_pir_request() = pir_request;
+        rpc::ParamValue pv;
+        pv.set_var_type(rpc::VarType::STRING);
+        pv.set_value_string(path_);
+        (*request.mutable_params()->mutable_param_map())["serverData"] = pv;
+        ExecuteTaskResponse response;
+        PIRServerTask task("test_node", request, &response, nullptr);
+        int ret = task.execute();
+        *pir_response = response.pir_response();
+        return ret;
+    }
+
+    // query positions of a database of db_size rows, the bucket size for a
+    // batched plan, the decoded rows are returned in values
+    void query(const rpc::PirPlan& plan, int64_t db_size,
+               const std::vector<uint64_t>& positions,
+               std::vector<std::string>* values) {
+        auto encryption_params = pir::GenerateEncryptionParams(
+            plan.poly_modulus_degree(), plan.plain_mod_bit_size());
+        auto params_or = pir::CreatePIRParameters(db_size, plan.elem_size(),
+            plan.dimensions(), encryption_params, true, 0);
+        ASSERT_TRUE(params_or.ok()) << params_or.status();
+        auto client_or = pir::PIRClient::Create(*params_or);
+        ASSERT_TRUE(client_or.ok()) << client_or.status();
+        auto client = std::move(client_or).value();
+        auto request_or = client->CreateRequest(positions);
+        ASSERT_TRUE(request_or.ok()) << request_or.status();
+        const auto& request = request_or.value();
+
+        rpc::PirRequest pir_request;
+        *pir_request.mutable_plan() = plan;
+        pir_request.set_galois_keys(request.galois_keys());
+        pir_request.set_relin_keys(request.relin_keys());
+        for (const auto& query : request.query()) {
+            auto* ptr_query = pir_request.add_query();
+            for (const auto& ct : query.ct()) {
+                ptr_query->add_ct(ct);
+            }
+        }
+        rpc::PirResponse pir_response;
+        ASSERT_EQ(runServer(pir_request, &pir_response), 0);
+        ASSERT_EQ(pir_response.ret_code(), 0);
+
+        pir::Response response;
+        for (const auto& reply : pir_response.reply()) {
+            auto* ptr_reply = response.add_reply();
+            for (const auto& ct : reply.ct()) {
+                ptr_reply->add_ct(ct);
+            }
+        }
+        auto result = client->ProcessResponse(positions, response);
+        ASSERT_TRUE(result.ok()) << result.status();
+        *values = std::move(result).value();
+    }
+
+    static void expectRow(const std::string& value, uint64_t index) {
+        std::string expected = row(index);
+        ASSERT_GE(value.size(), expected.size());
+        EXPECT_EQ(value.substr(0, expected.size()), expected);
+        // the rest is the zero padding up to elem_size
+        EXPECT_EQ(value.find_first_not_of('\0', expected.size()), std::string::npos);
+    }
+
+    std::string dir_;
+    std::string path_;
+};
+
+// a client without databaseSize asks for the size first, then queries
+TEST_F(PirRoundTripTest, SizeProbeThenQuery) {
+    constexpr int64_t kDbSize = 1000;
+    writeDataset(kDbSize);
+
+    rpc::PirRequest probe;
+    probe.mutable_plan()->set_database_size(-1);
+    rpc::PirResponse probe_response;
+    ASSERT_EQ(runServer(probe, &probe_response), 0);
+    EXPECT_EQ(probe_response.ret_code(), 0);
+    ASSERT_EQ(probe_response.database_size(), kDbSize);
+    EXPECT_EQ(probe_response.reply_size(), 0);
+    EXPECT_EQ(probe_response.plan().database_size(), kDbSize);
+    EXPECT_GE(probe_response.plan().dimensions(), 1u);
+
+    std::vector<uint64_t> positions = {3, 999};
+    rpc::PirPlan plan;
+    ASSERT_EQ(planPir(probe_response.database_size(), 64, positions.size(),
+                      0, 0, &plan, nullptr), 0);
+    std::vector<std::string> values;
+    query(plan, kDbSize, positions, &values);
+    ASSERT_EQ(values.size(), positions.size());
+    for (size_t i = 0; i < positions.size(); i++) {
+        expectRow(values[i], positions[i]);
+    }
+}
+
+// every validated parameter set decodes at the largest plaintext modulus
+// the planner gives it, with more than one dimension on 8192
+TEST_F(PirRoundTripTest, ValidatedSetsDecode) {
+    constexpr int64_t kDbSize = 3000;
+    writeDataset(kDbSize);
+    std::vector<uint64_t> positions = {0, 1234, 2999};
+    for (auto [poly_modulus_degree, dimensions] :
+            {std::make_pair(4096u, 1u), std::make_pair(8192u, 1u),
+             std::make_pair(8192u, 2u)}) {
+        rpc::PirPlan plan;
+        ASSERT_EQ(planPir(kDbSize, 64, positions.size(), dimensions,
+                          poly_modulus_degree, &plan, nullptr), 0);
+        ASSERT_EQ(plan.dimensions(), dimensions);
+        std::vector<std::string> values;
+        query(plan, kDbSize, positions, &values);
+        ASSERT_EQ(values.size(), positions.size()) << plan.ShortDebugString();
+        for (size_t i = 0; i < positions.size(); i++) {
+            expectRow(values[i], positions[i]);
+        }
+    }
+}
+
+// the batched plan of PIRClientTask, one query per cuckoo bucket
+TEST_F(PirRoundTripTest, BucketedPlanDecodes) {
+    constexpr int64_t kDbSize = 5000;
+    writeDataset(kDbSize);
+    std::vector<uint64_t> indices = {5, 123, 2500, 4000, 4999};
+    uint32_t num_buckets = PirBuckets::numBuckets(indices.size());
+    std::vector<int64_t> bucket_index;
+    ASSERT_TRUE(PirBuckets::assign(indices, num_buckets, &bucket_index));
+    std::vector<uint64_t> positions;
+    uint64_t bucket_size = PirBuckets::positions(kDbSize, num_buckets,
+                                                 bucket_index, &positions);
+    rpc::PirPlan plan;
+    ASSERT_EQ(planPir(bucket_size, 64, num_buckets, 2, 8192, &plan, nullptr), 0);
+    plan.set_database_size(kDbSize);
+    plan.set_num_buckets(num_buckets);
+
+    std::vector<std::string> values;
+    query(plan, bucket_size, positions, &values);
+    ASSERT_EQ(values.size(), num_buckets);
+    std::set<int64_t> decoded;
+    for (size_t b = 0; b < num_buckets; b++) {
+        if (bucket_index[b] < 0) {
+            continue;
+        }
+        expectRow(values[b], bucket_index[b]);
+        decoded.insert(bucket_index[b]);
+    }
+    EXPECT_EQ(decoded, std::set<int64_t>(indices.begin(), indices.end()));
+}
+
+// a client can not make the server run an unvalidated parameter set
+TEST_F(PirRoundTripTest, UnvalidatedPlanIsRejected) {
+    writeDataset(100);
+    rpc::PirRequest request;
+    ASSERT_EQ(planPir(100, 64, 1, 1, 4096, request.mutable_plan(), nullptr), 0);
+    request.mutable_plan()->set_dimensions(2);
+    request.add_query();
+    rpc::PirResponse response;
+    EXPECT_NE(runServer(request, &response), 0);
+    EXPECT_EQ(response.ret_code(), 2);
+    EXPECT_EQ(response.reply_size(), 0);
+}
+
+// a plan built for another size is answered with the real size
+TEST_F(PirRoundTripTest, StalePlanGetsRealSize) {
+    writeDataset(500);
+    rpc::PirRequest request;
+    ASSERT_EQ(planPir(800, 64, 1, 1, 0, request.mutable_plan(), nullptr), 0);
+    request.add_query();
+    rpc::PirResponse response;
+    EXPECT_EQ(runServer(request, &response), 0);
+    EXPECT_EQ(response.ret_code(), 2);
+    EXPECT_EQ(response.database_size(), 500);
+    EXPECT_EQ(response.reply_size(), 0);
+}
+
+}  // namespace primihub::task
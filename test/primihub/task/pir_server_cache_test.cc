@@ -0,0 +1,112 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "src/primihub/task/semantic/pir_server_cache.h"
+
+namespace primihub::task {
+
+namespace {
+PirDatabaseCache::Database database(uint64_t bytes) {
+    PirDatabaseCache::Database db;
+    db.bytes = bytes;
+    return db;
+}
+
+bool cached(const std::string& dataset, const std::string& param_key) {
+    PirDatabaseCache::Database db;
+    return PirDatabaseCache::getInstance().get(dataset, "v1", param_key, &db);
+}
+}  // namespace
+
+class PirDatabaseCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        PirDatabaseCache::Options options;
+        options.max_bytes = 300;
+        PirDatabaseCache::getInstance().setOptions(options);
+    }
+    void TearDown() override {
+        auto& cache = PirDatabaseCache::getInstance();
+        cache.erase("a");
+        cache.erase("b");
+        cache.setOptions(PirDatabaseCache::Options());
+    }
+};
+
+TEST_F(PirDatabaseCacheTest, EvictLeastRecentlyUsed) {
+    auto& cache = PirDatabaseCache::getInstance();
+    cache.put("a", "v1", "p1", database(100));
+    cache.put("a", "v1", "p2", database(100));
+    cache.put("b", "v1", "p1", database(100));
+    EXPECT_EQ(cache.bytes(), 300u);
+
+    // a/p1 is used again, so a/p2 is the oldest when b/p2 comes in
+    EXPECT_TRUE(cached("a", "p1"));
+    cache.put("b", "v1", "p2", database(100));
+    EXPECT_EQ(cache.bytes(), 300u);
+    EXPECT_TRUE(cached("a", "p1"));
+    EXPECT_FALSE(cached("a", "p2"));
+    EXPECT_TRUE(cached("b", "p1"));
+    EXPECT_TRUE(cached("b", "p2"));
+
+    // a large database evicts as many as it needs
+    cache.put("a", "v1", "p3", database(250));
+    EXPECT_EQ(cache.bytes(), 250u);
+    EXPECT_TRUE(cached("a", "p3"));
+    EXPECT_FALSE(cached("a", "p1"));
+    EXPECT_FALSE(cached("b", "p1"));
+    EXPECT_FALSE(cached("b", "p2"));
+}
+
+TEST_F(PirDatabaseCacheTest, DatabaseAboveCapIsNotCached) {
+    auto& cache = PirDatabaseCache::getInstance();
+    cache.put("a", "v1", "p1", database(100));
+    cache.put("a", "v1", "p2", database(301));
+    EXPECT_FALSE(cached("a", "p2"));
+    EXPECT_TRUE(cached("a", "p1"));
+    EXPECT_EQ(cache.bytes(), 100u);
+}
+
+TEST_F(PirDatabaseCacheTest, NewVersionAndEraseReleaseBytes) {
+    auto& cache = PirDatabaseCache::getInstance();
+    cache.put("a", "v1", "p1", database(100));
+    cache.put("b", "v1", "p1", database(100));
+    // replacing a database counts it once
+    cache.put("b", "v1", "p1", database(50));
+    EXPECT_EQ(cache.bytes(), 150u);
+
+    EXPECT_EQ(cache.numRows("a", "v2"), -1);
+    EXPECT_EQ(cache.bytes(), 50u);
+    cache.erase("b");
+    EXPECT_EQ(cache.bytes(), 0u);
+    EXPECT_FALSE(cached("b", "p1"));
+
+    // a lower cap applies at once
+    cache.put("a", "v1", "p1", database(100));
+    cache.put("a", "v1", "p2", database(100));
+    PirDatabaseCache::Options options;
+    options.max_bytes = 150;
+    cache.setOptions(options);
+    EXPECT_EQ(cache.bytes(), 100u);
+    EXPECT_TRUE(cached("a", "p2"));
+    EXPECT_FALSE(cached("a", "p1"));
+}
+
+}  // namespace primihub::task
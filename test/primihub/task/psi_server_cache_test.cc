@@ -0,0 +1,112 @@
+/*
+ Copyright 2022 Primihub
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+      https://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/primihub/task/semantic/psi_server_cache.h"
+
+namespace primihub::task {
+
+class PsiServerCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        PsiServerCache::Options options;
+        options.enabled = true;
+        ASSERT_EQ(PsiServerCache::getInstance().setOptions(options), 0);
+    }
+    void TearDown() override {
+        auto& cache = PsiServerCache::getInstance();
+        cache.clear();
+        cache.setOptions(PsiServerCache::Options());
+    }
+
+    void setMaxBytes(uint64_t max_bytes) {
+        auto options = PsiServerCache::getInstance().options();
+        options.max_bytes = max_bytes;
+        ASSERT_EQ(PsiServerCache::getInstance().setOptions(options), 0);
+    }
+
+    // asks for the server of dataset, returns whether the server set had
+    // to be encrypted, i.e. the cache missed
+    bool request(const std::string& dataset, const std::string& version = "v1",
+                 int num_elements = 1000) {
+        bool loaded = false;
+        auto load_dataset = [&](std::vector<std::string>* elements) {
+            loaded = true;
+            for (int i = 0; i < num_elements; i++) {
+                elements->push_back(dataset + "_" + std::to_string(i));
+            }
+            return 0;
+        };
+        std::shared_ptr<const PsiServerCache::PsiServer> server;
+        psi_proto::ServerSetup setup;
+        EXPECT_EQ(PsiServerCache::getInstance().getServer(dataset, version, true,
+            0.001, 100, 0, load_dataset, &server, &setup), 0);
+        EXPECT_NE(server, nullptr);
+        EXPECT_GT(setup.ByteSizeLong(), 0u);
+        return loaded;
+    }
+};
+
+TEST_F(PsiServerCacheTest, EvictLeastRecentlyUsed) {
+    auto& cache = PsiServerCache::getInstance();
+    EXPECT_TRUE(request("a"));
+    uint64_t a_bytes = cache.bytes();
+    EXPECT_TRUE(request("b"));
+    uint64_t b_bytes = cache.bytes() - a_bytes;
+    EXPECT_TRUE(request("c"));
+    uint64_t c_bytes = cache.bytes() - a_bytes - b_bytes;
+    EXPECT_GT(a_bytes, 0u);
+
+    // a is used again, so b is the oldest when the cap shrinks
+    EXPECT_FALSE(request("a"));
+    setMaxBytes(a_bytes + c_bytes);
+    EXPECT_EQ(cache.bytes(), a_bytes + c_bytes);
+    EXPECT_FALSE(request("a"));
+    EXPECT_FALSE(request("c"));
+
+    // b comes back and pushes out the least recently used, a
+    EXPECT_TRUE(request("b"));
+    EXPECT_TRUE(request("a"));
+}
+
+TEST_F(PsiServerCacheTest, EntryAboveCapIsNotCached) {
+    setMaxBytes(1);
+    EXPECT_TRUE(request("a"));
+    EXPECT_EQ(PsiServerCache::getInstance().bytes(), 0u);
+    EXPECT_TRUE(request("a"));
+}
+
+TEST_F(PsiServerCacheTest, NewVersionAndEraseReleaseBytes) {
+    auto& cache = PsiServerCache::getInstance();
+    EXPECT_TRUE(request("a", "v1", 1000));
+    uint64_t v1_bytes = cache.bytes();
+    // a smaller set under a new version replaces the old setups
+    EXPECT_TRUE(request("a", "v2", 10));
+    EXPECT_GT(cache.bytes(), 0u);
+    EXPECT_LT(cache.bytes(), v1_bytes);
+    EXPECT_FALSE(request("a", "v2", 10));
+
+    cache.erase("a");
+    EXPECT_EQ(cache.bytes(), 0u);
+    EXPECT_TRUE(request("a", "v2", 10));
+}
+
+}  // namespace primihub::task
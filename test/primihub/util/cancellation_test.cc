@@ -0,0 +1,104 @@
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "src/primihub/util/cancellation.h"
+
+using namespace primihub;
+
+TEST(Cancellation_Test, cancelRunsCallbacksOnce) {
+  auto token = std::make_shared<CancellationToken>();
+  int called = 0;
+  token->onCancel([&called]() { called++; });
+  EXPECT_FALSE(token->isCancelled());
+  EXPECT_TRUE(token->cancel("killed"));
+  EXPECT_FALSE(token->cancel("killed again"));
+  EXPECT_TRUE(token->isCancelled());
+  EXPECT_EQ(token->reason(), "killed");
+  EXPECT_EQ(called, 1);
+
+  // registered after cancel, runs right away
+  token->onCancel([&called]() { called++; });
+  EXPECT_EQ(called, 2);
+}
+
+TEST(Cancellation_Test, scopeRemovesCallback) {
+  auto token = std::make_shared<CancellationToken>();
+  int called = 0;
+  {
+    CancelScope scope(token, [&called]() { called++; });
+  }
+  token->cancel("killed");
+  EXPECT_EQ(called, 0);
+
+  CancelScope null_scope(nullptr, [&called]() { called++; });
+  EXPECT_EQ(called, 0);
+}
+
+TEST(Cancellation_Test, deadline) {
+  auto token = std::make_shared<CancellationToken>();
+  EXPECT_EQ(token->remainingMs(), -1);
+  token->setTimeout(50);
+  EXPECT_TRUE(token->hasDeadline());
+  EXPECT_LE(token->remainingMs(), 50);
+  // a token destroyed before its deadline is skipped by the watchdog
+  std::make_shared<CancellationToken>()->setTimeout(10);
+
+  auto start = std::chrono::steady_clock::now();
+  while (!token->isCancelled() &&
+         std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  EXPECT_TRUE(token->isCancelled());
+  EXPECT_EQ(token->reason(), "deadline exceeded");
+  EXPECT_EQ(token->remainingMs(), 0);
+}
+
+namespace {
+// counts the blocks freed through it, make_shared style single allocation
+size_t freed_blocks = 0;
+
+template <typename T>
+struct CountingAllocator {
+  using value_type = T;
+  CountingAllocator() = default;
+  template <typename U>
+  CountingAllocator(const CountingAllocator<U>&) {}
+  T* allocate(size_t n) { return std::allocator<T>().allocate(n); }
+  void deallocate(T* p, size_t n) {
+    freed_blocks++;
+    std::allocator<T>().deallocate(p, n);
+  }
+  template <typename U>
+  bool operator==(const CountingAllocator<U>&) const { return true; }
+  template <typename U>
+  bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+}  // namespace
+
+// a finished token with a far deadline frees its memory right away
+TEST(Cancellation_Test, unwatchOnDestroyAndCancel) {
+  auto& watchdog = DeadlineWatchdog::getInstance();
+  size_t watched = watchdog.numWatched();
+
+  freed_blocks = 0;
+  auto token = std::allocate_shared<CancellationToken>(
+      CountingAllocator<CancellationToken>());
+  token->setTimeout(3600 * 1000);
+  // a new deadline replaces the old entry
+  token->setTimeout(7200 * 1000);
+  EXPECT_EQ(watchdog.numWatched(), watched + 1);
+  token.reset();
+  EXPECT_EQ(freed_blocks, 1u);
+  EXPECT_EQ(watchdog.numWatched(), watched);
+
+  auto cancelled = std::make_shared<CancellationToken>();
+  cancelled->setTimeout(3600 * 1000);
+  EXPECT_EQ(watchdog.numWatched(), watched + 1);
+  cancelled->cancel("done");
+  EXPECT_EQ(watchdog.numWatched(), watched);
+  cancelled->setTimeout(3600 * 1000);
+  EXPECT_EQ(watchdog.numWatched(), watched);
+}
@@ -0,0 +1,83 @@
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "src/primihub/util/metrics.h"
+
+using namespace primihub;
+
+TEST(Metrics_Test, histogramBuckets) {
+  for (uint64_t v : {0ull, 15ull, 16ull, 17ull, 1000ull, 123456789ull, ~0ull}) {
+    int index = Histogram::bucketIndex(v);
+    EXPECT_GE(Histogram::bucketUpperBound(index), v);
+    if (index > 0) {
+      EXPECT_LT(Histogram::bucketUpperBound(index - 1), v);
+    }
+  }
+}
+
+TEST(Metrics_Test, histogramQuantile) {
+  Histogram hist;
+  for (uint64_t i = 1; i <= 1000; i++) {
+    hist.observe(i * 1000);
+  }
+  EXPECT_EQ(hist.count(), 1000u);
+  // log-linear buckets keep the relative error below 1/16
+  EXPECT_NEAR(hist.quantile(0.5), 500000, 500000 / 16);
+  EXPECT_NEAR(hist.quantile(0.99), 990000, 990000 / 16);
+  EXPECT_EQ(hist.quantile(1.0), 1000000u);
+}
+
+TEST(Metrics_Test, exportText) {
+  auto& registry = MetricsRegistry::getInstance();
+  registry.counter("test_requests_total", {{"task_type", "psi"}}).inc(3);
+  registry.histogram("test_latency_seconds", {}, "", 1e-6).observe(2000);
+  std::string text = registry.exportText();
+  EXPECT_NE(text.find("# TYPE test_requests_total counter"), std::string::npos);
+  EXPECT_NE(text.find("test_requests_total{task_type=\"psi\"} 3"), std::string::npos);
+  EXPECT_NE(text.find("test_latency_seconds_bucket{le=\"+Inf\"} 1"), std::string::npos);
+  EXPECT_NE(text.find("test_latency_seconds_count 1"), std::string::npos);
+}
+
+// every series exports the same le set, empty buckets included
+TEST(Metrics_Test, exportFixedBuckets) {
+  auto& registry = MetricsRegistry::getInstance();
+  // microseconds, 2ms and 40s
+  auto& hist = registry.histogram("test_fixed_seconds", {{"phase", "a"}}, "", 1e-6);
+  hist.observe(2000);
+  hist.observe(40000000);
+  registry.histogram("test_fixed_seconds", {{"phase", "b"}}, "", 1e-6);
+  registry.histogram("test_bytes", {}, "", 1.0, {1024, 16, 256}).observe(16);
+  std::string text = registry.exportText();
+
+  for (const std::string phase : {"a", "b"}) {
+    std::string prefix = "test_fixed_seconds_bucket{phase=\"" + phase + "\",le=\"";
+    size_t count = 0;
+    for (size_t pos = text.find(prefix); pos != std::string::npos;
+         pos = text.find(prefix, pos + 1)) {
+      count++;
+    }
+    EXPECT_EQ(count, MetricsRegistry::kDefaultBounds.size() + 1) << phase;
+  }
+  auto bucket = [](const std::string& phase, const std::string& le) {
+    return "test_fixed_seconds_bucket{phase=\"" + phase + "\",le=\"" + le + "\"} ";
+  };
+  EXPECT_NE(text.find(bucket("a", "0.001") + "0\n"), std::string::npos);
+  EXPECT_NE(text.find(bucket("a", "0.0025") + "1\n"), std::string::npos);
+  EXPECT_NE(text.find(bucket("a", "30") + "1\n"), std::string::npos);
+  EXPECT_NE(text.find(bucket("a", "60") + "2\n"), std::string::npos);
+  EXPECT_NE(text.find(bucket("a", "3600") + "2\n"), std::string::npos);
+  EXPECT_NE(text.find(bucket("a", "+Inf") + "2\n"), std::string::npos);
+  EXPECT_NE(text.find(bucket("b", "0.001") + "0\n"), std::string::npos);
+  EXPECT_NE(text.find(bucket("b", "+Inf") + "0\n"), std::string::npos);
+
+  // custom bounds are sorted, a bound on a recorded value includes it
+  size_t le16 = text.find("test_bytes_bucket{le=\"16\"} 1\n");
+  size_t le256 = text.find("test_bytes_bucket{le=\"256\"} 1\n");
+  size_t le1024 = text.find("test_bytes_bucket{le=\"1024\"} 1\n");
+  ASSERT_NE(le16, std::string::npos);
+  ASSERT_NE(le256, std::string::npos);
+  ASSERT_NE(le1024, std::string::npos);
+  EXPECT_LT(le16, le256);
+  EXPECT_LT(le256, le1024);
+}